@@ -0,0 +1,132 @@
+/**
+ * @file   can_bridge_capture.h
+ * @author Shadow Robot Software Team <software@shadowrobot.com>
+ * @date   Sun Oct 18 21:47:10 2026
+*
+* Copyright 2026 Shadow Robot Company Ltd.
+*
+* This program is free software: you can redistribute it and/or modify it
+* under the terms of the GNU General Public License as published by the Free
+* Software Foundation, either version 2 of the License, or (at your option)
+* any later version.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+* more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+ *
+ * @brief Capture of the CAN messages going through the EtherCAT CAN bridge,
+ *        in the candump log format.
+ *
+ * The realtime loop copies the messages sent and received to a lock-free
+ * ring, a background thread writes them to the file, one line per message:
+ * \code
+ *   (1760821630.123456) can1tx 64A#C0040000
+ *   (1760821630.125456) can1 65A#C0040000
+ * \endcode
+ * The interface is can1 or can2 for the messages received from the boards
+ * of that CAN bus, can1tx or can2tx for the messages sent to them. The log
+ * can be replayed or analysed with can-utils (canplayer, log2asc...).
+ *
+ * When the capture isn't started, capturing a message costs a single atomic load.
+ *
+ */
+
+#ifndef SR_EDC_ETHERCAT_DRIVERS_CAN_BRIDGE_CAPTURE_H
+#define SR_EDC_ETHERCAT_DRIVERS_CAN_BRIDGE_CAPTURE_H
+
+#include <boost/atomic.hpp>
+#include <boost/lockfree/spsc_queue.hpp>
+#include <boost/smart_ptr.hpp>
+#include <boost/thread.hpp>
+#include <boost/utility.hpp>
+#include <cstdio>
+#include <string>
+#include <time.h>
+
+#include <sr_external_dependencies/types_for_external.h>
+
+extern "C"
+{
+#include <sr_external_dependencies/external/common/ethercat_can_bridge_protocol.h>
+}
+
+namespace sr_edc_ethercat_drivers
+{
+  class CanBridgeCapture :
+          private boost::noncopyable
+  {
+  public:
+    enum Direction
+    {
+      SENT,
+      RECEIVED
+    };
+
+    /// messages which can be waiting to be written (more than 1s of messages in both directions at 1kHz)
+    static const unsigned int ring_size = 4096;
+
+    CanBridgeCapture();
+
+    ~CanBridgeCapture();
+
+    /**
+     * Opens the log file and starts the capture.
+     *
+     * @return false if the file couldn't be opened
+     */
+    bool start(const std::string &path);
+
+    /// Stops the capture, once the messages captured are written.
+    void stop();
+
+    /**
+     * Copies a message to the ring, from the realtime loop. Never blocks: the message is
+     * dropped if the ring is full. Empty messages (nothing sent or received) are ignored.
+     */
+    void capture(Direction direction, const ETHERCAT_CAN_BRIDGE_DATA &message)
+    {
+      if (capturing_.load(boost::memory_order_relaxed))
+      {
+        push(direction, message);
+      }
+    }
+
+  private:
+    struct Frame
+    {
+      struct timespec stamp;
+      Direction direction;
+      ETHERCAT_CAN_BRIDGE_DATA message;
+    };
+
+    void push(Direction direction, const ETHERCAT_CAN_BRIDGE_DATA &message);
+
+    /// Writes the content of the ring to the file every write_period_.
+    void writing_loop();
+
+    void write_frames();
+
+    static const boost::posix_time::time_duration write_period_;
+
+    boost::lockfree::spsc_queue<Frame, boost::lockfree::capacity<ring_size> > ring_;
+    boost::atomic<bool> capturing_;
+    boost::atomic<unsigned int> dropped_frames_;
+    unsigned int reported_dropped_frames_;
+
+    FILE *file_;
+    boost::shared_ptr<boost::thread> writing_thread_;
+  };
+}  // namespace sr_edc_ethercat_drivers
+
+/* For the emacs weenies in the crowd.
+Local Variables:
+   c-basic-offset: 2
+End:
+*/
+
+#endif  // SR_EDC_ETHERCAT_DRIVERS_CAN_BRIDGE_CAPTURE_H
@@ -0,0 +1,159 @@
+/**
+ * @file   can_bridge_requests.h
+ * @author Shadow Robot Software Team <software@shadowrobot.com>
+ * @date   Sun Oct 18 21:02:36 2026
+*
+* Copyright 2026 Shadow Robot Company Ltd.
+*
+* This program is free software: you can redistribute it and/or modify it
+* under the terms of the GNU General Public License as published by the Free
+* Software Foundation, either version 2 of the License, or (at your option)
+* any later version.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+* more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+ *
+ * @brief Asynchronous requests sent through the EtherCAT CAN bridge.
+ *
+ * Any thread can submit a CAN message with a predicate recognising its
+ * reply, and gets a future (or a callback) completed with the reply, or
+ * with a failure once the timeout expires. Any number of requests can be
+ * pending on both CAN buses at the same time.
+ *
+ * The realtime loop only pops the messages to send from a lock-free queue,
+ * one per frame, and pushes the CAN messages received to another one. A
+ * background thread matches the replies with the pending requests and
+ * handles the timeouts.
+ *
+ * \code
+ *   boost::unique_future<CanBridgeReply> reply =
+ *     requests.submit(message, &CanBridgeRequests::is_ack, 100);
+ *   if (reply.get().success) ...
+ * \endcode
+ *
+ */
+
+#ifndef SR_EDC_ETHERCAT_DRIVERS_CAN_BRIDGE_REQUESTS_H
+#define SR_EDC_ETHERCAT_DRIVERS_CAN_BRIDGE_REQUESTS_H
+
+#include <boost/atomic.hpp>
+#include <boost/function.hpp>
+#include <boost/lockfree/queue.hpp>
+#include <boost/smart_ptr.hpp>
+#include <boost/thread.hpp>
+#include <boost/utility.hpp>
+#include <ros/ros.h>
+#include <list>
+
+#include <sr_external_dependencies/types_for_external.h>
+
+extern "C"
+{
+#include <sr_external_dependencies/external/common/ethercat_can_bridge_protocol.h>
+}
+
+namespace sr_edc_ethercat_drivers
+{
+  struct CanBridgeReply
+  {
+    /// false if no reply was received before the timeout (or the request couldn't be queued)
+    bool success;
+    /// the reply (only valid on success)
+    ETHERCAT_CAN_BRIDGE_DATA message;
+  };
+
+  class CanBridgeRequests :
+          private boost::noncopyable
+  {
+  public:
+    /// Recognises the reply to a request (called from the background thread).
+    typedef boost::function<bool(const ETHERCAT_CAN_BRIDGE_DATA &request,
+                                 const ETHERCAT_CAN_BRIDGE_DATA &reply)> ReplyPredicate;
+    /// Called from the background thread when the request completes.
+    typedef boost::function<void(const CanBridgeReply &reply)> ReplyCallback;
+
+    /// maximum number of messages waiting to be sent, and of messages received waiting to be matched
+    static const unsigned int queue_size = 64;
+
+    CanBridgeRequests();
+
+    ~CanBridgeRequests();
+
+    // Any thread
+
+    /**
+     * Queues a request.
+     *
+     * @param request the CAN message to send (its can_bus is 1 or 2)
+     * @param is_reply recognises the reply among the CAN messages received on the same bus
+     * @param timeout maximum time (in ms) to wait for the reply
+     *
+     * @return the future reply
+     */
+    boost::unique_future<CanBridgeReply> submit(const ETHERCAT_CAN_BRIDGE_DATA &request, ReplyPredicate is_reply,
+                                                unsigned int timeout);
+
+    /// Same as above, the callback is called from the background thread instead.
+    void submit(const ETHERCAT_CAN_BRIDGE_DATA &request, ReplyPredicate is_reply, unsigned int timeout,
+                ReplyCallback callback);
+
+    /// The usual ack of the boards: same id with the ack bit (0x10) set, same length and data.
+    static bool is_ack(const ETHERCAT_CAN_BRIDGE_DATA &request, const ETHERCAT_CAN_BRIDGE_DATA &reply);
+
+    // Realtime loop
+
+    /**
+     * Gets the next message to send. Never blocks.
+     *
+     * @return false if there's nothing to send
+     */
+    bool next_request(ETHERCAT_CAN_BRIDGE_DATA *message);
+
+    /// A CAN message was received through the bridge. Never blocks, dropped if no request is pending.
+    void message_received(const ETHERCAT_CAN_BRIDGE_DATA &message);
+
+  private:
+    struct PendingRequest
+    {
+      ETHERCAT_CAN_BRIDGE_DATA message;
+      ReplyPredicate is_reply;
+      ReplyCallback callback;
+      ros::WallTime deadline;
+    };
+
+    /// Matches the messages received with the pending requests, and fails the expired ones.
+    void matching_loop();
+
+    void match_replies();
+
+    static void fulfil(boost::shared_ptr<boost::promise<CanBridgeReply> > promise, const CanBridgeReply &reply);
+
+    static const boost::posix_time::time_duration matching_period_;
+
+    boost::lockfree::queue<ETHERCAT_CAN_BRIDGE_DATA, boost::lockfree::capacity<queue_size> > to_send_;
+    boost::lockfree::queue<ETHERCAT_CAN_BRIDGE_DATA, boost::lockfree::capacity<queue_size> > received_;
+
+    /// the realtime loop only pushes the messages received while a request is pending
+    boost::atomic<unsigned int> nb_pending_;
+
+    /// oldest first (protected by pending_mutex_)
+    std::list<PendingRequest> pending_;
+    boost::mutex pending_mutex_;
+
+    boost::shared_ptr<boost::thread> matching_thread_;
+  };
+}  // namespace sr_edc_ethercat_drivers
+
+/* For the emacs weenies in the crowd.
+Local Variables:
+   c-basic-offset: 2
+End:
+*/
+
+#endif  // SR_EDC_ETHERCAT_DRIVERS_CAN_BRIDGE_REQUESTS_H
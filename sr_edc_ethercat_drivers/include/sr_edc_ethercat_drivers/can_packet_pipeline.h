@@ -0,0 +1,177 @@
+/**
+ * @file   can_packet_pipeline.h
+ * @author Shadow Robot Software Team <software@shadowrobot.com>
+ * @date   Sun Oct 18 19:21:07 2026
+*
+* Copyright 2026 Shadow Robot Company Ltd.
+*
+* This program is free software: you can redistribute it and/or modify it
+* under the terms of the GNU General Public License as published by the Free
+* Software Foundation, either version 2 of the License, or (at your option)
+* any later version.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+* more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+ *
+ * @brief A sequence of CAN packets sent through the EtherCAT CAN bridge,
+ *        one packet in flight at a time.
+ *
+ * The flashing thread fills the pipeline and calls run(). From then on the
+ * realtime loop drives it: it sends a packet, and as soon as the ack is
+ * received it sends the next packet in the very next frame. The flashing
+ * thread sleeps on a semaphore until the last packet is acked, or until
+ * no packet has been acked for the timeout.
+ *
+ * A packet can also be sent without waiting for its ack (the data packets of
+ * a streamed write): the next packet is then sent in the next frame, and the
+ * ack of a later packet acknowledges it as well.
+ *
+ */
+
+#ifndef SR_EDC_ETHERCAT_DRIVERS_CAN_PACKET_PIPELINE_H
+#define SR_EDC_ETHERCAT_DRIVERS_CAN_PACKET_PIPELINE_H
+
+#include <boost/atomic.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/utility.hpp>
+#include <semaphore.h>
+
+#include <sr_external_dependencies/types_for_external.h>
+
+extern "C"
+{
+#include <sr_external_dependencies/external/common/ethercat_can_bridge_protocol.h>
+}
+
+namespace sr_edc_ethercat_drivers
+{
+  class CanPacketPipeline :
+          private boost::noncopyable
+  {
+  public:
+    /// 12 blocks of the flashing protocol (1 address + 4 data packets)
+    static const unsigned int max_packets = 60;
+
+    struct Packet
+    {
+      ETHERCAT_CAN_BRIDGE_DATA message;
+      /// for a READ_FLASH_COMMAND or CRC_FLASH_COMMAND: the data the reply must contain, NULL otherwise
+      const unsigned char *expected_read;
+      /// false if the next packet is sent without waiting for an ack of this one
+      bool needs_ack;
+    };
+
+    CanPacketPipeline();
+
+    ~CanPacketPipeline();
+
+    // Flashing thread
+
+    /// Empties the pipeline. Must not be called while run() is in progress.
+    void clear();
+
+    /**
+     * Appends a packet to the pipeline. The last packet must need an ack.
+     *
+     * @return false if the pipeline is full
+     */
+    bool add(const ETHERCAT_CAN_BRIDGE_DATA &message, const unsigned char *expected_read = NULL,
+             bool needs_ack = true);
+
+    unsigned int size() const
+    {
+      return nb_packets_;
+    }
+
+    bool full() const
+    {
+      return nb_packets_ == max_packets;
+    }
+
+    /**
+     * Has the packets sent by the realtime loop and waits for their acks.
+     *
+     * @param timeout maximum time (in ms) without receiving any ack
+     * @param failed if not NULL, set to true if the run was stopped by packet_failed() rather than a timeout
+     *
+     * @return the number of packets acked (a packet sent without waiting for its ack only
+     *         counts once a later packet is acked), size() if they were all acked
+     */
+    unsigned int run(unsigned int timeout, bool *failed = NULL);
+
+    // Realtime loop
+
+    /**
+     * Gets the packet to send in this frame. Never blocks.
+     *
+     * @param packet where the packet to send is copied
+     *
+     * @return false if there's nothing to send (idle or waiting for an ack)
+     */
+    bool next_packet(Packet *packet);
+
+    /// Whether a packet was sent and its ack is expected.
+    bool waiting_for_ack();
+
+    /**
+     * The packet in flight was acked: the next one will be sent in the next frame.
+     * If the flashing thread holds the lock, the ack is recorded and applied the next time
+     * the realtime loop gets it.
+     */
+    void packet_acked();
+
+    /// The reply shows the packet in flight failed (e.g. the data read back is wrong): stops the run.
+    void packet_failed();
+
+  private:
+    enum State
+    {
+      IDLE,
+      RUNNING,
+      DONE,
+      FAILED
+    };
+
+    /// Ends the run, from the realtime loop.
+    void finish(State state);
+
+    /// Applies the ack recorded by packet_acked() while the lock was taken (called with mutex_ held).
+    void apply_pending_ack();
+
+    /// Moves on to the next packet if one is in flight (called with mutex_ held).
+    void ack_in_flight();
+
+    Packet packets_[max_packets];
+    unsigned int nb_packets_;
+
+    /// next packet to send (protected by mutex_)
+    unsigned int current_;
+    /// the current packet was sent and we're waiting for its ack (protected by mutex_)
+    bool in_flight_;
+
+    /// taken by the flashing thread while it modifies the pipeline, the realtime loop only tries it
+    boost::mutex mutex_;
+
+    boost::atomic<int> state_;
+    boost::atomic<unsigned int> nb_acked_;
+    /// an ack received while the flashing thread held mutex_
+    boost::atomic<bool> pending_ack_;
+
+    /// posted by the realtime loop at the end of a run, never blocks it
+    sem_t finished_;
+  };
+}  // namespace sr_edc_ethercat_drivers
+
+/* For the emacs weenies in the crowd.
+Local Variables:
+   c-basic-offset: 2
+End:
+*/
+
+#endif  // SR_EDC_ETHERCAT_DRIVERS_CAN_PACKET_PIPELINE_H
@@ -0,0 +1,100 @@
+/**
+ * @file   firmware_loader.h
+ * @author Shadow Robot Software Team <software@shadowrobot.com>
+ * @date   Sun Oct 18 22:15:53 2026
+*
+* Copyright 2026 Shadow Robot Company Ltd.
+*
+* This program is free software: you can redistribute it and/or modify it
+* under the terms of the GNU General Public License as published by the Free
+* Software Foundation, either version 2 of the License, or (at your option)
+* any later version.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+* more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+ *
+ * @brief Parses the motor firmwares from their object (.hex) files.
+ *
+ * Only used by the motor_flasher node: libbfd is kept out of the realtime
+ * process, the driver only receives the parsed firmware.
+ *
+ */
+
+#ifndef SR_EDC_ETHERCAT_DRIVERS_FIRMWARE_LOADER_H
+#define SR_EDC_ETHERCAT_DRIVERS_FIRMWARE_LOADER_H
+
+#include <sr_edc_ethercat_drivers/MotorFirmware.h>
+#include <bfd.h>
+#include <time.h>
+#include <map>
+#include <string>
+
+namespace sr_edc_ethercat_drivers
+{
+  class FirmwareLoader
+  {
+  public:
+    /**
+     * Reads the firmware from an object (.hex) file. The firmware is only parsed again
+     * if the file was modified since it was last loaded.
+     *
+     * @param path the path of the file
+     * @param firmware where the firmware is stored
+     *
+     * @return false if the file couldn't be parsed
+     */
+    bool load(const std::string &path, MotorFirmware *firmware);
+
+  private:
+    struct CachedFirmware
+    {
+      time_t modified;
+      MotorFirmware firmware;
+    };
+
+    bool parse(const std::string &path, MotorFirmware *firmware);
+
+    /**
+     * Look for the start and end address of every section in the hex file,
+     * to detect the lowest and highest address of the data we need to write in the PIC's flash.
+     * The sections starting at an address higher than 0x7fff will be ignored as they are not proper "code memory" firmware
+     * (they can contain the CONFIG bits of the microcontroller, which we don't want to write here)
+     * To understand the structure (sections) of the object file containing the firmware (usually a .hex) the following commands can be useful:
+     *   \code objdump -x simplemotor.hex \endcode
+     *   \code objdump -s simplemotor.hex \endcode
+     *
+     * @param fd pointer to a bfd file structure
+     * @param smallest_start_address the lowest address found is returned through this pointer
+     * @param biggest_end_address the highest address found is returned through this pointer
+     */
+    static void find_address_range(bfd *fd, unsigned int *smallest_start_address, unsigned int *biggest_end_address);
+
+    /**
+     * Reads the content from the object (.hex) file and stores it in a previously reserved memory space
+     *
+     * @param fd pointer to a bfd file structure
+     * @param content a pointer to the memory space where we want to store the firmware
+     * @param base_addr the base address of the code (the lowest address to be written on the flash)
+     *
+     * @return true if the reading succeeds
+     */
+    static bool read_content_from_object_file(bfd *fd, bfd_byte *content, unsigned int base_addr);
+
+    /// the firmwares already parsed, by path
+    std::map<std::string, CachedFirmware> cache_;
+  };
+}  // namespace sr_edc_ethercat_drivers
+
+/* For the emacs weenies in the crowd.
+Local Variables:
+   c-basic-offset: 2
+End:
+*/
+
+#endif  // SR_EDC_ETHERCAT_DRIVERS_FIRMWARE_LOADER_H
@@ -34,7 +34,6 @@
 #include <std_msgs/Float64MultiArray.h>
 #include <sr_robot_msgs/SimpleMotorFlasher.h>
 #include <pthread.h>
-#include <bfd.h>
 #include <boost/smart_ptr.hpp>
 #include <map>
 #include <vector>
@@ -99,13 +98,19 @@ private:
           ETHERCAT_DATA_STRUCTURE_0200_PALM_EDC_COMMAND> > sr_hand_lib;
 
   /**
-   *a counter used to publish the tactiles at 100Hz:
-   * count 10 cycles, then reset the cycle_count to 0.
+   * a counter used to publish the tactiles at publishing_rate (100Hz by default):
+   * count publishing_cycles_ cycles, then reset the cycle_count to 0.
    */
-  int16_t cycle_count;
+  unsigned int cycle_count;
+
+  /// How many cycles between two publications, from the ~publishing_rate and the cycle period
+  unsigned int publishing_cycles_;
 
   /// Debug real time publisher: publishes the raw ethercat data
   boost::shared_ptr<realtime_tools::RealtimePublisher<sr_robot_msgs::EthercatDebug> > debug_publisher;
+
+  /// Copy of the hand state used by the diagnostics
+  shadow_robot::HandStateSnapshot diagnostics_snapshot_;
 };
 
 
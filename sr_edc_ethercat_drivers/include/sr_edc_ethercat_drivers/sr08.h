@@ -34,7 +34,6 @@
 #include <std_msgs/Float64MultiArray.h>
 #include <sr_robot_msgs/SimpleMotorFlasher.h>
 #include <pthread.h>
-#include <bfd.h>
 #include <boost/smart_ptr.hpp>
 #include <map>
 #include <vector>
@@ -99,13 +98,26 @@ private:
           ETHERCAT_DATA_STRUCTURE_0230_PALM_EDC_COMMAND> > sr_hand_lib;
 
   /**
-   *a counter used to publish the tactiles at 100Hz:
-   * count 10 cycles, then reset the cycle_count to 0.
+   * a counter used to publish the tactiles at publishing_rate (100Hz by default):
+   * count publishing_cycles_ cycles, then reset the cycle_count to 0.
    */
-  int16_t cycle_count;
+  unsigned int cycle_count;
+
+  /// How many cycles between two publications, from the ~publishing_rate and the cycle period
+  unsigned int publishing_cycles_;
+
+  /// Was the status in prev_buffer decoded? (the tactile data are only compared to a decoded status)
+  bool prev_status_decoded_;
 
   /// Debug real time publisher: publishes the raw ethercat data
   boost::shared_ptr<realtime_tools::RealtimePublisher<sr_robot_msgs::EthercatDebug> > debug_publisher;
+
+  /// The name and hardware id of the palm diagnostics, built on the first diagnostics call
+  std::string diagnostics_name_;
+  std::string diagnostics_hardware_id_;
+
+  /// Copy of the hand state used by the diagnostics
+  shadow_robot::HandStateSnapshot diagnostics_snapshot_;
 };
 
 
@@ -0,0 +1,136 @@
+/**
+ * @file   sr10.h
+ * @author Shadow Robot Software Team <software@shadowrobot.com>
+ * @date   Sun Oct 18 23:58:06 2026
+ *
+ * Copyright 2026 Shadow Robot Company Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @brief This is a ROS driver for Shadow Robot #10 EtherCAT product ID
+ *
+ * The 0240 palm is the 0230 palm (SR08) returning the data of all the motors
+ * in every frame, instead of the even and the odd motors in turns.
+ *
+ */
+
+#ifndef SR_EDC_ETHERCAT_DRIVERS_SR10_H
+#define SR_EDC_ETHERCAT_DRIVERS_SR10_H
+
+#include <ros_ethercat_hardware/ethercat_hardware.h>
+#include <sr_edc_ethercat_drivers/sr_edc.h>
+#include <realtime_tools/realtime_publisher.h>
+#include <std_msgs/Int16.h>
+#include <std_msgs/Float64MultiArray.h>
+#include <sr_robot_msgs/SimpleMotorFlasher.h>
+#include <pthread.h>
+#include <boost/smart_ptr.hpp>
+#include <map>
+#include <vector>
+#include <boost/assign.hpp>
+#include <boost/algorithm/string.hpp>
+#include <boost/algorithm/string/find_iterator.hpp>
+
+#include <sr_robot_lib/sr_motor_hand_lib.hpp>
+
+#include <sr_robot_msgs/EthercatDebug.h>
+
+#include <sr_external_dependencies/types_for_external.h>
+
+extern "C"
+{
+#include <sr_external_dependencies/external/0240_palm_edc_TS/0240_palm_edc_ethercat_protocol.h>
+}
+
+class SR10 :
+        public SrEdc
+{
+public:
+  SR10();
+
+  virtual void construct(EtherCAT_SlaveHandler *sh, int &start_address);
+
+  virtual int initialize(hardware_interface::HardwareInterface *hw, bool allow_unprogrammed = true);
+
+  virtual void multiDiagnostics(vector<diagnostic_msgs::DiagnosticStatus> &vec, unsigned char *buffer);
+
+  virtual void packCommand(unsigned char *buffer, bool halt, bool reset);
+
+  virtual bool unpackState(unsigned char *this_buffer, unsigned char *prev_buffer);
+
+protected:
+  typedef realtime_tools::RealtimePublisher<std_msgs::Int16> rt_pub_int16_t;
+  std::vector<boost::shared_ptr<rt_pub_int16_t> > realtime_pub_;
+
+  /// Extra analog inputs real time publisher (+ accelerometer and gyroscope)
+  boost::shared_ptr<realtime_tools::RealtimePublisher<std_msgs::Float64MultiArray> > extra_analog_inputs_publisher;
+
+  /// This function will call the reinitialization function for the boards attached to the CAN bus
+  virtual void reinitialize_boards();
+
+  /**
+   * Given the identifier for a certain board (motor board/ muscle driver) determines the right value
+   * for the CAN bus and the ID of the board in that CAN bus.
+   *
+   * @param board_id the unique identifier for the board
+   * @param can_bus pointer to the can bus number we want to determine
+   * @param board_can_id pointer to the board id we want to determine
+   */
+  virtual void get_board_id_and_can_bus(int board_id, int *can_bus, unsigned int *board_can_id);
+
+private:
+  // std::string                      firmware_file_name;
+
+  // counter for the number of empty buffer we're reading.
+  unsigned int zero_buffer_read;
+
+  boost::shared_ptr<shadow_robot::SrMotorHandLib<ETHERCAT_DATA_STRUCTURE_0240_PALM_EDC_STATUS,
+          ETHERCAT_DATA_STRUCTURE_0240_PALM_EDC_COMMAND> > sr_hand_lib;
+
+  /**
+   * a counter used to publish the tactiles at publishing_rate (100Hz by default):
+   * count publishing_cycles_ cycles, then reset the cycle_count to 0.
+   */
+  unsigned int cycle_count;
+
+  /// How many cycles between two publications, from the ~publishing_rate and the cycle period
+  unsigned int publishing_cycles_;
+
+  /// The cycle period sent to the palm, which schedules its frame with it (in microseconds)
+  int16u frame_period_us_;
+
+  /// Was the status in prev_buffer decoded? (the tactile data are only compared to a decoded status)
+  bool prev_status_decoded_;
+
+  /// Debug real time publisher: publishes the raw ethercat data
+  boost::shared_ptr<realtime_tools::RealtimePublisher<sr_robot_msgs::EthercatDebug> > debug_publisher;
+
+  /// The name and hardware id of the palm diagnostics, built on the first diagnostics call
+  std::string diagnostics_name_;
+  std::string diagnostics_hardware_id_;
+
+  /// Copy of the hand state used by the diagnostics
+  shadow_robot::HandStateSnapshot diagnostics_snapshot_;
+};
+
+
+/* For the emacs weenies in the crowd.
+Local Variables:
+   c-basic-offset: 2
+End:
+ */
+
+
+#endif  // SR_EDC_ETHERCAT_DRIVERS_SR10_H
+
@@ -34,19 +34,24 @@
 
 #include <ros_ethercat_hardware/ethercat_hardware.h>
 #include <sr_edc_ethercat_drivers/sr0x.h>
+#include <sr_edc_ethercat_drivers/can_packet_pipeline.h>
+#include <sr_edc_ethercat_drivers/can_bridge_requests.h>
+#include <sr_edc_ethercat_drivers/can_bridge_capture.h>
 #include <realtime_tools/realtime_publisher.h>
 #include <std_msgs/Int16.h>
 #include <std_msgs/Float64MultiArray.h>
-#include <sr_robot_msgs/SimpleMotorFlasher.h>
+#include <sr_edc_ethercat_drivers/FlashMotorFirmware.h>
+#include <sr_edc_ethercat_drivers/MotorFirmware.h>
+#include <sr_edc_ethercat_drivers/CanBridgeRequest.h>
+#include <sr_edc_ethercat_drivers/MotorFlashResult.h>
 #include <pthread.h>
-#include <bfd.h>
 #include <boost/smart_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/atomic.hpp>
 #include <map>
 #include <string>
 #include <vector>
 #include <boost/assign.hpp>
-#include <boost/algorithm/string.hpp>
-#include <boost/algorithm/string/find_iterator.hpp>
 #include <sr_robot_msgs/EthercatDebug.h>
 
 #include <sr_external_dependencies/types_for_external.h>
@@ -70,17 +75,28 @@ public:
                          unsigned int ethercat_can_bridge_data_command_address,
                          unsigned int ethercat_can_bridge_data_status_address);
 
-  bool simple_motor_flasher(sr_robot_msgs::SimpleMotorFlasher::Request &req,
-                            sr_robot_msgs::SimpleMotorFlasher::Response &res);
-
-  void build_CAN_message(ETHERCAT_CAN_BRIDGE_DATA *message);
+  /**
+   * ROS service flashing a firmware to several motors, a motor on each CAN bus at the same time.
+   * The firmware is parsed by the motor_flasher node, which provides the SimpleMotorFlasher and
+   * BulkMotorFlasher services: libbfd and the file system stay out of the realtime process.
+   */
+  bool flash_motor_firmware(sr_edc_ethercat_drivers::FlashMotorFirmware::Request &req,
+                            sr_edc_ethercat_drivers::FlashMotorFirmware::Response &res);
 
-  bool can_data_is_ack(ETHERCAT_CAN_BRIDGE_DATA *packet);
+  /**
+   * ROS service sending a CAN message to a board and waiting for its reply. The requests are
+   * asynchronous: several calls (from several threads) can be pending at the same time.
+   */
+  bool can_bridge_request(sr_edc_ethercat_drivers::CanBridgeRequest::Request &req,
+                          sr_edc_ethercat_drivers::CanBridgeRequest::Response &res);
 
-  void erase_flash();
+  /// Asynchronous requests to the boards, sent through the CAN bridge (after the flashing packets).
+  sr_edc_ethercat_drivers::CanBridgeRequests &can_bridge_requests()
+  {
+    return can_bridge_requests_;
+  }
 
-  // bool read_flash(unsigned int offset, unsigned char baddrl, unsigned char baddrh, unsigned char baddru);
-  bool read_flash(unsigned int offset, unsigned int baddr);
+  void build_CAN_message(ETHERCAT_CAN_BRIDGE_DATA *message);
 
 protected:
   int counter_;
@@ -94,11 +110,42 @@ protected:
   boost::shared_ptr<realtime_tools::RealtimePublisher<std_msgs::Float64MultiArray> > extra_analog_inputs_publisher;
 
   bool flashing;
-  bool can_packet_acked;
+
+  /**
+   * Whether the palm firmware can send the CAN bridge packets in the sensor data frames. If it
+   * can, the rest of the hand keeps running while a motor is being flashed.
+   */
+  boost::atomic<bool> flash_while_streaming_;
+  /**
+   * While flashing, the CAN bridge packets are sent in CAN direct mode, which stops the sensor data.
+   * Read by the realtime loop while the flashing threads of both buses can switch to it.
+   */
+  boost::atomic<bool> can_direct_mode_;
+
+  /**
+   * The CAN bridge command and status aren't mapped in the process data (~compact_process_data):
+   * the frames are shorter, but the motors can't be flashed nor the CAN bridge requests sent.
+   */
+  bool compact_process_data_;
 
   std::string device_id_;
   std::string device_joint_prefix_;
 
+  /**
+   * Called from unpackState() with the CAN message received: moves the flashing pipeline to the
+   * next packet if it's the ack of the packet in flight, and passes it to the CAN bridge requests.
+   *
+   * @param packet the CAN message received in this frame
+   */
+  void check_CAN_reply(ETHERCAT_CAN_BRIDGE_DATA *packet);
+
+  /**
+   * Advertises the CanBridgeRequest service. Called by the drivers of the palms which send the
+   * CAN bridge packets in the sensor data frames, once flash_while_streaming_ is set (the other
+   * palms only forward them in CAN direct mode, the requests would time out).
+   */
+  void advertise_can_bridge_request();
+
   /// This function will call the reinitialization function for the boards attached to the CAN bus
   virtual void reinitialize_boards() = 0;
 
@@ -113,6 +160,38 @@ protected:
   virtual void get_board_id_and_can_bus(int board_id, int *can_bus, unsigned int *board_can_id) = 0;
 
 private:
+  /// The state of the flashing on one of the 2 CAN buses
+  struct FlashingBus
+  {
+    /// the CAN packets to send on this bus, driven by the acks received in the realtime loop
+    sr_edc_ethercat_drivers::CanPacketPipeline pipeline;
+    /// the last packet sent on this bus, only used from the realtime loop
+    sr_edc_ethercat_drivers::CanPacketPipeline::Packet in_flight;
+    /// 1 or 2, as given by get_board_id_and_can_bus()
+    int can_bus;
+    /// the id of the board being flashed on this bus
+    unsigned int motor;
+    /// the bootloader of the board supports the streamed write
+    bool streaming;
+  };
+
+  /// The firmware to flash, as parsed from the object (.hex) file by the motor_flasher node
+  struct FirmwareImage
+  {
+    /// the base address of the code (the lowest address to be written on the flash)
+    unsigned int base_addr;
+    /// the size in bytes of the code to write
+    unsigned int total_size;
+    /// the code, padded with 0xFF (total_size + 8 bytes)
+    std::vector<unsigned char> content;
+
+    /// The byte of the firmware at this flash address, 0xFF (erased) outside of the firmware.
+    unsigned char at(unsigned int address) const;
+
+    /// The CRC-16-CCITT of the flash once the firmware is written, as computed by the CRC_FLASH_COMMAND.
+    int16u crc(unsigned int address, unsigned int length) const;
+  };
+
   // static const unsigned int        nb_sensors_const;
   static const unsigned int max_retry;
   // static const unsigned short int  max_iter_const;
@@ -120,92 +199,167 @@ private:
   // static const unsigned short int  device_pub_freq_const;
   // static const unsigned char       nb_publish_by_unpack_const;
   // std::string                      firmware_file_name;
-  pthread_mutex_t producing;
-  ros::ServiceServer serviceServer;
+  ros::ServiceServer flash_motor_firmware_server_;
+  ros::ServiceServer can_bridge_request_server_;
+
+  sr_edc_ethercat_drivers::CanBridgeRequests can_bridge_requests_;
+
+  /// Capture of all the CAN bridge messages (started if the ~can_capture_file parameter is set)
+  sr_edc_ethercat_drivers::CanBridgeCapture can_bridge_capture_;
 
+  /// only one of the flashing services can run at a time
+  boost::mutex flashing_mutex_;
 
-  ETHERCAT_CAN_BRIDGE_DATA can_message_;
-  bool can_message_sent;
-  bfd_byte *binary_content;  // buffer containing the binary content to be flashed
-  unsigned int pos;  // position in binary_content buffer
-  unsigned int motor_being_flashed;
+  /// one per CAN bus, so that a motor can be flashed on each bus at the same time
+  FlashingBus flashing_buses_[2];
+  /// the bus which gets to send a packet first in the next frame (only used from the realtime loop)
+  unsigned int next_flashing_bus_;
 
+  /// Only write the rows of the flash which differ from the firmware (if the bootloader supports it).
+  bool differential_flashing_;
 
-  // We're using 2 can busses, so can_bus_ is 1 for motors 0 to 9 and 2 for motors 10 to 19
-  int can_bus_;
+  /// Gets the flashing state of the CAN bus of a board, and sets the board being flashed on it.
+  FlashingBus &get_flashing_bus(int board_id);
 
   /**
-   * Contains the common procedure to send a CAN message (i.e. write it in the global struct from which it is read, added to the
-   * next ethercat frame, and sent) and wait for the can_packet_acked flag to be set
+   * Flashes a motor: switches it to bootloader mode, writes and verifies the firmware, and resets it.
+   * Only the rows of the flash which differ from the firmware are written if the bootloader can compute
+   * the CRC of its flash, otherwise the whole flash is erased and written.
+   * Only uses the flashing pipeline of its CAN bus, so it can run in parallel with a motor on the other bus.
    *
-   * @param can_bus which of the 2 CAN buses (0 or 1) wil be used
-   * @param msg_id id of the CAN message
-   * @param msg_length the length in bytes of msg_data
-   * @param msg_data data of the CAN message
-   * @param timeout time max (in ms) to wait for the can_packet_acked flag to be set
-   * @param timedout if true, the can_packet_acked flag wasn't set before the timeout
+   * @param bus the CAN bus of the motor, with the id of the motor set
+   * @param firmware the firmware to write
+   * @param result the time spent in each phase, and the error if it failed
+   *
+   * @return true if the firmware was written and verified
+   */
+  bool flash_motor(FlashingBus &bus, const FirmwareImage &firmware, sr_edc_ethercat_drivers::MotorFlashResult *result);
+
+  /// Erases the flash, then writes and reads back the whole firmware.
+  bool flash_whole_firmware(FlashingBus &bus, const FirmwareImage &firmware,
+                            sr_edc_ethercat_drivers::MotorFlashResult *result);
+
+  /// Compares the CRC of the flash with the firmware, and only erases and writes the rows which differ.
+  bool flash_modified_rows(FlashingBus &bus, const FirmwareImage &firmware,
+                           sr_edc_ethercat_drivers::MotorFlashResult *result);
+
+  /// Whether the bootloader of the motor replies to the CRC_FLASH_COMMAND (older ones don't).
+  bool bootloader_supports_crc(FlashingBus &bus);
+
+  /// Whether the bootloader of the motor replies to the STREAM_WRITE_HEADER_COMMAND (older ones don't).
+  bool bootloader_supports_streaming(FlashingBus &bus);
+
+  /**
+   * Compares the CRC of regions of the flash, computed by the bootloader, with the CRC of the firmware.
+   *
+   * @param bus the CAN bus of the motor being flashed
+   * @param firmware the firmware to compare with
+   * @param start the address of the first region
+   * @param end the end of the last region
+   * @param region_size the size in bytes of the regions
+   * @param modified the addresses of the regions which differ are appended to this
+   *
+   * @return false if too many packets were lost
    */
-  void send_CAN_msg(int8u can_bus, int16u msg_id, int8u msg_length, int8u msg_data[], int timeout, bool *timedout);
+  bool find_modified_regions(FlashingBus &bus, const FirmwareImage &firmware, unsigned int start, unsigned int end,
+                             unsigned int region_size, std::vector<unsigned int> *modified);
 
   /**
-   * Read back the firmware from the flash of the PIC, and checks it against the data read from the object (.hex) file
+   * Erases and writes rows of 64 bytes of the flash.
    *
-   * @param baddr the base address of the code (the lowest address to be written on the flash)
-   * @param total_size the size in bytes of the code to write
+   * @param bus the CAN bus of the motor being flashed
+   * @param firmware the firmware to write
+   * @param rows the addresses of the rows
    *
-   * @return true if both are identical
+   * @return true if the writing process succeeds
    */
-  bool read_back_and_check_flash(unsigned int baddr, unsigned int total_size);
+  bool write_flash_rows(FlashingBus &bus, const FirmwareImage &firmware, const std::vector<unsigned int> &rows);
+
+  /// Flashes a list of motors of the same CAN bus one after the other.
+  void flash_motors(const FirmwareImage *firmware, const std::vector<int> *board_ids,
+                    std::vector<sr_edc_ethercat_drivers::MotorFlashResult> *results);
 
   /**
-   * Look for the start and end address of every section in the hex file,
-   * to detect the lowest and highest address of the data we need to write in the PIC's flash.
-   * The sections starting at an address higher than 0x7fff will be ignored as they are not proper "code memory" firmware
-   * (they can contain the CONFIG bits of the microcontroller, which we don't want to write here)
-   * To understand the structure (sections) of the object file containing the firmware (usually a .hex) the following commands can be useful:
-   *   \code objdump -x simplemotor.hex \endcode
-   *   \code objdump -s simplemotor.hex \endcode
+   * Checks the firmware received by the FlashMotorFirmware service, and pads it for the writing.
+   *
+   * @param image the parsed firmware
+   * @param firmware where the firmware is stored
    *
-   * @param fd pointer to a bfd file structure
-   * @param smallest_start_address the lowest address found is returned through this pointer
-   * @param biggest_end_address the highest address found is returned through this pointer
+   * @return false if the firmware is empty or doesn't fit in the code memory
    */
-  void find_address_range(bfd *fd, unsigned int *smallest_start_address, unsigned int *biggest_end_address);
+  bool set_firmware(const sr_edc_ethercat_drivers::MotorFirmware &image, FirmwareImage *firmware);
 
   /**
-   * Reads the content from the object (.hex) file and stores it in a previously reserved memory space
+   * Sends an ERASE_FLASH_COMMAND until it's acknowledged.
    *
-   * @param fd pointer to a bfd file structure
-   * @param content a pointer to the memory space where we want to store the firmware
-   * @param base_addr the base address of the code (the lowest address to be written on the flash)
+   * @return false if the motor never acknowledged it
+   */
+  bool erase_flash(FlashingBus &bus);
+
+  /**
+   * Contains the common procedure to send a CAN message (i.e. put it in the flashing pipeline from which it is read, added to the
+   * next ethercat frame, and sent) and wait for its ack
    *
-   * @return true if the reading succeeds
+   * @param bus which of the 2 CAN buses will be used
+   * @param msg_id id of the CAN message
+   * @param msg_length the length in bytes of msg_data
+   * @param msg_data data of the CAN message
+   * @param timeout time max (in ms) to wait for the ack
+   * @param timedout if true, the message wasn't acked before the timeout
    */
-  bool read_content_from_object_file(bfd *fd, bfd_byte *content, unsigned int base_addr);
+  void send_CAN_msg(FlashingBus &bus, int16u msg_id, int8u msg_length, int8u msg_data[], int timeout, bool *timedout);
+
+  /// Builds a bootloader command for the motor being flashed on the bus, with length bytes of zeroed data.
+  ETHERCAT_CAN_BRIDGE_DATA bootloader_command(const FlashingBus &bus, int8u command, int8u length) const;
+
+  /// Builds a bootloader command for the motor being flashed on the bus, carrying a flash address.
+  ETHERCAT_CAN_BRIDGE_DATA bootloader_address_command(const FlashingBus &bus, int8u command,
+                                                      unsigned int address) const;
+
+  /// Whether the CAN message is the reply to the READ_FLASH_COMMAND or CRC_FLASH_COMMAND in flight on the bus.
+  bool is_data_reply(const FlashingBus &bus, ETHERCAT_CAN_BRIDGE_DATA *packet);
+
+  /// Whether the data reply echoes the address and length of the request in flight (only the CRC replies do).
+  bool data_reply_echoes_request(const FlashingBus &bus, ETHERCAT_CAN_BRIDGE_DATA *packet);
+
+  /**
+   * Checks if the CAN message received is an ack of the packet in flight on the bus.
+   *
+   * @return true if packet is an ACK of the packet in flight.
+   */
+  bool can_data_is_ack(const FlashingBus &bus, ETHERCAT_CAN_BRIDGE_DATA *packet);
+
+  /**
+   * Read back the firmware from the flash of the PIC, and checks it against the data read from the object (.hex) file
+   *
+   * @param bus the CAN bus of the motor being flashed
+   * @param firmware the firmware which was written
+   *
+   * @return true if both are identical
+   */
+  bool read_back_and_check_flash(FlashingBus &bus, const FirmwareImage &firmware);
 
   /**
    * Writes the code previously read from the hex file to the flash memory of the PIC
    *
-   * @param base_addr the base address of the code (the lowest address to be written on the flash)
-   * @param total_size the size in bytes of the code to write
+   * @param bus the CAN bus of the motor being flashed
+   * @param firmware the firmware to write
    *
    * @return true if the writing process succeeds
    */
-  bool write_flash_data(unsigned int base_addr, unsigned int total_size);
+  bool write_flash_data(FlashingBus &bus, const FirmwareImage &firmware);
 
   /**
-   * Extract the filename from the full path.
+   * Adds the packets writing consecutive blocks of 32 bytes to the flashing pipeline of the bus:
+   * streamed if the bootloader supports it, one acked address and 4 acked data packets per block otherwise.
    *
-   * @param full_path The full path.
-   *
-   * @return the filename.
+   * @param bus the CAN bus of the motor being flashed
+   * @param firmware the firmware to write
+   * @param address the address of the first block
+   * @param nb_blocks the number of blocks
    */
-  static inline std::string get_filename(std::string full_path)
-  {
-    std::vector<std::string> splitted_string;
-    boost::split(splitted_string, full_path, boost::is_any_of("/"));
-    return splitted_string.back();
-  }
+  void add_write_blocks(FlashingBus &bus, const FirmwareImage &firmware, unsigned int address, unsigned int nb_blocks);
+
 };
 
 
@@ -1,6 +1,11 @@
 #!/bin/bash
+# Flashes the released firmware to the motors given as arguments (11 to 19 by default).
+# The firmware is parsed once, and a motor on each CAN bus is flashed at the same time.
 
-for i in {11..19} ; do
-    echo "Flashing motor: $i"
-    rosservice call SimpleMotorFlasher `rospack find sr_external_dependencies`/compiled_firmware/released_firmware/simplemotor.hex $i;
-done
+if [ $# -eq 0 ] ; then
+    set -- {11..19}
+fi
+
+motor_ids=$(echo "$@" | sed 's/ /, /g')
+echo "Flashing motors: $motor_ids"
+rosservice call BulkMotorFlasher "{firmware: '`rospack find sr_external_dependencies`/compiled_firmware/released_firmware/simplemotor.hex', motor_ids: [$motor_ids]}"
@@ -0,0 +1,149 @@
+/**
+ * @file   can_bridge_capture.cpp
+ * @author Shadow Robot Software Team <software@shadowrobot.com>
+ * @date   Sun Oct 18 21:47:10 2026
+*
+* Copyright 2026 Shadow Robot Company Ltd.
+*
+* This program is free software: you can redistribute it and/or modify it
+* under the terms of the GNU General Public License as published by the Free
+* Software Foundation, either version 2 of the License, or (at your option)
+* any later version.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+* more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+ *
+ * @brief Capture of the CAN messages going through the EtherCAT CAN bridge,
+ *        in the candump log format.
+ *
+ *
+ */
+
+#include <sr_edc_ethercat_drivers/can_bridge_capture.h>
+#include <ros/ros.h>
+#include <boost/bind.hpp>
+#include <algorithm>
+
+namespace sr_edc_ethercat_drivers
+{
+  const unsigned int CanBridgeCapture::ring_size;
+  const boost::posix_time::time_duration CanBridgeCapture::write_period_ = boost::posix_time::milliseconds(100);
+
+  CanBridgeCapture::CanBridgeCapture()
+          : capturing_(false),
+            dropped_frames_(0),
+            reported_dropped_frames_(0),
+            file_(NULL)
+  {
+  }
+
+  CanBridgeCapture::~CanBridgeCapture()
+  {
+    stop();
+  }
+
+  bool CanBridgeCapture::start(const std::string &path)
+  {
+    stop();
+
+    file_ = fopen(path.c_str(), "w");
+    if (file_ == NULL)
+    {
+      ROS_ERROR("Couldn't open %s to capture the CAN bridge messages", path.c_str());
+      return false;
+    }
+
+    ROS_INFO("Capturing the CAN bridge messages to %s", path.c_str());
+    writing_thread_.reset(new boost::thread(boost::bind(&CanBridgeCapture::writing_loop, this)));
+    capturing_.store(true);
+    return true;
+  }
+
+  void CanBridgeCapture::stop()
+  {
+    capturing_.store(false);
+    if (writing_thread_)
+    {
+      writing_thread_->interrupt();
+      writing_thread_->join();
+      writing_thread_.reset();
+    }
+
+    if (file_ != NULL)
+    {
+      fclose(file_);
+      file_ = NULL;
+    }
+  }
+
+  void CanBridgeCapture::push(Direction direction, const ETHERCAT_CAN_BRIDGE_DATA &message)
+  {
+    if (message.message_id == 0 && message.message_length == 0)
+    {
+      return;
+    }
+
+    Frame frame;
+    clock_gettime(CLOCK_REALTIME, &frame.stamp);
+    frame.direction = direction;
+    frame.message = message;
+    if (!ring_.push(frame))
+    {
+      dropped_frames_.fetch_add(1, boost::memory_order_relaxed);
+    }
+  }
+
+  void CanBridgeCapture::writing_loop()
+  {
+    try
+    {
+      while (true)
+      {
+        boost::this_thread::sleep(write_period_);
+        write_frames();
+      }
+    }
+    catch (boost::thread_interrupted const &)
+    {
+      // the capture is stopped: write what's left
+      write_frames();
+    }
+  }
+
+  void CanBridgeCapture::write_frames()
+  {
+    Frame frame;
+    while (ring_.pop(frame))
+    {
+      const ETHERCAT_CAN_BRIDGE_DATA &message = frame.message;
+      fprintf(file_, "(%010ld.%06ld) can%u%s %03X#", static_cast<long>(frame.stamp.tv_sec),
+              static_cast<long>(frame.stamp.tv_nsec / 1000), static_cast<unsigned int>(message.can_bus),
+              frame.direction == SENT ? "tx" : "", static_cast<unsigned int>(message.message_id));
+      for (unsigned int i = 0; i < std::min<unsigned int>(message.message_length, 8); ++i)
+      {
+        fprintf(file_, "%02X", static_cast<unsigned int>(message.message_data[i]));
+      }
+      fputc('\n', file_);
+    }
+    fflush(file_);
+
+    unsigned int dropped = dropped_frames_.load(boost::memory_order_relaxed);
+    if (dropped != reported_dropped_frames_)
+    {
+      ROS_WARN("%u CAN bridge messages weren't captured (ring full)", dropped - reported_dropped_frames_);
+      reported_dropped_frames_ = dropped;
+    }
+  }
+}  // namespace sr_edc_ethercat_drivers
+
+/* For the emacs weenies in the crowd.
+Local Variables:
+   c-basic-offset: 2
+End:
+*/
@@ -0,0 +1,188 @@
+/**
+ * @file   can_bridge_requests.cpp
+ * @author Shadow Robot Software Team <software@shadowrobot.com>
+ * @date   Sun Oct 18 21:02:36 2026
+*
+* Copyright 2026 Shadow Robot Company Ltd.
+*
+* This program is free software: you can redistribute it and/or modify it
+* under the terms of the GNU General Public License as published by the Free
+* Software Foundation, either version 2 of the License, or (at your option)
+* any later version.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+* more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+ *
+ * @brief Asynchronous requests sent through the EtherCAT CAN bridge.
+ *
+ *
+ */
+
+#include <sr_edc_ethercat_drivers/can_bridge_requests.h>
+#include <boost/bind.hpp>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+namespace sr_edc_ethercat_drivers
+{
+  const unsigned int CanBridgeRequests::queue_size;
+  const boost::posix_time::time_duration CanBridgeRequests::matching_period_ = boost::posix_time::milliseconds(1);
+
+  CanBridgeRequests::CanBridgeRequests()
+          : nb_pending_(0)
+  {
+    matching_thread_.reset(new boost::thread(boost::bind(&CanBridgeRequests::matching_loop, this)));
+  }
+
+  CanBridgeRequests::~CanBridgeRequests()
+  {
+    matching_thread_->interrupt();
+    matching_thread_->join();
+  }
+
+  boost::unique_future<CanBridgeReply> CanBridgeRequests::submit(const ETHERCAT_CAN_BRIDGE_DATA &request,
+                                                                 ReplyPredicate is_reply, unsigned int timeout)
+  {
+    boost::shared_ptr<boost::promise<CanBridgeReply> > promise(new boost::promise<CanBridgeReply>());
+    submit(request, is_reply, timeout, boost::bind(&CanBridgeRequests::fulfil, promise, _1));
+    return promise->get_future();
+  }
+
+  void CanBridgeRequests::submit(const ETHERCAT_CAN_BRIDGE_DATA &request, ReplyPredicate is_reply,
+                                 unsigned int timeout, ReplyCallback callback)
+  {
+    PendingRequest pending;
+    pending.message = request;
+    pending.is_reply = is_reply;
+    pending.callback = callback;
+    pending.deadline = ros::WallTime::now() + ros::WallDuration(timeout / 1000.0);
+
+    // the messages received are only kept while a request is pending, and the reply
+    // can't be matched before the request is in pending_ (the lock is held)
+    boost::mutex::scoped_lock l(pending_mutex_);
+    nb_pending_.fetch_add(1);
+    if (!to_send_.push(request))
+    {
+      ROS_WARN("Too many CAN bridge requests queued, the request to 0x%04X failed", request.message_id);
+      // failed from the background thread, as the other requests
+      pending.deadline = ros::WallTime();
+    }
+    pending_.push_back(pending);
+  }
+
+  bool CanBridgeRequests::is_ack(const ETHERCAT_CAN_BRIDGE_DATA &request, const ETHERCAT_CAN_BRIDGE_DATA &reply)
+  {
+    return reply.message_id == (request.message_id | 0x10) &&
+           reply.message_length == request.message_length &&
+           memcmp(reply.message_data, request.message_data, request.message_length) == 0;
+  }
+
+  bool CanBridgeRequests::next_request(ETHERCAT_CAN_BRIDGE_DATA *message)
+  {
+    return to_send_.pop(*message);
+  }
+
+  void CanBridgeRequests::message_received(const ETHERCAT_CAN_BRIDGE_DATA &message)
+  {
+    if (message.message_id == 0 || nb_pending_.load() == 0)
+    {
+      return;
+    }
+    // dropped if full: the request it answers will time out
+    received_.bounded_push(message);
+  }
+
+  void CanBridgeRequests::matching_loop()
+  {
+    try
+    {
+      while (true)
+      {
+        boost::this_thread::sleep(matching_period_);
+        match_replies();
+      }
+    }
+    catch (boost::thread_interrupted const &)
+    {
+      // fail what's left
+      std::list<PendingRequest> pending;
+      {
+        boost::mutex::scoped_lock l(pending_mutex_);
+        pending.swap(pending_);
+      }
+      CanBridgeReply failure;
+      failure.success = false;
+      for (std::list<PendingRequest>::iterator it = pending.begin(); it != pending.end(); ++it)
+      {
+        it->callback(failure);
+      }
+    }
+  }
+
+  void CanBridgeRequests::match_replies()
+  {
+    // the callbacks are called once the lock is released: they can submit new requests
+    std::vector<std::pair<ReplyCallback, CanBridgeReply> > completed;
+    {
+      boost::mutex::scoped_lock l(pending_mutex_);
+
+      ETHERCAT_CAN_BRIDGE_DATA message;
+      while (received_.pop(message))
+      {
+        for (std::list<PendingRequest>::iterator it = pending_.begin(); it != pending_.end(); ++it)
+        {
+          if (it->message.can_bus == message.can_bus && it->is_reply(it->message, message))
+          {
+            CanBridgeReply reply;
+            reply.success = true;
+            reply.message = message;
+            completed.push_back(std::make_pair(it->callback, reply));
+            pending_.erase(it);
+            break;
+          }
+        }
+      }
+
+      ros::WallTime now = ros::WallTime::now();
+      for (std::list<PendingRequest>::iterator it = pending_.begin(); it != pending_.end();)
+      {
+        if (it->deadline <= now)
+        {
+          CanBridgeReply reply;
+          reply.success = false;
+          completed.push_back(std::make_pair(it->callback, reply));
+          it = pending_.erase(it);
+        }
+        else
+        {
+          ++it;
+        }
+      }
+      nb_pending_.store(pending_.size());
+    }
+
+    for (size_t i = 0; i < completed.size(); ++i)
+    {
+      completed[i].first(completed[i].second);
+    }
+  }
+
+  void CanBridgeRequests::fulfil(boost::shared_ptr<boost::promise<CanBridgeReply> > promise,
+                                 const CanBridgeReply &reply)
+  {
+    promise->set_value(reply);
+  }
+}  // namespace sr_edc_ethercat_drivers
+
+/* For the emacs weenies in the crowd.
+Local Variables:
+   c-basic-offset: 2
+End:
+*/
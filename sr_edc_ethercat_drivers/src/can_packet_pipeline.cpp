@@ -0,0 +1,239 @@
+/**
+ * @file   can_packet_pipeline.cpp
+ * @author Shadow Robot Software Team <software@shadowrobot.com>
+ * @date   Sun Oct 18 19:21:07 2026
+*
+* Copyright 2026 Shadow Robot Company Ltd.
+*
+* This program is free software: you can redistribute it and/or modify it
+* under the terms of the GNU General Public License as published by the Free
+* Software Foundation, either version 2 of the License, or (at your option)
+* any later version.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+* more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+ *
+ * @brief A sequence of CAN packets sent through the EtherCAT CAN bridge.
+ *
+ *
+ */
+
+#include <sr_edc_ethercat_drivers/can_packet_pipeline.h>
+#include <errno.h>
+#include <time.h>
+
+namespace sr_edc_ethercat_drivers
+{
+  const unsigned int CanPacketPipeline::max_packets;
+
+  CanPacketPipeline::CanPacketPipeline()
+          : nb_packets_(0),
+            current_(0),
+            in_flight_(false),
+            state_(IDLE),
+            nb_acked_(0),
+            pending_ack_(false)
+  {
+    sem_init(&finished_, 0, 0);
+  }
+
+  CanPacketPipeline::~CanPacketPipeline()
+  {
+    sem_destroy(&finished_);
+  }
+
+  void CanPacketPipeline::clear()
+  {
+    boost::mutex::scoped_lock l(mutex_);
+    nb_packets_ = 0;
+  }
+
+  bool CanPacketPipeline::add(const ETHERCAT_CAN_BRIDGE_DATA &message, const unsigned char *expected_read,
+                              bool needs_ack)
+  {
+    boost::mutex::scoped_lock l(mutex_);
+    if (nb_packets_ == max_packets)
+    {
+      return false;
+    }
+    packets_[nb_packets_].message = message;
+    packets_[nb_packets_].expected_read = expected_read;
+    packets_[nb_packets_].needs_ack = needs_ack;
+    ++nb_packets_;
+    return true;
+  }
+
+  unsigned int CanPacketPipeline::run(unsigned int timeout, bool *failed)
+  {
+    if (failed != NULL)
+    {
+      *failed = false;
+    }
+    if (nb_packets_ == 0)
+    {
+      return 0;
+    }
+
+    {
+      boost::mutex::scoped_lock l(mutex_);
+      // forget a post from a previous run which ended on a timeout
+      while (sem_trywait(&finished_) == 0)
+      {
+      }
+      current_ = 0;
+      in_flight_ = false;
+      nb_acked_.store(0);
+      // an ack recorded while the previous run was ending isn't for this one
+      pending_ack_.store(false);
+      state_.store(RUNNING);
+    }
+
+    unsigned int last_nb_acked = 0;
+    while (state_.load() == RUNNING)
+    {
+      struct timespec deadline;
+      clock_gettime(CLOCK_REALTIME, &deadline);
+      deadline.tv_sec += timeout / 1000;
+      deadline.tv_nsec += (timeout % 1000) * 1000000;
+      if (deadline.tv_nsec >= 1000000000)
+      {
+        deadline.tv_sec += 1;
+        deadline.tv_nsec -= 1000000000;
+      }
+
+      if (sem_timedwait(&finished_, &deadline) == 0 || errno != ETIMEDOUT)
+      {
+        // finished, or interrupted by a signal: check the state again
+        continue;
+      }
+
+      // the semaphore is only posted at the end of the run, so look at the progress
+      unsigned int nb_acked = nb_acked_.load();
+      if (nb_acked == last_nb_acked)
+      {
+        break;
+      }
+      last_nb_acked = nb_acked;
+    }
+
+    // stops the realtime loop if we timed out (it only sends packets while running)
+    boost::mutex::scoped_lock l(mutex_);
+    if (failed != NULL)
+    {
+      *failed = (state_.load() == FAILED);
+    }
+    state_.store(IDLE);
+    return nb_acked_.load();
+  }
+
+  bool CanPacketPipeline::next_packet(Packet *packet)
+  {
+    boost::mutex::scoped_try_lock l(mutex_);
+    if (!l.owns_lock())
+    {
+      return false;
+    }
+    apply_pending_ack();
+    if (state_.load() != RUNNING || in_flight_)
+    {
+      return false;
+    }
+
+    *packet = packets_[current_];
+    if (packet->needs_ack)
+    {
+      in_flight_ = true;
+    }
+    else if (++current_ == nb_packets_)
+    {
+      // shouldn't happen: the last packet needs an ack
+      nb_acked_.store(current_);
+      finish(DONE);
+    }
+    return true;
+  }
+
+  bool CanPacketPipeline::waiting_for_ack()
+  {
+    boost::mutex::scoped_try_lock l(mutex_);
+    if (!l.owns_lock())
+    {
+      // the reply is still checked: packet_acked() records the ack if the lock is still taken
+      return state_.load() == RUNNING;
+    }
+    apply_pending_ack();
+    return state_.load() == RUNNING && in_flight_;
+  }
+
+  void CanPacketPipeline::packet_acked()
+  {
+    boost::mutex::scoped_try_lock l(mutex_);
+    if (!l.owns_lock())
+    {
+      // applied the next time the realtime loop gets the lock
+      pending_ack_.store(true);
+      return;
+    }
+    apply_pending_ack();
+    ack_in_flight();
+  }
+
+  void CanPacketPipeline::packet_failed()
+  {
+    boost::mutex::scoped_try_lock l(mutex_);
+    if (!l.owns_lock())
+    {
+      return;
+    }
+    apply_pending_ack();
+    if (state_.load() != RUNNING || !in_flight_)
+    {
+      return;
+    }
+
+    in_flight_ = false;
+    finish(FAILED);
+  }
+
+  void CanPacketPipeline::apply_pending_ack()
+  {
+    if (pending_ack_.exchange(false))
+    {
+      ack_in_flight();
+    }
+  }
+
+  void CanPacketPipeline::ack_in_flight()
+  {
+    if (state_.load() != RUNNING || !in_flight_)
+    {
+      return;
+    }
+
+    in_flight_ = false;
+    ++current_;
+    nb_acked_.store(current_);
+    if (current_ == nb_packets_)
+    {
+      finish(DONE);
+    }
+  }
+
+  void CanPacketPipeline::finish(State state)
+  {
+    state_.store(state);
+    sem_post(&finished_);
+  }
+}  // namespace sr_edc_ethercat_drivers
+
+/* For the emacs weenies in the crowd.
+Local Variables:
+   c-basic-offset: 2
+End:
+*/
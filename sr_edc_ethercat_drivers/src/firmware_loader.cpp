@@ -0,0 +1,237 @@
+/**
+ * @file   firmware_loader.cpp
+ * @author Shadow Robot Software Team <software@shadowrobot.com>
+ * @date   Sun Oct 18 22:15:53 2026
+*
+* Copyright 2026 Shadow Robot Company Ltd.
+*
+* This program is free software: you can redistribute it and/or modify it
+* under the terms of the GNU General Public License as published by the Free
+* Software Foundation, either version 2 of the License, or (at your option)
+* any later version.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+* more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+ *
+ * @brief Parses the motor firmwares from their object (.hex) files.
+ *
+ *
+ */
+
+#include <sr_edc_ethercat_drivers/firmware_loader.h>
+#include <ros/ros.h>
+#include <boost/algorithm/string.hpp>
+#include <algorithm>
+#include <sys/stat.h>
+#include <vector>
+
+namespace sr_edc_ethercat_drivers
+{
+  namespace
+  {
+    /// Extract the filename from the full path.
+    std::string get_filename(const std::string &full_path)
+    {
+      std::vector<std::string> splitted_string;
+      boost::split(splitted_string, full_path, boost::is_any_of("/"));
+      return splitted_string.back();
+    }
+  }  // namespace
+
+  bool FirmwareLoader::load(const std::string &path, MotorFirmware *firmware)
+  {
+    struct stat file_stat;
+    if (stat(path.c_str(), &file_stat) != 0)
+    {
+      ROS_ERROR("error opening the file %s", get_filename(path).c_str());
+      return false;
+    }
+
+    std::map<std::string, CachedFirmware>::iterator cached = cache_.find(path);
+    if (cached != cache_.end() && cached->second.modified == file_stat.st_mtime)
+    {
+      ROS_INFO("firmware %s already parsed", get_filename(path).c_str());
+      *firmware = cached->second.firmware;
+      return true;
+    }
+
+    if (!parse(path, firmware))
+    {
+      cache_.erase(path);
+      return false;
+    }
+
+    CachedFirmware &entry = cache_[path];
+    entry.modified = file_stat.st_mtime;
+    entry.firmware = *firmware;
+    return true;
+  }
+
+  /** \brief Reads the firmware to flash from an object file
+   *
+   *  This function will first read all the sections of the firmware using libbfd and find out the lowest and highest addresses containing code.
+   *  Then it will allocate an array to contain the firmware's code. The size is (highest_addr - lowest_addr).
+   *  The bfd library provides functions to manage object files more easily. To better understand some of the concepts used below,
+   *  the following link can be useful:
+   *  http://www.delorie.com/gnu/docs/binutils/ld_7.html
+   *  The use of the following commands can also help to understand the structure of the object file containing the firmware
+   *  \code objdump -x simplemotor.hex \endcode
+   *  \code objdump -s simplemotor.hex \endcode
+   *
+   * @param path the path of the object (.hex) file
+   * @param firmware where the firmware is stored
+   *
+   * @return false if the file couldn't be parsed
+   */
+  bool FirmwareLoader::parse(const std::string &path, MotorFirmware *firmware)
+  {
+    unsigned int smallest_start_address = 0x7fff;
+    unsigned int biggest_end_address = 0;
+
+    // Initialize the bfd library: "This routine must be called before any other BFD
+    // function to initialize magical internal data structures."
+    bfd_init();
+
+    // Open the requested firmware object file
+    bfd *fd = bfd_openr(path.c_str(), NULL);
+    if (fd == NULL)
+    {
+      ROS_ERROR("error opening the file %s", get_filename(path).c_str());
+      return false;
+    }
+
+    // Check that bfd recognises the file as a correctly formatted object file
+    if (!bfd_check_format(fd, bfd_object))
+    {
+      if (bfd_get_error() != bfd_error_file_ambiguously_recognized)
+      {
+        ROS_ERROR("Incompatible format");
+        bfd_close(fd);
+        return false;
+      }
+    }
+
+    ROS_INFO("firmware %s's format is : %s.", get_filename(path).c_str(), fd->xvec->name);
+
+    // Look for the start and end address of every section in the hex file,
+    // to detect the lowest and highest address of the data we need to write in the PIC's flash.
+    find_address_range(fd, &smallest_start_address, &biggest_end_address);
+    if (biggest_end_address <= smallest_start_address)
+    {
+      ROS_ERROR("No code to flash in %s.", get_filename(path).c_str());
+      bfd_close(fd);
+      return false;
+    }
+
+    // Calculate the size of the chunk of data to be flashed
+    unsigned int total_size = biggest_end_address - smallest_start_address;
+    firmware->name = get_filename(path);
+    firmware->base_address = smallest_start_address;
+
+    // Set all the bytes of the content to 0xFF initially (i.e. before reading the content from the hex file)
+    // This way we make sure that any byte in the region between smallest_start_address and biggest_end_address
+    // that is not included in any section of the hex file, will be written with a 0xFF value,
+    // which is the default in the PIC
+    firmware->content.assign(total_size, 0xFF);
+
+    // The content of the firmware is read from the .hex file pointed by fd
+    if (!read_content_from_object_file(fd, &firmware->content[0], firmware->base_address))
+    {
+      ROS_ERROR("something went wrong while parsing %s.", get_filename(path).c_str());
+      bfd_close(fd);
+      return false;
+    }
+
+    // We do not need the file anymore
+    bfd_close(fd);
+    return true;
+  }
+
+  void FirmwareLoader::find_address_range(bfd *fd, unsigned int *smallest_start_address, unsigned int *biggest_end_address)
+  {
+    asection *s;
+    unsigned int section_size = 0;
+    unsigned int section_addr = 0;
+
+    // Look for the start and end address of every section in the hex file,
+    // to detect the lowest and highest address of the data we need to write in the PIC's flash.
+    // The sections starting at an address higher than 0x7fff will be ignored as they are not proper
+    // "code memory" firmware
+    // (they can contain the CONFIG bits of the microcontroller, which we don't want to write here)
+    // To understand the structure (sections) of the object file containing the firmware (usually a .hex) the following
+    // commands can be useful:
+    //  \code objdump -x simplemotor.hex \endcode
+    //  \code objdump -s simplemotor.hex \endcode
+    for (s = fd->sections; s; s = s->next)
+    {
+      // Only the sections with the LOAD flag on will be considered
+      if (bfd_get_section_flags(fd, s) & (SEC_LOAD))
+      {
+        // Only the sections with the same VMA (virtual memory address) and LMA (load MA) will be considered
+        // http://www.delorie.com/gnu/docs/binutils/ld_7.html
+        if (bfd_section_lma(fd, s) == bfd_section_vma(fd, s))
+        {
+          section_addr = (unsigned int) bfd_section_lma(fd, s);
+          if (section_addr >= 0x7fff)
+          {
+            continue;
+          }
+          section_size = (unsigned int) bfd_section_size(fd, s);
+          *smallest_start_address = std::min(section_addr, *smallest_start_address);
+          *biggest_end_address = std::max(*biggest_end_address, section_addr + section_size);
+        }
+      }
+    }
+  }
+
+  bool FirmwareLoader::read_content_from_object_file(bfd *fd, bfd_byte *content, unsigned int base_addr)
+  {
+    asection *s;
+    unsigned int section_size = 0;
+    unsigned int section_addr = 0;
+
+    for (s = fd->sections; s; s = s->next)
+    {
+      // Only the sections with the LOAD flag on will be considered
+      if (bfd_get_section_flags(fd, s) & (SEC_LOAD))
+      {
+        // Only the sections with the same VMA (virtual memory address) and LMA (load MA) will be considered
+        // http://www.delorie.com/gnu/docs/binutils/ld_7.html
+        if (bfd_section_lma(fd, s) == bfd_section_vma(fd, s))
+        {
+          section_addr = (unsigned int) bfd_section_lma(fd, s);
+          // The sections starting at an address higher than 0x7fff will be ignored as they are
+          // not proper "code memory" firmware
+          // (they can contain the CONFIG bits of the microcontroller, which we don't want to write here)
+          if (section_addr >= 0x7fff)
+          {
+            continue;
+          }
+          section_size = (unsigned int) bfd_section_size(fd, s);
+          bfd_get_section_contents(fd, s, content + (section_addr - base_addr), 0, section_size);
+        }
+        else
+        {
+          return false;
+        }
+      }
+      else
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+}  // namespace sr_edc_ethercat_drivers
+
+/* For the emacs weenies in the crowd.
+Local Variables:
+   c-basic-offset: 2
+End:
+*/
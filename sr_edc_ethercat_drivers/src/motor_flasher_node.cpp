@@ -0,0 +1,135 @@
+/**
+ * @file   motor_flasher_node.cpp
+ * @author Shadow Robot Software Team <software@shadowrobot.com>
+ * @date   Sun Oct 18 22:15:53 2026
+*
+* Copyright 2026 Shadow Robot Company Ltd.
+*
+* This program is free software: you can redistribute it and/or modify it
+* under the terms of the GNU General Public License as published by the Free
+* Software Foundation, either version 2 of the License, or (at your option)
+* any later version.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+* more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+ *
+ * @brief Provides the SimpleMotorFlasher and BulkMotorFlasher services.
+ *
+ * The firmware files are parsed here, outside of the realtime process, and
+ * the parsed firmware is sent to the FlashMotorFirmware service of the
+ * driver. The parsed firmwares are kept until their file changes.
+ *
+ * The ~device_ids parameter lists the namespaces of the hands (the device
+ * ids of their drivers), it defaults to a single hand without namespace.
+ *
+ */
+
+#include <ros/ros.h>
+#include <sr_robot_msgs/SimpleMotorFlasher.h>
+#include <sr_edc_ethercat_drivers/BulkMotorFlasher.h>
+#include <sr_edc_ethercat_drivers/FlashMotorFirmware.h>
+#include <sr_edc_ethercat_drivers/firmware_loader.h>
+#include <boost/smart_ptr.hpp>
+#include <string>
+#include <vector>
+
+using sr_edc_ethercat_drivers::BulkMotorFlasher;
+using sr_edc_ethercat_drivers::FirmwareLoader;
+using sr_edc_ethercat_drivers::FlashMotorFirmware;
+using sr_robot_msgs::SimpleMotorFlasher;
+
+class MotorFlasher
+{
+public:
+  /**
+   * Advertises the flashing services of a hand.
+   *
+   * @param loader the firmware loader, shared by all the hands
+   * @param device_id the namespace of the services of the hand
+   */
+  MotorFlasher(FirmwareLoader *loader, const std::string &device_id)
+          : loader_(loader),
+            node_handle_(device_id)
+  {
+    flash_motor_firmware_ = node_handle_.serviceClient<FlashMotorFirmware>("FlashMotorFirmware");
+    simple_motor_flasher_ = node_handle_.advertiseService("SimpleMotorFlasher", &MotorFlasher::simple_motor_flasher,
+                                                          this);
+    bulk_motor_flasher_ = node_handle_.advertiseService("BulkMotorFlasher", &MotorFlasher::bulk_motor_flasher, this);
+  }
+
+  bool simple_motor_flasher(SimpleMotorFlasher::Request &req, SimpleMotorFlasher::Response &res)
+  {
+    FlashMotorFirmware flash;
+    flash.request.motor_ids.push_back(req.motor_id);
+    if (!loader_->load(req.firmware, &flash.request.firmware) || !flash_motor_firmware_.call(flash) ||
+        flash.response.value != flash.response.SUCCESS)
+    {
+      res.value = res.FAIL;
+      return false;
+    }
+
+    res.value = res.SUCCESS;
+    return true;
+  }
+
+  bool bulk_motor_flasher(BulkMotorFlasher::Request &req, BulkMotorFlasher::Response &res)
+  {
+    FlashMotorFirmware flash;
+    flash.request.motor_ids = req.motor_ids;
+    if (!loader_->load(req.firmware, &flash.request.firmware))
+    {
+      res.value = res.FAIL;
+      return true;
+    }
+
+    if (!flash_motor_firmware_.call(flash))
+    {
+      ROS_ERROR("The FlashMotorFirmware service of the driver isn't available");
+      res.value = res.FAIL;
+      return true;
+    }
+
+    res.value = flash.response.value;
+    res.results = flash.response.results;
+    res.total_time = flash.response.total_time;
+    return true;
+  }
+
+private:
+  FirmwareLoader *loader_;
+  ros::NodeHandle node_handle_;
+  ros::ServiceClient flash_motor_firmware_;
+  ros::ServiceServer simple_motor_flasher_;
+  ros::ServiceServer bulk_motor_flasher_;
+};
+
+int main(int argc, char **argv)
+{
+  ros::init(argc, argv, "motor_flasher");
+  ros::NodeHandle nh_tilde("~");
+
+  std::vector<std::string> device_ids;
+  nh_tilde.param("device_ids", device_ids, std::vector<std::string>(1, ""));
+
+  FirmwareLoader loader;
+  std::vector<boost::shared_ptr<MotorFlasher> > flashers;
+  for (size_t i = 0; i < device_ids.size(); ++i)
+  {
+    flashers.push_back(boost::shared_ptr<MotorFlasher>(new MotorFlasher(&loader, device_ids[i])));
+  }
+
+  ros::spin();
+  return 0;
+}
+
+/* For the emacs weenies in the crowd.
+Local Variables:
+   c-basic-offset: 2
+End:
+*/
@@ -26,10 +26,12 @@
 
 
 #include <sr_edc_ethercat_drivers/sr08.h>
+#include <sr_robot_lib/rt_logger.hpp>
 
 #include <realtime_tools/realtime_publisher.h>
 
 #include <math.h>
+#include <cstring>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -78,7 +80,9 @@ PLUGINLIB_EXPORT_CLASS(SR08, EthercatDevice);
  */
 SR08::SR08()
         : zero_buffer_read(0),
-          cycle_count(0)
+          cycle_count(0),
+          publishing_cycles_(10),
+          prev_status_decoded_(false)
 {
   /*
     ROS_INFO("There are %d sensors", nb_sensors_const);
@@ -133,6 +137,12 @@ void SR08::construct(EtherCAT_SlaveHandler *sh, int &start_address)
                    ETHERCAT_COMMAND_DATA_ADDRESS, ETHERCAT_STATUS_DATA_ADDRESS,
                    ETHERCAT_CAN_BRIDGE_DATA_COMMAND_ADDRESS, ETHERCAT_CAN_BRIDGE_DATA_STATUS_ADDRESS);
 
+  // The 0230 palm firmware forwards the CAN bridge packets in the sensor data frames
+  bool flash_while_streaming;
+  nh_tilde_.param("flash_while_streaming", flash_while_streaming, true);
+  flash_while_streaming_.store(flash_while_streaming);
+  advertise_can_bridge_request();
+
   ROS_INFO("Finished constructing the SR08 driver");
 }
 
@@ -154,6 +164,11 @@ int SR08::initialize(hardware_interface::HardwareInterface *hw, bool allow_unpro
                   ETHERCAT_DATA_STRUCTURE_0230_PALM_EDC_COMMAND>(hw, nodehandle_, nh_tilde_,
                                                                  device_id_, device_joint_prefix_));
 
+  // publish the tactiles and the palm extras at the same rate, whatever the cycle period
+  double publishing_rate;
+  nh_tilde_.param("publishing_rate", publishing_rate, 100.0);
+  publishing_cycles_ = sr_hand_lib->cycles_for_rate(publishing_rate);
+
   ROS_INFO("ETHERCAT_STATUS_DATA_SIZE      = %4d bytes", static_cast<int> (ETHERCAT_STATUS_DATA_SIZE));
   ROS_INFO("ETHERCAT_COMMAND_DATA_SIZE     = %4d bytes", static_cast<int> (ETHERCAT_COMMAND_DATA_SIZE));
   ROS_INFO("ETHERCAT_CAN_BRIDGE_DATA_SIZE  = %4d bytes", static_cast<int> (ETHERCAT_CAN_BRIDGE_DATA_SIZE));
@@ -179,13 +194,18 @@ void SR08::multiDiagnostics(vector<diagnostic_msgs::DiagnosticStatus> &vec, unsi
 {
   diagnostic_updater::DiagnosticStatusWrapper &d(diagnostic_status_);
 
-  stringstream name;
-  string prefix = device_id_.empty() ? device_id_ : (device_id_ + " ");
-  d.name = prefix + "EtherCAT Dual CAN Palm";
+  if (diagnostics_name_.empty())
+  {
+    // those don't change, build them only once
+    string prefix = device_id_.empty() ? device_id_ : (device_id_ + " ");
+    diagnostics_name_ = prefix + "EtherCAT Dual CAN Palm";
+    stringstream hwid;
+    hwid << sh_->get_product_code() << "-" << sh_->get_serial();
+    diagnostics_hardware_id_ = hwid.str();
+  }
+  d.name = diagnostics_name_;
   d.summary(d.OK, "OK");
-  stringstream hwid;
-  hwid << sh_->get_product_code() << "-" << sh_->get_serial();
-  d.hardware_id = hwid.str();
+  d.hardware_id = diagnostics_hardware_id_;
 
   d.clear();
   d.addf("Position", "%02d", sh_->get_ring_position());
@@ -194,10 +214,18 @@ void SR08::multiDiagnostics(vector<diagnostic_msgs::DiagnosticStatus> &vec, unsi
   d.addf("Revision", "%d", sh_->get_revision());
   d.addf("Counter", "%d", ++counter_);
 
-  d.addf("PIC idle time (in microsecs)", "%d", sr_hand_lib->main_pic_idle_time);
-  d.addf("Min PIC idle time (since last diagnostics)", "%d", sr_hand_lib->main_pic_idle_time_min);
-  // reset the idle time min to a big number, to get a fresh number on next diagnostic
-  sr_hand_lib->main_pic_idle_time_min = 1000;
+  sr_hand_lib->get_state_snapshot(diagnostics_snapshot_);
+  d.addf("PIC idle time (in microsecs)", "%d", diagnostics_snapshot_.main_pic_idle_time);
+  d.addf("Min PIC idle time (since last diagnostics)", "%d", diagnostics_snapshot_.main_pic_idle_time_min);
+  // the realtime loop resets the idle time min to a big number, to get a fresh number on next diagnostic
+  sr_hand_lib->reset_main_pic_idle_time_min();
+  d.addf("Lost frames", "%u", diagnostics_snapshot_.lost_frames);
+  d.addf("Repeated frames", "%u", diagnostics_snapshot_.repeated_frames);
+  d.addf("Frame faults", "%u", diagnostics_snapshot_.frame_faults);
+  if (diagnostics_snapshot_.frame_fault)
+  {
+    d.mergeSummary(d.ERROR, "No new frame received: demands nullified");
+  }
 
   this->ethercatDiagnostics(d, 2);
   vec.push_back(d);
@@ -208,14 +236,15 @@ void SR08::multiDiagnostics(vector<diagnostic_msgs::DiagnosticStatus> &vec, unsi
   // Add the diagnostics from the tactiles
   if (sr_hand_lib->tactiles != NULL)
   {
-    sr_hand_lib->tactiles->add_diagnostics(vec, d);
+    sr_hand_lib->tactiles->add_diagnostics(vec, d, diagnostics_snapshot_);
   }
 }
 
 /** \brief packs the commands before sending them to the EtherCAT bus
  *
  *  This is one of the most important functions of this driver.
- *  This function is called each millisecond (1 kHz freq) by the EthercatHardware::update() function
+ *  This function is called at each cycle (1 kHz by default, see the cycle_period parameter) by the
+ *  EthercatHardware::update() function
  *  in the controlLoop() of the ros_etherCAT node.
  *
  *  This function is called with a buffer as a parameter, the buffer provided is where we write the commands to send via EtherCAT.
@@ -229,13 +258,16 @@ void SR08::multiDiagnostics(vector<diagnostic_msgs::DiagnosticStatus> &vec, unsi
  */
 void SR08::packCommand(unsigned char *buffer, bool halt, bool reset)
 {
+  sr_hand_lib->load_governor->start_processing();
+
   SrEdc::packCommand(buffer, halt, reset);
 
   ETHERCAT_DATA_STRUCTURE_0230_PALM_EDC_COMMAND *command =
           reinterpret_cast<ETHERCAT_DATA_STRUCTURE_0230_PALM_EDC_COMMAND *>(buffer);
   ETHERCAT_CAN_BRIDGE_DATA *message = reinterpret_cast<ETHERCAT_CAN_BRIDGE_DATA *>(buffer + ETHERCAT_COMMAND_DATA_SIZE);
 
-  if (!flashing)
+  // While flashing, the CAN bridge packets are sent along with the sensor data unless the palm needs the CAN direct mode
+  if (!flashing || !can_direct_mode_)
   {
     command->EDC_command = EDC_COMMAND_SENSOR_DATA;
   }
@@ -279,6 +311,8 @@ void SR08::packCommand(unsigned char *buffer, bool halt, bool reset)
           command->motor_data[19]);
 
   build_CAN_message(message);
+
+  sr_hand_lib->load_governor->end_processing();
 }
 
 /** \brief This functions receives data from the EtherCAT bus
@@ -308,6 +342,8 @@ bool SR08::unpackState(unsigned char *this_buffer, unsigned char *prev_buffer)
   //  int16u                                        *status_buffer = (int16u*)status_data;
   static unsigned int num_rxed_packets = 0;
 
+  sr_hand_lib->load_governor->start_processing();
+
   ++num_rxed_packets;
 
 
@@ -351,25 +387,49 @@ bool SR08::unpackState(unsigned char *this_buffer, unsigned char *prev_buffer)
     debug_publisher->unlockAndPublish();
   }
 
-  if (status_data->EDC_command == EDC_COMMAND_INVALID)
+  // the data of a lost or repeated frame must not be decoded
+  const shadow_robot::FrameMonitor::FrameStatus frame_status = sr_hand_lib->frame_monitor->check_frame(
+          status_data->EDC_command != EDC_COMMAND_INVALID, this_buffer + command_size_, prev_buffer + command_size_,
+          ETHERCAT_STATUS_DATA_SIZE);
+  if (frame_status == shadow_robot::FrameMonitor::FRAME_LOST)
   {
     // received empty message: the pic is not writing to its mailbox.
     ++zero_buffer_read;
     float percentage_packet_loss = 100.f * (static_cast<float>(zero_buffer_read) /
             static_cast<float>(num_rxed_packets));
 
-    ROS_DEBUG("Reception error detected : %d errors out of %d rxed packets (%2.3f%%) ; idle time %dus",
-              zero_buffer_read, num_rxed_packets, percentage_packet_loss, status_data->idle_time_us);
+    SR_RT_LOG_DEBUG("Reception error detected : %d errors out of %d rxed packets (%2.3f%%) ; idle time %dus",
+                    zero_buffer_read, num_rxed_packets, percentage_packet_loss, status_data->idle_time_us);
+    prev_status_decoded_ = false;
+  }
+  if (frame_status != shadow_robot::FrameMonitor::FRAME_OK)
+  {
+    // hold (or extrapolate) the joint states until the next new frame
+    sr_hand_lib->frame_missed();
+    // the idle time of this frame isn't a new one, it's not sampled by the load governor
+    sr_hand_lib->load_governor->end_processing();
+    // the CAN bridge data of a lost or repeated frame aren't a new reply: the request in flight
+    // isn't checked against them (it is sent again on timeout)
     return true;
   }
 
+  // The tactile and aux sections often stay the same between two frames (no new reply from the
+  // sensors): they don't need to be decoded again if they didn't change since the previous status.
+  const unsigned char *tactile_section = this_buffer + command_size_ + STATUS_TACTILE_START;
+  const unsigned char *prev_tactile_section = prev_buffer + command_size_ + STATUS_TACTILE_START;
+  sr_hand_lib->set_tactile_data_unchanged(
+          prev_status_decoded_ &&
+          memcmp(tactile_section, prev_tactile_section, STATUS_TACTILE_LENGTH + STATUS_AUX_LENGTH) == 0);
+  prev_status_decoded_ = true;
+
   // We received a coherent message.
   // Update the library (positions, diagnostics values, actuators, etc...)
   // with the received information
   sr_hand_lib->update(status_data);
 
-  // Now publish the additional data at 100Hz (every 10 cycles)
-  if (cycle_count >= 10)
+  // Now publish the additional data at publishing_rate, slower when the load governor sheds the publishing
+  const unsigned int publishing_divider = sr_hand_lib->load_governor->divider(shadow_robot::LoadGovernor::PUBLISHING);
+  if (cycle_count >= publishing_cycles_ * publishing_divider)
   {
     // publish tactiles if we have them
     if (sr_hand_lib->tactiles != NULL)
@@ -412,15 +472,12 @@ bool SR08::unpackState(unsigned char *this_buffer, unsigned char *prev_buffer)
   }
   ++cycle_count;
 
+  sr_hand_lib->load_governor->end_processing();
+  sr_hand_lib->load_governor->sample(status_data->idle_time_us);
 
-  // If we're flashing, check is the packet has been acked
-  if (flashing & !can_packet_acked)
-  {
-    if (can_data_is_ack(can_data))
-    {
-      can_packet_acked = true;
-    }
-  }
+  // Check if the packet acks the flashing packet in flight (the next one is then sent in the next frame),
+  // or answers one of the CAN bridge requests
+  check_CAN_reply(can_data);
 
   return true;
 }
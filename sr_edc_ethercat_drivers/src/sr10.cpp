@@ -0,0 +1,477 @@
+/**
+ * @file   sr10.cpp
+ * @author Shadow Robot Software Team <software@shadowrobot.com>
+ * @date   Sun Oct 18 23:58:06 2026
+ *
+ * Copyright 2026 Shadow Robot Company Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @brief This is a ROS driver for Shadow Robot #10 EtherCAT product ID
+ *
+ *
+ */
+
+
+#include <sr_edc_ethercat_drivers/sr10.h>
+#include <sr_robot_lib/rt_logger.hpp>
+
+#include <realtime_tools/realtime_publisher.h>
+
+#include <math.h>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <iomanip>
+#include <boost/foreach.hpp>
+#include <std_msgs/Int16.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <pthread.h>
+
+#include <sr_utilities/sr_math_utils.hpp>
+
+using std::string;
+using std::stringstream;
+using std::vector;
+
+#include <sr_external_dependencies/types_for_external.h>
+
+#include <boost/static_assert.hpp>
+
+namespace is_edc_command_32_bits
+{
+// check is the EDC_COMMAND is 32bits on the computer
+// if not, fails
+  BOOST_STATIC_ASSERT(sizeof(EDC_COMMAND) == 4);
+}  // namespace is_edc_command_32_bits
+
+#define ETHERCAT_STATUS_DATA_SIZE sizeof(ETHERCAT_DATA_STRUCTURE_0240_PALM_EDC_STATUS)
+#define ETHERCAT_COMMAND_DATA_SIZE sizeof(ETHERCAT_DATA_STRUCTURE_0240_PALM_EDC_COMMAND)
+
+#define ETHERCAT_CAN_BRIDGE_DATA_SIZE sizeof(ETHERCAT_CAN_BRIDGE_DATA)
+
+#define ETHERCAT_COMMAND_DATA_ADDRESS                   PALM_0240_ETHERCAT_COMMAND_DATA_ADDRESS
+#define ETHERCAT_STATUS_DATA_ADDRESS                    PALM_0240_ETHERCAT_STATUS_DATA_ADDRESS
+#define ETHERCAT_CAN_BRIDGE_DATA_COMMAND_ADDRESS        PALM_0240_ETHERCAT_CAN_BRIDGE_DATA_COMMAND_ADDRESS
+#define ETHERCAT_CAN_BRIDGE_DATA_STATUS_ADDRESS         PALM_0240_ETHERCAT_CAN_BRIDGE_DATA_STATUS_ADDRESS
+
+
+PLUGINLIB_EXPORT_CLASS(SR10, EthercatDevice);
+
+/** \brief Constructor of the SR10 driver
+ *
+ *  This is the Constructor of the driver. We
+ *  initialize a few boolean values, a mutex
+ *  and create the Bootloading service.
+ */
+SR10::SR10()
+        : zero_buffer_read(0),
+          cycle_count(0),
+          publishing_cycles_(10),
+          frame_period_us_(PALM_0240_FRAME_PERIOD_US_DEFAULT),
+          prev_status_decoded_(false)
+{
+  /*
+    ROS_INFO("There are %d sensors", nb_sensors_const);
+    ROS_INFO(     "device_pub_freq_const = %d", device_pub_freq_const      );
+    ROS_INFO(        "ros_pub_freq_const = %d", ros_pub_freq_const         );
+    ROS_INFO(            "max_iter_const = %d", max_iter_const             );
+    ROS_INFO(          "nb_sensors_const = %d", nb_sensors_const           );
+    ROS_INFO("nb_publish_by_unpack_const = %d", nb_publish_by_unpack_const );
+   */
+}
+
+/** \brief Construct function, run at startup to set SyncManagers and FMMUs
+ *
+ *  Same layout as the SR08 driver (see SR08::construct()), only the status is longer:
+ *  it contains the data of all the motors.
+ */
+void SR10::construct(EtherCAT_SlaveHandler *sh, int &start_address)
+{
+  ROS_ASSERT(ETHERCAT_STATUS_0240_AGREED_SIZE == ETHERCAT_STATUS_DATA_SIZE);
+  ROS_ASSERT(ETHERCAT_COMMAND_0240_AGREED_SIZE == ETHERCAT_COMMAND_DATA_SIZE);
+
+  SrEdc::construct(sh, start_address, ETHERCAT_COMMAND_DATA_SIZE, ETHERCAT_STATUS_DATA_SIZE,
+                   ETHERCAT_CAN_BRIDGE_DATA_SIZE,
+                   ETHERCAT_COMMAND_DATA_ADDRESS, ETHERCAT_STATUS_DATA_ADDRESS,
+                   ETHERCAT_CAN_BRIDGE_DATA_COMMAND_ADDRESS, ETHERCAT_CAN_BRIDGE_DATA_STATUS_ADDRESS);
+
+  // The 0240 palm firmware forwards the CAN bridge packets in the sensor data frames
+  bool flash_while_streaming;
+  nh_tilde_.param("flash_while_streaming", flash_while_streaming, true);
+  flash_while_streaming_.store(flash_while_streaming);
+  advertise_can_bridge_request();
+
+  ROS_INFO("Finished constructing the SR10 driver");
+}
+
+/**
+ *
+ */
+int SR10::initialize(hardware_interface::HardwareInterface *hw, bool allow_unprogrammed)
+{
+  int retval = SR0X::initialize(hw, allow_unprogrammed);
+
+  if (retval != 0)
+  {
+    return retval;
+  }
+
+  sr_hand_lib = boost::shared_ptr<shadow_robot::SrMotorHandLib<ETHERCAT_DATA_STRUCTURE_0240_PALM_EDC_STATUS,
+          ETHERCAT_DATA_STRUCTURE_0240_PALM_EDC_COMMAND> >(
+          new shadow_robot::SrMotorHandLib<ETHERCAT_DATA_STRUCTURE_0240_PALM_EDC_STATUS,
+                  ETHERCAT_DATA_STRUCTURE_0240_PALM_EDC_COMMAND>(hw, nodehandle_, nh_tilde_,
+                                                                 device_id_, device_joint_prefix_));
+
+  // publish the tactiles and the palm extras at the same rate, whatever the cycle period
+  double publishing_rate;
+  nh_tilde_.param("publishing_rate", publishing_rate, 100.0);
+  publishing_cycles_ = sr_hand_lib->cycles_for_rate(publishing_rate);
+
+  frame_period_us_ = static_cast<int16u>(sr_hand_lib->cycle_period * 1.0e6 + 0.5);
+  if (frame_period_us_ < PALM_0240_FRAME_PERIOD_US_MIN || frame_period_us_ > PALM_0240_FRAME_PERIOD_US_MAX)
+  {
+    ROS_WARN("The palm can't follow a %dus cycle, it will run its frames as if they lasted between %d and %dus",
+             frame_period_us_, PALM_0240_FRAME_PERIOD_US_MIN, PALM_0240_FRAME_PERIOD_US_MAX);
+  }
+
+  ROS_INFO("ETHERCAT_STATUS_DATA_SIZE      = %4d bytes", static_cast<int> (ETHERCAT_STATUS_DATA_SIZE));
+  ROS_INFO("ETHERCAT_COMMAND_DATA_SIZE     = %4d bytes", static_cast<int> (ETHERCAT_COMMAND_DATA_SIZE));
+  ROS_INFO("ETHERCAT_CAN_BRIDGE_DATA_SIZE  = %4d bytes", static_cast<int> (ETHERCAT_CAN_BRIDGE_DATA_SIZE));
+
+  // initialise the publisher for the extra analog inputs, gyroscope and accelerometer on the palm
+  extra_analog_inputs_publisher.reset(
+          new realtime_tools::RealtimePublisher<std_msgs::Float64MultiArray>(nodehandle_, "palm_extras", 10));
+
+
+  // Debug real time publisher: publishes the raw ethercat data
+  debug_publisher = boost::shared_ptr<realtime_tools::RealtimePublisher<sr_robot_msgs::EthercatDebug> >(
+          new realtime_tools::RealtimePublisher<sr_robot_msgs::EthercatDebug>(nodehandle_, "debug_etherCAT_data", 4));
+  return retval;
+}
+
+/** \brief This function gives some diagnostics data
+ *
+ *  This function provides diagnostics data that can be displayed by
+ *  the runtime_monitor node. We use the mutliDiagnostics as it publishes
+ *  the diagnostics for each motors.
+ */
+void SR10::multiDiagnostics(vector<diagnostic_msgs::DiagnosticStatus> &vec, unsigned char *buffer)
+{
+  diagnostic_updater::DiagnosticStatusWrapper &d(diagnostic_status_);
+
+  if (diagnostics_name_.empty())
+  {
+    // those don't change, build them only once
+    string prefix = device_id_.empty() ? device_id_ : (device_id_ + " ");
+    diagnostics_name_ = prefix + "EtherCAT Dual CAN Palm";
+    stringstream hwid;
+    hwid << sh_->get_product_code() << "-" << sh_->get_serial();
+    diagnostics_hardware_id_ = hwid.str();
+  }
+  d.name = diagnostics_name_;
+  d.summary(d.OK, "OK");
+  d.hardware_id = diagnostics_hardware_id_;
+
+  d.clear();
+  d.addf("Position", "%02d", sh_->get_ring_position());
+  d.addf("Product Code", "%d", sh_->get_product_code());
+  d.addf("Serial Number", "%d", sh_->get_serial());
+  d.addf("Revision", "%d", sh_->get_revision());
+  d.addf("Counter", "%d", ++counter_);
+
+  sr_hand_lib->get_state_snapshot(diagnostics_snapshot_);
+  d.addf("PIC idle time (in microsecs)", "%d", diagnostics_snapshot_.main_pic_idle_time);
+  d.addf("Min PIC idle time (since last diagnostics)", "%d", diagnostics_snapshot_.main_pic_idle_time_min);
+  // the realtime loop resets the idle time min to a big number, to get a fresh number on next diagnostic
+  sr_hand_lib->reset_main_pic_idle_time_min();
+  d.addf("Lost frames", "%u", diagnostics_snapshot_.lost_frames);
+  d.addf("Repeated frames", "%u", diagnostics_snapshot_.repeated_frames);
+  d.addf("Frame faults", "%u", diagnostics_snapshot_.frame_faults);
+  if (diagnostics_snapshot_.frame_fault)
+  {
+    d.mergeSummary(d.ERROR, "No new frame received: demands nullified");
+  }
+
+  this->ethercatDiagnostics(d, 2);
+  vec.push_back(d);
+
+  // Add the diagnostics from the hand
+  sr_hand_lib->add_diagnostics(vec, d);
+
+  // Add the diagnostics from the tactiles
+  if (sr_hand_lib->tactiles != NULL)
+  {
+    sr_hand_lib->tactiles->add_diagnostics(vec, d, diagnostics_snapshot_);
+  }
+}
+
+/** \brief packs the commands before sending them to the EtherCAT bus
+ *
+ *  Same as SR08::packCommand(), and the cycle period is sent to the palm. The MotorUpdater
+ *  sets WHICH_MOTORS_ALL in which_motors to get the data of all the motors.
+ */
+void SR10::packCommand(unsigned char *buffer, bool halt, bool reset)
+{
+  sr_hand_lib->load_governor->start_processing();
+
+  SrEdc::packCommand(buffer, halt, reset);
+
+  ETHERCAT_DATA_STRUCTURE_0240_PALM_EDC_COMMAND *command =
+          reinterpret_cast<ETHERCAT_DATA_STRUCTURE_0240_PALM_EDC_COMMAND *>(buffer);
+  ETHERCAT_CAN_BRIDGE_DATA *message = reinterpret_cast<ETHERCAT_CAN_BRIDGE_DATA *>(buffer + ETHERCAT_COMMAND_DATA_SIZE);
+
+  // While flashing, the CAN bridge packets are sent along with the sensor data
+  // unless the palm needs the CAN direct mode
+  if (!flashing || !can_direct_mode_)
+  {
+    command->EDC_command = EDC_COMMAND_SENSOR_DATA;
+  }
+  else
+  {
+    command->EDC_command = EDC_COMMAND_CAN_DIRECT_MODE;
+  }
+
+  // alternate between even and uneven motors
+  // and ask for the different informations.
+  sr_hand_lib->build_command(command);
+
+  // the palm schedules its frame (waiting for the motors, reading the Pac...) for this period
+  command->frame_period_us = frame_period_us_;
+
+  // @todo For the moment the aux_data_type in the commend will be fixed here. This is for convenience,
+  // before we separate the aux data (and the prox_mid data) from the UBIO sensor type in the driver.
+  // After that, this should be done in the aux_data_updater (or something similar ) in the driver
+  command->aux_data_type = TACTILE_SENSOR_TYPE_MCP320x_TACTILE;
+
+  ROS_DEBUG(
+          "Sending command : Type : 0x%02X ; data : 0x%04X 0x%04X 0x%04X 0x%04X 0x%04X 0x%04X 0x%04X 0x%04X 0x%04X"
+                  " 0x%04X 0x%04X 0x%04X 0x%04X 0x%04X 0x%04X 0x%04X 0x%04X 0x%04X 0x%04X 0x%04X",
+          command->to_motor_data_type,
+          command->motor_data[0],
+          command->motor_data[1],
+          command->motor_data[2],
+          command->motor_data[3],
+          command->motor_data[4],
+          command->motor_data[5],
+          command->motor_data[6],
+          command->motor_data[7],
+          command->motor_data[8],
+          command->motor_data[9],
+          command->motor_data[10],
+          command->motor_data[11],
+          command->motor_data[12],
+          command->motor_data[13],
+          command->motor_data[14],
+          command->motor_data[15],
+          command->motor_data[16],
+          command->motor_data[17],
+          command->motor_data[18],
+          command->motor_data[19]);
+
+  build_CAN_message(message);
+
+  sr_hand_lib->load_governor->end_processing();
+}
+
+/** \brief This functions receives data from the EtherCAT bus
+ *
+ *  Same as SR08::unpackState(), the SrMotorRobotLib reads the data of all the motors
+ *  when the palm echoes WHICH_MOTORS_ALL.
+ *
+ * @param this_buffer The data just being received by EtherCAT
+ * @param prev_buffer The previous data received by EtherCAT
+ */
+bool SR10::unpackState(unsigned char *this_buffer, unsigned char *prev_buffer)
+{
+  ETHERCAT_DATA_STRUCTURE_0240_PALM_EDC_STATUS *status_data =
+          reinterpret_cast<ETHERCAT_DATA_STRUCTURE_0240_PALM_EDC_STATUS *>(this_buffer + command_size_);
+  ETHERCAT_CAN_BRIDGE_DATA *can_data =
+          reinterpret_cast<ETHERCAT_CAN_BRIDGE_DATA *>(this_buffer + command_size_ + ETHERCAT_STATUS_DATA_SIZE);
+  //  int16u                                        *status_buffer = (int16u*)status_data;
+  static unsigned int num_rxed_packets = 0;
+
+  sr_hand_lib->load_governor->start_processing();
+
+  ++num_rxed_packets;
+
+
+  // publishes the debug information (a slightly formatted version of the incoming ethercat packet):
+  if (debug_publisher->trylock())
+  {
+    debug_publisher->msg_.header.stamp = ros::Time::now();
+
+    debug_publisher->msg_.sensors.clear();
+    for (unsigned int i = 0; i < SENSORS_NUM_0220 + 1; ++i)
+    {
+      debug_publisher->msg_.sensors.push_back(status_data->sensors[i]);
+    }
+
+    debug_publisher->msg_.motor_data_type.data = static_cast<int> (status_data->motor_data_type);
+    debug_publisher->msg_.which_motors = status_data->which_motors;
+    debug_publisher->msg_.which_motor_data_arrived = status_data->which_motor_data_arrived;
+    debug_publisher->msg_.which_motor_data_had_errors = status_data->which_motor_data_had_errors;
+
+    debug_publisher->msg_.motor_data_packet_torque.clear();
+    debug_publisher->msg_.motor_data_packet_misc.clear();
+    for (unsigned int i = 0; i < NUM_MOTORS; ++i)
+    {
+      debug_publisher->msg_.motor_data_packet_torque.push_back(status_data->motor_data_packet[i].torque);
+      debug_publisher->msg_.motor_data_packet_misc.push_back(status_data->motor_data_packet[i].misc);
+    }
+
+    debug_publisher->msg_.tactile_data_type = static_cast<unsigned int> (
+            static_cast<int32u>(status_data->tactile_data_type));
+    debug_publisher->msg_.tactile_data_valid = static_cast<unsigned int> (
+            static_cast<int16u> (status_data->tactile_data_valid));
+    debug_publisher->msg_.tactile.clear();
+    for (unsigned int i = 0; i < 5; ++i)
+    {
+      debug_publisher->msg_.tactile.push_back(
+              static_cast<unsigned int> (static_cast<int16u> (status_data->tactile[i].word[0])));
+    }
+
+    debug_publisher->msg_.idle_time_us = status_data->idle_time_us;
+
+    debug_publisher->unlockAndPublish();
+  }
+
+  // the data of a lost or repeated frame must not be decoded (a status with all the
+  // motors has no field changing at each frame: it can't be told from a repeated one)
+  const shadow_robot::FrameMonitor::FrameStatus frame_status = sr_hand_lib->frame_monitor->check_frame(
+          status_data->EDC_command != EDC_COMMAND_INVALID, this_buffer + command_size_, prev_buffer + command_size_,
+          ETHERCAT_STATUS_DATA_SIZE, (status_data->which_motors & WHICH_MOTORS_ALL) == 0);
+  if (frame_status == shadow_robot::FrameMonitor::FRAME_LOST)
+  {
+    // received empty message: the pic is not writing to its mailbox.
+    ++zero_buffer_read;
+    float percentage_packet_loss = 100.f * (static_cast<float>(zero_buffer_read) /
+            static_cast<float>(num_rxed_packets));
+
+    SR_RT_LOG_DEBUG("Reception error detected : %d errors out of %d rxed packets (%2.3f%%) ; idle time %dus",
+                    zero_buffer_read, num_rxed_packets, percentage_packet_loss, status_data->idle_time_us);
+    prev_status_decoded_ = false;
+  }
+  if (frame_status != shadow_robot::FrameMonitor::FRAME_OK)
+  {
+    // hold (or extrapolate) the joint states until the next new frame
+    sr_hand_lib->frame_missed();
+    // the idle time of this frame isn't a new one, it's not sampled by the load governor
+    sr_hand_lib->load_governor->end_processing();
+    // the CAN bridge data of a lost or repeated frame aren't a new reply: the request in flight
+    // isn't checked against them (it is sent again on timeout)
+    return true;
+  }
+
+  // The tactile and aux sections often stay the same between two frames (no new reply from the
+  // sensors): they don't need to be decoded again if they didn't change since the previous status.
+  const unsigned char *tactile_section = this_buffer + command_size_ + STATUS_TACTILE_START;
+  const unsigned char *prev_tactile_section = prev_buffer + command_size_ + STATUS_TACTILE_START;
+  sr_hand_lib->set_tactile_data_unchanged(
+          prev_status_decoded_ &&
+          memcmp(tactile_section, prev_tactile_section, STATUS_TACTILE_LENGTH + STATUS_AUX_LENGTH) == 0);
+  prev_status_decoded_ = true;
+
+  // We received a coherent message.
+  // Update the library (positions, diagnostics values, actuators, etc...)
+  // with the received information
+  sr_hand_lib->update(status_data);
+
+  // Now publish the additional data at publishing_rate, slower when the load governor sheds the publishing
+  const unsigned int publishing_divider = sr_hand_lib->load_governor->divider(shadow_robot::LoadGovernor::PUBLISHING);
+  if (cycle_count >= publishing_cycles_ * publishing_divider)
+  {
+    // publish tactiles if we have them
+    if (sr_hand_lib->tactiles != NULL)
+    {
+      sr_hand_lib->tactiles->publish();
+    }
+
+    // And we also publish the additional data (accelerometer / gyroscope / analog inputs)
+    std_msgs::Float64MultiArray extra_analog_msg;
+    extra_analog_msg.layout.dim.resize(3);
+    extra_analog_msg.data.resize(3 + 3 + 4);
+    std::vector<double> data;
+
+    extra_analog_msg.layout.dim[0].label = "accelerometer";
+    extra_analog_msg.layout.dim[0].size = 3;
+    extra_analog_msg.data[0] = status_data->sensors[ACCX];
+    extra_analog_msg.data[1] = status_data->sensors[ACCY];
+    extra_analog_msg.data[2] = status_data->sensors[ACCZ];
+
+    extra_analog_msg.layout.dim[1].label = "gyrometer";
+    extra_analog_msg.layout.dim[1].size = 3;
+    extra_analog_msg.data[3] = status_data->sensors[GYRX];
+    extra_analog_msg.data[4] = status_data->sensors[GYRY];
+    extra_analog_msg.data[5] = status_data->sensors[GYRZ];
+
+    extra_analog_msg.layout.dim[2].label = "analog_inputs";
+    extra_analog_msg.layout.dim[2].size = 4;
+    extra_analog_msg.data[6] = status_data->sensors[ANA0];
+    extra_analog_msg.data[7] = status_data->sensors[ANA1];
+    extra_analog_msg.data[8] = status_data->sensors[ANA2];
+    extra_analog_msg.data[9] = status_data->sensors[ANA3];
+
+    if (extra_analog_inputs_publisher->trylock())
+    {
+      extra_analog_inputs_publisher->msg_ = extra_analog_msg;
+      extra_analog_inputs_publisher->unlockAndPublish();
+    }
+
+    cycle_count = 0;
+  }
+  ++cycle_count;
+
+  sr_hand_lib->load_governor->end_processing();
+  sr_hand_lib->load_governor->sample(status_data->idle_time_us);
+
+  // Check if the packet acks the flashing packet in flight (the next one is then sent in the next frame),
+  // or answers one of the CAN bridge requests
+  check_CAN_reply(can_data);
+
+  return true;
+}
+
+void SR10::reinitialize_boards()
+{
+  // Reinitialize motors information
+  sr_hand_lib->reinitialize_motors();
+}
+
+void SR10::get_board_id_and_can_bus(int board_id, int *can_bus, unsigned int *board_can_id)
+{
+  // We're using 2 can busses,
+  // if motor id is between 0 and 9, then we're using the can_bus 1
+  // else, we're using the can bus 2.
+  int motor_id_tmp = board_id;
+  if (motor_id_tmp > 9)
+  {
+    motor_id_tmp -= 10;
+    *can_bus = 2;
+  }
+  else
+  {
+    *can_bus = 1;
+  }
+
+  *board_can_id = motor_id_tmp;
+}
+
+/* For the emacs weenies in the crowd.
+   Local Variables:
+   c-basic-offset: 2
+   End:
+ */
@@ -31,6 +31,7 @@
 
 
 #include <sr_edc_ethercat_drivers/sr_edc.h>
+#include <sr_robot_lib/rt_logger.hpp>
 
 #include <realtime_tools/realtime_publisher.h>
 
@@ -39,12 +40,13 @@
 #include <sstream>
 #include <iomanip>
 #include <boost/foreach.hpp>
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
 #include <std_msgs/Int16.h>
 #include <math.h>
 #include <fcntl.h>
 #include <stdio.h>
 #include <pthread.h>
-#include <bfd.h>
 
 #include <sr_utilities/sr_math_utils.hpp>
 
@@ -70,47 +72,27 @@ namespace is_edc_command_32_bits
 
 const unsigned int SrEdc::max_retry = 20;
 
-#define ETHERCAT_CAN_BRIDGE_DATA_SIZE sizeof(ETHERCAT_CAN_BRIDGE_DATA)
+namespace
+{
+  /// the user application is between the bootloader and the debugger code
+  const unsigned int application_start = 0x04C0;
+  const unsigned int application_end = 0x7DC0;
+  /// the flash is erased by rows of 64 bytes
+  const unsigned int flash_row_size = 64;
+  /// packets to write a block of 32 bytes: 1 address + 4 data packets, or 5 streamed data packets
+  const unsigned int packets_per_block = 5;
+  /// the CRC are first compared by regions of 1kB, then by rows in the regions which differ
+  const unsigned int crc_region_size = 1024;
+
+  /// The reply to a CanBridgeRequest service call, recognised by its id.
+  bool reply_id_matches(int16u reply_id, int16u reply_mask, const ETHERCAT_CAN_BRIDGE_DATA &reply)
+  {
+    return (reply.message_id & reply_mask) == (reply_id & reply_mask);
+  }
+}  // namespace
 
+#define ETHERCAT_CAN_BRIDGE_DATA_SIZE sizeof(ETHERCAT_CAN_BRIDGE_DATA)
 
-#define check_for_pthread_mutex_init_error(x)  switch (x)               \
-  {                                                                     \
-  case EAGAIN:                                                          \
-    ROS_ERROR("The system temporarily lacks the resources to create another mutex : %s:%d", __FILE__, __LINE__); \
-    exit(1);                                                            \
-    break;                                                              \
-  case EINVAL:                                                          \
-    ROS_ERROR("The value specified as attribute is invalid for mutex init : %s:%d", __FILE__, __LINE__); \
-    exit(1);                                                            \
-    break;                                                              \
-  case ENOMEM:                                                          \
-    ROS_ERROR("The process cannot allocate enough memory to create another mutex : %s:%d", __FILE__, __LINE__); \
-    exit(1);                                                            \
-    break;                                                              \
-  case 0: /* SUCCESS */                                                 \
-    break;                                                              \
-  default:                                                              \
-    ROS_ERROR("unknown error value, is this POSIX system ? : %s:%d", __FILE__, __LINE__); \
-    exit(1);                                                            \
-  }
-
-#define unlock(x)  switch ( pthread_mutex_unlock(x) )              \
-  {                                                                     \
-  case EINVAL:                                                          \
-    ROS_ERROR("The value specified as a mutex is invalid : %s:%d", __FILE__, __LINE__); \
-    exit(1);                                                            \
-    break;                                                              \
-  case EPERM:                                                           \
-    ROS_ERROR("The current thread does not hold a lock on the mutex : %s:%d", __FILE__, __LINE__); \
-    exit(1);                                                            \
-    break;                                                              \
-  }
-
-#define check_for_trylock_error(x)  if (x == EINVAL)        \
-  {                                                             \
-    ROS_ERROR("mutex error %s:%d", __FILE__, __LINE__);         \
-    exit(1);                                                    \
-  }
 
 /** \brief Constructor of the SrEdc driver
  *
@@ -120,16 +102,22 @@ const unsigned int SrEdc::max_retry = 20;
  */
 SrEdc::SrEdc()
         : flashing(false),
-          can_message_sent(true),
-          can_packet_acked(true),
-          can_bus_(0),
-          counter_(0)
+          flash_while_streaming_(false),
+          can_direct_mode_(false),
+          compact_process_data_(false),
+          counter_(0),
+          next_flashing_bus_(0),
+          differential_flashing_(true)
 {
-  int res = 0;
-  check_for_pthread_mutex_init_error(res);
-
-  res = pthread_mutex_init(&producing, NULL);
-  check_for_pthread_mutex_init_error(res);
+  flashing_buses_[0].can_bus = 1;
+  flashing_buses_[0].motor = 0;
+  flashing_buses_[0].streaming = false;
+  flashing_buses_[1].can_bus = 2;
+  flashing_buses_[1].motor = 0;
+  flashing_buses_[1].streaming = false;
+
+  // start the realtime logger now rather than from the first log in the realtime loop
+  shadow_robot::RtLogger::instance();
 }
 
 /** \brief Construct function, run at startup to set SyncManagers and FMMUs
@@ -160,6 +148,11 @@ SrEdc::SrEdc()
  *   data, finger tips data and motor data. The other is the can command response in CAN_DIRECT_MODE. When doing a flashing in bootloading mode this is usually an acknowledgment
  *   from the bootloader. This Mailbox is at logical address 0x10038 and mapped via a FMMU to physical address 0x1038.
  *
+ * With the ~compact_process_data parameter, the CAN bridge command and status are left out: each Mailbox only
+ * contains the data of the first command / status, and only their two SyncManagers are set. This shortens every
+ * frame, but the CAN bridge can't be used (no flashing nor CAN bridge requests) until the driver is restarted with
+ * the full layout, as the process data are only laid out once, when the EtherCAT master starts.
+ *
  * This function sets the two private members command_size_ and status_size_ to be the size of each Mailbox.
  * It is important for these numbers to be accurate since they are used by the EthercatHardware class when manipulating the buffers.
  * If you need to have several commands like in this SrEdc driver, put the sum of the size, same thing for the status.
@@ -190,7 +183,15 @@ void SrEdc::construct(EtherCAT_SlaveHandler *sh, int &start_address, unsigned in
 
   nodehandle_ = ros::NodeHandle(device_id_);
   nh_tilde_ = ros::NodeHandle(ros::NodeHandle("~"), device_id_);
-  serviceServer = nodehandle_.advertiseService("SimpleMotorFlasher", &SrEdc::simple_motor_flasher, this);
+  flash_motor_firmware_server_ = nodehandle_.advertiseService("FlashMotorFirmware", &SrEdc::flash_motor_firmware,
+                                                             this);
+  nh_tilde_.param("differential_flashing", differential_flashing_, true);
+
+  std::string can_capture_file;
+  if (nh_tilde_.getParam("can_capture_file", can_capture_file) && !can_capture_file.empty())
+  {
+    can_bridge_capture_.start(can_capture_file);
+  }
 
   // get the alias from the parameter server if it exists
   std::string path_to_prefix, prefix;
@@ -206,13 +207,20 @@ void SrEdc::construct(EtherCAT_SlaveHandler *sh, int &start_address, unsigned in
     device_joint_prefix_ = "";
   }
 
+  nh_tilde_.param("compact_process_data", compact_process_data_, false);
+  if (compact_process_data_)
+  {
+    ROS_INFO("Compact process data: the CAN bridge isn't mapped (no flashing nor CAN bridge requests)");
+  }
+  unsigned int mapped_can_bridge_data_size = compact_process_data_ ? 0 : ethercat_can_bridge_data_size;
+
   command_base_ = start_address;
-  command_size_ = ethercat_command_data_size + ethercat_can_bridge_data_size;
+  command_size_ = ethercat_command_data_size + mapped_can_bridge_data_size;
 
   start_address += command_size_;
 
   status_base_ = start_address;
-  status_size_ = ethercat_status_data_size + ethercat_can_bridge_data_size;
+  status_size_ = ethercat_status_data_size + mapped_can_bridge_data_size;
 
   start_address += status_size_;
 
@@ -261,26 +269,40 @@ void SrEdc::construct(EtherCAT_SlaveHandler *sh, int &start_address, unsigned in
 
   sh->set_fmmu_config(fmmu);
 
-  EtherCAT_PD_Config *pd = new EtherCAT_PD_Config(4);
-
-  (*pd)[0] = EC_SyncMan(ethercat_command_data_address, ethercat_command_data_size, EC_QUEUED, EC_WRITTEN_FROM_MASTER);
-  (*pd)[1] = EC_SyncMan(ethercat_can_bridge_data_command_address, ethercat_can_bridge_data_size, EC_QUEUED,
-                        EC_WRITTEN_FROM_MASTER);
-  (*pd)[2] = EC_SyncMan(ethercat_status_data_address, ethercat_status_data_size, EC_QUEUED);
-  (*pd)[3] = EC_SyncMan(ethercat_can_bridge_data_status_address, ethercat_can_bridge_data_size, EC_QUEUED);
+  EtherCAT_PD_Config *pd = new EtherCAT_PD_Config(compact_process_data_ ? 2 : 4);
 
-  status_size_ = ethercat_status_data_size + ethercat_can_bridge_data_size;
-
-  (*pd)[0].ChannelEnable = true;
-  (*pd)[0].ALEventEnable = true;
-  (*pd)[0].WriteEvent = true;
+  if (compact_process_data_)
+  {
+    (*pd)[0] = EC_SyncMan(ethercat_command_data_address, ethercat_command_data_size, EC_QUEUED,
+                          EC_WRITTEN_FROM_MASTER);
+    (*pd)[1] = EC_SyncMan(ethercat_status_data_address, ethercat_status_data_size, EC_QUEUED);
 
-  (*pd)[1].ChannelEnable = true;
-  (*pd)[1].ALEventEnable = true;
-  (*pd)[1].WriteEvent = true;
+    (*pd)[0].ChannelEnable = true;
+    (*pd)[0].ALEventEnable = true;
+    (*pd)[0].WriteEvent = true;
 
-  (*pd)[2].ChannelEnable = true;
-  (*pd)[3].ChannelEnable = true;
+    (*pd)[1].ChannelEnable = true;
+  }
+  else
+  {
+    (*pd)[0] = EC_SyncMan(ethercat_command_data_address, ethercat_command_data_size, EC_QUEUED,
+                          EC_WRITTEN_FROM_MASTER);
+    (*pd)[1] = EC_SyncMan(ethercat_can_bridge_data_command_address, ethercat_can_bridge_data_size, EC_QUEUED,
+                          EC_WRITTEN_FROM_MASTER);
+    (*pd)[2] = EC_SyncMan(ethercat_status_data_address, ethercat_status_data_size, EC_QUEUED);
+    (*pd)[3] = EC_SyncMan(ethercat_can_bridge_data_status_address, ethercat_can_bridge_data_size, EC_QUEUED);
+
+    (*pd)[0].ChannelEnable = true;
+    (*pd)[0].ALEventEnable = true;
+    (*pd)[0].WriteEvent = true;
+
+    (*pd)[1].ChannelEnable = true;
+    (*pd)[1].ALEventEnable = true;
+    (*pd)[1].WriteEvent = true;
+
+    (*pd)[2].ChannelEnable = true;
+    (*pd)[3].ChannelEnable = true;
+  }
 
   sh->set_pd_config(pd);
 
@@ -289,309 +311,648 @@ void SrEdc::construct(EtherCAT_SlaveHandler *sh, int &start_address, unsigned in
 
 /** \brief Erase the PIC18F Flash memory
  *
- *  This function fills the can_message_ struct with a CAN message
- *  which tells the bootloader of the PIC18F to erase its Flash memory
+ *  This function sends a CAN message which tells the bootloader
+ *  of the PIC18F to erase its Flash memory, until it's acknowledged.
+ *
+ * @param bus the CAN bus of the motor being flashed
+ *
+ * @return false if the command was never acknowledged
  */
-void SrEdc::erase_flash(void)
+bool SrEdc::erase_flash(FlashingBus &bus)
 {
-  unsigned char cmd_sent;
-  unsigned int wait_time;
   bool timedout = true;
-  unsigned int timeout;
-  int err;
 
-  while (timedout)
+  for (unsigned int retry = 0; timedout && retry < max_retry; ++retry)
   {
-    ROS_INFO("Erasing FLASH");
-    // First we send the erase command
-    cmd_sent = 0;
-    while (!cmd_sent)
-    {
-      if (!(err = pthread_mutex_trylock(&producing)))
-      {
-        can_message_.message_length = 1;
-        can_message_.can_bus = can_bus_;
-        can_message_.message_id = 0x0600 | (motor_being_flashed << 5) | ERASE_FLASH_COMMAND;
-        cmd_sent = 1;
-        unlock(&producing);
-      }
-      else
-      {
-        check_for_trylock_error(err);
-      }
-    }
-    wait_time = 0;
-    timeout = 3000;
-    can_message_sent = false;
-    can_packet_acked = false;
-    timedout = false;
-    while (!can_packet_acked)
-    {
-      usleep(1000);
-      if (wait_time > timeout)
-      {
-        timedout = true;
-        break;
-      }
-      wait_time++;
-    }
+    ROS_INFO("Erasing FLASH of motor %u on CAN bus %d", bus.motor, bus.can_bus);
+    send_CAN_msg(bus, 0x0600 | (bus.motor << 5) | ERASE_FLASH_COMMAND, 1, NULL, 3000, &timedout);
 
     if (timedout)
     {
       ROS_ERROR("ERASE command timedout, resending it !");
     }
-  };
+  }
+  return !timedout;
 }
 
-/** \brief Function that reads back 8 bytes from PIC18F program memory
+/** \brief Builds a CAN message for the bootloader of the motor being flashed on a bus
+ *
+ * @param bus the CAN bus of the motor being flashed
+ * @param command the bootloader command
+ * @param length the length in bytes of the data (which is zeroed)
  *
- *  Flash memory is the program memory on the PIC18F
- *  This function is here to read back what we flashed into the PIC18F
- *  To check that there was no flashing transmission or writting error
- *  during the Flashing process.
- *  8 bytes will be read, from address baddr + offset
- *  This function will fill the can_message_ structure with the correct value
- *  to allow the packCommand() function to send the correct etherCAT message
- *  to the PIC32 which will then send the correct CAN message to the PIC18F
+ * @return the CAN message
+ */
+ETHERCAT_CAN_BRIDGE_DATA SrEdc::bootloader_command(const FlashingBus &bus, int8u command, int8u length) const
+{
+  ETHERCAT_CAN_BRIDGE_DATA message;
+  message.can_bus = bus.can_bus;
+  message.message_length = length;
+  message.message_id = 0x0600 | (bus.motor << 5) | command;
+  bzero(message.message_data, sizeof(message.message_data));
+  return message;
+}
+
+/** \brief Builds a CAN message for the bootloader of the motor being flashed on a bus, carrying a flash address
  *
- * @param offset The position of the 8 bytes we want to read, relative to the base address
- * @param baddr the base address
+ * @param bus the CAN bus of the motor being flashed
+ * @param command the bootloader command (READ_FLASH_COMMAND or WRITE_FLASH_ADDRESS_COMMAND)
+ * @param address the address in the flash of the PIC18F
  *
- * @return Returns true if the command has timed out, false if the command was properly acknowledged
+ * @return the CAN message
  */
-bool SrEdc::read_flash(unsigned int offset, unsigned int baddr)
-{
-  unsigned int cmd_sent;
-  int err;
-  unsigned int wait_time;
-  bool timedout;
-  unsigned int timeout;
-  cmd_sent = 0;
-  while (!cmd_sent)
-  {
-    if (!(err = pthread_mutex_trylock(&producing)))
-    {
-      ROS_DEBUG("Sending READ data ... position : %03x", pos);
-      can_message_.can_bus = can_bus_;
-      can_message_.message_length = 3;
-      can_message_.message_id = 0x0600 | (motor_being_flashed << 5) | READ_FLASH_COMMAND;
-      can_message_.message_data[2] = (offset + baddr) >> 16;
-      can_message_.message_data[1] = (offset + baddr) >> 8;  // User application start address is 0x4C0
-      can_message_.message_data[0] = offset + baddr;
-      cmd_sent = 1;
-      unlock(&producing);
-    }
-    else
-    {
-      check_for_trylock_error(err);
-    }
-  }
-  timedout = false;
-  wait_time = 0;
-  timeout = 100;
-  can_message_sent = false;
-  can_packet_acked = false;
-  while (!can_packet_acked)
+ETHERCAT_CAN_BRIDGE_DATA SrEdc::bootloader_address_command(const FlashingBus &bus, int8u command,
+                                                           unsigned int address) const
+{
+  ETHERCAT_CAN_BRIDGE_DATA message = bootloader_command(bus, command, 3);
+  message.message_data[2] = address >> 16;
+  message.message_data[1] = address >> 8;  // User application start address is 0x4C0
+  message.message_data[0] = address;
+  return message;
+}
+
+SrEdc::FlashingBus &SrEdc::get_flashing_bus(int board_id)
+{
+  int can_bus;
+  unsigned int board_can_id;
+  get_board_id_and_can_bus(board_id, &can_bus, &board_can_id);
+
+  FlashingBus &bus = flashing_buses_[can_bus == 2 ? 1 : 0];
+  bus.can_bus = can_bus;
+  bus.motor = board_can_id;
+  return bus;
+}
+
+unsigned char SrEdc::FirmwareImage::at(unsigned int address) const
+{
+  if (address < base_addr || address >= base_addr + total_size)
   {
-    usleep(1000);
-    if (wait_time > timeout)
-    {
-      timedout = true;
-      break;
-    }
-    wait_time++;
+    return 0xFF;
   }
-  return timedout;
+  return content[address - base_addr];
 }
 
-/** \brief ROS Service that flashes a new firmware into a SimpleMotor board
- *
- *  This function is a ROS Service, aimed at flashing a new firmware into the
- *  PIC18F of a SimpleMotor board through a CAN bootloader protocol.
+/** \brief Computes the CRC of the flash once the firmware is written
  *
- *  The CAN bootloader allows for several commands to be executed : read_flash, erase_flash, write_flash, reboot, read_version
+ *  Same CRC-16-CCITT as the CRC_FLASH_COMMAND of the bootloader (initial value 0xFFFF, polynomial 0x1021).
  *
- *  This service will fill a can_message_ structure and then switch a few boolean values to "false" in order to trigger
- *  the message to be sent by the SRXX::packCommand() function. And then repeat the process for another message, and so on.
+ * @param address the first address of the flash
+ * @param length the number of bytes
  *
- *  This service will first read all the sections of the firmware using libbfd and find out the lowest and highest addresses containing code.
- *  Then it will allocate an array to contain the firmware's code. The size is (highest_addr - lowest_addr).
- *  The bfd library provides functions to manage object files more easily. To better understand some of the concepts used below,
- *  the following link can be useful:
- *  http://www.delorie.com/gnu/docs/binutils/ld_7.html
- *  The use of the following commands can also help to understand the structure of the object file containing the firmware
- *  \code objdump -x simplemotor.hex \endcode
- *  \code objdump -s simplemotor.hex \endcode
+ * @return the CRC
+ */
+int16u SrEdc::FirmwareImage::crc(unsigned int address, unsigned int length) const
+{
+  int16u value = 0xFFFF;
+  for (unsigned int i = 0; i < length; ++i)
+  {
+    value ^= static_cast<int16u>(at(address + i)) << 8;
+    for (unsigned int bit = 0; bit < 8; ++bit)
+    {
+      value = (value & 0x8000) ? static_cast<int16u>((value << 1) ^ 0x1021) : static_cast<int16u>(value << 1);
+    }
+  }
+  return value;
+}
+
+/** \brief Flashes a new firmware into a SimpleMotor board
  *
- *  - Then it will send a MAGIC PACKET command to the PIC18F which will make it reboot in bootloader mode (regardless of whether it was already in
+ *  - It will send a MAGIC PACKET command to the PIC18F which will make it reboot in bootloader mode (regardless of whether it was already in
  *  bootloader mode or whether it was running the SimpleMotor code)
  *  - Then it will send an ERASE_FLASH command to the PIC18F.
  *  - Then it will send a WRITE_FLASH_ADDRESS_COMMAND to tell the PIC18F
  *  where we wanna write, and then 4 WRITE_FLASH_DATA commands (we write by blocks of 32 bytes). This process is repeated untill we've written
  *  all the firmware code, padding with 0x00 bytes in the end if the size is not a multiple of 32 bytes.
  *  The process starts at address (lowest_addr) and ends at (hiest_addr) + a few padding bytes if necessary.
+ *  - Then it reads the flash back to check it, and resets the PIC18F.
  *
- *  You can call this service using this command :
+ *  Only the flashing pipeline of the CAN bus of the motor is used: a motor on each bus can be flashed at the same time.
  *
- *  \code rosservice call SimpleMotorFlasher "/home/hand/simplemotor.hex" 8 \endcode
+ * @param bus the CAN bus of the motor, with the id of the motor to flash
+ * @param firmware the firmware to write
+ * @param result the time spent in each phase, and the error if it failed
  *
- *  This will flash the "simplemotor.hex" firmware to the motor 8
- *
- *  @param req The Request, contains the ID of the motor we want to flash via req.motor_id, and the path of the firmware to flash in req.firmware
- *  @param res The Response, it is always SUCCESS for now.
- *
- *  @return This returns always true, the real return value is in the res parameter
+ * @return true if the firmware was written and verified
  */
-bool SrEdc::simple_motor_flasher(sr_robot_msgs::SimpleMotorFlasher::Request &req,
-                                 sr_robot_msgs::SimpleMotorFlasher::Response &res)
-{
-  bfd *fd;
-  unsigned int base_addr;
-  unsigned int smallest_start_address = 0x7fff;
-  unsigned int biggest_end_address = 0;
-  unsigned int total_size = 0;
+bool SrEdc::flash_motor(FlashingBus &bus, const FirmwareImage &firmware,
+                        sr_edc_ethercat_drivers::MotorFlashResult *result)
+{
   bool timedout = true;
+  const bool was_in_can_direct_mode = can_direct_mode_.load();
 
-  get_board_id_and_can_bus(req.motor_id, &can_bus_, &motor_being_flashed);
+  // @todo Check if it's necessary to send this dummy packet before the magic packet
+  ROS_DEBUG("Sending dummy packet");
+  send_CAN_msg(bus, 0, 0, NULL, 1, &timedout);
 
-  binary_content = NULL;
-  flashing = true;
+  ROS_INFO_STREAM("Switching motor " << bus.motor << " on CAN bus " << bus.can_bus << " into bootloader mode");
+  ros::WallTime phase_start = ros::WallTime::now();
+  // Send the magic packet that will force the microcontroller to go into bootloader mode
+  int8u magic_packet[] = {0x55, 0xAA, 0x55, 0xAA, 0x55, 0xAA, 0x55, 0xAA};
+  send_CAN_msg(bus, 0x0600 | (bus.motor << 5) | 0b1010, 8, magic_packet, 100, &timedout);
 
-  ROS_INFO("Flashing the motor");
+  // Send a second magic packet if the first one wasn't acknowledged
+  if (timedout)
+  {
+    ROS_WARN("First magic CAN packet timedout");
+    ROS_WARN("Sending another magic CAN packet to put the motor in bootloading mode");
+    send_CAN_msg(bus, 0x0600 | (bus.motor << 5) | 0b1010, 8, magic_packet, 100, &timedout);
+  }
 
-  // Initialize the bfd library: "This routine must be called before any other BFD
-  // function to initialize magical internal data structures."
-  bfd_init();
+  // An older palm firmware ignores the CAN bridge packets in the sensor data frames
+  if (timedout && !was_in_can_direct_mode)
+  {
+    // the other bus may have switched already: only the first one switches the mode
+    bool expected = false;
+    if (can_direct_mode_.compare_exchange_strong(expected, true))
+    {
+      ROS_WARN("The magic packets weren't ACKed while streaming the sensor data, switching to CAN direct mode "
+               "(the rest of the hand stops until the flashing is finished)");
+      flash_while_streaming_.store(false);
+    }
+    send_CAN_msg(bus, 0x0600 | (bus.motor << 5) | 0b1010, 8, magic_packet, 100, &timedout);
+  }
 
-  // Open the requested firmware object file
-  fd = bfd_openr(req.firmware.c_str(), NULL);
-  if (fd == NULL)
+  if (timedout)
   {
-    ROS_ERROR("error opening the file %s", get_filename(req.firmware).c_str());
-    res.value = res.FAIL;
-    flashing = false;
+    ROS_ERROR("None of the magic packets were ACKed, didn't bootload the motor.");
+    result->error = "None of the magic packets were acknowledged";
     return false;
   }
+  result->bootloader_time = (ros::WallTime::now() - phase_start).toSec();
 
-  // Check that bfd recognises the file as a correctly formatted object file
-  if (!bfd_check_format(fd, bfd_object))
+  // The new bootloader commands only accept the user application
+  bool in_application = firmware.base_addr >= application_start &&
+                        firmware.base_addr + firmware.total_size <= application_end;
+
+  // The blocks are streamed (one ack per block) if the bootloader supports it
+  bus.streaming = in_application && (firmware.base_addr % 32) == 0 && bootloader_supports_streaming(bus);
+  result->streamed = bus.streaming;
+
+  // Only the rows which changed are written if the bootloader can compute the CRC of the flash
+  result->differential = differential_flashing_ && in_application && bootloader_supports_crc(bus);
+  if (result->differential)
   {
-    if (bfd_get_error() != bfd_error_file_ambiguously_recognized)
+    if (!flash_modified_rows(bus, firmware, result))
     {
-      ROS_ERROR("Incompatible format");
-      res.value = res.FAIL;
-      flashing = false;
       return false;
     }
   }
+  else if (!flash_whole_firmware(bus, firmware, result))
+  {
+    return false;
+  }
 
-  ROS_INFO("firmware %s's format is : %s.", get_filename(req.firmware).c_str(), fd->xvec->name);
+  ROS_INFO("Resetting microcontroller.");
+  // Then we send the RESET command to PIC18F
+  timedout = true;
+  for (unsigned int retry = 0; timedout && retry < max_retry; ++retry)
+  {
+    send_CAN_msg(bus, 0x0600 | (bus.motor << 5) | RESET_COMMAND, 0, NULL, 1000, &timedout);
+  }
+  if (timedout)
+  {
+    ROS_ERROR("The RESET command was never ACKed by motor %u on CAN bus %d", bus.motor, bus.can_bus);
+    result->error = "The reset command was never acknowledged";
+    return false;
+  }
 
-  // @todo Check if it's necessary to send this dummy packet before the magic packet
-  ROS_DEBUG("Sending dummy packet");
-  send_CAN_msg(can_bus_, 0, 0, NULL, 1, &timedout);
+  ROS_INFO("Flashed %u bytes to motor %u on CAN bus %d (%u bytes written): bootloader %.3fs, compare %.3fs, "
+           "erase %.3fs, write %.3fs (%.2f kB/s), verify %.3fs",
+           firmware.total_size, bus.motor, bus.can_bus, result->bytes_written, result->bootloader_time,
+           result->compare_time, result->erase_time, result->write_time,
+           result->bytes_written / 1024.0 / std::max(result->write_time, 1e-6), result->verify_time);
+  return true;
+}
 
-  ROS_INFO_STREAM("Switching motor " << motor_being_flashed << " on CAN bus " << can_bus_ << " into bootloader mode");
-  // Send the magic packet that will force the microcontroller to go into bootloader mode
-  int8u magic_packet[] = {0x55, 0xAA, 0x55, 0xAA, 0x55, 0xAA, 0x55, 0xAA};
-  send_CAN_msg(can_bus_, 0x0600 | (motor_being_flashed << 5) | 0b1010, 8, magic_packet, 100, &timedout);
+/** \brief Erases the whole user application, then writes and reads back the whole firmware
+ *
+ * @param bus the CAN bus of the motor, in bootloader mode
+ * @param firmware the firmware to write
+ * @param result the time spent in each phase, and the error if it failed
+ *
+ * @return true if the firmware was written and verified
+ */
+bool SrEdc::flash_whole_firmware(FlashingBus &bus, const FirmwareImage &firmware,
+                                 sr_edc_ethercat_drivers::MotorFlashResult *result)
+{
+  // Erase the PIC18 microcontroller flash memory
+  // (the erase is only acked once it's finished, there's no need to wait after it)
+  ros::WallTime phase_start = ros::WallTime::now();
+  if (!erase_flash(bus))
+  {
+    ROS_ERROR("Too much retry for ERASE, try flashing again");
+    result->error = "The erase command was never acknowledged";
+    return false;
+  }
+  result->erase_time = (ros::WallTime::now() - phase_start).toSec();
 
-  // Send a second magic packet if the first one wasn't acknowledged
-  if (timedout)
+  // The firmware is actually written to the flash memory of the PIC18
+  phase_start = ros::WallTime::now();
+  if (!write_flash_data(bus, firmware))
   {
-    ROS_WARN("First magic CAN packet timedout");
-    ROS_WARN("Sending another magic CAN packet to put the motor in bootloading mode");
-    send_CAN_msg(can_bus_, 0x0600 | (motor_being_flashed << 5) | 0b1010, 8, magic_packet, 100, &timedout);
+    result->error = "Too many write packets lost";
+    return false;
+  }
+  result->write_time = (ros::WallTime::now() - phase_start).toSec();
+  result->bytes_written = firmware.total_size;
 
-    if (timedout)
+  ROS_INFO("Verifying");
+  // Now we have to read back the flash content
+  phase_start = ros::WallTime::now();
+  if (!read_back_and_check_flash(bus, firmware))
+  {
+    result->error = "The flash read back doesn't match the firmware";
+    return false;
+  }
+  result->verify_time = (ros::WallTime::now() - phase_start).toSec();
+  return true;
+}
+
+/** \brief Only erases and writes the rows of the flash which differ from the firmware
+ *
+ *  The CRC of the user application is compared with the firmware by regions of 1kB, then by rows of
+ *  64 bytes in the regions which differ. Only those rows are erased and written (bytes which aren't in
+ *  the firmware must be 0xFF, as after a full erase). The whole user application is then verified with
+ *  one CRC per region.
+ *
+ * @param bus the CAN bus of the motor, in bootloader mode
+ * @param firmware the firmware to write
+ * @param result the time spent in each phase, and the error if it failed
+ *
+ * @return true if the firmware was written and verified
+ */
+bool SrEdc::flash_modified_rows(FlashingBus &bus, const FirmwareImage &firmware,
+                                sr_edc_ethercat_drivers::MotorFlashResult *result)
+{
+  ros::WallTime phase_start = ros::WallTime::now();
+  std::vector<unsigned int> regions;
+  if (!find_modified_regions(bus, firmware, application_start, application_end, crc_region_size, &regions))
+  {
+    result->error = "Too many CRC packets lost";
+    return false;
+  }
+
+  std::vector<unsigned int> rows;
+  for (size_t i = 0; i < regions.size(); ++i)
+  {
+    unsigned int region_end = std::min(regions[i] + crc_region_size, application_end);
+    if (!find_modified_regions(bus, firmware, regions[i], region_end, flash_row_size, &rows))
     {
-      ROS_ERROR("None of the magic packets were ACKed, didn't bootload the motor.");
-      res.value = res.FAIL;
-      flashing = false;
+      result->error = "Too many CRC packets lost";
       return false;
     }
   }
+  result->compare_time = (ros::WallTime::now() - phase_start).toSec();
+  ROS_INFO("%zu rows of %u bytes differ from the firmware", rows.size(), flash_row_size);
 
-  // Erase the PIC18 microcontroller flash memory
-  erase_flash();
+  // Each row is erased just before being written
+  phase_start = ros::WallTime::now();
+  if (!write_flash_rows(bus, firmware, rows))
+  {
+    result->error = "Too many write packets lost";
+    return false;
+  }
+  result->write_time = (ros::WallTime::now() - phase_start).toSec();
+  result->bytes_written = rows.size() * flash_row_size;
+
+  ROS_INFO("Verifying");
+  phase_start = ros::WallTime::now();
+  std::vector<unsigned int> modified;
+  if (!find_modified_regions(bus, firmware, application_start, application_end, crc_region_size, &modified))
+  {
+    result->error = "Too many CRC packets lost";
+    return false;
+  }
+  if (!modified.empty())
+  {
+    ROS_ERROR("The CRC of the flash at 0x%06X doesn't match the firmware, try flashing again", modified.front());
+    result->error = "The CRC of the flash doesn't match the firmware";
+    return false;
+  }
+  result->verify_time = (ros::WallTime::now() - phase_start).toSec();
+  return true;
+}
+
+/** \brief Checks if the bootloader can compute the CRC of the flash (an older bootloader doesn't reply)
+ *
+ * @param bus the CAN bus of the motor, in bootloader mode
+ *
+ * @return true if the CRC_FLASH_COMMAND was acknowledged
+ */
+bool SrEdc::bootloader_supports_crc(FlashingBus &bus)
+{
+  ETHERCAT_CAN_BRIDGE_DATA message = bootloader_address_command(bus, CRC_FLASH_COMMAND, application_start);
+  message.message_length = 5;
+  message.message_data[3] = flash_row_size;
+  message.message_data[4] = 0;
 
-  sleep(1);
+  for (unsigned int retry = 0; retry < 2; ++retry)
+  {
+    bus.pipeline.clear();
+    bus.pipeline.add(message);
+    if (bus.pipeline.run(100) == 1)
+    {
+      return true;
+    }
+  }
 
-  // Look for the start and end address of every section in the hex file,
-  // to detect the lowest and highest address of the data we need to write in the PIC's flash.
-  find_address_range(fd, &smallest_start_address, &biggest_end_address);
+  ROS_WARN("The bootloader of motor %u on CAN bus %d can't compute the CRC of its flash, writing the whole firmware",
+           bus.motor, bus.can_bus);
+  return false;
+}
 
-  // Calculate the size of the chunk of data to be flashed
-  total_size = biggest_end_address - smallest_start_address;
-  base_addr = smallest_start_address;
+/** \brief Checks if the bootloader supports the streamed write (an older bootloader doesn't reply)
+ *
+ *  An empty streamed write is started at the beginning of the user application.
+ *
+ * @param bus the CAN bus of the motor, in bootloader mode
+ *
+ * @return true if the STREAM_WRITE_HEADER_COMMAND was acknowledged
+ */
+bool SrEdc::bootloader_supports_streaming(FlashingBus &bus)
+{
+  ETHERCAT_CAN_BRIDGE_DATA message = bootloader_address_command(bus, STREAM_WRITE_HEADER_COMMAND, application_start);
+  message.message_length = 5;
+  message.message_data[3] = 0;
+  message.message_data[4] = 0;
 
-  // Allocate the memory space to store the data to be flashed
-  // This could be done with new bfd_byte[total_size+8] and delete() instead of malloc()
-  // and free() but will stay this way for the moment
-  binary_content = reinterpret_cast<bfd_byte *>(malloc(total_size + 8));
-  if (binary_content == NULL)
+  for (unsigned int retry = 0; retry < 2; ++retry)
   {
-    ROS_ERROR("Error allocating memory for binary_content");
-    res.value = res.FAIL;
-    flashing = false;
-    return false;
+    bus.pipeline.clear();
+    bus.pipeline.add(message);
+    if (bus.pipeline.run(100) == 1)
+    {
+      return true;
+    }
   }
 
-  // Set all the bytes in the binary_content to 0xFF initially (i.e. before reading the content from the hex file)
-  // This way we make sure that any byte in the region between smallest_start_address and biggest_end_address
-  // that is not included in any section of the hex file, will be written with a 0xFF value,
-  // which is the default in the PIC
-  memset(binary_content, 0xFF, total_size + 8);
+  ROS_WARN("The bootloader of motor %u on CAN bus %d doesn't support the streamed write, "
+           "acknowledging every packet", bus.motor, bus.can_bus);
+  return false;
+}
 
-  // The content of the firmware is read from the .hex file pointed by fd, to a memory region pointed by binary_content
-  if (!read_content_from_object_file(fd, binary_content, base_addr))
+/** \brief Compares the CRC of regions of the flash with the CRC of the firmware
+ *
+ *  The CRC of the region is computed by the bootloader, and the reply is compared with the expected one
+ *  in can_data_is_ack(): a region which differs stops the pipeline straight away (if the reply echoes
+ *  the address and length of the request in flight), and the next regions are sent again.
+ *
+ * @param bus the CAN bus of the motor, in bootloader mode
+ * @param firmware the firmware to compare with
+ * @param start the address of the first region
+ * @param end the end of the last region (which can be shorter than the others)
+ * @param region_size the size in bytes of the regions
+ * @param modified the address of the regions which differ are appended to this
+ *
+ * @return false if too many packets were lost
+ */
+bool SrEdc::find_modified_regions(FlashingBus &bus, const FirmwareImage &firmware, unsigned int start,
+                                  unsigned int end, unsigned int region_size, std::vector<unsigned int> *modified)
+{
+  // The expected replies: address (3 bytes), length (2 bytes) and CRC (2 bytes) of each region
+  unsigned int nb_regions = (end - start + region_size - 1) / region_size;
+  std::vector<unsigned char> expected(nb_regions * 8, 0);
+  for (unsigned int i = 0; i < nb_regions; ++i)
   {
-    ROS_ERROR("something went wrong while parsing %s.", get_filename(req.firmware).c_str());
-    res.value = res.FAIL;
-    free(binary_content);
-    flashing = false;
-    return false;
+    unsigned int address = start + i * region_size;
+    unsigned int length = std::min(region_size, end - address);
+    int16u crc = firmware.crc(address, length);
+
+    unsigned char *reply = &expected[i * 8];
+    reply[0] = address;
+    reply[1] = address >> 8;
+    reply[2] = address >> 16;
+    reply[3] = length;
+    reply[4] = length >> 8;
+    reply[5] = crc;
+    reply[6] = crc >> 8;
   }
 
-  // We do not need the file anymore
-  bfd_close(fd);
+  unsigned int next = 0;
+  unsigned int retry = 0;
+  while (next < nb_regions)
+  {
+    bus.pipeline.clear();
+    for (unsigned int i = next; i < nb_regions && !bus.pipeline.full(); ++i)
+    {
+      ETHERCAT_CAN_BRIDGE_DATA message = bootloader_command(bus, CRC_FLASH_COMMAND, 5);
+      memcpy(message.message_data, &expected[i * 8], 5);
+      bus.pipeline.add(message, &expected[i * 8]);
+    }
 
-  // The firmware is actually written to the flash memory of the PIC18
-  if (!write_flash_data(base_addr, total_size))
+    bool failed = false;
+    unsigned int nb_acked = bus.pipeline.run(100, &failed);
+    next += nb_acked;
+
+    if (failed)
+    {
+      // the CRC of this region differs
+      modified->push_back(start + next * region_size);
+      ++next;
+      retry = 0;
+    }
+    else if (nb_acked == bus.pipeline.size())
+    {
+      retry = 0;
+    }
+    else if (++retry > max_retry)
+    {
+      ROS_ERROR("Too much retry for CRC, try flashing again");
+      return false;
+    }
+  }
+  return true;
+}
+
+/** \brief Erases and writes rows of the flash
+ *
+ * @param bus the CAN bus of the motor, in bootloader mode
+ * @param firmware the firmware to write
+ * @param rows the addresses of the rows to write
+ *
+ * @return true if the writing process succeeds
+ */
+bool SrEdc::write_flash_rows(FlashingBus &bus, const FirmwareImage &firmware, const std::vector<unsigned int> &rows)
+{
+  // ERASE_FLASH_ROW_COMMAND, then 2 blocks of 32 bytes (and the header of the streamed write)
+  const unsigned int packets_per_row = 1 + (bus.streaming ? 1 : 0) + 2 * packets_per_block;
+
+  size_t next = 0;
+  unsigned int retry = 0;
+  while (next < rows.size())
   {
-    res.value = res.FAIL;
-    free(binary_content);
-    flashing = false;
+    bus.pipeline.clear();
+    for (size_t i = next;
+         i < rows.size() &&
+         bus.pipeline.size() + packets_per_row <= sr_edc_ethercat_drivers::CanPacketPipeline::max_packets;
+         ++i)
+    {
+      ROS_DEBUG("Writing row to motor %u : 0x%06X", bus.motor, rows[i]);
+      bus.pipeline.add(bootloader_address_command(bus, ERASE_FLASH_ROW_COMMAND, rows[i]));
+      add_write_blocks(bus, firmware, rows[i], flash_row_size / 32);
+    }
+
+    unsigned int nb_acked = bus.pipeline.run(100);
+    // a row which wasn't completely acked is erased and written again
+    next += nb_acked / packets_per_row;
+
+    if (nb_acked == bus.pipeline.size())
+    {
+      retry = 0;
+    }
+    else
+    {
+      ROS_ERROR("A packet has been lost, writing the row at 0x%06X again !", rows[next]);
+      if (++retry > max_retry)
+      {
+        ROS_ERROR("Too much retry for WRITE, try flashing again");
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+void SrEdc::flash_motors(const FirmwareImage *firmware, const std::vector<int> *board_ids,
+                         std::vector<sr_edc_ethercat_drivers::MotorFlashResult> *results)
+{
+  results->resize(board_ids->size());
+  for (size_t i = 0; i < board_ids->size(); ++i)
+  {
+    sr_edc_ethercat_drivers::MotorFlashResult &result = results->at(i);
+    result.motor_id = board_ids->at(i);
+
+    ros::WallTime start = ros::WallTime::now();
+    result.success = flash_motor(get_flashing_bus(result.motor_id), *firmware, &result);
+    result.total_time = (ros::WallTime::now() - start).toSec();
+  }
+}
+
+/** \brief Checks the firmware received by the FlashMotorFirmware service
+ *
+ *  The firmware was parsed from the object (.hex) file by the motor_flasher node. It's padded with 8 bytes of 0xFF,
+ *  as the last block written can go past the end of the firmware.
+ *
+ * @param image the parsed firmware
+ * @param firmware where the firmware is stored
+ *
+ * @return false if the firmware is empty or doesn't fit in the code memory
+ */
+bool SrEdc::set_firmware(const sr_edc_ethercat_drivers::MotorFirmware &image, FirmwareImage *firmware)
+{
+  if (image.content.empty() || image.base_address + image.content.size() > 0x7fff)
+  {
+    ROS_ERROR("Invalid firmware %s: %zu bytes at 0x%X", image.name.c_str(), image.content.size(),
+              image.base_address);
     return false;
   }
 
+  firmware->base_addr = image.base_address;
+  firmware->total_size = image.content.size();
+  firmware->content.assign(image.content.begin(), image.content.end());
+  firmware->content.resize(firmware->total_size + 8, 0xFF);
 
-  ROS_INFO("Verifying");
-  // Now we have to read back the flash content
-  if (!read_back_and_check_flash(base_addr, total_size))
+  ROS_INFO("Firmware %s: %u bytes at 0x%X", image.name.c_str(), firmware->total_size, firmware->base_addr);
+  return true;
+}
+
+/** \brief ROS Service that flashes a new firmware into several SimpleMotor boards
+ *
+ *  This function is a ROS Service, aimed at flashing a new firmware into the PIC18F of SimpleMotor boards
+ *  through a CAN bootloader protocol. The firmware is parsed by the motor_flasher node, which provides the
+ *  SimpleMotorFlasher and BulkMotorFlasher services (taking the path of the firmware) on top of this one.
+ *
+ *  The flashing pipeline of a bus is filled with a sequence of CAN messages (e.g. a few blocks of 32 bytes),
+ *  which are sent by SRXX::packCommand() as soon as the previous one has been acknowledged in
+ *  SRXX::unpackState(), so there's no idle frame between two messages.
+ *
+ *  If the palm firmware supports it (~flash_while_streaming, true for the 0230 palm), the CAN messages are sent
+ *  along with the sensor data, so the rest of the hand keeps running. Otherwise the palm is switched to
+ *  CAN direct mode, which stops the sensor data until the flashing is finished.
+ *
+ *  The motors are split by CAN bus: the motors of each bus are flashed
+ *  one after the other, and both buses are flashed at the same time. The EtherCAT CAN bridge carries one
+ *  CAN message per frame, so the buses take turns in the frames, each one sending while the other is
+ *  waiting for an ack (the flash write of a block or the erase, which take the longest, overlap).
+ *
+ *  \code rosservice call BulkMotorFlasher "{firmware: '/home/hand/simplemotor.hex', motor_ids: [0, 10, 1, 11]}" \endcode
+ *
+ *  @param req The Request, contains the parsed firmware and the IDs of the motors to flash
+ *  @param res The Response, contains the result and the timings for each motor (in the order of the request)
+ *
+ *  @return always true, so that the results are returned even if some of the motors failed
+ */
+bool SrEdc::flash_motor_firmware(sr_edc_ethercat_drivers::FlashMotorFirmware::Request &req,
+                                 sr_edc_ethercat_drivers::FlashMotorFirmware::Response &res)
+{
+  if (compact_process_data_)
   {
+    ROS_ERROR("The CAN bridge isn't mapped (~compact_process_data): restart the driver with the full process data"
+              " to flash the motors");
     res.value = res.FAIL;
-    free(binary_content);
-    flashing = false;
-    return false;
+    return true;
   }
 
+  boost::mutex::scoped_try_lock lock(flashing_mutex_);
+  if (!lock.owns_lock())
+  {
+    ROS_ERROR("Already flashing, try again once it's finished");
+    res.value = res.FAIL;
+    return true;
+  }
 
-  free(binary_content);
+  ros::WallTime start = ros::WallTime::now();
 
-  ROS_INFO("Resetting microcontroller.");
-  // Then we send the RESET command to PIC18F
-  timedout = true;
-  while (timedout)
+  FirmwareImage firmware;
+  if (!set_firmware(req.firmware, &firmware))
   {
-    send_CAN_msg(can_bus_, 0x0600 | (motor_being_flashed << 5) | RESET_COMMAND, 0, NULL, 1000, &timedout);
-  };
+    res.value = res.FAIL;
+    return true;
+  }
+
+  // the motors of each CAN bus, in the order of the request
+  std::vector<int> board_ids[2];
+  std::vector<sr_edc_ethercat_drivers::MotorFlashResult> results[2];
+  for (size_t i = 0; i < req.motor_ids.size(); ++i)
+  {
+    int can_bus;
+    unsigned int board_can_id;
+    get_board_id_and_can_bus(req.motor_ids[i], &can_bus, &board_can_id);
+    board_ids[can_bus == 2 ? 1 : 0].push_back(req.motor_ids[i]);
+  }
+
+  ROS_INFO("Flashing %zu motors on the first CAN bus and %zu motors on the second one",
+           board_ids[0].size(), board_ids[1].size());
 
+  can_direct_mode_.store(!flash_while_streaming_.load());
+  flashing = true;
+  // the second bus is flashed from another thread while this one flashes the first bus
+  boost::thread second_bus(boost::bind(&SrEdc::flash_motors, this, &firmware, &board_ids[1], &results[1]));
+  flash_motors(&firmware, &board_ids[0], &results[0]);
+  second_bus.join();
   flashing = false;
 
-  ROS_INFO("Flashing done");
+  // gives the results back in the order of the request
+  size_t next_result[2] = {0, 0};
+  bool success = true;
+  for (size_t i = 0; i < req.motor_ids.size(); ++i)
+  {
+    int can_bus;
+    unsigned int board_can_id;
+    get_board_id_and_can_bus(req.motor_ids[i], &can_bus, &board_can_id);
+    unsigned int bus_index = can_bus == 2 ? 1 : 0;
+    res.results.push_back(results[bus_index][next_result[bus_index]++]);
+    success = success && res.results.back().success;
+
+    if (!res.results.back().success)
+    {
+      ROS_ERROR("Flashing motor %d failed: %s", req.motor_ids[i], res.results.back().error.c_str());
+    }
+  }
 
-  res.value = res.SUCCESS;
+  res.total_time = (ros::WallTime::now() - start).toSec();
+  res.value = success ? res.SUCCESS : res.FAIL;
+  ROS_INFO("Flashed %zu motors in %.3fs", req.motor_ids.size(), res.total_time);
 
   // Reinitialize motor boards or valve controller boards information
   reinitialize_boards();
@@ -599,408 +960,468 @@ bool SrEdc::simple_motor_flasher(sr_robot_msgs::SimpleMotorFlasher::Request &req
   return true;
 }
 
+void SrEdc::advertise_can_bridge_request()
+{
+  if (!flash_while_streaming_.load())
+  {
+    ROS_INFO("The palm doesn't send the CAN bridge packets in the sensor data frames (~flash_while_streaming):"
+             " CanBridgeRequest not advertised");
+    return;
+  }
+  can_bridge_request_server_ = nodehandle_.advertiseService("CanBridgeRequest", &SrEdc::can_bridge_request, this);
+}
+
+/** \brief ROS service sending a CAN message to a board and waiting for its reply
+ *
+ *  The request goes through the asynchronous CAN bridge requests: this only blocks the thread
+ *  calling the service, other requests can be sent and answered in the meantime. The palm firmware
+ *  must be able to send the CAN bridge packets in the sensor data frames: the service is only
+ *  advertised by the drivers of those palms (see advertise_can_bridge_request()).
+ */
+bool SrEdc::can_bridge_request(sr_edc_ethercat_drivers::CanBridgeRequest::Request &req,
+                               sr_edc_ethercat_drivers::CanBridgeRequest::Response &res)
+{
+  if ((req.can_bus != 1 && req.can_bus != 2) || req.data.size() > 8)
+  {
+    ROS_ERROR("Invalid CAN bridge request: bus %u, %zu bytes", req.can_bus, req.data.size());
+    return false;
+  }
+
+  if (compact_process_data_)
+  {
+    ROS_ERROR("The CAN bridge isn't mapped (~compact_process_data): restart the driver with the full process data"
+              " to send CAN bridge requests");
+    return false;
+  }
+
+  ETHERCAT_CAN_BRIDGE_DATA message;
+  message.can_bus = req.can_bus;
+  message.message_id = req.message_id;
+  message.message_length = req.data.size();
+  bzero(message.message_data, sizeof(message.message_data));
+  std::copy(req.data.begin(), req.data.end(), message.message_data);
+
+  sr_edc_ethercat_drivers::CanBridgeRequests::ReplyPredicate is_reply;
+  if (req.reply_mask == 0)
+  {
+    is_reply = &sr_edc_ethercat_drivers::CanBridgeRequests::is_ack;
+  }
+  else
+  {
+    is_reply = boost::bind(&reply_id_matches, req.reply_id, req.reply_mask, _2);
+  }
+
+  boost::unique_future<sr_edc_ethercat_drivers::CanBridgeReply> future =
+          can_bridge_requests_.submit(message, is_reply, req.timeout);
+  sr_edc_ethercat_drivers::CanBridgeReply reply = future.get();
+
+  res.success = reply.success;
+  if (reply.success)
+  {
+    res.message_id = reply.message.message_id;
+    res.data.assign(reply.message.message_data,
+                    reply.message.message_data + std::min<int>(reply.message.message_length, 8));
+  }
+  return true;
+}
+
 void SrEdc::build_CAN_message(ETHERCAT_CAN_BRIDGE_DATA *message)
 {
-  int res;
+  if (compact_process_data_)
+  {
+    // the CAN bridge command isn't in the frame
+    return;
+  }
 
-  if (flashing && !can_packet_acked && !can_message_sent)
+  if (flashing)
   {
-    if (!(res = pthread_mutex_trylock(&producing)))
+    // Only one CAN message fits in a frame: when both buses have a packet to send, they take turns
+    for (unsigned int i = 0; i < 2; ++i)
     {
-      ROS_DEBUG_STREAM("Ethercat bridge data size: " << ETHERCAT_CAN_BRIDGE_DATA_SIZE);
+      unsigned int bus_index = (next_flashing_bus_ + i) % 2;
+      FlashingBus &bus = flashing_buses_[bus_index];
+      if (!bus.pipeline.next_packet(&bus.in_flight))
+      {
+        continue;
+      }
+      next_flashing_bus_ = (bus_index + 1) % 2;
+
+      SR_RT_LOG_DEBUG("Ethercat bridge data size: %d", static_cast<int>(ETHERCAT_CAN_BRIDGE_DATA_SIZE));
+
+      SR_RT_LOG_DEBUG("We're sending a CAN message for flashing.");
+      memcpy(message, &bus.in_flight.message, sizeof(bus.in_flight.message));
+
+      SR_RT_LOG_DEBUG("Sending : SID : 0x%04X ; bus : 0x%02X ; length : 0x%02X",
+                      message->message_id,
+                      message->can_bus,
+                      message->message_length);
+      SR_RT_LOG_DEBUG("Sending : data : 0x%02X 0x%02X 0x%02X 0x%02X 0x%02X 0x%02X 0x%02X 0x%02X",
+                      message->message_data[0],
+                      message->message_data[1],
+                      message->message_data[2],
+                      message->message_data[3],
+                      message->message_data[4],
+                      message->message_data[5],
+                      message->message_data[6],
+                      message->message_data[7]);
+      can_bridge_capture_.capture(sr_edc_ethercat_drivers::CanBridgeCapture::SENT, *message);
+      return;
+    }
+  }
 
-      ROS_DEBUG("We're sending a CAN message for flashing.");
-      memcpy(message, &can_message_, sizeof(can_message_));
-      can_message_sent = true;
+  if (can_bridge_requests_.next_request(message))
+  {
+    SR_RT_LOG_DEBUG("Sending CAN bridge request : SID : 0x%04X ; bus : 0x%02X", message->message_id,
+                    message->can_bus);
+    can_bridge_capture_.capture(sr_edc_ethercat_drivers::CanBridgeCapture::SENT, *message);
+    return;
+  }
+
+  message->can_bus = 0;
+  message->message_id = 0x00;
+  message->message_length = 0;
+}
+
+/** \brief Checks the CAN message received in unpackState()
+ *
+ *  The message is first passed to the CAN bridge requests, which match it with their
+ *  pending requests in their own thread.
+ *
+ *  The message is checked against the packet in flight on the CAN bus it comes from.
+ *  If it acknowledges it, the next packet of the flashing pipeline of that bus
+ *  will be sent. If it's the reply to the CRC request in flight (same address and length)
+ *  with the wrong CRC, the pipeline stops straight away rather than waiting for the timeout.
+ *  Any other reply (e.g. a late one to a previous request) is ignored.
+ *
+ *  @param packet The CAN message from this_buffer of unpackState()
+ */
+void SrEdc::check_CAN_reply(ETHERCAT_CAN_BRIDGE_DATA *packet)
+{
+  if (compact_process_data_)
+  {
+    // the CAN bridge status isn't in the frame
+    return;
+  }
 
-      ROS_DEBUG(
-              "Sending : SID : 0x%04X ; bus : 0x%02X ; length : 0x%02X ;"
-                      " data : 0x%02X 0x%02X 0x%02X 0x%02X 0x%02X 0x%02X 0x%02X 0x%02X",
-              message->message_id,
-              message->can_bus,
-              message->message_length,
-              message->message_data[0],
-              message->message_data[1],
-              message->message_data[2],
-              message->message_data[3],
-              message->message_data[4],
-              message->message_data[5],
-              message->message_data[6],
-              message->message_data[7]);
+  can_bridge_capture_.capture(sr_edc_ethercat_drivers::CanBridgeCapture::RECEIVED, *packet);
+  can_bridge_requests_.message_received(*packet);
 
-      unlock(&producing);
+  for (unsigned int i = 0; flashing && i < 2; ++i)
+  {
+    FlashingBus &bus = flashing_buses_[i];
+    if (packet->can_bus != bus.can_bus || !bus.pipeline.waiting_for_ack())
+    {
+      continue;
     }
-    else
+
+    if (can_data_is_ack(bus, packet))
     {
-      ROS_ERROR("Mutex is locked, we don't send any CAN message !");
-      check_for_trylock_error(res);
+      bus.pipeline.packet_acked();
+    }
+    else if (is_data_reply(bus, packet) && data_reply_echoes_request(bus, packet))
+    {
+      bus.pipeline.packet_failed();
     }
   }
-  else
+}
+
+/** \brief Checks if the packet is the reply to the READ or CRC request in flight (whatever its data)
+ *
+ *  @param bus The CAN bus the packet comes from
+ *  @param packet The packet from this_buffer of unpackState()
+ *  @return Returns true if the packet in flight is a READ_FLASH_COMMAND or CRC_FLASH_COMMAND and this is its reply
+ */
+bool SrEdc::is_data_reply(const FlashingBus &bus, ETHERCAT_CAN_BRIDGE_DATA *packet)
+{
+  int8u command = bus.in_flight.message.message_id & 0x0F;
+  if (command != READ_FLASH_COMMAND && command != CRC_FLASH_COMMAND)
+  {
+    return false;
+  }
+  return (packet->message_id & 0b0000011111111111) == (0x0600 | (bus.motor << 5) | 0x10 | command);
+}
+
+/** \brief Checks if the data reply echoes the address and length of the request in flight
+ *
+ *  Only the CRC reply echoes the request (address on 3 bytes and length on 2 bytes): a READ reply
+ *  only carries the flash content, it can't be told apart from a late reply to a previous READ.
+ *
+ *  @param bus The CAN bus the packet comes from
+ *  @param packet The packet from this_buffer of unpackState(), a reply to a READ or CRC request
+ *  @return Returns true if the packet is the CRC reply to the request in flight
+ */
+bool SrEdc::data_reply_echoes_request(const FlashingBus &bus, ETHERCAT_CAN_BRIDGE_DATA *packet)
+{
+  const ETHERCAT_CAN_BRIDGE_DATA &in_flight = bus.in_flight.message;
+  if ((in_flight.message_id & 0x0F) != CRC_FLASH_COMMAND || packet->message_length != 7)
   {
-    message->can_bus = can_bus_;
-    message->message_id = 0x00;
-    message->message_length = 0;
+    return false;
   }
+  return !memcmp(packet->message_data, in_flight.message_data, 5);
 }
 
 /** \brief This function checks if the can packet in the unpackState() this_buffer is an ACK
  *
  *  This function checks several things on the can packet in this_buffer, it compares it with the
- *  can_message_ private member in several ways (SID, length, data) to check if it's an ACK.
+ *  packet in flight on the bus in several ways (SID, length, data) to check if it's an ACK.
  *
+ *  @param bus The CAN bus the packet comes from
  *  @param packet The packet from this_buffer of unpackState() that we want to check if it's an ACK
- *  @return Returns true if packet is an ACK of can_message_ packet.
+ *  @return Returns true if packet is an ACK of the packet in flight.
  */
-bool SrEdc::can_data_is_ack(ETHERCAT_CAN_BRIDGE_DATA *packet)
+bool SrEdc::can_data_is_ack(const FlashingBus &bus, ETHERCAT_CAN_BRIDGE_DATA *packet)
 {
   int i;
+  const ETHERCAT_CAN_BRIDGE_DATA &in_flight = bus.in_flight.message;
 
   if (packet->message_id == 0)
   {
-    ROS_DEBUG("ID is zero");
+    SR_RT_LOG_DEBUG("ID is zero");
     return false;
   }
 
-  ROS_DEBUG("ack sid : %04X", packet->message_id);
+  SR_RT_LOG_DEBUG("ack sid : %04X", packet->message_id);
 
-  // Is this a reply to a READ request?
-  if ((packet->message_id & 0b0000011111111111) == (0x0600 | (motor_being_flashed << 5) | 0x10 | READ_FLASH_COMMAND))
+  // Is this a reply to a READ or CRC request?
+  if (is_data_reply(bus, packet))
   {
-    ROS_DEBUG("READ reply  %02x:%02x:%02x:%02x:%02x:%02x:%02x:%02x", packet->message_data[0],
-              packet->message_data[1],
-              packet->message_data[2],
-              packet->message_data[3],
-              packet->message_data[4],
-              packet->message_data[5],
-              packet->message_data[6],
-              packet->message_data[7]);
-    ROS_DEBUG("Should be   %02x:%02x:%02x:%02x:%02x:%02x:%02x:%02x", binary_content[pos + 0],
-              binary_content[pos + 1],
-              binary_content[pos + 2],
-              binary_content[pos + 3],
-              binary_content[pos + 4],
-              binary_content[pos + 5],
-              binary_content[pos + 6],
-              binary_content[pos + 7]);
+    const unsigned char *expected = bus.in_flight.expected_read;
+    if (expected == NULL)
+    {
+      // nothing to check the data against
+      return true;
+    }
 
-    if (!memcmp(packet->message_data, binary_content + pos, 8))
+    // the CRC reply is the request followed by the CRC (2 bytes)
+    int8u length = ((in_flight.message_id & 0x0F) == CRC_FLASH_COMMAND) ? 7 : 8;
+    if (packet->message_length != length)
     {
-      ROS_DEBUG("data is good");
+      SR_RT_LOG_DEBUG("Length is bad: %d", packet->message_length);
+      return false;
+    }
+
+    SR_RT_LOG_DEBUG("READ reply  %02x:%02x:%02x:%02x:%02x:%02x:%02x:%02x", packet->message_data[0],
+                    packet->message_data[1],
+                    packet->message_data[2],
+                    packet->message_data[3],
+                    packet->message_data[4],
+                    packet->message_data[5],
+                    packet->message_data[6],
+                    packet->message_data[7]);
+    SR_RT_LOG_DEBUG("Should be   %02x:%02x:%02x:%02x:%02x:%02x:%02x:%02x", expected[0],
+                    expected[1],
+                    expected[2],
+                    expected[3],
+                    expected[4],
+                    expected[5],
+                    expected[6],
+                    expected[7]);
+
+    if (!memcmp(packet->message_data, expected, length))
+    {
+      SR_RT_LOG_DEBUG("data is good");
       return true;
     }
     else
     {
-      ROS_DEBUG("data is bad");
+      SR_RT_LOG_DEBUG("data is bad");
       return false;
     }
   }
 
-  if (packet->message_length != can_message_.message_length)
+  if (packet->message_length != in_flight.message_length)
   {
-    ROS_DEBUG("Length is bad: %d", packet->message_length);
+    SR_RT_LOG_DEBUG("Length is bad: %d", packet->message_length);
     return false;
   }
 
-  ROS_DEBUG("Length is OK");
+  SR_RT_LOG_DEBUG("Length is OK");
 
   for (i = 0; i < packet->message_length; ++i)
   {
-    ROS_DEBUG("packet sent, data[%d] : %02X ; ack, data[%d] : %02X", i, can_message_.message_data[i], i,
-              packet->message_data[i]);
-    if (packet->message_data[i] != can_message_.message_data[i])
+    SR_RT_LOG_DEBUG("packet sent, data[%d] : %02X ; ack, data[%d] : %02X", i, in_flight.message_data[i], i,
+                    packet->message_data[i]);
+    if (packet->message_data[i] != in_flight.message_data[i])
     {
       return false;
     }
   }
-  ROS_DEBUG("Data is OK");
+  SR_RT_LOG_DEBUG("Data is OK");
 
   if (!(0x0010 & packet->message_id))
   {
     return false;
   }
 
-  ROS_DEBUG("This is an ACK");
+  SR_RT_LOG_DEBUG("This is an ACK");
 
-  if ((packet->message_id & 0b0000000111101111) != (can_message_.message_id & 0b0000000111101111))
+  if ((packet->message_id & 0b0000000111101111) != (in_flight.message_id & 0b0000000111101111))
   {
-    ROS_WARN_STREAM("Bad packet id: " << packet->message_id);
+    SR_RT_LOG_WARN("Bad packet id: %d", packet->message_id);
     return false;
   }
 
-  ROS_DEBUG("SID is OK");
+  SR_RT_LOG_DEBUG("SID is OK");
 
-  ROS_DEBUG("Everything is OK, this is our ACK !");
+  SR_RT_LOG_DEBUG("Everything is OK, this is our ACK !");
   return true;
 }
 
-void SrEdc::send_CAN_msg(int8u can_bus, int16u msg_id, int8u msg_length, int8u msg_data[], int timeout, bool *timedout)
+void SrEdc::send_CAN_msg(FlashingBus &bus, int16u msg_id, int8u msg_length, int8u msg_data[], int timeout,
+                         bool *timedout)
 {
-  int err;
-  unsigned char cmd_sent;
-  int wait_time;
+  ETHERCAT_CAN_BRIDGE_DATA message;
+  message.can_bus = bus.can_bus;
+  message.message_id = msg_id;
+  message.message_length = msg_length;
+  bzero(message.message_data, sizeof(message.message_data));
 
-  cmd_sent = 0;
-  while (!cmd_sent)
+  if (msg_data != NULL)
   {
-    if (!(err = pthread_mutex_trylock(&producing)))
+    for (unsigned int i = 0; i < msg_length; i++)
     {
-      can_message_.message_length = msg_length;
-      can_message_.can_bus = can_bus;
-      can_message_.message_id = msg_id;
-
-      if (msg_data != NULL)
-      {
-        for (unsigned int i = 0; i < msg_length; i++)
-        {
-          can_message_.message_data[i] = msg_data[i];
-        }
-      }
-
-      cmd_sent = 1;
-      unlock(&producing);
-    }
-    else
-    {
-      check_for_trylock_error(err);
-    }
-  }
-  wait_time = 0;
-  *timedout = false;
-  can_message_sent = false;
-  can_packet_acked = false;
-  while (!can_packet_acked)
-  {
-    usleep(1000);  // 1 ms
-    wait_time++;
-    if (wait_time > timeout)
-    {
-      *timedout = true;
-      break;
+      message.message_data[i] = msg_data[i];
     }
   }
+
+  bus.pipeline.clear();
+  bus.pipeline.add(message);
+  *timedout = (bus.pipeline.run(timeout) != 1);
 }
 
-bool SrEdc::read_back_and_check_flash(unsigned int baddr, unsigned int total_size)
+bool SrEdc::read_back_and_check_flash(FlashingBus &bus, const FirmwareImage &firmware)
 {
   // The actual comparison between the content read from the flash and the content read from
-  // the hex file is carried out in the can_data_is_ack() function.
-  // read_flash(...) will return timedout = true if the 8 byte content read from the flash doesn't
-  // match the 8 bytes from the hex file
-  // BE CAREFUL with the pos "global" field, because it's being used inside can_data_is_ack()
-  // function to check if the response of the READ_FLASH_COMMAND is correct
-  pos = 0;
-  unsigned int retry;
-  while (pos < total_size)
-  {
-    bool timedout = true;
-
-    retry = 0;
-    while (timedout)
-    {
-      timedout = read_flash(pos, baddr);
-      if (!timedout)
-      {
-        pos += 8;
-      }
-      retry++;
-      if (retry > max_retry)
-      {
-        ROS_ERROR("Too much retry for READ back, try flashing again");
-        return false;
-      }
-    };
-  }
-  return true;
-}
+  // the hex file is carried out in the can_data_is_ack() function, against the expected data
+  // given with each READ_FLASH_COMMAND. A READ reply which doesn't match isn't acked (it could be a
+  // late reply to a previous READ): the reads are sent again from the first one which wasn't acked.
+  unsigned int pos = 0;
+  unsigned int retry = 0;
+  while (pos < firmware.total_size)
+  {
+    bus.pipeline.clear();
+    for (unsigned int offset = pos; offset < firmware.total_size && !bus.pipeline.full(); offset += 8)
+    {
+      bus.pipeline.add(bootloader_address_command(bus, READ_FLASH_COMMAND, firmware.base_addr + offset),
+                       &firmware.content[offset]);
+    }
 
-void SrEdc::find_address_range(bfd *fd, unsigned int *smallest_start_address, unsigned int *biggest_end_address)
-{
-  asection *s;
-  unsigned int section_size = 0;
-  unsigned int section_addr = 0;
-
-  // Look for the start and end address of every section in the hex file,
-  // to detect the lowest and highest address of the data we need to write in the PIC's flash.
-  // The sections starting at an address higher than 0x7fff will be ignored as they are not proper
-  // "code memory" firmware
-  // (they can contain the CONFIG bits of the microcontroller, which we don't want to write here)
-  // To understand the structure (sections) of the object file containing the firmware (usually a .hex) the following
-  // commands can be useful:
-  //  \code objdump -x simplemotor.hex \endcode
-  //  \code objdump -s simplemotor.hex \endcode
-  for (s = fd->sections; s; s = s->next)
-  {
-    // Only the sections with the LOAD flag on will be considered
-    if (bfd_get_section_flags(fd, s) & (SEC_LOAD))
-    {
-      // Only the sections with the same VMA (virtual memory address) and LMA (load MA) will be considered
-      // http://www.delorie.com/gnu/docs/binutils/ld_7.html
-      if (bfd_section_lma(fd, s) == bfd_section_vma(fd, s))
-      {
-        section_addr = (unsigned int) bfd_section_lma(fd, s);
-        if (section_addr >= 0x7fff)
-        {
-          continue;
-        }
-        section_size = (unsigned int) bfd_section_size(fd, s);
-        *smallest_start_address = std::min(section_addr, *smallest_start_address);
-        *biggest_end_address = std::max(*biggest_end_address, section_addr + section_size);
-      }
+    unsigned int nb_acked = bus.pipeline.run(100);
+    pos += nb_acked * 8;
+
+    if (nb_acked == bus.pipeline.size())
+    {
+      retry = 0;
+    }
+    else if (++retry > max_retry)
+    {
+      ROS_ERROR("Too much retry for READ back, try flashing again");
+      return false;
     }
   }
+  return true;
 }
 
-bool SrEdc::read_content_from_object_file(bfd *fd, bfd_byte *content, unsigned int base_addr)
+bool SrEdc::write_flash_data(FlashingBus &bus, const FirmwareImage &firmware)
 {
-  asection *s;
-  unsigned int section_size = 0;
-  unsigned int section_addr = 0;
-
-  for (s = fd->sections; s; s = s->next)
+  // The blocks of 32 bytes are pipelined: as many blocks as the pipeline can hold
+  // are sent back to back, each packet in the frame following the ack of the previous one
+  // (or straight away for the data packets of a streamed write).
+  const unsigned int header_packets = bus.streaming ? 1 : 0;
+  const unsigned int max_blocks =
+          (sr_edc_ethercat_drivers::CanPacketPipeline::max_packets - header_packets) / packets_per_block;
+  unsigned int total_size = firmware.total_size;
+  unsigned int padded_size = (total_size % 32) == 0 ? total_size : (total_size + 32 - (total_size % 32));
+
+  unsigned int pos = 0;
+  unsigned int retry = 0;
+  ROS_INFO("Sending the firmware data%s", bus.streaming ? " (streamed)" : "");
+  while (pos < padded_size)
   {
-    // Only the sections with the LOAD flag on will be considered
-    if (bfd_get_section_flags(fd, s) & (SEC_LOAD))
+    bus.pipeline.clear();
+    add_write_blocks(bus, firmware, firmware.base_addr + pos, std::min((padded_size - pos) / 32, max_blocks));
+
+    unsigned int nb_acked = bus.pipeline.run(100);
+    // a block which wasn't completely acked is written again from its address
+    unsigned int nb_blocks = nb_acked > header_packets ? (nb_acked - header_packets) / packets_per_block : 0;
+    pos += nb_blocks * 32;
+
+    if (nb_acked == bus.pipeline.size())
     {
-      // Only the sections with the same VMA (virtual memory address) and LMA (load MA) will be considered
-      // http://www.delorie.com/gnu/docs/binutils/ld_7.html
-      if (bfd_section_lma(fd, s) == bfd_section_vma(fd, s))
-      {
-        section_addr = (unsigned int) bfd_section_lma(fd, s);
-        // The sections starting at an address higher than 0x7fff will be ignored as they are
-        // not proper "code memory" firmware
-        // (they can contain the CONFIG bits of the microcontroller, which we don't want to write here)
-        if (section_addr >= 0x7fff)
-        {
-          continue;
-        }
-        section_size = (unsigned int) bfd_section_size(fd, s);
-        bfd_get_section_contents(fd, s, content + (section_addr - base_addr), 0, section_size);
-      }
-      else
-      {
-        return false;
-      }
+      retry = 0;
     }
     else
     {
-      return false;
+      ROS_ERROR("A WRITE packet has been lost, resending the 32 bytes block at pos=%u  !", pos);
+      if (++retry > max_retry)
+      {
+        ROS_ERROR("Too much retry for WRITE, try flashing again");
+        return false;
+      }
     }
   }
   return true;
 }
 
-bool SrEdc::write_flash_data(unsigned int base_addr, unsigned int total_size)
+/** \brief Adds the packets writing consecutive blocks of 32 bytes to the flashing pipeline
+ *
+ *  With the old protocol each block is a WRITE_FLASH_ADDRESS_COMMAND followed by 4 WRITE_FLASH_DATA_COMMAND
+ *  packets of 8 bytes, all acknowledged. A streamed write starts with a STREAM_WRITE_HEADER_COMMAND, then each
+ *  block is sent in 5 STREAM_WRITE_DATA_COMMAND packets (a sequence number and up to 7 bytes): only the last
+ *  packet of a block is acknowledged, once the block is written.
+ *
+ * @param bus the CAN bus of the motor being flashed
+ * @param firmware the firmware to write
+ * @param address the address of the first block
+ * @param nb_blocks the number of blocks
+ */
+void SrEdc::add_write_blocks(FlashingBus &bus, const FirmwareImage &firmware, unsigned int address,
+                             unsigned int nb_blocks)
 {
-  int err;
-  unsigned char cmd_sent;
-  int wait_time, timeout;
-
-  pos = 0;
-  unsigned int packet = 0;
-  ROS_INFO("Sending the firmware data");
-  while (pos < ((total_size % 32) == 0 ? total_size : (total_size + 32 - (total_size % 32))))
+  if (bus.streaming)
   {
-    bool timedout = true;
+    unsigned int length = nb_blocks * 32;
+    ETHERCAT_CAN_BRIDGE_DATA header = bootloader_address_command(bus, STREAM_WRITE_HEADER_COMMAND, address);
+    header.message_length = 5;
+    header.message_data[3] = length;
+    header.message_data[4] = length >> 8;
+    bus.pipeline.add(header);
+  }
 
-    // For every WRITE_FLASH_ADDRESS_COMMAND we write 32 bytes of data to flash
-    // and this is done by sending 4 WRITE_FLASH_DATA_COMMAND packets, every one containing
-    // 8 bytes of data to be written
-    if ((pos % 32) == 0)
+  int8u sequence = 0;
+  for (unsigned int block = address; block < address + nb_blocks * 32; block += 32)
+  {
+    ROS_DEBUG("Writing block to motor %u : 0x%06X", bus.motor, block);
+    if (bus.streaming)
     {
-      packet = 0;
-      while (timedout)
+      for (unsigned int data = block; data < block + 32; data += 7)
       {
-        cmd_sent = 0;
-        while (!cmd_sent)
+        int8u length = std::min(7u, block + 32 - data);
+        ETHERCAT_CAN_BRIDGE_DATA message = bootloader_command(bus, STREAM_WRITE_DATA_COMMAND, length + 1);
+        message.message_data[0] = sequence++;
+        for (unsigned char j = 0; j < length; ++j)
         {
-          if (!(err = pthread_mutex_trylock(&producing)))
-          {
-            can_message_.message_length = 3;
-            can_message_.can_bus = can_bus_;
-            can_message_.message_id = 0x0600 | (motor_being_flashed << 5) | WRITE_FLASH_ADDRESS_COMMAND;
-            can_message_.message_data[2] = (base_addr + pos) >> 16;
-            can_message_.message_data[1] = (base_addr + pos) >> 8;  // User application start address is 0x4C0
-            can_message_.message_data[0] = base_addr + pos;
-            ROS_DEBUG("Sending write address to motor %d : 0x%02X%02X%02X", motor_being_flashed,
-                      can_message_.message_data[2], can_message_.message_data[1], can_message_.message_data[0]);
-            cmd_sent = 1;
-            unlock(&producing);
-          }
-          else
-          {
-            check_for_trylock_error(err);
-          }
+          message.message_data[j + 1] = firmware.at(data + j);
         }
-        wait_time = 0;
-        timedout = false;
-        timeout = 100;
-        can_message_sent = false;
-        can_packet_acked = false;
-        while (!can_packet_acked)
-        {
-          usleep(1000);
-          if (wait_time > timeout)
-          {
-            timedout = true;
-            break;
-          }
-          wait_time++;
-        }
-        if (timedout)
-        {
-          ROS_ERROR("WRITE ADDRESS timedout ");
-        }
-      };
+        // only the packet completing the block is acked
+        bus.pipeline.add(message, NULL, data + length == block + 32);
+      }
     }
-    cmd_sent = 0;
-    while (!cmd_sent)
+    else
     {
-      if (!(err = pthread_mutex_trylock(&producing)))
+      bus.pipeline.add(bootloader_address_command(bus, WRITE_FLASH_ADDRESS_COMMAND, block));
+
+      for (unsigned int data = block; data < block + 32; data += 8)
       {
-        ROS_DEBUG("Sending data ... position == %d", pos);
-        can_message_.message_length = 8;
-        can_message_.can_bus = can_bus_;
-        can_message_.message_id = 0x0600 | (motor_being_flashed << 5) | WRITE_FLASH_DATA_COMMAND;
-        bzero(can_message_.message_data, 8);
+        ETHERCAT_CAN_BRIDGE_DATA message = bootloader_command(bus, WRITE_FLASH_DATA_COMMAND, 8);
         for (unsigned char j = 0; j < 8; ++j)
         {
-          can_message_.message_data[j] = (pos > total_size) ? 0xFF : *(binary_content + pos + j);
+          message.message_data[j] = firmware.at(data + j);
         }
-
-        pos += 8;
-        cmd_sent = 1;
-        unlock(&producing);
-      }
-      else
-      {
-        check_for_trylock_error(err);
-      }
-    }
-    packet++;
-    timedout = false;
-    wait_time = 0;
-    timeout = 100;
-    can_message_sent = false;
-    can_packet_acked = false;
-    while (!can_packet_acked)
-    {
-      usleep(1000);
-      if (wait_time > timeout)
-      {
-        timedout = true;
-        break;
+        bus.pipeline.add(message);
       }
-      wait_time++;
-    }
-    if (timedout)
-    {
-      ROS_ERROR("A WRITE data packet has been lost at pos=%u, resending the 32 bytes block at pos=%u  !", pos,
-                (pos - packet * 8));
-      pos -= packet * 8;
     }
   }
-  return true;
 }
 
 
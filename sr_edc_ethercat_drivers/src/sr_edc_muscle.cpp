@@ -25,6 +25,7 @@
 
 
 #include <sr_edc_ethercat_drivers/sr_edc_muscle.h>
+#include <sr_robot_lib/rt_logger.hpp>
 
 #include <realtime_tools/realtime_publisher.h>
 
@@ -77,7 +78,8 @@ PLUGINLIB_EXPORT_CLASS(SrEdcMuscle, EthercatDevice);
  */
 SrEdcMuscle::SrEdcMuscle()
         : zero_buffer_read(0),
-          cycle_count(0)
+          cycle_count(0),
+          publishing_cycles_(10)
 {
   /*
     ROS_INFO("There are %d sensors", nb_sensors_const);
@@ -153,6 +155,11 @@ int SrEdcMuscle::initialize(hardware_interface::HardwareInterface *hw, bool allo
                   ETHERCAT_DATA_STRUCTURE_0300_PALM_EDC_COMMAND>(hw, nodehandle_, nh_tilde_,
                                                                  device_id_, device_joint_prefix_));
 
+  // publish the tactiles and the palm extras at the same rate, whatever the cycle period
+  double publishing_rate;
+  nh_tilde_.param("publishing_rate", publishing_rate, 100.0);
+  publishing_cycles_ = sr_hand_lib->cycles_for_rate(publishing_rate);
+
   ROS_INFO("ETHERCAT_STATUS_DATA_SIZE      = %4d bytes", static_cast<int> (ETHERCAT_STATUS_DATA_SIZE));
   ROS_INFO("ETHERCAT_COMMAND_DATA_SIZE     = %4d bytes", static_cast<int> (ETHERCAT_COMMAND_DATA_SIZE));
   ROS_INFO("ETHERCAT_CAN_BRIDGE_DATA_SIZE  = %4d bytes", static_cast<int> (ETHERCAT_CAN_BRIDGE_DATA_SIZE));
@@ -193,10 +200,11 @@ void SrEdcMuscle::multiDiagnostics(vector<diagnostic_msgs::DiagnosticStatus> &ve
   d.addf("Revision", "%d", sh_->get_revision());
   d.addf("Counter", "%d", ++counter_);
 
-  d.addf("PIC idle time (in microsecs)", "%d", sr_hand_lib->main_pic_idle_time);
-  d.addf("Min PIC idle time (since last diagnostics)", "%d", sr_hand_lib->main_pic_idle_time_min);
-  // reset the idle time min to a big number, to get a fresh number on next diagnostic
-  sr_hand_lib->main_pic_idle_time_min = 1000;
+  sr_hand_lib->get_state_snapshot(diagnostics_snapshot_);
+  d.addf("PIC idle time (in microsecs)", "%d", diagnostics_snapshot_.main_pic_idle_time);
+  d.addf("Min PIC idle time (since last diagnostics)", "%d", diagnostics_snapshot_.main_pic_idle_time_min);
+  // the realtime loop resets the idle time min to a big number, to get a fresh number on next diagnostic
+  sr_hand_lib->reset_main_pic_idle_time_min();
 
   this->ethercatDiagnostics(d, 2);
   vec.push_back(d);
@@ -207,14 +215,15 @@ void SrEdcMuscle::multiDiagnostics(vector<diagnostic_msgs::DiagnosticStatus> &ve
   // Add the diagnostics from the tactiles
   if (sr_hand_lib->tactiles != NULL)
   {
-    sr_hand_lib->tactiles->add_diagnostics(vec, d);
+    sr_hand_lib->tactiles->add_diagnostics(vec, d, diagnostics_snapshot_);
   }
 }
 
 /** \brief packs the commands before sending them to the EtherCAT bus
  *
  *  This is one of the most important functions of this driver.
- *  This function is called each millisecond (1 kHz freq) by the EthercatHardware::update() function
+ *  This function is called at each cycle (1 kHz by default, see the cycle_period parameter) by the
+ *  EthercatHardware::update() function
  *  in the controlLoop() of the ros_etherCAT node.
  *
  *  This function is called with a buffer as a parameter, the buffer provided is where we write the commands to send via EtherCAT.
@@ -234,7 +243,8 @@ void SrEdcMuscle::packCommand(unsigned char *buffer, bool halt, bool reset)
           reinterpret_cast<ETHERCAT_DATA_STRUCTURE_0300_PALM_EDC_COMMAND *>(buffer);
   ETHERCAT_CAN_BRIDGE_DATA *message = reinterpret_cast<ETHERCAT_CAN_BRIDGE_DATA *>(buffer + ETHERCAT_COMMAND_DATA_SIZE);
 
-  if (!flashing)
+  // While flashing, the CAN bridge packets are sent along with the sensor data unless the palm needs the CAN direct mode
+  if (!flashing || !can_direct_mode_)
   {
     command->EDC_command = EDC_COMMAND_SENSOR_DATA;
   }
@@ -376,8 +386,8 @@ bool SrEdcMuscle::unpackState(unsigned char *this_buffer, unsigned char *prev_bu
     ++zero_buffer_read;
     float percentage_packet_loss = 100.f * (static_cast<float>(zero_buffer_read)/ static_cast<float>(num_rxed_packets));
 
-    ROS_DEBUG("Reception error detected : %d errors out of %d rxed packets (%2.3f%%) ; idle time %dus",
-              zero_buffer_read, num_rxed_packets, percentage_packet_loss, status_data->idle_time_us);
+    SR_RT_LOG_DEBUG("Reception error detected : %d errors out of %d rxed packets (%2.3f%%) ; idle time %dus",
+                    zero_buffer_read, num_rxed_packets, percentage_packet_loss, status_data->idle_time_us);
     return true;
   }
 
@@ -386,8 +396,8 @@ bool SrEdcMuscle::unpackState(unsigned char *this_buffer, unsigned char *prev_bu
   // with the received information
   sr_hand_lib->update(status_data);
 
-  // Now publish the additional data at 100Hz (every 10 cycles)
-  if (cycle_count >= 9)
+  // Now publish the additional data at publishing_rate
+  if (cycle_count >= publishing_cycles_)
   {
     // publish tactiles if we have them
     if (sr_hand_lib->tactiles != NULL)
@@ -431,14 +441,9 @@ bool SrEdcMuscle::unpackState(unsigned char *this_buffer, unsigned char *prev_bu
   ++cycle_count;
 
 
-  // If we're flashing, check is the packet has been acked
-  if (flashing & !can_packet_acked)
-  {
-    if (can_data_is_ack(can_data))
-    {
-      can_packet_acked = true;
-    }
-  }
+  // Check if the packet acks the flashing packet in flight (the next one is then sent in the next frame),
+  // or answers one of the CAN bridge requests
+  check_CAN_reply(can_data);
 
   return true;
 }
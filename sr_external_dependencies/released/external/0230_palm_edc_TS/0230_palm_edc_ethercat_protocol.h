@@ -116,6 +116,8 @@ typedef struct
     FROM_MOTOR_DATA_TYPE    from_motor_data_type;               //!< Which data does the host want from the motors?
     int16s                  which_motors;                       //!< Which motors does the host want to read?
                                                                 //!< 0: Even motor numbers.  1: Odd motor numbers
+                                                                //!< The other bits can tell which of these motors are
+                                                                //!< present, see WHICH_MOTORS_PRESENCE_VALID
 
     TO_MOTOR_DATA_TYPE      to_motor_data_type;                 //!< Request for specific motor data
     int32u                   tactile_data_type;                 //!< Request for specific tactile data
@@ -127,6 +129,16 @@ typedef struct
 } __attribute__((packed)) ETHERCAT_DATA_STRUCTURE_0230_PALM_EDC_COMMAND;
 
 
+//! which_motors in the command: bit 0 selects the even or odd motors.
+//! When WHICH_MOTORS_PRESENCE_VALID is set, bit (WHICH_MOTORS_PRESENCE_SHIFT + n) is set if motor (2n + parity)
+//! is present, and the palm only waits for the data of these motors instead of waiting for 10 CAN messages.
+//! Older hosts leave these bits at 0, so the palm keeps waiting for 10 messages.
+#define WHICH_MOTORS_PARITY             0x0001
+#define WHICH_MOTORS_PRESENCE_SHIFT     1
+#define WHICH_MOTORS_PRESENCE_MASK      0x07FE
+#define WHICH_MOTORS_PRESENCE_VALID     0x4000
+
+
 #define PALM_0230_ETHERCAT_COMMAND_HEADER_SIZE  (  sizeof(EDC_COMMAND)          +   \
                                                    sizeof(FROM_MOTOR_DATA_TYPE) +   \
                                                    sizeof(int16s)               +   \
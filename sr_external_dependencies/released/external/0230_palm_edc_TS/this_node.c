@@ -47,8 +47,8 @@ int32u      global_AL_Event_Register = 0;
 TACTILE_SENSOR_PROTOCOL_TYPE    tactile_sensor_protocol = TACTILE_SENSOR_PROTOCOL_TYPE_INVALID;
     AUX_SENSOR_PROTOCOL_TYPE        aux_sensor_protocol =     AUX_SENSOR_PROTOCOL_TYPE_INVALID;
 
-ETHERCAT_DATA_STRUCTURE_0230_PALM_EDC_COMMAND   etherCAT_command_data;              //!< Data structure containing command data, arrived from host PC.
-ETHERCAT_DATA_STRUCTURE_0230_PALM_EDC_STATUS    etherCAT_status_data;               //!< Data structure containing sensor data, going to PC.
+COMMAND_DATA_TYPE                               etherCAT_command_data;              //!< Data structure containing command data, arrived from host PC.
+STATUS_DATA_TYPE                                etherCAT_status_data;               //!< Data structure containing sensor data, going to PC.
 
 ETHERCAT_CAN_BRIDGE_DATA                        can_bridge_data_from_ROS;
 ETHERCAT_CAN_BRIDGE_DATA                        can_bridge_data_to_ROS;
@@ -59,6 +59,14 @@ ETHERCAT_CAN_BRIDGE_DATA                        can_bridge_data_to_ROS;
 
 #define CORE_TIMER_TO_MICROSECONDS(x) ((x) / (SYSTEM_FREQ_HZ/2000000))              //!< Convert from the number of core ticks returned by ReadCoreTimer to a real time in microseconds.
 
+#define FRAME_TIME_US(x)    (((x) * frame_period_us) / 1000)                            //!< Scale a frame time tuned for a 1000us frame to the current frame period.
+
+#define CAN_BRIDGE_REPLY_FRAME_TIME_US  750                                             //!< How long to wait for the reply to a CAN bridge packet sent along with
+                                                                                        //!  the sensor data (after the motor data have been collected).
+
+#define CAN_BRIDGE_REPLY_TIMEOUT_FRAMES 100                                             //!< How many sensor frames to look for the reply to a CAN bridge packet
+                                                                                        //!  (the host gives up after 100ms).
+
 
 
 #ifdef PALM_PCB_00
@@ -115,6 +123,8 @@ ETHERCAT_CAN_BRIDGE_DATA                        can_bridge_data_to_ROS;
 
 int32u frame_start_time             = 0;    //!< Is set to the value of the MIPS core timer when an EtherCAT packet arrives
 int32u idle_time_start              = 0;    //!< Is set to the value of the MIPS core timer when the status data are written to the ET1200
+int32u frame_period_us              = 1000; //!< The period of the EtherCAT frames. Only the 0240 palm follows the period set by the host.
+int32u frames_since_1ms_handler     = 0;    //!< How many frames arrived since approx_1ms_handler() was last called
 
 LED_Class *LED_CAN1_TX              = 0;    //!< The CAN 1 transmit LED
 LED_Class *LED_CAN1_RX              = 0;    //!< The CAN 1 receive LED
@@ -146,13 +156,23 @@ SPI_simple_master_class   *SPI_port = 0;
 
 
 int num_motor_CAN_messages_received_this_frame = 0;     //!< Count of the number of CAN messages received since the Start Of Frame message was sent.
+int8u  motor_presence_known = 0;                        //!< Did the host tell us which motors are present this frame?
+int32u motors_present_this_frame = 0;                   //!< Bit N set if motor N is present and was asked for data this frame.
+int32u can_bridge_reply_frames_left = 0;                //!< How many more sensor frames to look for the reply to the CAN bridge packet. 0 if none is expected.
+int8u  can_bridge_status_holds_message = 0;             //!< Does the CAN bridge status in the ET1200 hold a message (which must be cleared in the next frame)?
+
+#ifdef PALM_0240
+    int8u  all_motors_this_frame = 0;                   //!< Did the host ask for the data of all the motors this frame? (WHICH_MOTORS_ALL)
+    int8u  motor_presence_known_of_parity[2] = {0, 0};  //!< The last presence masks received for the even and odd motors,
+    int32u motors_present_of_parity[2]       = {0, 0};  //!  used when all the motors are asked for data.
+#endif
 
 
 
 void run_tests(void)
 {
-    assert_static(sizeof(ETHERCAT_DATA_STRUCTURE_0230_PALM_EDC_STATUS)  == ETHERCAT_STATUS_0230_AGREED_SIZE);
-    assert_static(sizeof(ETHERCAT_DATA_STRUCTURE_0230_PALM_EDC_COMMAND) == ETHERCAT_COMMAND_0230_AGREED_SIZE);
+    assert_static(sizeof(STATUS_DATA_TYPE)                               == ETHERCAT_STATUS_AGREED_SIZE);
+    assert_static(sizeof(COMMAND_DATA_TYPE)                              == ETHERCAT_COMMAND_AGREED_SIZE);
 
     typedef_tests();
     simple_CAN_tests();
@@ -325,34 +345,34 @@ void initialise_this_node(void)
 
 void Read_Commands_From_ET1200(void)
 {
-    assert_dynamic(PALM_0230_ETHERCAT_COMMAND_DATA_SIZE > 0);
+    assert_dynamic(PALM_ETHERCAT_COMMAND_DATA_SIZE > 0);
     //read_ET1200_register_N(EC_PALM_EDC_COMMAND_PHY_BASE, ETHERCAT_COMMAND_DATA_SIZE, (int8u*)(&etherCAT_command_data));
 /*
-    read_ET1200_register_N( PALM_0230_ETHERCAT_COMMAND_DATA_ADDRESS,
-                            PALM_0230_ETHERCAT_COMMAND_DATA_SIZE,
+    read_ET1200_register_N( PALM_ETHERCAT_COMMAND_DATA_ADDRESS,
+                            PALM_ETHERCAT_COMMAND_DATA_SIZE,
                             (int8u*)(&etherCAT_command_data)  );
 */
-    read_DMA_ET1200_register_N ( PALM_0230_ETHERCAT_COMMAND_DATA_ADDRESS,
-                                 PALM_0230_ETHERCAT_COMMAND_DATA_SIZE,
+    read_DMA_ET1200_register_N ( PALM_ETHERCAT_COMMAND_DATA_ADDRESS,
+                                 PALM_ETHERCAT_COMMAND_DATA_SIZE,
                                 (int8u*)(&etherCAT_command_data)  );
 }
 
 
 void Read_Command_Header_From_ET1200(void)
 {
-    assert_dynamic(PALM_0230_ETHERCAT_COMMAND_DATA_SIZE > 0);
+    assert_dynamic(PALM_ETHERCAT_COMMAND_DATA_SIZE > 0);
 
-    read_ET1200_register_N( PALM_0230_ETHERCAT_COMMAND_DATA_ADDRESS,
+    read_ET1200_register_N( PALM_ETHERCAT_COMMAND_DATA_ADDRESS,
                             PALM_0230_ETHERCAT_COMMAND_HEADER_SIZE,
                             (int8u*)(&etherCAT_command_data)  );
 }
 
 void Read_Command_Footer_From_ET1200(void)
 {
-    assert_dynamic(PALM_0230_ETHERCAT_COMMAND_DATA_SIZE > 0);
+    assert_dynamic(PALM_ETHERCAT_COMMAND_DATA_SIZE > 0);
 
-    read_ET1200_register_N( PALM_0230_ETHERCAT_COMMAND_DATA_ADDRESS + PALM_0230_ETHERCAT_COMMAND_HEADER_SIZE,
-                            PALM_0230_ETHERCAT_COMMAND_DATA_SIZE    - PALM_0230_ETHERCAT_COMMAND_HEADER_SIZE,
+    read_ET1200_register_N( PALM_ETHERCAT_COMMAND_DATA_ADDRESS + PALM_0230_ETHERCAT_COMMAND_HEADER_SIZE,
+                            PALM_ETHERCAT_COMMAND_DATA_SIZE    - PALM_0230_ETHERCAT_COMMAND_HEADER_SIZE,
                             (int8u*)(&etherCAT_command_data)        + PALM_0230_ETHERCAT_COMMAND_HEADER_SIZE);
 
 }
@@ -365,7 +385,7 @@ void Read_Command_Footer_From_ET1200(void)
 //! @author Hugo Elias
 inline void write_status_header_and_joint_data_To_ET1200(void)
 {
-    int16u destniation_address = PALM_0230_ETHERCAT_STATUS_DATA_ADDRESS;
+    int16u destniation_address = PALM_ETHERCAT_STATUS_DATA_ADDRESS;
     int16u num_bytes           = STATUS_JOINTS_LENGTH;
     int8u *source_pointer      = (int8u*)(&etherCAT_status_data);
 
@@ -375,7 +395,7 @@ inline void write_status_header_and_joint_data_To_ET1200(void)
 
 inline void write_status_tactile_data_To_ET1200(void)
 {
-    int16u destniation_address = PALM_0230_ETHERCAT_STATUS_DATA_ADDRESS + STATUS_TACTILE_START;
+    int16u destniation_address = PALM_ETHERCAT_STATUS_DATA_ADDRESS + STATUS_TACTILE_START;
     int16u num_bytes           = STATUS_TACTILE_LENGTH;
     int8u *source_pointer      = (int8u*)(&etherCAT_status_data)        + STATUS_TACTILE_START;
 
@@ -385,7 +405,7 @@ inline void write_status_tactile_data_To_ET1200(void)
 
 inline void write_status_aux_data_To_ET1200(void)
 {
-    int16u destniation_address = PALM_0230_ETHERCAT_STATUS_DATA_ADDRESS + STATUS_AUX_START;
+    int16u destniation_address = PALM_ETHERCAT_STATUS_DATA_ADDRESS + STATUS_AUX_START;
     int16u num_bytes           = STATUS_AUX_LENGTH;
     int8u *source_pointer      = (int8u*)(&etherCAT_status_data)        + STATUS_AUX_START;
 
@@ -395,18 +415,18 @@ inline void write_status_aux_data_To_ET1200(void)
 
 inline void write_status_motor_data_To_ET1200(void)
 {
-    int16u destniation_address = PALM_0230_ETHERCAT_STATUS_DATA_ADDRESS + STATUS_MOTOR_START;
-    int16u num_bytes           = STATUS_MOTOR_LENGTH;
-    int8u *source_pointer      = (int8u*)(&etherCAT_status_data)        + STATUS_MOTOR_START;
+    int16u destniation_address = PALM_ETHERCAT_STATUS_DATA_ADDRESS + PALM_STATUS_MOTOR_START;
+    int16u num_bytes           = PALM_STATUS_MOTOR_LENGTH;
+    int8u *source_pointer      = (int8u*)(&etherCAT_status_data)        + PALM_STATUS_MOTOR_START;
 
     write_DMA_ET1200_register_N(destniation_address, num_bytes, source_pointer);
 }
 
 inline void write_status_idletime_data_To_ET1200(void)
 {
-    int16u destniation_address = PALM_0230_ETHERCAT_STATUS_DATA_ADDRESS + STATUS_IDLETIME_START;
-    int16u num_bytes           = STATUS_IDLETIME_LENGTH;
-    int8u *source_pointer      = (int8u*)(&etherCAT_status_data)        + STATUS_IDLETIME_START;
+    int16u destniation_address = PALM_ETHERCAT_STATUS_DATA_ADDRESS + PALM_STATUS_IDLETIME_START;
+    int16u num_bytes           = PALM_STATUS_IDLETIME_LENGTH;
+    int8u *source_pointer      = (int8u*)(&etherCAT_status_data)        + PALM_STATUS_IDLETIME_START;
 
     write_DMA_ET1200_register_N(destniation_address, num_bytes, source_pointer);
 }
@@ -414,7 +434,7 @@ inline void write_status_idletime_data_To_ET1200(void)
 
 inline void write_status_data_To_ET1200(void)
 {
-    int16u destniation_address = PALM_0230_ETHERCAT_STATUS_DATA_ADDRESS;
+    int16u destniation_address = PALM_ETHERCAT_STATUS_DATA_ADDRESS;
     int16u num_bytes           = sizeof(etherCAT_status_data);
     int8u *source_pointer      = (int8u*)(&etherCAT_status_data);
 
@@ -455,12 +475,50 @@ int8u ROS_Wants_me_to_send_CAN(void)
 //! @author Hugo Elias
 int8u not_all_motor_data_received(void)
 {
+    if (motor_presence_known)
+        return (etherCAT_status_data.which_motor_data_arrived & motors_present_this_frame) != motors_present_this_frame;
+
+    #ifdef PALM_0240
+        if (all_motors_this_frame)
+            return num_motor_CAN_messages_received_this_frame < NUM_MOTORS;
+    #endif
+
     return num_motor_CAN_messages_received_this_frame < 10;
 }
 
 
 
-//! Return the time in microseconds since the the beginning of the current 1ms frame.
+//! Read the motor presence mask sent by the host in which_motors (see WHICH_MOTORS_PRESENCE_VALID),
+//! so that we don't wait for the motors which aren't there.
+void update_motors_present(void)
+{
+    int16s which_motors = etherCAT_command_data.which_motors;
+    int8u  parity       = which_motors & WHICH_MOTORS_PARITY;
+    int16u present      = (which_motors & WHICH_MOTORS_PRESENCE_MASK) >> WHICH_MOTORS_PRESENCE_SHIFT;
+    int8u  i;
+
+    motor_presence_known      = (which_motors & WHICH_MOTORS_PRESENCE_VALID) != 0;
+    motors_present_this_frame = 0x00000000;
+
+    for (i=0; i<10; i++)
+        if (present & (0x01 << i))
+            motors_present_this_frame |= 0x00000001 << ((i<<1) + parity);
+
+    #ifdef PALM_0240
+        all_motors_this_frame = (which_motors & WHICH_MOTORS_ALL) != 0;
+        if (all_motors_this_frame)                                                      // The host still alternates the parity, with the
+        {                                                                               // presence mask of that parity: keep the last mask
+            motor_presence_known_of_parity[parity] = motor_presence_known;              // of each parity, and wait for the motors present
+            motors_present_of_parity[parity]       = motors_present_this_frame;         // in both.
+            motor_presence_known      = motor_presence_known_of_parity[0] && motor_presence_known_of_parity[1];
+            motors_present_this_frame = motors_present_of_parity[0] | motors_present_of_parity[1];
+        }
+    #endif
+}
+
+
+
+//! Return the time in microseconds since the the beginning of the current frame.
 //! The timer is started when the PIC sees that new Command data are available.
 //!
 //! @author Hugo Elias
@@ -471,6 +529,30 @@ int32u get_frame_time_us(void)
 
 
 
+#ifdef PALM_0240
+//! Take the frame period asked by the host. The frame deadlines
+//! (FRAME_TIME_US) follow it from the next frame on.
+//!
+//! @author Shadow Robot Software Team
+void update_frame_period(void)
+{
+    int32u period = etherCAT_command_data.frame_period_us;
+
+    if (period == 0)                                                                    // Hosts which don't know about the frame period
+        period = PALM_0240_FRAME_PERIOD_US_DEFAULT;
+
+    if (period < PALM_0240_FRAME_PERIOD_US_MIN)
+        period = PALM_0240_FRAME_PERIOD_US_MIN;
+
+    if (period > PALM_0240_FRAME_PERIOD_US_MAX)
+        period = PALM_0240_FRAME_PERIOD_US_MAX;
+
+    frame_period_us = period;
+}
+#endif
+
+
+
 //! Half the motors will each send back one data message.
 //! Wait until we have 5 messages from each bus, then we
 //! can write the data back to the ET1200
@@ -495,14 +577,14 @@ void Wait_For_All_Motors_To_Send_Data(int32u timeout_us)
 
  
 
-//! Wait until a certain time within the 1000us frame time.
+//! Wait until a certain time within the frame (frame_period_us long).
 //! This is a useful function for waiting until the last
 //! moment to see if any more CAN messages arrive, before
 //! writing data back to the ET1200.
 //!
 //! Frame time is in microseconds, starting at 0 when the EtherCAT
-//! packet arrives, and should never be seen to go beyond 1000, when
-//! the next EtherCAT packet should arrive.
+//! packet arrives, and should never be seen to go beyond frame_period_us,
+//! when the next EtherCAT packet should arrive.
 //!
 //! @param frame_time_us The frame time in microseconds.
 //!
@@ -622,10 +704,10 @@ void Read_Tactile_Sensors(void)
         case TACTILE_SENSOR_PROTOCOL_TYPE_BIOTAC_2_3:                               // BioTac: Hall, Misc, and Pac again are read after joint sensors.
             biotac_read_sensors(&etherCAT_command_data, &etherCAT_status_data, 0);
 
-            Wait_For_All_Motors_To_Send_Data(frame_time+490);                       // Use this delay time productively
-            Wait_For_Until_Frame_Time(frame_time+500);                              // Now that we're close to the time, use a more accurate wait routine.
+            Wait_For_All_Motors_To_Send_Data(frame_time+FRAME_TIME_US(490));        // Use this delay time productively
+            Wait_For_Until_Frame_Time(frame_time+FRAME_TIME_US(500));               // Now that we're close to the time, use a more accurate wait routine.
 
-            biotac_read_pac(1, &etherCAT_command_data, &etherCAT_status_data);      // Read the Pac again at 500us to achieve 2000Hz.
+            biotac_read_pac(1, &etherCAT_command_data, &etherCAT_status_data);      // Read the Pac again half way through the frame to achieve twice the frame rate.
             break;
 
         case TACTILE_SENSOR_PROTOCOL_TYPE_UBI0:                                     //
@@ -676,6 +758,88 @@ void Read_Aux_Sensors(void)
 
 }
 
+//! Clear the CAN bridge status once it's been written to the ET1200,
+//! just for Wireshark tidyness.
+//!
+//! @author Shadow Robot Software Team
+void clear_CAN_bridge_data_to_ROS(void)
+{
+    can_bridge_data_to_ROS.message_id      = 0;
+    can_bridge_data_to_ROS.message_length  = 0;
+    can_bridge_data_to_ROS.can_bus         = 0;
+    can_bridge_data_to_ROS.message_data[0] = 0;
+    can_bridge_data_to_ROS.message_data[1] = 0;
+    can_bridge_data_to_ROS.message_data[2] = 0;
+    can_bridge_data_to_ROS.message_data[3] = 0;
+    can_bridge_data_to_ROS.message_data[4] = 0;
+    can_bridge_data_to_ROS.message_data[5] = 0;
+    can_bridge_data_to_ROS.message_data[6] = 0;
+    can_bridge_data_to_ROS.message_data[7] = 0;
+}
+
+
+
+//! Write the CAN bridge status to the ET1200, then clear it.
+//!
+//! @author Shadow Robot Software Team
+void write_CAN_bridge_data_to_ROS(void)
+{
+    can_bridge_status_holds_message = (can_bridge_data_to_ROS.message_id != 0);
+    write_ET1200_register_N(PALM_ETHERCAT_CAN_BRIDGE_DATA_STATUS_ADDRESS, ETHERCAT_CAN_BRIDGE_DATA_SIZE, (int8u*)(&can_bridge_data_to_ROS));
+    clear_CAN_bridge_data_to_ROS();
+}
+
+
+
+//! Forward the CAN bridge packet from ROS in a normal sensor data frame.
+//! This lets ROS flash one motor while the rest of the hand keeps running.
+//! The packet is sent once the motor data have been collected, so that it
+//! doesn't delay them. The reply, if it arrives early enough, is returned
+//! in the CAN bridge status of the same frame. Otherwise it's returned in
+//! the next frame (it's saved by Check_For_EtherCAT_Packet() in between).
+//!
+//! ROS sends an empty packet (ID 0) when it has nothing to send, and those
+//! are not forwarded to the CAN buses.
+//!
+//! The CAN buses are only polled while a reply is expected (until it arrives,
+//! or for CAN_BRIDGE_REPLY_TIMEOUT_FRAMES frames), and the CAN bridge status
+//! is only written when it holds a message, or to clear the previous one.
+//!
+//! @author Shadow Robot Software Team
+void Service_CAN_Bridge_In_Sensor_Frame(void)
+{
+    if ( ROS_Wants_me_to_send_CAN() )
+    {
+        read_ET1200_register_N(PALM_ETHERCAT_CAN_BRIDGE_DATA_COMMAND_ADDRESS, ETHERCAT_CAN_BRIDGE_DATA_SIZE, (int8u*)(&can_bridge_data_from_ROS));
+        global_AL_Event_Register = read_ET1200_register_32u(0x220);
+
+        if (can_bridge_data_from_ROS.message_id != 0)
+        {
+            send_CAN_message_from_ROS();
+            can_bridge_reply_frames_left = CAN_BRIDGE_REPLY_TIMEOUT_FRAMES;
+            Wait_For_Until_Frame_Time(FRAME_TIME_US(CAN_BRIDGE_REPLY_FRAME_TIME_US));   // Give the node a little time to respond
+        }
+    }
+
+    if (can_bridge_reply_frames_left)
+    {
+        --can_bridge_reply_frames_left;
+        collect_one_CAN_message();                                                      // From either CAN bus
+    }
+
+    if (can_bridge_data_to_ROS.message_id != 0)                                         // The reply arrived (maybe saved by Check_For_EtherCAT_Packet())
+    {
+        can_bridge_reply_frames_left = 0;
+        write_CAN_bridge_data_to_ROS();
+    }
+    else if (can_bridge_status_holds_message)                                           // Clear the reply sent in the previous frame
+    {
+        write_CAN_bridge_data_to_ROS();
+    }
+}
+
+
+
 //! Zero the array containing the motor data so that it's tidy.
 //!
 //! @author Hugo Elias
@@ -683,7 +847,7 @@ void zero_motor_data_packets(void)
 {
     int i;
 
-    for (i=0; i<9; i++)
+    for (i=0; i<sizeof(etherCAT_status_data.motor_data_packet)/sizeof(MOTOR_DATA_PACKET); i++)
     {
         etherCAT_status_data.motor_data_packet[i].torque = 0;
         etherCAT_status_data.motor_data_packet[i].misc   = 0;
@@ -691,7 +855,11 @@ void zero_motor_data_packets(void)
 
     etherCAT_status_data.which_motor_data_arrived    = 0x00000000;
     etherCAT_status_data.which_motor_data_had_errors = 0x00000000;
-    etherCAT_status_data.which_motors                = etherCAT_command_data.which_motors;
+    #ifdef PALM_0240
+        etherCAT_status_data.which_motors            = etherCAT_command_data.which_motors & (WHICH_MOTORS_PARITY | WHICH_MOTORS_ALL);
+    #else
+        etherCAT_status_data.which_motors            = etherCAT_command_data.which_motors & WHICH_MOTORS_PARITY;
+    #endif
 }
 
 
@@ -711,7 +879,7 @@ void Check_For_EtherCAT_Packet(void)
 
     #if AUTO_TRIGGER == 1                                                                   // This is just for debugging.
         //Read_All_Sensors();
-        if (get_frame_time_us() > 1150)                                                     // 
+        if (get_frame_time_us() > FRAME_TIME_US(1150))                                      // 
         {                                                                                   // 
             //Read_All_Sensors();
             
@@ -728,14 +896,20 @@ void Check_For_EtherCAT_Packet(void)
     if (There_is_Command_From_ET1200())
     {   
         frame_start_time = ReadCoreTimer();                                                 // The frame starts NOW!
-        approx_1ms_handler();                                                               // Normally, the EtherCAT packets are used as a 1ms time base.
+        frames_since_1ms_handler++;                                                         // Normally, the EtherCAT packets are used as a 1ms time base,
+        if (frames_since_1ms_handler * frame_period_us >= 1000)                             // counting as many frames as a millisecond takes.
+        {
+            frames_since_1ms_handler = 0;
+            approx_1ms_handler();
+        }
         Service_EtherCAT_Packet();
         return;
     }
 
-    if (get_frame_time_us() > 1300)                                                         // If there are no EtherCAT packets,
+    if (get_frame_time_us() > FRAME_TIME_US(1300))                                          // If there are no EtherCAT packets,
     {                                                                                       // then we need to trigger approx_1ms_handler()
         frame_start_time = ReadCoreTimer();                                                 // And so we think of a frame starting now.
+        frames_since_1ms_handler = 0;
         approx_1ms_handler();                                                               // by time instead. 
         return;
     }
@@ -776,7 +950,17 @@ void Service_EtherCAT_Packet(void)
                 send_CAN_request_data_message( 0x00,
                                                MOTOR_DATA_SLOW_MISC);     // Start of frame message
             #else
-                send_CAN_request_data_message( etherCAT_command_data.which_motors,
+                #ifdef PALM_0240
+                if (etherCAT_command_data.which_motors & WHICH_MOTORS_ALL)                      // All the motors send their data this frame
+                {
+                    send_CAN_request_data_message( 0x00,
+                                                   etherCAT_command_data.from_motor_data_type); // Start of frame message for the even motors
+                    send_CAN_request_data_message( 0x01,
+                                                   etherCAT_command_data.from_motor_data_type); // and for the odd ones
+                }
+                else
+                #endif
+                send_CAN_request_data_message( etherCAT_command_data.which_motors & WHICH_MOTORS_PARITY,
                                                etherCAT_command_data.from_motor_data_type);     // Start of frame message
             #endif
 
@@ -794,12 +978,18 @@ void Service_EtherCAT_Packet(void)
             write_status_aux_data_To_ET1200();                                              // Start transmitting that data to the ET1200
 
             num_motor_CAN_messages_received_this_frame = 0;
+            update_motors_present();
             zero_motor_data_packets();                                                      // Housekeeping
-            Wait_For_All_Motors_To_Send_Data(550);                                          // Wait for 600us max.
+            Wait_For_All_Motors_To_Send_Data(FRAME_TIME_US(550));                           // Wait for 550us max (at 1kHz).
             Send_Data_To_Motors(&etherCAT_command_data);                                    // Send CAN messages to motors
-            Wait_For_All_Motors_To_Send_Data(625);                                          // Wait for 600us max.
+            #ifdef PALM_0240
+            update_frame_period();                                                          // The whole command has been read by now
+            #endif
+            Wait_For_All_Motors_To_Send_Data(FRAME_TIME_US(625));                           // Wait for 625us max (at 1kHz).
             write_status_motor_data_To_ET1200();
 
+            Service_CAN_Bridge_In_Sensor_Frame();                                           // e.g. flashing a motor while the others are running
+
             etherCAT_status_data.EDC_command  = EDC_COMMAND_SENSOR_DATA;                    // FIXME: I don't think this calculation is correct
             etherCAT_status_data.idle_time_us = calculate_idle_time();                      // 
 
@@ -821,7 +1011,7 @@ void Service_EtherCAT_Packet(void)
 
             if ( ROS_Wants_me_to_send_CAN() )
             {
-                read_ET1200_register_N(PALM_0230_ETHERCAT_CAN_BRIDGE_DATA_COMMAND_ADDRESS, ETHERCAT_CAN_BRIDGE_DATA_SIZE, (int8u*)(&can_bridge_data_from_ROS));
+                read_ET1200_register_N(PALM_ETHERCAT_CAN_BRIDGE_DATA_COMMAND_ADDRESS, ETHERCAT_CAN_BRIDGE_DATA_SIZE, (int8u*)(&can_bridge_data_from_ROS));
                 send_CAN_message_from_ROS();
                 global_AL_Event_Register = read_ET1200_register_32u(0x220);
             }
@@ -830,24 +1020,12 @@ void Service_EtherCAT_Packet(void)
             etherCAT_status_data.idle_time_us = calculate_idle_time();                      // FIXME: I don't think this calculation is correct
             write_status_data_To_ET1200();                                                  // 
 
-            Wait_For_Until_Frame_Time(600);                                                 // Give the node a little time to respond, and we might be able
+            Wait_For_Until_Frame_Time(FRAME_TIME_US(600));                                  // Give the node a little time to respond, and we might be able
                                                                                             // to get the reply message back into the very next EtherCAT packet.
 
             collect_one_CAN_message();                                                      // From either CAN bus
 
-            write_ET1200_register_N(PALM_0230_ETHERCAT_CAN_BRIDGE_DATA_STATUS_ADDRESS, ETHERCAT_CAN_BRIDGE_DATA_SIZE, (int8u*)(&can_bridge_data_to_ROS));
-
-            can_bridge_data_to_ROS.message_id      = 0;                                     // Clear the buffer just for Wireshark tidyness
-            can_bridge_data_to_ROS.message_length  = 0;
-            can_bridge_data_to_ROS.can_bus         = 0;
-            can_bridge_data_to_ROS.message_data[0] = 0;
-            can_bridge_data_to_ROS.message_data[1] = 0;
-            can_bridge_data_to_ROS.message_data[2] = 0;
-            can_bridge_data_to_ROS.message_data[3] = 0;
-            can_bridge_data_to_ROS.message_data[4] = 0;
-            can_bridge_data_to_ROS.message_data[5] = 0;
-            can_bridge_data_to_ROS.message_data[6] = 0;
-            can_bridge_data_to_ROS.message_data[7] = 0;
+            write_CAN_bridge_data_to_ROS();                                                 // Then clear the buffer just for Wireshark tidyness
 
             idle_time_start = ReadCoreTimer();                                              // Idle time begins now
 
@@ -874,10 +1052,10 @@ void Platform_Init_Callback(void)
     etherCAT_command_data.EDC_command        = 0xDD;//EDC_COMMAND_SENSOR_DATA;
     can_bridge_data_from_ROS.message_data[0] = 0xff;
 
-    for (i = 1; i < PALM_0230_ETHERCAT_STATUS_DATA_SIZE / 2 ; ++i)
+    for (i = 1; i < PALM_ETHERCAT_STATUS_DATA_SIZE / 2 ; ++i)
         ((int16s *)&etherCAT_status_data)[i] = 0xDEAD;
     
-    write_ET1200_register_N  ( PALM_0230_ETHERCAT_STATUS_DATA_ADDRESS, PALM_0230_ETHERCAT_STATUS_DATA_SIZE,   (int8u*)&etherCAT_status_data);
+    write_ET1200_register_N  ( PALM_ETHERCAT_STATUS_DATA_ADDRESS, PALM_ETHERCAT_STATUS_DATA_SIZE,   (int8u*)&etherCAT_status_data);
 }
 
 
@@ -1021,14 +1199,20 @@ void Received_Motor_Data(FROM_MOTOR_DATA_TYPE data_type, int8u motor_number, int
     }
 
     FROM_MOTOR_DATA_TYPE    expected_data_type   = etherCAT_command_data.from_motor_data_type;
+    int8u                   packet               = motor_number>>1;                                     // Even or odd motors: 10 packets
+
+    #ifdef PALM_0240
+        if (all_motors_this_frame)                                                                      // All the motors: one packet each
+            packet = motor_number;
+    #endif
 
     num_motor_CAN_messages_received_this_frame++;
 
     if (data_type == expected_data_type)                                                                // This is good :)
     {
         etherCAT_status_data.motor_data_type                            = data_type;
-        etherCAT_status_data.motor_data_packet[motor_number>>1].torque  = measured_torque;
-        etherCAT_status_data.motor_data_packet[motor_number>>1].misc    = other_value;
+        etherCAT_status_data.motor_data_packet[packet].torque           = measured_torque;
+        etherCAT_status_data.motor_data_packet[packet].misc             = other_value;
 
         etherCAT_status_data.which_motor_data_arrived                  |= 0x00000001 << motor_number;   // Record that a message arrived
         etherCAT_status_data.which_motor_data_had_errors               &= 0xFFFFFFFE << motor_number;   // and that it was good (as far as we can tell)
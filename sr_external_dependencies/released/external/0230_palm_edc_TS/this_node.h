@@ -59,8 +59,41 @@
 
 #define NO_STRINGS
 #include "0230_palm_edc_ethercat_protocol.h"
-#define COMMAND_DATA_TYPE ETHERCAT_DATA_STRUCTURE_0230_PALM_EDC_COMMAND
-#define STATUS_DATA_TYPE  ETHERCAT_DATA_STRUCTURE_0230_PALM_EDC_STATUS
+
+#ifdef PALM_0240                                    // Define PALM_0240 to build the firmware of the 0240 palm, which can
+                                                    // return the data of all the motors in every frame, and follows the
+                                                    // frame period of the host.
+    #include "../0240_palm_edc_TS/0240_palm_edc_ethercat_protocol.h"
+    #define COMMAND_DATA_TYPE                       ETHERCAT_DATA_STRUCTURE_0240_PALM_EDC_COMMAND
+    #define ETHERCAT_COMMAND_AGREED_SIZE            ETHERCAT_COMMAND_0240_AGREED_SIZE
+    #define PALM_ETHERCAT_COMMAND_DATA_ADDRESS      PALM_0240_ETHERCAT_COMMAND_DATA_ADDRESS
+    #define PALM_ETHERCAT_COMMAND_DATA_SIZE         PALM_0240_ETHERCAT_COMMAND_DATA_SIZE
+    #define PALM_ETHERCAT_CAN_BRIDGE_DATA_COMMAND_ADDRESS   PALM_0240_ETHERCAT_CAN_BRIDGE_DATA_COMMAND_ADDRESS
+    #define STATUS_DATA_TYPE                        ETHERCAT_DATA_STRUCTURE_0240_PALM_EDC_STATUS
+    #define ETHERCAT_STATUS_AGREED_SIZE             ETHERCAT_STATUS_0240_AGREED_SIZE
+    #define PALM_ETHERCAT_STATUS_DATA_ADDRESS       PALM_0240_ETHERCAT_STATUS_DATA_ADDRESS
+    #define PALM_ETHERCAT_STATUS_DATA_SIZE          PALM_0240_ETHERCAT_STATUS_DATA_SIZE
+    #define PALM_ETHERCAT_CAN_BRIDGE_DATA_STATUS_ADDRESS    PALM_0240_ETHERCAT_CAN_BRIDGE_DATA_STATUS_ADDRESS
+    #define PALM_STATUS_MOTOR_START                 STATUS_0240_MOTOR_START
+    #define PALM_STATUS_MOTOR_LENGTH                STATUS_0240_MOTOR_LENGTH
+    #define PALM_STATUS_IDLETIME_START              STATUS_0240_IDLETIME_START
+    #define PALM_STATUS_IDLETIME_LENGTH             STATUS_0240_IDLETIME_LENGTH
+#else
+    #define COMMAND_DATA_TYPE                       ETHERCAT_DATA_STRUCTURE_0230_PALM_EDC_COMMAND
+    #define ETHERCAT_COMMAND_AGREED_SIZE            ETHERCAT_COMMAND_0230_AGREED_SIZE
+    #define PALM_ETHERCAT_COMMAND_DATA_ADDRESS      PALM_0230_ETHERCAT_COMMAND_DATA_ADDRESS
+    #define PALM_ETHERCAT_COMMAND_DATA_SIZE         PALM_0230_ETHERCAT_COMMAND_DATA_SIZE
+    #define PALM_ETHERCAT_CAN_BRIDGE_DATA_COMMAND_ADDRESS   PALM_0230_ETHERCAT_CAN_BRIDGE_DATA_COMMAND_ADDRESS
+    #define STATUS_DATA_TYPE                        ETHERCAT_DATA_STRUCTURE_0230_PALM_EDC_STATUS
+    #define ETHERCAT_STATUS_AGREED_SIZE             ETHERCAT_STATUS_0230_AGREED_SIZE
+    #define PALM_ETHERCAT_STATUS_DATA_ADDRESS       PALM_0230_ETHERCAT_STATUS_DATA_ADDRESS
+    #define PALM_ETHERCAT_STATUS_DATA_SIZE          PALM_0230_ETHERCAT_STATUS_DATA_SIZE
+    #define PALM_ETHERCAT_CAN_BRIDGE_DATA_STATUS_ADDRESS    PALM_0230_ETHERCAT_CAN_BRIDGE_DATA_STATUS_ADDRESS
+    #define PALM_STATUS_MOTOR_START                 STATUS_MOTOR_START
+    #define PALM_STATUS_MOTOR_LENGTH                STATUS_MOTOR_LENGTH
+    #define PALM_STATUS_IDLETIME_START              STATUS_IDLETIME_START
+    #define PALM_STATUS_IDLETIME_LENGTH             STATUS_IDLETIME_LENGTH
+#endif
 #include "simple_can/simple_can.h"
 
 
@@ -125,8 +158,13 @@ void   Check_For_EtherCAT_Packet(void);
 int32u get_product_code(void);
 
 // application defines
-#define THIS_NODE_PRODUCT_CODE_LEFT     0x01000001
-#define THIS_NODE_PRODUCT_CODE_RIGHT    0x01000000
+#ifdef PALM_0240
+    #define THIS_NODE_PRODUCT_CODE_LEFT     0x01000005
+    #define THIS_NODE_PRODUCT_CODE_RIGHT    0x01000004
+#else
+    #define THIS_NODE_PRODUCT_CODE_LEFT     0x01000001
+    #define THIS_NODE_PRODUCT_CODE_RIGHT    0x01000000
+#endif
 #define THIS_NODE_PRODUCT_CODE      get_product_code()
 
 #define SYSTEM_FREQ_HZ            80000000
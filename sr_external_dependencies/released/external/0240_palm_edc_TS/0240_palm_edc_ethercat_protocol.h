@@ -0,0 +1,170 @@
+//
+// (C) 2026 Shadow Robot Company Limited.
+//
+// FileName:        0240_palm_edc_ethercat_protocol.h
+// Dependencies:
+// Processor:       PIC32
+// Compiler:        MPLAB C32
+//
+//  +------------------------------------------------------------------------+
+//  | This file is part of The Shadow Robot PIC32 firmware code base.        |
+//  |                                                                        |
+//  | It is free software: you can redistribute it and/or modify             |
+//  | it under the terms of the GNU General Public License as published by   |
+//  | the Free Software Foundation, either version 3 of the License, or      |
+//  | (at your option) any later version.                                    |
+//  |                                                                        |
+//  | It is distributed in the hope that it will be useful,                  |
+//  | but WITHOUT ANY WARRANTY; without even the implied warranty of         |
+//  | MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          |
+//  | GNU General Public License for more details.                           |
+//  |                                                                        |
+//  | You should have received a copy of the GNU General Public License      |
+//  | along with this code repository. The text of the license can be found  |
+//  | in Pic32/License/gpl.txt. If not, see <http://www.gnu.org/licenses/>.  |
+//  +------------------------------------------------------------------------+
+//
+//
+//
+//  Doxygen
+//  -------
+//
+//! @file
+//!
+//! The 0240 palm is the 0230 palm returning the data of all 20 motors in every frame.
+//!
+//! The command is the 0230 command followed by the frame period, so that the palm can
+//! schedule its frame for EtherCAT cycles faster (or slower) than 1ms. When the host sets WHICH_MOTORS_ALL in
+//! which_motors, the palm asks both the even and the odd motors for from_motor_data_type,
+//! and motor_data_packet[N] contains the data of motor N. Otherwise the palm alternates
+//! between the even and odd motors like the 0230 palm, and only motor_data_packet[0..9]
+//! are used (motor N in motor_data_packet[N>>1]).
+//!
+//! The status echoes WHICH_MOTORS_ALL in which_motors, so the host knows how to read it.
+//!
+//! The tactile and aux data are at the same place as in the 0230 status, so STATUS_TACTILE_START,
+//! STATUS_AUX_START and their lengths are valid for both.
+//!
+//! @addtogroup
+//
+
+#ifndef PALM_EDC_0240_ETHERCAT_PROTOCOL_H_INCLUDED
+#define PALM_EDC_0240_ETHERCAT_PROTOCOL_H_INCLUDED
+
+#include "../0230_palm_edc_TS/0230_palm_edc_ethercat_protocol.h"
+
+//! These are the data sent from the Palm to the host.
+typedef struct
+{
+    EDC_COMMAND                 EDC_command;                        //!< This tells us the contents of the data below.
+                                                                    //!< This value should be identical to the EDC_command
+                                                                    //!< value which arrived from the host in the previous
+                                                                    //!< EtherCAT packet
+
+    //  Joint data & Mid/Prox Tactile data  //
+    int16u                      sensors[SENSORS_NUM_0220+1];        //!<          74 bytes
+    TACTILE_SENSOR_MID_PROX     tactile_mid_prox[5];                //!< 16*5  =  80 bytes
+                                                                    //!< TOTAL = 154 bytes
+
+    //  Fingertip Tactile data  //
+    int32u                      tactile_data_type;                  //!<           4 bytes
+    int16u                      tactile_data_valid;                 //!<           2 bytes          (Bit 0: FF. Bit 4: TH.)
+    TACTILE_SENSOR_STATUS_v2    tactile[5];                         //!<  32*5 = 160 bytes
+                                                                    //!< TOTAL = 166 bytes
+
+    //  Aux SPI port data  //
+    int32u                      aux_spi_data_type;                  //!<           4 bytes
+    AUX_SPI_SENSOR              aux_spi_sensor;                     //!<          32 bytes
+                                                                    //!< TOTAL =  36 bytes
+
+
+    //  Motor data  //
+    FROM_MOTOR_DATA_TYPE        motor_data_type;                    //!< Which data does motor[] contain?
+                                                                    //!< This value should agree with the previous value
+                                                                    //!< in ETHERCAT_DATA_STRUCTURE_0240_PALM_EDC_COMMAND
+    int16s                      which_motors;                       //!< WHICH_MOTORS_ALL: All motors. Otherwise 0: Even motor numbers.  1: Odd motor numbers
+                                                                    //!< This value should agree with the previous value
+                                                                    //!< in ETHERCAT_DATA_STRUCTURE_0240_PALM_EDC_COMMAND
+
+    int32u                      which_motor_data_arrived;           //!< Bit N set when motor CAN message arrives. Ideally, bits 0..19 get set
+    int32u                      which_motor_data_had_errors;        //!< Bit N set when motor sends bad CAN message Ideally, no bits get set.
+
+    MOTOR_DATA_PACKET           motor_data_packet[NUM_MOTORS];      //!< Data for all the motors with WHICH_MOTORS_ALL,
+                                                                    //!< for 10 motors only otherwise (Even ones or Odd ones)
+                                                                    //!< 80 bytes
+                                                                    //  TOTAL MOTOR DATA = 94 bytes
+
+
+    int16u                      idle_time_us;                       //!< The idle time from when the palm has finished dealing with one EtherCAT
+                                                                    //!< packet, and the next packet arriving. Ideally, this number should be more than 50.
+
+} __attribute__((packed)) ETHERCAT_DATA_STRUCTURE_0240_PALM_EDC_STATUS;
+
+#define STATUS_0240_MOTOR_START     (offsetof(ETHERCAT_DATA_STRUCTURE_0240_PALM_EDC_STATUS,   motor_data_type))
+#define STATUS_0240_IDLETIME_START  (offsetof(ETHERCAT_DATA_STRUCTURE_0240_PALM_EDC_STATUS,      idle_time_us))
+
+#define STATUS_0240_TOTAL_LENGTH    (sizeof(ETHERCAT_DATA_STRUCTURE_0240_PALM_EDC_STATUS))
+#define STATUS_0240_MOTOR_LENGTH    (STATUS_0240_IDLETIME_START - STATUS_0240_MOTOR_START)
+#define STATUS_0240_IDLETIME_LENGTH (STATUS_0240_TOTAL_LENGTH   - STATUS_0240_IDLETIME_START)
+
+
+
+//! These are the data sent by the host: the 0230 command, followed by the frame period.
+typedef struct
+{
+    EDC_COMMAND             EDC_command;                        //!< Header [0]:18  What type of data should the palm send back in the next packet?
+                                                                //!< ------
+
+    FROM_MOTOR_DATA_TYPE    from_motor_data_type;               //!< Which data does the host want from the motors?
+    int16s                  which_motors;                       //!< Which motors does the host want to read?
+                                                                //!< WHICH_MOTORS_ALL: All motors. Otherwise 0: Even motor numbers.  1: Odd motor numbers
+                                                                //!< The other bits can tell which of these motors are
+                                                                //!< present, see WHICH_MOTORS_PRESENCE_VALID
+
+    TO_MOTOR_DATA_TYPE      to_motor_data_type;                 //!< Request for specific motor data
+    int32u                   tactile_data_type;                 //!< Request for specific tactile data
+    int32u                       aux_data_type;                 //!< Request for specific aux data
+
+
+    int16s                  motor_data[NUM_MOTORS];             //!< Motor Data [18]:40  Data to send to motors. Typically torque/PWM demands, or configs.
+
+    int16u                  frame_period_us;                    //!< [62]:2  The period of the EtherCAT cycle, in microseconds.
+                                                                //!< The palm scales its frame deadlines (waiting for the motors, reading
+                                                                //!< the BioTac Pac...) to it. 0: 1000us, like the 0230 palm.
+
+} __attribute__((packed)) ETHERCAT_DATA_STRUCTURE_0240_PALM_EDC_COMMAND;
+
+
+//! The frame periods the palm accepts, in microseconds. Outside this range, the palm clamps the period.
+#define PALM_0240_FRAME_PERIOD_US_DEFAULT   1000
+#define PALM_0240_FRAME_PERIOD_US_MIN        500
+#define PALM_0240_FRAME_PERIOD_US_MAX       2000
+
+
+//! which_motors in the command: the palm returns the data of all the motors, whatever the parity.
+//! The parity and the presence bits are still used for the presence mask (see WHICH_MOTORS_PRESENCE_VALID):
+//! the palm keeps the last mask received for each parity, and waits for the motors present in both.
+//! Ignored by the 0230 palm.
+#define WHICH_MOTORS_ALL                0x2000
+
+
+#define PALM_0240_ETHERCAT_STATUS_DATA_SIZE       sizeof(ETHERCAT_DATA_STRUCTURE_0240_PALM_EDC_STATUS)
+#define PALM_0240_ETHERCAT_COMMAND_DATA_SIZE      sizeof(ETHERCAT_DATA_STRUCTURE_0240_PALM_EDC_COMMAND)
+
+#define ETHERCAT_STATUS_0240_AGREED_SIZE     456    //! This is the size of the Status  EtherCAT packet (Status + CAN packet)
+#define ETHERCAT_COMMAND_0240_AGREED_SIZE    64     //! This is the size of the Command EtherCAT packet (Status + CAN packet)
+
+
+//! Same layout as the 0230 palm, only the command and the status are longer
+//!
+//! | ETHERCAT_COMMAND_DATA | ETHERCAT_CAN_BRIDGE_DATA_COMMAND | ETHERCAT_STATUS_DATA | ETHERCAT_CAN_BRIDGE_DATA_STATUS |
+
+#define PALM_0240_ETHERCAT_COMMAND_DATA_ADDRESS               0x1000
+#define PALM_0240_ETHERCAT_CAN_BRIDGE_DATA_COMMAND_ADDRESS    (PALM_0240_ETHERCAT_COMMAND_DATA_ADDRESS            + PALM_0240_ETHERCAT_COMMAND_DATA_SIZE)
+
+#define PALM_0240_ETHERCAT_STATUS_DATA_ADDRESS                (PALM_0240_ETHERCAT_CAN_BRIDGE_DATA_COMMAND_ADDRESS + ETHERCAT_CAN_BRIDGE_DATA_SIZE)
+#define PALM_0240_ETHERCAT_CAN_BRIDGE_DATA_STATUS_ADDRESS     (PALM_0240_ETHERCAT_STATUS_DATA_ADDRESS             + PALM_0240_ETHERCAT_STATUS_DATA_SIZE)
+
+
+
+#endif
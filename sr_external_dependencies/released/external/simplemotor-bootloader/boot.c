@@ -67,7 +67,11 @@ typedef enum
     RESET_COMMAND                 = 0x03,
     READ_VERSION_COMMAND          = 0x04,
     WRITE_FLASH_ADDRESS_COMMAND   = 0x05,
-    MAGIC_PACKET                  = 0x0A
+    CRC_FLASH_COMMAND             = 0x07,
+    ERASE_FLASH_ROW_COMMAND       = 0x08,
+    STREAM_WRITE_HEADER_COMMAND   = 0x09,
+    MAGIC_PACKET                  = 0x0A,
+    STREAM_WRITE_DATA_COMMAND     = 0x0B
 }BOOTLOADER_COMMAND;
 
 typedef enum
@@ -102,6 +106,8 @@ struct CANmsg CanMsgR;                          //!< Structure to store CAN mess
 
 int8u motor_id = 0xFF;                          //!< motor_id will be read from the EEPROM at boot time.
 int8u position = 0x00;                          //!< this is the position of the current FLASH_WRITTING operation ( 0 <= position <= 32)
+int16u stream_remaining = 0;                    //!< number of bytes still expected by the current streamed write
+int8u stream_sequence = 0;                      //!< sequence number of the next data packet of the current streamed write
 
 
 
@@ -349,6 +355,48 @@ static void erase_flash(void)
         address += 64;
     }   
 }
+
+
+
+//! This function erases one row (64 bytes) of the program memory (which is flash),
+//! at the address present in the incoming CAN command. It's used to only rewrite
+//! the rows which changed, instead of erasing the whole user application.
+//! The rows of the bootloader and of the debugger code are never erased.
+//!
+//! @return 0 if the row isn't in the user application (nothing was erased)
+//!
+//! @author Shadow Robot Software Team
+static int8u erase_flash_row(void)
+{
+    overlay int16u address = 0;         // address of the row we're erasing
+
+    address   = CanMsgR.d.byte[1];
+    address <<= 8;
+    address  |= CanMsgR.d.byte[0];
+
+    if ( (CanMsgR.d.byte[2] != 0) || (address < 0x04c0) || (address >= 0x7dc0) )
+        return 0;
+
+    TBLPTR  = address;
+    TBLPTR &= 0xFFFFC0;
+
+    EECON1 |=128;                       // point to Flash program memory
+    EECON1 &= ~64;                      // access Flash program memory
+    EECON1 |= 4;                        // enable write to memory
+    EECON1 |= 16;                       // enable Row Erase operation
+    INTCON &= ~128;                     // disable interrupts
+    EECON2 = 0x55;
+    EECON2 = 0xaa;
+    EECON1 |= 2;                        // start erase (CPU stall)
+
+    while (EECON1 & 2)                  // Wait for stuff being written
+    {
+    }
+
+    INTCON |= 128;                      // enable interrupts
+    EECON1 &= ~4;                       // disable write to memory
+    return 1;
+}
 
 
 
@@ -376,6 +424,54 @@ static void read_flash(void)
     CanMsgT.length    = 8;
     sendCanMsg();
 }
+
+
+
+//! This function computes the CRC of a range of the program memory (which is FLASH).
+//! The address (3 bytes) and the length in bytes (2 bytes) of the range are in the
+//! incoming CAN command. The reply contains the same 5 bytes followed by the CRC
+//! (CRC-16-CCITT, initial value 0xFFFF, low byte first). This lets the host check
+//! a whole region against its firmware image in one CAN round trip, instead of
+//! reading it back 8 bytes at a time.
+//!
+//! @author Shadow Robot Software Team
+static void crc_flash(void)
+{
+    overlay int16u length = 0;
+    overlay int16u crc    = 0xFFFF;
+    overlay int8u  i      = 0;
+
+    TBLPTRL = CanMsgR.d.byte[0];
+    TBLPTRH = CanMsgR.d.byte[1];
+    TBLPTRU = CanMsgR.d.byte[2];
+
+    length   = CanMsgR.d.byte[4];
+    length <<= 8;
+    length  |= CanMsgR.d.byte[3];
+
+    while (length--)
+    {
+        _asm
+            TBLRDPOSTINC
+        _endasm
+        crc ^= ((int16u)TABLAT) << 8;
+
+        for (i=0; i<8; ++i)
+        {
+            if (crc & 0x8000)
+                crc = (crc << 1) ^ 0x1021;
+            else
+                crc <<= 1;
+        }
+    }
+
+    CanMsgT = CanMsgR;                  // Echo the address and the length
+    CanMsgT.d.byte[5] = crc;
+    CanMsgT.d.byte[6] = crc >> 8;
+    CanMsgT.messageID = CanMsgR.messageID | 0x10; // We set the "ACK" bit in the SID
+    CanMsgT.length    = 7;
+    sendCanMsg();
+}
 
 
 
@@ -406,6 +502,32 @@ static void write_flash_address(void)
 
 
 
+//! This function writes the 32 bytes block buffered in the holding registers to the
+//! program memory (which is FLASH). TBLPTR must point at the byte following the block
+//! (after the TBLWTPOSTINC of its last byte), it is left on the last byte of the block.
+//!
+//! @author Yann Sionneau
+static void write_flash_block(void)
+{
+    _asm
+        TBLRDPOSTDEC                                // We do a TBLRDPOSTDEC in order for the TBLPTR addressing register to stay in the range of the 32 bytes
+    _endasm                                         // block we are writting, this is necessary because there has been one extra unneeded TBLWTPOSTINC during
+                                                    // the previous loop. If we don't do that, the block will be written over the next block, so 32 bytes after
+                                                    // the address provided by the previous WRITE_FLASH_ADDRESS command.
+
+    EECON1 |= ((1 << EEPGD) | (1 << WREN));         // point to Flash program memory & enable write to memory
+    EECON1 &= ~(1 << CFGS);                         // access Flash program memory
+    INTCON &= ~(1 << GIE);                          // disable interrupts
+    EECON2 = 0x55;                                  // magic enable
+    EECON2 = 0xaa;
+    EECON1 |= (1 << WR);                            // starts the actual writting (CPU stall)
+    INTCON |= (1 << GIE);                           // re-enable interrupts
+    EECON1 &= ~(1 << WREN);                         // disable write to memory
+    position = 0;                                   // reset the position to 0, we just finished a 32 bytes block
+}
+
+
+
 //! This function does the actual writting in program memory (which is FLASH).
 //! Writting the flash has to be done in blocks of 32 bytes. But we can only transport
 //! 8 bytes of data in a CAN message, so we do the block writting in 4 CAN commands.
@@ -431,23 +553,93 @@ static void write_flash_data(void)
 
     if (position == 32)                                 // If we have buffured a 32 bytes block, we can start the wrtting procedure
     {
-        _asm
-            TBLRDPOSTDEC                                // We do a TBLRDPOSTDEC in order for the TBLPTR addressing register to stay in the range of the 32 bytes
-        _endasm                                         // block we are writting, this is necessary because there has been one extra unneeded TBLWTPOSTINC during
-                                                        // the previous loop. If we don't do that, the block will be written over the next block, so 32 bytes after
-                                                        // the address provided by the previous WRITE_FLASH_ADDRESS command.
-
-        EECON1 |= ((1 << EEPGD) | (1 << WREN));         // point to Flash program memory & enable write to memory
-        EECON1 &= ~(1 << CFGS);                         // access Flash program memory
-        INTCON &= ~(1 << GIE);                          // disable interrupts
-        EECON2 = 0x55;                                  // magic enable
-        EECON2 = 0xaa;
-        EECON1 |= (1 << WR);                            // starts the actual writting (CPU stall)
-        INTCON |= (1 << GIE);                           // re-enable interrupts
-        EECON1 &= ~(1 << WREN);                         // disable write to memory
-        position = 0;                                   // reset the position to 0, we just finished a 32 bytes block
+        write_flash_block();
     }
 }
+
+
+
+//! This function starts a streamed write. The address (2 bytes, the third one must be 0)
+//! and the length in bytes (2 bytes) of the range to write are in the incoming CAN command.
+//! Both must be multiples of 32 bytes and the range must be in the user application,
+//! which must have been erased before.
+//!
+//! @return 0 if the range is refused (no streamed write is started)
+//!
+//! @author Shadow Robot Software Team
+static int8u stream_write_header(void)
+{
+    overlay int16u address = 0;         // first address of the range
+
+    address   = CanMsgR.d.byte[1];
+    address <<= 8;
+    address  |= CanMsgR.d.byte[0];
+
+    stream_remaining   = CanMsgR.d.byte[4];
+    stream_remaining <<= 8;
+    stream_remaining  |= CanMsgR.d.byte[3];
+
+    stream_sequence = 0;
+    position        = 0;
+
+    if ( (CanMsgR.d.byte[2] != 0) || (address & 31) || (stream_remaining & 31) ||
+         (address < 0x04c0) || (address > 0x7dc0) || (stream_remaining > 0x7dc0 - address) )
+    {
+        stream_remaining = 0;
+        return 0;
+    }
+
+    TBLPTRU = 0;
+    TBLPTRH = CanMsgR.d.byte[1];
+    TBLPTRL = CanMsgR.d.byte[0];
+    return 1;
+}
+
+
+
+//! This function buffers the data of a streamed write. The first byte of the incoming
+//! CAN command is its sequence number (starting at 0 after the header), it's followed
+//! by up to 7 bytes of data. Each time 32 bytes are buffered the block is written.
+//! The data packets aren't acknowledged, only the packet completing a block is: this
+//! acknowledges the whole block. If a packet was lost (wrong sequence number), the
+//! rest of the streamed write is ignored, the host will start a new one from the
+//! first block which wasn't acknowledged.
+//!
+//! @return 1 if this packet completed a block
+//!
+//! @author Shadow Robot Software Team
+static int8u stream_write_data(void)
+{
+    int8u i;
+    int8u block_written = 0;
+
+    if ( (stream_remaining == 0) || (CanMsgR.d.byte[0] != stream_sequence) )
+    {
+        stream_remaining = 0;
+        return 0;
+    }
+    ++stream_sequence;
+
+    for (i=1; (i<CanMsgR.length) && (stream_remaining != 0); ++i)
+    {
+        TABLAT = CanMsgR.d.byte[i];
+        _asm
+            TBLWTPOSTINC
+        _endasm
+        --stream_remaining;
+
+        if (++position == 32)
+        {
+            write_flash_block();
+            _asm
+                TBLRDPOSTINC                        // back to the first byte of the next block
+            _endasm
+            block_written = 1;
+        }
+    }
+
+    return block_written;
+}
 
 
 
@@ -529,6 +721,25 @@ static void handle_can_msg(void)
                 acknowledge_packet();
                 break;
 
+            case CRC_FLASH_COMMAND:
+                crc_flash();                            // special ack, done in the function, will ack with the CRC
+                break;
+
+            case ERASE_FLASH_ROW_COMMAND:               // erases one row of program memory
+                if (erase_flash_row())                  // (not acked if the row isn't in the user application)
+                    acknowledge_packet();
+                break;
+
+            case STREAM_WRITE_HEADER_COMMAND:           // starts a streamed write
+                if (stream_write_header())              // (not acked if the range is refused)
+                    acknowledge_packet();
+                break;
+
+            case STREAM_WRITE_DATA_COMMAND:             // buffers the data of a streamed write
+                if (stream_write_data())                // only acked once a whole block is written
+                    acknowledge_packet();
+                break;
+
             case RESET_COMMAND:
                 write_eeprom();
                 acknowledge_packet();
@@ -52,7 +52,11 @@ typedef enum
     READ_VERSION_COMMAND          = 0x04,
     WRITE_FLASH_ADDRESS_COMMAND   = 0x05,
     START_FLASH_WRITE_COMMAND     = 0x06,
-    MAGIC_PACKET                  = 0x0A
+    CRC_FLASH_COMMAND             = 0x07,
+    ERASE_FLASH_ROW_COMMAND       = 0x08,
+    STREAM_WRITE_HEADER_COMMAND   = 0x09,
+    MAGIC_PACKET                  = 0x0A,
+    STREAM_WRITE_DATA_COMMAND     = 0x0B
 }BOOTLOADER_COMMAND;
 
 
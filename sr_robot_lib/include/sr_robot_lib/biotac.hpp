@@ -36,6 +36,7 @@
 
 #include "sr_robot_lib/generic_tactiles.hpp"
 #include "sr_robot_lib/generic_updater.hpp"
+#include "sr_robot_lib/biotac_pac_buffer.hpp"
 
 namespace tactiles
 {
@@ -66,6 +67,24 @@ namespace tactiles
      */
     virtual void update(StatusType *status_data);
 
+    /// The Pac buffer gets a frame at each update, even if its samples didn't change.
+    virtual bool update_when_unchanged() const
+    {
+      return pac_buffer_ != NULL;
+    }
+
+    /**
+     * Builds the tactile part of the command. With the adaptive polling, the data polled depend
+     * on the contact: without contact, mostly the pressure and temperature, with an electrode pair
+     * every idle_electrode_period frames. On contact, mostly the electrodes, alternating between
+     * the pairs which are changing on the fingers in contact and the full scan, with the pressure
+     * every contact_pressure_period frames to detect the release. Still one data type per frame.
+     *
+     * @param command The command which will be sent to the palm.
+     * @return current update state
+     */
+    virtual operation_mode::device_update_state::DeviceUpdateState build_command(CommandType *command);
+
     /**
      * Publish the information to a ROS topic.
      *
@@ -75,9 +94,13 @@ namespace tactiles
     /**
      * This function adds the diagnostics for the tactiles to the
      * multi diagnostic status published by the hand.
+     *
+     * @param snapshot the state of the hand (SrRobotLib::get_state_snapshot()), the tactiles
+     *        are read from it and not from the tactiles_vector written by the realtime loop
      */
     virtual void add_diagnostics(std::vector<diagnostic_msgs::DiagnosticStatus> &vec,
-                                 diagnostic_updater::DiagnosticStatusWrapper &d);
+                                 diagnostic_updater::DiagnosticStatusWrapper &d,
+                                 const shadow_robot::HandStateSnapshot &snapshot);
 
 
     virtual std::vector<AllTactileData> *get_tactile_data();
@@ -90,8 +113,54 @@ namespace tactiles
 
     size_t nb_electrodes_;
 
+    /// Lossless capture of the Pac samples, only instantiated if enabled in the parameters.
+    boost::shared_ptr<BiotacPacBuffer> pac_buffer_;
+    /// Preallocated frame filled at each update before being pushed to the pac_buffer_.
+    BiotacPacFrame pac_frame_;
+
     static const size_t nb_electrodes_v1_;
     static const size_t nb_electrodes_v2_;
+
+    /// Adaptive polling of the electrodes (biotac_adaptive_polling parameters)
+    bool adaptive_polling_;
+    /// A finger is in contact when its Pdc is this much above its baseline
+    int pdc_threshold_;
+    /// An electrode pair is changing when one of them moved this much since its last sample
+    int electrode_threshold_;
+    /// Without contact, an electrode pair is polled every idle_electrode_period_ frames
+    unsigned int idle_electrode_period_;
+    /// On contact, the pressure data are polled every contact_pressure_period_ frames
+    unsigned int contact_pressure_period_;
+
+    /// The important data polled in turn: the pressure and temperature ones, and the electrode pairs
+    std::vector<int32u> pressure_data_;
+    std::vector<int32u> electrode_data_;
+    /// index in electrode_data_ of each data type, -1 if it's not an electrode pair
+    std::vector<int> electrode_slots_;
+
+    /// Pdc without contact of each finger, negative until the first sample
+    std::vector<double> pdc_baselines_;
+    /// fingers (bit mask) whose Pdc is above their baseline
+    int32u fingers_in_contact_;
+    /// electrode pairs (bit mask of their index in electrode_data_) changing on the fingers in contact
+    int32u changing_electrodes_;
+    /// set while decoding a frame if one of the electrodes polled changed
+    bool electrodes_changed_;
+
+    unsigned int polling_frame_;
+    size_t next_pressure_;
+    size_t next_electrode_;
+    size_t next_changing_electrode_;
+    bool changing_electrodes_turn_;
+
+    /**
+     * Follows the Pdc of a finger to detect the contact, and checks if its electrodes are
+     * changing (before the new samples replace the current values).
+     */
+    void track_contact(unsigned int id_sensor, int32u data_type, TACTILE_SENSOR_BIOTAC_DATA_CONTENTS *tactile_data);
+
+    /// The next important data to poll with the adaptive polling.
+    int32u next_adaptive_data();
   };  // end class
 }  // namespace tactiles
 
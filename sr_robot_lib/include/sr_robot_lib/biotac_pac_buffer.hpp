@@ -0,0 +1,117 @@
+/**
+ * @file   biotac_pac_buffer.hpp
+ * @author Shadow Robot Software Team <software@shadowrobot.com>
+ * @date   Sun Oct 18 10:12:51 2026
+ *
+ * Copyright 2026 Shadow Robot Company Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @brief Lossless capture of the BioTac Pac channel.
+ *
+ * The palm reads the Pac twice per EtherCAT frame (at the start and half way through), the
+ * Biotac class only keeps the latest pair. When the capture is enabled,
+ * every pair is pushed with its cycle timestamp to a preallocated lock-free
+ * ring from the realtime loop. A separate thread drains the ring and
+ * publishes all the samples received during the last window in one message.
+ *
+ */
+
+#ifndef _BIOTAC_PAC_BUFFER_HPP_
+#define _BIOTAC_PAC_BUFFER_HPP_
+
+#include <ros/ros.h>
+#include <boost/thread.hpp>
+#include <boost/atomic.hpp>
+#include <boost/smart_ptr.hpp>
+#include <boost/utility.hpp>
+#include <boost/lockfree/spsc_queue.hpp>
+#include <sr_external_dependencies/types_for_external.h>
+#include <sr_robot_lib/BiotacPacAll.h>
+
+namespace tactiles
+{
+  /// All the Pac samples received in one EtherCAT frame.
+  struct BiotacPacFrame
+  {
+    static const unsigned int max_tactiles = 5;
+    static const unsigned int samples_per_frame = 2;
+
+    ros::Time stamp;
+    int16u pac[max_tactiles][samples_per_frame];
+  };
+
+  class BiotacPacBuffer :
+          private boost::noncopyable
+  {
+  public:
+    /**
+     * Preallocates the ring and the message, then starts the publishing thread.
+     *
+     * @param nh The node handle used to advertise the topic.
+     * @param nb_tactiles The number of BioTacs on the hand.
+     * @param window The publishing period (in seconds).
+     * @param buffer_length How much data the ring can hold (in seconds) if the
+     *                      publishing thread falls behind.
+     * @param cycle_period The period of the EtherCAT cycle (in seconds).
+     */
+    BiotacPacBuffer(ros::NodeHandle nh, unsigned int nb_tactiles, double window, double buffer_length,
+                    double cycle_period);
+
+    ~BiotacPacBuffer();
+
+    /**
+     * Called from the realtime loop for every frame. Never blocks nor
+     * allocates: the frame is dropped if the ring is full.
+     *
+     * @param frame The Pac samples received in this frame.
+     */
+    void push(const BiotacPacFrame &frame);
+
+    /// Number of frames dropped because the ring was full.
+    unsigned int get_dropped_frames() const
+    {
+      return dropped_frames_.load(boost::memory_order_relaxed);
+    }
+
+  private:
+    /// Publishes the content of the ring every window_.
+    void publishing_loop();
+
+    /// Empties the ring into msg_ and publishes it if it's not empty.
+    void drain_and_publish();
+
+    unsigned int nb_tactiles_;
+    boost::posix_time::time_duration window_;
+    /// Time between the two Pac reads in the palm (half a cycle)
+    ros::Duration pac_sample_offset_;
+    boost::lockfree::spsc_queue<BiotacPacFrame> ring_;
+
+    /// only written from the realtime loop, read by the diagnostics
+    boost::atomic<unsigned int> dropped_frames_;
+
+    ros::Publisher publisher_;
+    sr_robot_lib::BiotacPacAll msg_;
+
+    boost::shared_ptr<boost::thread> publishing_thread_;
+  };
+}  // namespace tactiles
+
+/* For the emacs weenies in the crowd.
+Local Variables:
+   c-basic-offset: 2
+End:
+*/
+
+#endif /* _BIOTAC_PAC_BUFFER_HPP_ */
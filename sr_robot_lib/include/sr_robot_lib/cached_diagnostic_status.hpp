@@ -0,0 +1,120 @@
+/**
+ * @file   cached_diagnostic_status.hpp
+ * @author Shadow Robot Software Team <software@shadowrobot.com>
+ * @date   Sun Oct 18 16:40:12 2026
+ *
+ * Copyright 2026 Shadow Robot Company Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @brief A diagnostic status which is kept from one diagnostics call to the
+ *        next. The keys are added in the same order at each call, so they're
+ *        only created once, and the values are only reformatted when they
+ *        changed.
+ *
+ * Usage (same order of calls as with a DiagnosticStatusWrapper):
+ * \code
+ *   status.clear();
+ *   status.summary(diagnostic_msgs::DiagnosticStatus::OK, "OK");
+ *   status.add("Temperature", temperature);
+ *   status.finish();
+ *   vec.push_back(status.status);
+ * \endcode
+ *
+ */
+
+#ifndef _CACHED_DIAGNOSTIC_STATUS_HPP_
+#define _CACHED_DIAGNOSTIC_STATUS_HPP_
+
+#include <diagnostic_msgs/DiagnosticStatus.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace shadow_robot
+{
+  class CachedDiagnosticStatus
+  {
+  public:
+    CachedDiagnosticStatus();
+
+    /// The status published: its name and hardware_id are only set once by the user.
+    diagnostic_msgs::DiagnosticStatus status;
+
+    /// Starts a new update of the values.
+    void clear();
+
+    /// Sets the level and message, the message is only copied if it changed.
+    void summary(unsigned char level, const char *message);
+
+    void add(const char *key, int value);
+
+    void add(const char *key, double value);
+
+    void add(const char *key, uint64_t value);
+
+    void add(const char *key, const char *value);
+
+    void add(const char *key, const std::string &value);
+
+    /**
+     * Adds a value formatted from up to 3 integers (e.g. a date).
+     * The format must be a string literal: the pointer is used to
+     * detect a change of format.
+     */
+    void addf(const char *key, const char *format, int a, int b = 0, int c = 0);
+
+    /// Removes the values which were not added since clear().
+    void finish();
+
+  private:
+    enum FieldType
+    {
+      INVALID,
+      INT,
+      DOUBLE,
+      UINT64,
+      STRING,
+      FORMATTED
+    };
+
+    struct Field
+    {
+      FieldType type;
+      const char *format;
+      int64_t integers[3];
+      double real;
+    };
+
+    /**
+     * Moves the cursor to the next value and makes sure it has the given key.
+     *
+     * @return the cached field, whose type is INVALID if the value must be reformatted
+     */
+    Field &next_field(const char *key);
+
+    void format_value(const char *format, ...);
+
+    std::vector<Field> fields_;
+    size_t cursor_;
+  };
+}  // namespace shadow_robot
+
+/* For the emacs weenies in the crowd.
+Local Variables:
+   c-basic-offset: 2
+End:
+*/
+
+#endif /* _CACHED_DIAGNOSTIC_STATUS_HPP_ */
@@ -0,0 +1,141 @@
+/**
+ * @file   frame_monitor.hpp
+ * @author Shadow Robot Software Team <software@shadowrobot.com>
+ * @date   Sun Oct 18 15:12:47 2026
+ *
+ * Copyright 2026 Shadow Robot Company Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @brief Detects the lost and repeated frames, and the faults they lead to.
+ *
+ * The palm status has no frame counter: a frame is lost when the palm didn't
+ * write its mailbox (EDC_COMMAND_INVALID), and repeated when its status is
+ * identical to the previous valid one. When the motors alternate, the parity of
+ * the motors in the status changes at each frame, so two different frames are
+ * never identical. When the palm returns all the motors in every frame, no field
+ * is guaranteed to change: the repeated frames aren't detected in this mode,
+ * as a few identical frames in a row would be taken for a fault.
+ *
+ * The data of these frames must not be fed to the filters: the joint states
+ * are extrapolated (with their last velocity) for max_extrapolated_frames
+ * frames, then held. After max_lost_frames consecutive frames without new
+ * data, the monitor is in fault (the demands sent to the motors are nullified)
+ * until a new frame arrives.
+ *
+ * The filters compute their derivatives from the time of the samples: the
+ * monitor gives them the time of the frames in whole cycles, so that the jitter
+ * of the host doesn't show in the velocities and a frame which arrives after
+ * some missed ones is as far in time as it should be.
+ *
+ * Configured with the ~frame_monitor parameters.
+ *
+ */
+
+#ifndef _FRAME_MONITOR_HPP_
+#define _FRAME_MONITOR_HPP_
+
+#include <ros/ros.h>
+#include <boost/utility.hpp>
+
+namespace shadow_robot
+{
+  class FrameMonitor :
+          private boost::noncopyable
+  {
+  public:
+    enum FrameStatus
+    {
+      FRAME_OK,
+      FRAME_LOST,
+      FRAME_REPEATED
+    };
+
+    /**
+     * Reads the ~frame_monitor parameters.
+     *
+     * @param nh_tilde the private node handle of the driver
+     * @param cycle_period the period of the EtherCAT cycle (in seconds)
+     */
+    FrameMonitor(ros::NodeHandle nh_tilde, double cycle_period);
+
+    /**
+     * Called by the driver for each frame received, before decoding it.
+     *
+     * @param valid false if the palm didn't write its status (EDC_COMMAND_INVALID)
+     * @param status the status of this frame
+     * @param prev_status the status of the previous frame
+     * @param size the size of the status
+     * @param check_repeated false if the status has no field changing at each frame (an identical
+     *        status can then be a new one)
+     *
+     * @return FRAME_OK if the status is new and must be decoded
+     */
+    FrameStatus check_frame(bool valid, const unsigned char *status, const unsigned char *prev_status, size_t size,
+                            bool check_repeated = true);
+
+    /**
+     * The time of the frame being decoded, to be given to the filters.
+     *
+     * @param timestamp the time at which the frame is decoded (in seconds)
+     * @return the time of the frame, a whole number of cycles (at least one) after the previous one
+     */
+    double filter_time(double timestamp);
+
+    /// The number of frames without new data in a row
+    unsigned int missed_frames() const
+    {
+      return missed_frames_;
+    }
+
+    /// Should the joint states be extrapolated for the current missed frame? (held otherwise)
+    bool extrapolate() const
+    {
+      return missed_frames_ <= max_extrapolated_frames_;
+    }
+
+    /// Too many frames were missed in a row
+    bool fault() const
+    {
+      return max_lost_frames_ > 0 && missed_frames_ >= max_lost_frames_;
+    }
+
+    /// total number of frames lost
+    unsigned int lost_frames;
+    /// total number of frames repeated
+    unsigned int repeated_frames;
+    /// number of faults since the start
+    unsigned int faults;
+
+  private:
+    double cycle_period_;
+    unsigned int max_extrapolated_frames_;
+    unsigned int max_lost_frames_;
+
+    unsigned int missed_frames_;
+    /// the previous frame was valid, so a frame identical to it is a repeated one
+    bool prev_frame_valid_;
+
+    double last_timestamp_;
+    double filter_time_;
+  };
+}  // namespace shadow_robot
+
+/* For the emacs weenies in the crowd.
+Local Variables:
+   c-basic-offset: 2
+End:
+*/
+
+#endif /* _FRAME_MONITOR_HPP_ */
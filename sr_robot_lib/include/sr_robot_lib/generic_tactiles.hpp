@@ -35,6 +35,7 @@ extern "C"
 {
 #include <sr_external_dependencies/external/0220_palm_edc/0220_palm_edc_ethercat_protocol.h>
 #include <sr_external_dependencies/external/0230_palm_edc_TS/0230_palm_edc_ethercat_protocol.h>
+#include <sr_external_dependencies/external/0240_palm_edc_TS/0240_palm_edc_ethercat_protocol.h>
 #include <sr_external_dependencies/external/0320_palm_edc_muscle/0320_palm_edc_ethercat_protocol.h>
 }
 
@@ -49,6 +50,8 @@ extern "C"
 #include <sr_hardware_interface/tactile_sensors.hpp>
 #include "sr_robot_lib/generic_updater.hpp"
 #include "sr_robot_lib/sensor_updater.hpp"
+#include "sr_robot_lib/cached_diagnostic_status.hpp"
+#include "sr_robot_lib/hand_state_snapshot.hpp"
 
 namespace tactiles
 {
@@ -73,6 +76,38 @@ namespace tactiles
      */
     virtual void update(StatusType *status_data);
 
+    /**
+     * Sets the time of the frame decoded by the next update(), so that the samples
+     * are stamped with it rather than with the time at which they're decoded.
+     *
+     * @param stamp the time of the frame (in seconds)
+     */
+    void set_frame_stamp(double stamp)
+    {
+      frame_stamp_.fromSec(stamp);
+    }
+
+    /**
+     * Should update() be called for a status whose tactile data are the same as in the
+     * previous one? Decoding them again doesn't change the tactiles_vector, so no by default.
+     */
+    virtual bool update_when_unchanged() const
+    {
+      return false;
+    }
+
+    /**
+     * Builds the tactile part of the command once the sensors are initialized.
+     * By default the sensor_updater polls the important data in turn.
+     *
+     * @param command The command which will be sent to the palm.
+     * @return current update state
+     */
+    virtual operation_mode::device_update_state::DeviceUpdateState build_command(CommandType *command)
+    {
+      return sensor_updater->build_command(command);
+    }
+
     /**
      * Publish the information to a ROS topic.
      *
@@ -82,9 +117,13 @@ namespace tactiles
     /**
      * This function adds the diagnostics for the tactiles to the
      * multi diagnostic status published by the hand.
+     *
+     * @param snapshot the state of the hand (SrRobotLib::get_state_snapshot()), the tactiles
+     *        are read from it and not from the tactiles_vector written by the realtime loop
      */
     virtual void add_diagnostics(std::vector<diagnostic_msgs::DiagnosticStatus> &vec,
-                                 diagnostic_updater::DiagnosticStatusWrapper &d);
+                                 diagnostic_updater::DiagnosticStatusWrapper &d,
+                                 const shadow_robot::HandStateSnapshot &snapshot);
 
     /**
      * Reset the tactile sensors.
@@ -106,12 +145,26 @@ namespace tactiles
 
     virtual std::vector<AllTactileData> *get_tactile_data();
 
+    /**
+     * Were the identification strings (manufacturer, serial number, versions) of
+     * a sensor changed since the last call? Only called from the realtime loop.
+     */
+    bool take_ids_changed()
+    {
+      bool changed = ids_changed_;
+      ids_changed_ = false;
+      return changed;
+    }
+
   protected:
     void process_received_data_type(int32u data);
 
     ros::NodeHandle nodehandle_;
     std::string device_id_;
 
+    /// The time of the frame being decoded, see set_frame_stamp()
+    ros::Time frame_stamp_;
+
     ros::ServiceServer reset_service_client_;
 
     // Contains the received data types.
@@ -129,7 +182,46 @@ namespace tactiles
      */
     std::string sanitise_string(const char *raw_string, const unsigned int str_size);
 
+    /**
+     * Sets an identification string of a sensor, flagging the identification
+     * as changed if it's not the one already stored.
+     *
+     * @param id The string stored in the tactile data.
+     * @param raw_string The incoming raw string
+     * @param str_size The max size of the string
+     */
+    void update_id_string(std::string &id, const char *raw_string, const unsigned int str_size);
+
+    /**
+     * Sets the software version of a sensor if the raw string received changed
+     * (it's compared raw: formatting the version allocates).
+     *
+     * @param data The tactile data of the sensor.
+     * @param id_sensor The index of the sensor.
+     * @param raw_string The incoming raw string
+     * @param str_size The max size of the string
+     */
+    void update_software_version(GenericTactileData &data, unsigned int id_sensor, const char *raw_string,
+                                 const unsigned int str_size);
+
+    /// Set by update_id_string() and update_software_version(), see take_ids_changed()
+    bool ids_changed_;
+    /// The last raw software version received from each sensor
+    std::vector<std::string> raw_software_versions_;
+
     boost::shared_ptr<std::vector<AllTactileData> > all_tactile_data;
+
+    /**
+     * Returns the diagnostics of a tactile sensor, kept from one diagnostics call
+     * to the next so that only the values which changed are reformatted.
+     *
+     * @param id_tact The index of the sensor.
+     *
+     * @return the cached diagnostics, named after the sensor.
+     */
+    shadow_robot::CachedDiagnosticStatus &get_tactile_diagnostics(unsigned int id_tact);
+
+    std::vector<shadow_robot::CachedDiagnosticStatus> tactile_diagnostics_;
   };  // end class
 }  // namespace tactiles
 
@@ -41,6 +41,7 @@ extern "C"
 {
 #include <sr_external_dependencies/external/0220_palm_edc/0220_palm_edc_ethercat_protocol.h>
 #include <sr_external_dependencies/external/0230_palm_edc_TS/0230_palm_edc_ethercat_protocol.h>
+#include <sr_external_dependencies/external/0240_palm_edc_TS/0240_palm_edc_ethercat_protocol.h>
 #include <sr_external_dependencies/external/0320_palm_edc_muscle/0320_palm_edc_ethercat_protocol.h>
 }
 
@@ -104,6 +105,15 @@ namespace generic_updater
      */
     void timer_callback(const ros::TimerEvent &event, int32u data_type);
 
+    /**
+     * Slows down the refresh of the unimportant data: their rates from the config
+     * are divided by the given divider (1 to go back to the configured rates).
+     * Not called from the realtime loop.
+     *
+     * @param divider How many times slower the unimportant data are refreshed.
+     */
+    void set_unimportant_rate_divider(unsigned int divider);
+
     operation_mode::device_update_state::DeviceUpdateState update_state;
     // Contains all the initialization data types.
     std::vector<UpdateConfig> initialization_configs_vector;
@@ -123,6 +133,8 @@ namespace generic_updater
     std::queue<int32u, std::list<int32u> > unimportant_data_queue;
     // Contains the vector with the update configs for every command. We store it to be able to reinitialize.
     std::vector<UpdateConfig> update_configs_vector;
+    // The current divider of the unimportant data rates.
+    unsigned int unimportant_rate_divider;
 
     boost::shared_ptr<boost::mutex> mutex;
   };
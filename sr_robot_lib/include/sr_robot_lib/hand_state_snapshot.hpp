@@ -0,0 +1,166 @@
+/**
+ * @file   hand_state_snapshot.hpp
+ * @author Shadow Robot Software Team <software@shadowrobot.com>
+ * @date   Sun Oct 18 14:02:37 2026
+ *
+ * Copyright 2026 Shadow Robot Company Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @brief The state of a hand, as committed by the realtime loop at the end
+ *        of each cycle. Only fixed size fields so that it can be copied
+ *        from the SeqLock by the non realtime threads.
+ *
+ *
+ */
+
+#ifndef _HAND_STATE_SNAPSHOT_HPP_
+#define _HAND_STATE_SNAPSHOT_HPP_
+
+#include <stdint.h>
+
+namespace shadow_robot
+{
+  struct MotorStateSnapshot
+  {
+    bool actuator_ok;
+    bool bad_data;
+    int motor_id;
+    int msg_motor_id;
+
+    /// the raw flags received from the motor (use humanize_flags to read them)
+    int flags;
+
+    int serial_number;
+    int assembly_data_day;
+    int assembly_data_month;
+    int assembly_data_year;
+    int strain_gauge_left;
+    int strain_gauge_right;
+    int pwm;
+    double current;
+    double voltage;
+    double temperature;
+    double position_unfiltered;
+    double force_unfiltered;
+    int gear_ratio;
+    uint64_t can_msgs_received;
+    uint64_t can_msgs_transmitted;
+
+    int force_control_pterm;
+    int force_control_iterm;
+    int force_control_dterm;
+    int force_control_f;
+    int force_control_p;
+    int force_control_i;
+    int force_control_d;
+    int force_control_imax;
+    int force_control_deadband;
+    int force_control_frequency;
+    int force_control_sign;
+
+    int server_firmware_svn_revision;
+    int pic_firmware_svn_revision;
+    bool firmware_modified;
+  };
+
+  struct JointStateSnapshot
+  {
+    bool has_actuator;
+    double position;
+    double velocity;
+    double effort;
+    double commanded_effort;
+
+    /// only valid if has_actuator is true and the hand has motors
+    MotorStateSnapshot motor;
+  };
+
+  struct TactileStateSnapshot
+  {
+    enum TactileType
+    {
+      NONE,
+      PST,
+      BIOTAC,
+      UBI
+    };
+
+    static const unsigned int max_electrodes = 24;
+    static const unsigned int nb_distal = 12;
+    static const unsigned int nb_mid_prox = 4;
+    /// the identification strings are truncated to this length (with the terminating null)
+    static const unsigned int max_string_length = 64;
+
+    TactileType type;
+    int sample_frequency;
+
+    /// only copied when they change (formatting the software version allocates)
+    char manufacturer[max_string_length];
+    char serial_number[max_string_length];
+    char software_version[max_string_length];
+    char pcb_version[max_string_length];
+
+    int pst_pressure;
+    int pst_temperature;
+    int pst_pressure_raw;
+    int pst_zero_tracking;
+    int pst_dac_value;
+
+    int biotac_pac0;
+    int biotac_pac1;
+    int biotac_pdc;
+    int biotac_tac;
+    int biotac_tdc;
+    unsigned int biotac_nb_electrodes;
+    int biotac_electrodes[max_electrodes];
+
+    int ubi_distal[nb_distal];
+    int ubi_middle[nb_mid_prox];
+    int ubi_proximal[nb_mid_prox];
+  };
+
+  struct HandStateSnapshot
+  {
+    static const unsigned int max_joints = 32;
+    static const unsigned int max_tactiles = 5;
+
+    /// time at which the realtime loop committed this state (in seconds)
+    double stamp;
+
+    int main_pic_idle_time;
+    int main_pic_idle_time_min;
+
+    /// see the FrameMonitor
+    unsigned int lost_frames;
+    unsigned int repeated_frames;
+    unsigned int frame_faults;
+    bool frame_fault;
+
+    /// in the same order as the joints_vector of the hand library
+    unsigned int nb_joints;
+    JointStateSnapshot joints[max_joints];
+
+    unsigned int nb_tactiles;
+    TactileStateSnapshot tactiles[max_tactiles];
+  };
+}  // namespace shadow_robot
+
+/* For the emacs weenies in the crowd.
+Local Variables:
+   c-basic-offset: 2
+End:
+*/
+
+#endif /* _HAND_STATE_SNAPSHOT_HPP_ */
@@ -0,0 +1,159 @@
+/**
+ * @file   joint_state_estimator.hpp
+ * @author Shadow Robot Software Team <software@shadowrobot.com>
+ * @date   Sun Oct 18 17:26:03 2026
+ *
+ * Copyright 2026 Shadow Robot Company Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @brief Estimates the joint states ahead of the transport delay.
+ *
+ * The positions are estimated by a constant acceleration Kalman filter, the
+ * efforts by a constant rate one. The position of every joint is measured at
+ * each frame with the same noise: their covariance and gains are the same, and
+ * are computed once per frame for all the joints. The effort of a motor is only
+ * measured in the frames which carry its data (every other frame when the motors
+ * alternate): each joint has its own effort covariance, the efforts are
+ * predicted through the frames without data.
+ *
+ * The states are stored joint by joint in arrays, allocated once, so that the
+ * filters run over all the joints in simple loops the compiler vectorizes.
+ *
+ * The estimates are extrapolated to the time the controllers use them, delay
+ * seconds after the frame was sampled (one cycle by default), rather than
+ * lagging behind like the low pass filters.
+ *
+ * Configured with the ~joint_estimator parameters, disabled by default.
+ *
+ */
+
+#ifndef _JOINT_STATE_ESTIMATOR_HPP_
+#define _JOINT_STATE_ESTIMATOR_HPP_
+
+#include <ros/ros.h>
+#include <boost/utility.hpp>
+#include <vector>
+
+namespace shadow_robot
+{
+  class JointStateEstimator :
+          private boost::noncopyable
+  {
+  public:
+    /**
+     * Reads the ~joint_estimator parameters.
+     *
+     * @param nh_tilde the private node handle of the driver
+     * @param cycle_period the period of the EtherCAT cycle (in seconds)
+     */
+    JointStateEstimator(ros::NodeHandle nh_tilde, double cycle_period);
+
+    bool enabled() const
+    {
+      return enabled_;
+    }
+
+    /**
+     * Allocates the states of the joints. Not called from the realtime loop.
+     *
+     * @param nb_joints the number of joints (the joints are indexed as in the joints_vector)
+     */
+    void resize(unsigned int nb_joints);
+
+    /// The calibrated (unfiltered) position of a joint, measured in this frame
+    void set_position(unsigned int joint, double position)
+    {
+      measured_positions_[joint] = position;
+    }
+
+    /// The (unfiltered) effort of a joint, when its motor data are in this frame
+    void set_effort(unsigned int joint, double effort)
+    {
+      measured_efforts_[joint] = effort;
+      effort_measured_[joint] = 1.0;
+    }
+
+    /**
+     * Runs the filters of all the joints for a frame, once its measurements are set.
+     *
+     * @param time the time of the frame (in seconds, see FrameMonitor::filter_time())
+     */
+    void update(double time);
+
+    /// The position of a joint, delay after the last frame
+    double position(unsigned int joint) const
+    {
+      return positions_[joint] + delay_ * (velocities_[joint] + 0.5 * delay_ * accelerations_[joint]);
+    }
+
+    /// The velocity of a joint, delay after the last frame
+    double velocity(unsigned int joint) const
+    {
+      return velocities_[joint] + delay_ * accelerations_[joint];
+    }
+
+    /// The effort of a joint, delay after the last frame
+    double effort(unsigned int joint) const
+    {
+      return efforts_[joint] + delay_ * effort_rates_[joint];
+    }
+
+  private:
+    /// Initializes the states from the first positions measured
+    void initialize();
+
+    bool enabled_;
+    /// how far ahead of the frame the estimates are (in seconds)
+    double delay_;
+    /// variance of the position measurements
+    double position_variance_;
+    /// spectral density of the jerk (the process noise of the positions)
+    double jerk_density_;
+    /// variance of the effort measurements
+    double effort_variance_;
+    /// spectral density of the effort acceleration (the process noise of the efforts)
+    double effort_acceleration_density_;
+
+    bool initialized_;
+    double last_time_;
+
+    /// the measurements of the frame
+    std::vector<double> measured_positions_;
+    std::vector<double> measured_efforts_;
+    /// 1.0 if the effort of the joint was measured in the frame, 0.0 otherwise
+    std::vector<double> effort_measured_;
+
+    /// the state of the positions, and their covariance (the same for all the joints)
+    std::vector<double> positions_;
+    std::vector<double> velocities_;
+    std::vector<double> accelerations_;
+    double p_pp_, p_pv_, p_pa_, p_vv_, p_va_, p_aa_;
+
+    /// the state of the efforts, and their covariances
+    std::vector<double> efforts_;
+    std::vector<double> effort_rates_;
+    std::vector<double> p_ff_;
+    std::vector<double> p_fr_;
+    std::vector<double> p_rr_;
+  };
+}  // namespace shadow_robot
+
+/* For the emacs weenies in the crowd.
+Local Variables:
+   c-basic-offset: 2
+End:
+*/
+
+#endif /* _JOINT_STATE_ESTIMATOR_HPP_ */
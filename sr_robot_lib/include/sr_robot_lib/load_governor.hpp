@@ -0,0 +1,132 @@
+/**
+ * @file   load_governor.hpp
+ * @author Shadow Robot Software Team <software@shadowrobot.com>
+ * @date   Sun Oct 18 23:41:12 2026
+ *
+ * Copyright 2026 Shadow Robot Company Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @brief Sheds the telemetry load when the palm or the host run out of time.
+ *
+ * The governor averages the idle time of the palm and the time the host
+ * spends processing each cycle over windows of cycles. When a window is
+ * overloaded (idle time under idle_time_low_us or processing time over
+ * processing_time_high_us), the next stage in the shedding_order is shed:
+ * its rates are divided by rate_divider. A stage is restored once the load
+ * stayed under the high-water marks (idle_time_high_us and
+ * processing_time_low_us) for recovery_windows windows in a row.
+ *
+ * The stages are the publishing of the tactiles and analog inputs, and the
+ * polling of the unimportant tactile and motor data: the important data,
+ * and so the control, are never slowed down.
+ *
+ * Configured with the ~load_governor parameters, disabled by default.
+ *
+ */
+
+#ifndef _LOAD_GOVERNOR_HPP_
+#define _LOAD_GOVERNOR_HPP_
+
+#include <ros/ros.h>
+#include <boost/atomic.hpp>
+#include <boost/utility.hpp>
+#include <vector>
+
+namespace shadow_robot
+{
+  class LoadGovernor :
+          private boost::noncopyable
+  {
+  public:
+    enum Stage
+    {
+      PUBLISHING,
+      TACTILE_DATA,
+      MOTOR_DATA,
+      NB_STAGES
+    };
+
+    /**
+     * Reads the ~load_governor parameters.
+     *
+     * @param nh_tilde the private node handle of the driver
+     */
+    explicit LoadGovernor(ros::NodeHandle nh_tilde);
+
+    bool enabled() const
+    {
+      return enabled_;
+    }
+
+    /// Marks the start of some host processing of the cycle (packCommand, unpackState...)
+    void start_processing();
+
+    /// Marks the end of the processing, its time is added to the processing time of the cycle
+    void end_processing();
+
+    /**
+     * Called once per cycle from the realtime loop, after the processing of the cycle.
+     *
+     * @param palm_idle_time_us the idle time reported by the palm
+     */
+    void sample(int palm_idle_time_us);
+
+    /**
+     * How many times slower the rates of a stage must be. Can be called from any thread.
+     *
+     * @return rate_divider if the stage is shed, 1 otherwise
+     */
+    unsigned int divider(Stage stage) const
+    {
+      return (shed_stages_.load(boost::memory_order_relaxed) & (1 << stage)) ? rate_divider_ : 1;
+    }
+
+  private:
+    static double monotonic_us();
+
+    /// Sheds or restores a stage at the end of a window
+    void end_window(double idle_time_us, double processing_time_us);
+
+    bool enabled_;
+    double idle_time_low_us_;
+    double idle_time_high_us_;
+    double processing_time_high_us_;
+    double processing_time_low_us_;
+    unsigned int window_cycles_;
+    unsigned int recovery_windows_;
+    unsigned int rate_divider_;
+    std::vector<Stage> shedding_order_;
+
+    /// the stages shed (bit mask), read by the threads applying the rates
+    boost::atomic<int> shed_stages_;
+
+    /// only used from the realtime loop
+    unsigned int nb_shed_stages_;
+    double processing_start_us_;
+    double cycle_processing_time_us_;
+    unsigned int window_cycle_;
+    double window_idle_time_us_;
+    double window_processing_time_us_;
+    unsigned int headroom_windows_;
+  };
+}  // namespace shadow_robot
+
+/* For the emacs weenies in the crowd.
+Local Variables:
+   c-basic-offset: 2
+End:
+*/
+
+#endif /* _LOAD_GOVERNOR_HPP_ */
@@ -0,0 +1,143 @@
+/**
+ * @file   motor_data_capture.hpp
+ * @author Shadow Robot Software Team <software@shadowrobot.com>
+ * @date   Sun Oct 18 23:04:37 2026
+ *
+ * Copyright 2026 Shadow Robot Company Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @brief Records the motor data received during a capture window.
+ *
+ * A capture is started for some motors and data types (the MotorUpdater then
+ * polls these data in one frame out of two). The realtime loop records every
+ * sample of these data with its cycle timestamp in a buffer preallocated when
+ * the capture starts, and closes the window once the duration is over. The
+ * samples are then published in one message, out of the realtime loop.
+ *
+ */
+
+#ifndef _MOTOR_DATA_CAPTURE_HPP_
+#define _MOTOR_DATA_CAPTURE_HPP_
+
+#include <ros/ros.h>
+#include <boost/atomic.hpp>
+#include <boost/utility.hpp>
+#include <vector>
+#include <sr_external_dependencies/types_for_external.h>
+#include <sr_robot_lib/MotorDataSamples.h>
+
+namespace shadow_robot
+{
+  class MotorDataCapture :
+          private boost::noncopyable
+  {
+  public:
+    /// The longest capture (in seconds)
+    static const double max_duration;
+
+    /**
+     * @param nh The node handle used to advertise the motor_data_capture topic.
+     * @param cycle_period The period of the EtherCAT cycle (in seconds): the buffer holds
+     *                     a sample of each motor captured at each cycle.
+     */
+    MotorDataCapture(ros::NodeHandle nh, double cycle_period);
+
+    /**
+     * Allocates the buffer and starts a capture. Not called from the realtime loop.
+     *
+     * @param motors bit N set to capture the data of the motor N
+     * @param data_types the FROM_MOTOR_DATA_TYPEs to capture
+     * @param duration the duration of the capture, from its first cycle (in seconds)
+     *
+     * @return false if a capture is already running
+     */
+    bool start(int32u motors, const std::vector<int32u> &data_types, double duration);
+
+    /**
+     * Called from the realtime loop at each cycle, before the samples are recorded:
+     * opens the capture window at the first cycle and closes it after the duration.
+     *
+     * @param stamp the timestamp of the cycle
+     */
+    void new_cycle(double stamp);
+
+    /**
+     * Called from the realtime loop for each motor data received, keeps the ones being
+     * captured. Never blocks nor allocates: the sample is dropped if the buffer is full.
+     */
+    void record(double stamp, int motor_id, int32u data_type, int16s torque, int16u value)
+    {
+      if (state_.load(boost::memory_order_acquire) == CAPTURING &&
+          (motors_ & (1 << motor_id)) && data_type < 32 && (data_types_ & (1 << data_type)))
+      {
+        push(stamp, motor_id, data_type, torque, value);
+      }
+    }
+
+    /// Is the capture window over? (the samples can then be published)
+    bool finished() const
+    {
+      return state_.load(boost::memory_order_acquire) == FINISHED;
+    }
+
+    /// Publishes the samples of a finished capture, a new capture can then be started.
+    void publish();
+
+  private:
+    enum State
+    {
+      IDLE,
+      CAPTURING,
+      FINISHED
+    };
+
+    struct Sample
+    {
+      double stamp;
+      int8u motor_id;
+      int8u data_type;
+      int16s torque;
+      int16u value;
+    };
+
+    void push(double stamp, int motor_id, int32u data_type, int16s torque, int16u value);
+
+    boost::atomic<int> state_;
+
+    double cycle_period_;
+
+    /// set by start(), before the capture is started
+    int32u motors_;
+    int32u data_types_;
+    double duration_;
+
+    /// only used by the realtime loop while capturing
+    std::vector<Sample> samples_;
+    size_t nb_samples_;
+    unsigned int dropped_samples_;
+    double end_stamp_;
+
+    ros::Publisher publisher_;
+    sr_robot_lib::MotorDataSamples msg_;
+  };
+}  // namespace shadow_robot
+
+/* For the emacs weenies in the crowd.
+Local Variables:
+   c-basic-offset: 2
+End:
+*/
+
+#endif /* _MOTOR_DATA_CAPTURE_HPP_ */
@@ -33,6 +33,7 @@
 #include <vector>
 #include <list>
 #include <queue>
+#include <utility>
 #include <boost/thread.hpp>
 #include <boost/smart_ptr.hpp>
 #include "sr_robot_lib/generic_updater.hpp"
@@ -83,9 +84,49 @@ namespace generic_updater
      */
     operation_mode::device_update_state::DeviceUpdateState build_command(CommandType *command);
 
+    /**
+     * Sends the presence of the motors with which_motors (see WHICH_MOTORS_PRESENCE_VALID), so
+     * that the palm doesn't wait for the data of the missing motors. Only for the palm firmwares
+     * supporting it: the older ones expect which_motors to be 0 or 1.
+     *
+     * @param motors_present bit N set if the motor N is present
+     */
+    void set_motors_present(int32u motors_present);
+
+    /**
+     * Asks the palm for the data of all the motors in every frame (see WHICH_MOTORS_ALL), instead
+     * of the even and odd motors in turn. Only for the palms returning the data of all the motors (0240).
+     *
+     * @param all_motors true to ask for all the motors in every frame
+     */
+    void set_all_motors(bool all_motors);
+
+    /**
+     * Dedicates one frame out of two to the given data of the given motors, until stop_capture().
+     * The other frames follow the normal schedule.
+     *
+     * @param motors bit N set for the motor N
+     * @param data_types the FROM_MOTOR_DATA_TYPEs to poll
+     */
+    void start_capture(int32u motors, const std::vector<int32u> &data_types);
+
+    /// Goes back to the normal schedule in every frame.
+    void stop_capture();
+
   private:
     // are we sending the command to the even or the uneven motors.
     int even_motors;
+
+    // the presence bits added to which_motors for the even and the odd motors (0 if not sent)
+    int16s motors_present_[2];
+
+    // WHICH_MOTORS_ALL if all the motors are asked for their data in every frame, 0 otherwise
+    int16s all_motors_;
+
+    // the (even_motors, data type) polled in turn in the capture frames
+    std::vector<std::pair<int, int32u> > capture_slots_;
+    unsigned int next_capture_slot_;
+    bool capture_frame_;
   };
 }  // namespace generic_updater
 
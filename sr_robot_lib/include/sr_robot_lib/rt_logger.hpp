@@ -0,0 +1,238 @@
+/**
+ * @file   rt_logger.hpp
+ * @author Shadow Robot Software Team <software@shadowrobot.com>
+ * @date   Sun Oct 18 18:05:44 2026
+ *
+ * Copyright 2026 Shadow Robot Company Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @brief Logging from the realtime loop.
+ *
+ * The realtime loop only pushes the format string pointer and the binary
+ * arguments to a preallocated lock-free ring. A background thread formats
+ * them and forwards them to rosconsole. Each call site is rate limited (once
+ * per second by default) and the number of messages suppressed in between is
+ * appended to the next message printed. The debug messages aren't rate
+ * limited, so that they show every step of a sequence, but they're only pushed
+ * while the debug level is enabled.
+ *
+ * \code
+ *   SR_RT_LOG_WARN("Motor id not found: %d", motor_id);
+ *   SR_RT_LOG_THROTTLE(ros::console::levels::Debug, 0.1, "received: %u", data_type);
+ * \endcode
+ *
+ * The format must be a string literal, with at most 8 arguments (integers,
+ * doubles or strings). A string argument is not copied: it must still be
+ * valid when the message is printed (literal or owned by the hand library).
+ *
+ */
+
+#ifndef _RT_LOGGER_HPP_
+#define _RT_LOGGER_HPP_
+
+#include <ros/console.h>
+#include <boost/atomic.hpp>
+#include <boost/thread.hpp>
+#include <boost/smart_ptr.hpp>
+#include <boost/utility.hpp>
+#include <boost/lockfree/queue.hpp>
+#include <stdint.h>
+
+/// Logs from the realtime loop, at most once every period seconds for this call site.
+#define SR_RT_LOG_THROTTLE(level, period, ...) \
+  do \
+  { \
+    static shadow_robot::RtLogSite sr_rt_log_site = {level, period, -1.0, 0}; \
+    shadow_robot::RtLogger::instance().log(sr_rt_log_site, __VA_ARGS__); \
+  } while (0)
+
+#define SR_RT_LOG_DEBUG(...) SR_RT_LOG_THROTTLE(::ros::console::levels::Debug, 0.0, __VA_ARGS__)
+#define SR_RT_LOG_INFO(...) SR_RT_LOG_THROTTLE(::ros::console::levels::Info, 1.0, __VA_ARGS__)
+#define SR_RT_LOG_WARN(...) SR_RT_LOG_THROTTLE(::ros::console::levels::Warn, 1.0, __VA_ARGS__)
+#define SR_RT_LOG_ERROR(...) SR_RT_LOG_THROTTLE(::ros::console::levels::Error, 1.0, __VA_ARGS__)
+
+namespace shadow_robot
+{
+  /**
+   * A logging call site. Statically initialised by the SR_RT_LOG macros, so
+   * there's no initialisation guard on the realtime path. Only the thread
+   * running the call site modifies it.
+   */
+  struct RtLogSite
+  {
+    ros::console::levels::Level level;
+    /// minimum time between two messages (in seconds)
+    double period;
+    /// last time a message was pushed (monotonic clock, in seconds)
+    double last_logged;
+    /// messages dropped by the rate limit since the last one pushed
+    unsigned int suppressed;
+  };
+
+  /// An argument of a message, stored in binary form until it's formatted.
+  struct RtLogValue
+  {
+    enum Type
+    {
+      NONE,
+      SIGNED,
+      UNSIGNED,
+      REAL,
+      STRING
+    };
+
+    Type type;
+    union
+    {
+      int64_t i;
+      uint64_t u;
+      double d;
+      const char *s;
+    };
+  };
+
+  /// Converts the arguments given to the SR_RT_LOG macros.
+  struct RtLogArg
+  {
+    RtLogArg()
+    {
+      value.type = RtLogValue::NONE;
+      value.s = 0;
+    }
+
+    RtLogArg(int v)
+    {
+      value.type = RtLogValue::SIGNED;
+      value.i = v;
+    }
+
+    RtLogArg(long v)
+    {
+      value.type = RtLogValue::SIGNED;
+      value.i = v;
+    }
+
+    RtLogArg(long long v)
+    {
+      value.type = RtLogValue::SIGNED;
+      value.i = v;
+    }
+
+    RtLogArg(unsigned int v)
+    {
+      value.type = RtLogValue::UNSIGNED;
+      value.u = v;
+    }
+
+    RtLogArg(unsigned long v)
+    {
+      value.type = RtLogValue::UNSIGNED;
+      value.u = v;
+    }
+
+    RtLogArg(unsigned long long v)
+    {
+      value.type = RtLogValue::UNSIGNED;
+      value.u = v;
+    }
+
+    RtLogArg(double v)
+    {
+      value.type = RtLogValue::REAL;
+      value.d = v;
+    }
+
+    RtLogArg(const char *v)
+    {
+      value.type = RtLogValue::STRING;
+      value.s = v;
+    }
+
+    RtLogValue value;
+  };
+
+  /// What the realtime loop pushes to the ring.
+  struct RtLogEntry
+  {
+    static const unsigned int max_args = 8;
+
+    ros::console::levels::Level level;
+    /// the format is used as the message id: it's a string literal
+    const char *format;
+    unsigned int suppressed;
+    RtLogValue args[max_args];
+  };
+
+  class RtLogger :
+          private boost::noncopyable
+  {
+  public:
+    /**
+     * The logger shared by all the hands. Call it once outside of the realtime
+     * loop (the hand libraries do it in their constructor) so that the ring
+     * and the thread aren't created from the realtime loop.
+     */
+    static RtLogger &instance();
+
+    ~RtLogger();
+
+    /**
+     * Pushes a message to the ring unless the site is rate limited. Never
+     * blocks nor allocates: the message is dropped if the ring is full.
+     */
+    void log(RtLogSite &site, const char *format,
+             RtLogArg a0 = RtLogArg(), RtLogArg a1 = RtLogArg(), RtLogArg a2 = RtLogArg(), RtLogArg a3 = RtLogArg(),
+             RtLogArg a4 = RtLogArg(), RtLogArg a5 = RtLogArg(), RtLogArg a6 = RtLogArg(), RtLogArg a7 = RtLogArg());
+
+    /// Number of messages dropped because the ring was full.
+    unsigned int get_dropped_messages() const
+    {
+      return dropped_messages_.load(boost::memory_order_relaxed);
+    }
+
+    /// Formats an entry (used by the draining thread).
+    static void format(const RtLogEntry &entry, char *buffer, size_t size);
+
+  private:
+    RtLogger();
+
+    /// Forwards the content of the ring to rosconsole every drain_period_.
+    void draining_loop();
+
+    void drain();
+
+    /// Reads the level of the rt logger from rosconsole (not from the realtime loop)
+    void update_debug_enabled();
+
+    static const unsigned int ring_size = 256;
+    static const boost::posix_time::time_duration drain_period_;
+
+    boost::lockfree::queue<RtLogEntry, boost::lockfree::capacity<ring_size> > ring_;
+    boost::atomic<unsigned int> dropped_messages_;
+    /// the debug messages are dropped straight away when the debug level isn't enabled
+    boost::atomic<bool> debug_enabled_;
+    unsigned int reported_dropped_messages_;
+
+    boost::shared_ptr<boost::thread> draining_thread_;
+  };
+}  // namespace shadow_robot
+
+/* For the emacs weenies in the crowd.
+Local Variables:
+   c-basic-offset: 2
+End:
+*/
+
+#endif /* _RT_LOGGER_HPP_ */
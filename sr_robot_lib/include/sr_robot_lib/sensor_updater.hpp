@@ -83,6 +83,15 @@ namespace generic_updater
      */
     operation_mode::device_update_state::DeviceUpdateState build_command(CommandType *command);
 
+    /**
+     * For the tactiles choosing the important data themselves: gets the unimportant data
+     * waiting to be sent, if any. They have priority over the important data.
+     *
+     * @param data The unimportant data type to send.
+     * @return true if an unimportant data was waiting.
+     */
+    bool pop_unimportant_data(int32u *data);
+
     /**
      * Will send the reset command to the tactiles, on next build
      * command call.
@@ -0,0 +1,138 @@
+/**
+ * @file   seqlock.hpp
+ * @author Shadow Robot Software Team <software@shadowrobot.com>
+ * @date   Sun Oct 18 14:02:37 2026
+ *
+ * Copyright 2026 Shadow Robot Company Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @brief A single writer / multiple readers sequence lock.
+ *
+ * The writer (the realtime loop) never waits: it makes the sequence odd,
+ * updates the value in place and makes the sequence even again. The readers
+ * copy the value and retry if the sequence changed during the copy. The
+ * value is copied with a plain assignment while it may be written, so it
+ * must be a POD type (no pointer, vector or string).
+ *
+ */
+
+#ifndef _SEQLOCK_HPP_
+#define _SEQLOCK_HPP_
+
+#include <boost/atomic.hpp>
+#include <boost/thread.hpp>
+#include <boost/utility.hpp>
+
+namespace shadow_robot
+{
+  template<class T>
+  class SeqLock :
+          private boost::noncopyable
+  {
+  public:
+    SeqLock()
+            : sequence_(0), value_()
+    {
+    }
+
+    /**
+     * Starts writing: the returned reference can be modified
+     * in place until end_write() is called. Only one thread
+     * can write.
+     *
+     * @return the value to update
+     */
+    T &begin_write()
+    {
+      sequence_.store(sequence_.load(boost::memory_order_relaxed) + 1, boost::memory_order_relaxed);
+      boost::atomic_thread_fence(boost::memory_order_release);
+      return value_;
+    }
+
+    /// Publishes the value modified since begin_write().
+    void end_write()
+    {
+      sequence_.store(sequence_.load(boost::memory_order_relaxed) + 1, boost::memory_order_release);
+    }
+
+    /**
+     * Tries to copy a consistent value, without waiting.
+     *
+     * @param value where the value is copied
+     *
+     * @return false if the value was being written (value may then be torn)
+     */
+    bool try_read(T &value) const
+    {
+      unsigned int before = sequence_.load(boost::memory_order_acquire);
+      if (before & 1)
+      {
+        return false;
+      }
+      value = value_;
+      boost::atomic_thread_fence(boost::memory_order_acquire);
+      return before == sequence_.load(boost::memory_order_relaxed);
+    }
+
+    /**
+     * Copies a consistent value, retrying until the writer is not
+     * modifying it. Never blocks the writer.
+     *
+     * @param value where the value is copied
+     *
+     * @return the version of the value: the number of writes completed
+     */
+    unsigned int read(T &value) const
+    {
+      unsigned int attempts = 0;
+      while (true)
+      {
+        unsigned int before = sequence_.load(boost::memory_order_acquire);
+        if (!(before & 1))
+        {
+          value = value_;
+          boost::atomic_thread_fence(boost::memory_order_acquire);
+          if (before == sequence_.load(boost::memory_order_relaxed))
+          {
+            return before / 2;
+          }
+        }
+        // the writer is only a few microseconds long, let it finish
+        if (++attempts % 16 == 0)
+        {
+          boost::this_thread::yield();
+        }
+      }
+    }
+
+    /// The number of writes completed.
+    unsigned int version() const
+    {
+      return sequence_.load(boost::memory_order_acquire) / 2;
+    }
+
+  private:
+    boost::atomic<unsigned int> sequence_;
+    T value_;
+  };
+}  // namespace shadow_robot
+
+/* For the emacs weenies in the crowd.
+Local Variables:
+   c-basic-offset: 2
+End:
+*/
+
+#endif /* _SEQLOCK_HPP_ */
@@ -74,9 +74,13 @@ namespace tactiles
     /**
      * This function adds the diagnostics for the tactiles to the
      * multi diagnostic status published by the hand.
+     *
+     * @param snapshot the state of the hand (SrRobotLib::get_state_snapshot()), the tactiles
+     *        are read from it and not from the tactiles_vector written by the realtime loop
      */
     virtual void add_diagnostics(std::vector<diagnostic_msgs::DiagnosticStatus> &vec,
-                                 diagnostic_updater::DiagnosticStatusWrapper &d);
+                                 diagnostic_updater::DiagnosticStatusWrapper &d,
+                                 const shadow_robot::HandStateSnapshot &snapshot);
 
     /// the vector containing the data for the tactiles.
     boost::shared_ptr<std::vector<PST3Data> > tactiles_vector;
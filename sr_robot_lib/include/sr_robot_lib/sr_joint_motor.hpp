@@ -89,7 +89,8 @@ namespace shadow_joints
   public:
     MotorWrapper()
             : motor_id(0),
-              msg_motor_id(0)
+              msg_motor_id(0),
+              flags(0)
     {
     }
 
@@ -100,6 +101,9 @@ namespace shadow_joints
     // the position of the motor in the message array
     int msg_motor_id;
 
+    // the raw flags last received from the motor
+    int flags;
+
     /**
      * A service used to set the force PID settings on the
      * motor.
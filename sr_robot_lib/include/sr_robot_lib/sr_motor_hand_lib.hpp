@@ -30,13 +30,15 @@
 
 #include "sr_robot_lib/sr_motor_robot_lib.hpp"
 #include <std_srvs/Empty.h>
+#include <sr_robot_lib/ChangeForcePids.h>
+#include <sr_robot_lib/CaptureMotorData.h>
+#include <boost/thread.hpp>
 
 // to be able to load the configuration from the
 // parameter server
 #include <ros/ros.h>
 #include <string>
 #include <utility>
-#include <map>
 #include <vector>
 
 namespace shadow_robot
@@ -49,6 +51,8 @@ namespace shadow_robot
     SrMotorHandLib(hardware_interface::HardwareInterface *hw, ros::NodeHandle nh, ros::NodeHandle nhtilde,
                    std::string device_id, std::string joint_prefix);
 
+    ~SrMotorHandLib();
+
     /**
      * The service callback for setting the Force PID values. There's only one callback
      * function, but it can called for any motors. We know which motor called the service
@@ -64,6 +68,19 @@ namespace shadow_robot
                             sr_robot_msgs::ForceController::Response &response,
                             int motor_index);
 
+    /**
+     * The service callback for setting the Force PID values of several motors at once. The configs
+     * of all the motors are sent in the same frames, and the parameter server is updated in the
+     * background.
+     *
+     * @param request The new parameters, with the joint of each motor.
+     * @param response Whether each motor was configured.
+     *
+     * @return true, the motors which couldn't be configured are given in the response.
+     */
+    bool force_pids_callback(sr_robot_lib::ChangeForcePids::Request &request,
+                             sr_robot_lib::ChangeForcePids::Response &response);
+
     /**
      * Reset the motor at motor index.
      *
@@ -129,6 +146,15 @@ namespace shadow_robot
      */
     std::string find_joint_name(int motor_index);
 
+    /**
+     * Finds the motor index for a certain joint name
+     *
+     * @param joint_name The name of the joint (the case is ignored)
+     *
+     * @return the motor index, -1 if the joint has no motor
+     */
+    int find_motor_index(const std::string &joint_name);
+
   private:
     /**
      * Reads the mapping associating a joint to a motor.
@@ -147,7 +173,7 @@ namespace shadow_robot
 
     /**
      * Read the motor board force pids from the parameter servers,
-     * called when resetting the motor.
+     * called when a reset motor rebooted and no pid was sent to it before.
      *
      * @param joint_name the joint we want to reset
      * @param motor_index the index of the motor for this joint
@@ -155,10 +181,68 @@ namespace shadow_robot
     void resend_pids(std::string joint_name, int motor_index);
 
     /**
-     * A map used to keep the timers created in reset_motor_callback alive.
-     * We're using a map to keep only one timer per joint.
+     * Read the backlash compensation setting from the parameter server and
+     * sends it to the motor, called when a reset motor rebooted.
+     *
+     * @param joint_name the joint we reset
+     * @param motor_index the index of the motor for this joint
      */
-    std::map<std::string, ros::Timer> pid_timers;
+    void resend_backlash_compensation(std::string joint_name, int motor_index);
+
+    /**
+     * Completes the reinitialization of the motors which rebooted after a reset
+     * (their force pid was already resent by the realtime loop if it was known).
+     */
+    void check_rebooted_motors(const ros::TimerEvent &event);
+
+    /// Checks for rebooted motors, only running while motors are being reset
+    ros::Timer reboot_timer_;
+
+    /**
+     * Checks that the force PID values are in the ranges accepted by the motors.
+     *
+     * @param request The new parameters for the controllers.
+     *
+     * @return false if a value is out of range.
+     */
+    bool force_pid_in_range(const sr_robot_msgs::ForceController::Request &request);
+
+    /// The force PIDs to write to the parameter server, with the name of their joint
+    typedef std::vector<std::pair<std::string, sr_robot_msgs::ForceController::Request> > ForcePidParams;
+
+    /**
+     * Writes a batch of force PIDs to the parameter server, from the param_server_writer_ thread.
+     *
+     * @param pids the force PIDs, with the name of their joint
+     */
+    void write_force_pids_to_param_server(ForcePidParams pids);
+
+    /**
+     * The service callback starting a motor data capture: the data are polled at a high rate
+     * for the requested duration, then published on the motor_data_capture topic.
+     *
+     * @param request The joints, the data types and the duration of the capture.
+     * @param response success is false if the request is invalid or a capture is running.
+     *
+     * @return true
+     */
+    bool capture_motor_data_callback(sr_robot_lib::CaptureMotorData::Request &request,
+                                     sr_robot_lib::CaptureMotorData::Response &response);
+
+    /**
+     * Publishes the samples once the capture is over, and restores the normal polling.
+     */
+    void check_motor_data_capture(const ros::TimerEvent &event);
+
+    /// Service starting a motor data capture
+    ros::ServiceServer capture_motor_data_service_;
+    /// Checks for the end of the capture, only running during a capture
+    ros::Timer capture_timer_;
+
+    /// Service setting the force PIDs of several motors at once
+    ros::ServiceServer change_force_pids_service_;
+    /// Writes the last batch of force PIDs to the parameter server (joined before starting the next batch)
+    boost::shared_ptr<boost::thread> param_server_writer_;
   };
 }  // namespace shadow_robot
 
@@ -37,6 +37,11 @@
 
 #include "sr_robot_lib/motor_updater.hpp"
 #include "sr_robot_lib/motor_data_checker.hpp"
+#include "sr_robot_lib/motor_data_capture.hpp"
+#include "sr_robot_lib/joint_state_estimator.hpp"
+#include "sr_robot_lib/cached_diagnostic_status.hpp"
+
+#include <boost/atomic.hpp>
 
 #include <string>
 #include <queue>
@@ -101,6 +106,16 @@ namespace shadow_robot
     virtual void initialize(std::vector<std::string> joint_names, std::vector<int> actuator_ids,
                             std::vector<shadow_joints::JointToSensor> joint_to_sensors) = 0;
 
+    /**
+     * Tells the motor updater which motors are present in the joints_vector, if the palm
+     * firmware supports it (~send_motor_presence), so that the palm doesn't wait for the
+     * data of the missing motors.
+     */
+    void send_motor_presence();
+
+    /// Also slows down the polling of the unimportant motor data when the load governor sheds them.
+    virtual void apply_load_shedding();
+
     /**
      * Compute the calibrated position for the given joint. This method is called
      * from the update method, each time a new message is received.
@@ -130,6 +145,20 @@ namespace shadow_robot
     void process_position_sensor_data(std::vector<shadow_joints::Joint>::iterator joint_tmp, StatusType *status_data,
                                       double timestamp);
 
+    /**
+     * Fills the joints part of the state snapshot from the joints_vector.
+     *
+     * @param snapshot the snapshot being committed
+     */
+    void fill_joints_snapshot(HandStateSnapshot &snapshot);
+
+    /**
+     * Extrapolates the position of the joints with their filtered velocity.
+     *
+     * @param dt the time since the last state (in seconds)
+     */
+    void extrapolate_joint_states(double dt);
+
     /**
      * Transforms the incoming flag as a human
      * readable vector of strings.
@@ -190,16 +219,156 @@ namespace shadow_robot
      * This queue contains the force PID config waiting to be pushed to the motor.
      */
     std::queue<ForceConfig, std::list<ForceConfig> > reconfig_queue;
+    // protects the reconfig_queue, filled from the services and emptied from the realtime loop
+    boost::shared_ptr<boost::mutex> lock_reconfig_queue_;
+    /**
+     * The configs being sent, at most one per motor: they are all sent in the same frames,
+     * to the odd and even motors (only used from the realtime loop). Preallocated for all the
+     * motors, only the first nb_configs_being_sent_ are being sent.
+     */
+    std::vector<ForceConfig> configs_being_sent_;
+    unsigned int nb_configs_being_sent_;
     // this index is used to iterate over the config we're sending.
     int config_index;
 
+    /**
+     * Builds a force control config with its CRC (same parameters as generate_force_control_config()).
+     *
+     * @return the config, ready to be queued
+     */
+    ForceConfig build_force_control_config(int motor_index, int max_pwm, int sg_left, int sg_right,
+                                           int f, int p, int i, int d, int imax,
+                                           int deadband, int sign);
+
+    /**
+     * Adds several configs to the reconfig_queue at once, so that they're sent in the same frames
+     * (the configs for the same motor are sent one after the other).
+     *
+     * @param configs the configs to send
+     */
+    void queue_force_control_configs(const std::vector<ForceConfig> &configs);
+
+    /**
+     * Moves the configs of the rebooted motors then the configs waiting in the reconfig_queue to
+     * configs_being_sent_, stopping at the first motor which already has a config being sent.
+     * Never blocks: nothing is taken if a service is filling the queue.
+     */
+    void take_waiting_configs();
+
+    /// Copies a config after the configs being sent (there's at most one config per motor)
+    void add_config_being_sent(const ForceConfig &config);
+
+    /**
+     * The last config queued for each motor (the vector of config is empty if none was), resent as
+     * soon as the motor has rebooted after a reset (protected by lock_reconfig_queue_).
+     */
+    std::vector<ForceConfig> motor_configs_;
+
     // contains a queue of motor indexes to reset
     std::queue<int16_t, std::list<int16_t> > reset_motors_queue;
 
+    /// The reboot of a motor after a reset, followed from its status (only used from the realtime loop)
+    struct MotorReset
+    {
+      MotorReset()
+              : resetting(false), data_missed(false), samples(0)
+      {
+      }
+
+      /// the reset was sent, the motor hasn't rebooted yet
+      bool resetting;
+      /// the motor stopped sending its data since the reset (it's rebooting)
+      bool data_missed;
+      /// the number of times the motor was sampled since the reset
+      unsigned int samples;
+    };
+    std::vector<MotorReset> motor_resets_;
+
+    /**
+     * A motor still sending its data after this number of samples (1s) is considered rebooted anyway.
+     * Computed from the cycle_period and whether the motors alternate.
+     */
+    unsigned int reboot_timeout_samples_;
+
+    /// the motors (bit mask) which rebooted and need their config resent (only used from the realtime loop)
+    int32u configs_to_resend_;
+
+    /// the motors (bit mask) for which a reset was requested and which haven't rebooted yet
+    boost::atomic<int32u> motors_resetting_;
+    /// the motors (bit mask) which rebooted since the last call to take_rebooted_motors()
+    boost::atomic<int32u> motors_rebooted_;
+
+    /// Records the motor data polled during a capture (see the capture_motor_data service)
+    boost::shared_ptr<MotorDataCapture> motor_data_capture_;
+
+    /// Estimates the joint states ahead of the transport delay, instead of the low pass filters (if enabled)
+    boost::shared_ptr<JointStateEstimator> joint_estimator_;
+
+    /**
+     * Queues the reset of a motor. Its force control config is resent as soon as it has rebooted.
+     *
+     * @param motor_index The motor index.
+     */
+    void reset_motor(int motor_index);
+
+    /**
+     * Follows the reboot of a reset motor, called each time the motor is sampled.
+     *
+     * @param motor_index The motor index.
+     * @param data_received whether the data of the motor was received (without errors) in this frame
+     */
+    void check_motor_reboot(int motor_index, bool data_received);
+
+    /**
+     * Gets the motors which rebooted after a reset since the last call.
+     *
+     * @return a bit mask of the motor indexes
+     */
+    int32u take_rebooted_motors()
+    {
+      return motors_rebooted_.exchange(0);
+    }
+
+    /// Whether a reset motor hasn't rebooted yet.
+    bool motors_resetting() const
+    {
+      return motors_resetting_.load() != 0;
+    }
+
+    /// Whether a force control config was queued for this motor (and will be resent after a reset).
+    bool has_force_control_config(int motor_index);
+
+    /// the copy of the state snapshot used by the diagnostics (too big for the stack)
+    HandStateSnapshot diagnostics_snapshot_;
+
+    /// The diagnostics of a motor, kept from one call to the next
+    struct MotorDiagnostics
+    {
+      MotorDiagnostics()
+              : flags(-1), flags_level(diagnostic_msgs::DiagnosticStatus::OK)
+      {
+      }
+
+      CachedDiagnosticStatus status;
+      /// the flags for which the flags_description has been computed
+      int flags;
+      unsigned char flags_level;
+      std::string flags_description;
+    };
+    std::vector<MotorDiagnostics> motor_diagnostics_;
+
+    /**
+     * Humanizes the flags for the diagnostics, only called when the flags change.
+     *
+     * @param motor_diagnostics the diagnostics of the motor
+     * @param flags the new raw flags
+     */
+    void update_flags_diagnostics(MotorDiagnostics &motor_diagnostics, int flags);
+
 
     // The index of the motor in all the 20 motors
     int motor_index_full;
-    // The index of the motor in the current message (from 0 to 9)
+    // The index of the motor in the current message (from 0 to 9, or 19 when all the motors are sent)
     int index_motor_in_msg;
 
     int8u crc_byte;
@@ -224,6 +393,16 @@ namespace shadow_robot
      * doing so would cause a deadlock, thus we do it in the realtime loop thread instead.
      */
     bool control_type_changed_flag_;
+
+    /// Send the presence of the motors to the palm (needs a palm firmware supporting WHICH_MOTORS_PRESENCE_VALID)
+    bool send_motor_presence_;
+
+    /**
+     * Request the data of all the motors in each frame (0240 palms), unless ~alternate_motors
+     * is set. It's set by default for cycles shorter than 1ms, too short for all the replies.
+     */
+    bool all_motors_every_frame_;
+
     // A service server used to change the control type on the fly.
     ros::ServiceServer change_control_type_;
     // A mutual exclusion object to ensure that no command will be sent to the robot while a change
@@ -139,6 +139,20 @@ namespace shadow_robot
     void process_position_sensor_data(std::vector<shadow_joints::Joint>::iterator joint_tmp, StatusType *status_data,
                                       double timestamp);
 
+    /**
+     * Fills the joints part of the state snapshot from the joints_vector.
+     *
+     * @param snapshot the snapshot being committed
+     */
+    void fill_joints_snapshot(HandStateSnapshot &snapshot);
+
+    /**
+     * Extrapolates the position of the joints with their filtered velocity.
+     *
+     * @param dt the time since the last state (in seconds)
+     */
+    void extrapolate_joint_states(double dt);
+
     /**
      * Read additional data from the latest message and stores it into the
      * joints_vector.
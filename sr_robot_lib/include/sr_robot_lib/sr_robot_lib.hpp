@@ -30,6 +30,7 @@
 #include <boost/smart_ptr.hpp>
 #include <boost/ptr_container/ptr_vector.hpp>
 #include <boost/thread.hpp>
+#include <boost/atomic.hpp>
 #include <vector>
 #include <utility>
 #include <string>
@@ -56,6 +57,10 @@
 
 #include "sr_robot_lib/sr_joint_motor.hpp"
 #include "sr_robot_lib/generic_tactiles.hpp"
+#include "sr_robot_lib/hand_state_snapshot.hpp"
+#include "sr_robot_lib/seqlock.hpp"
+#include "sr_robot_lib/load_governor.hpp"
+#include "sr_robot_lib/frame_monitor.hpp"
 
 #include <sr_external_dependencies/types_for_external.h>
 
@@ -63,6 +68,7 @@ extern "C"
 {
 #include <sr_external_dependencies/external/0220_palm_edc/0220_palm_edc_ethercat_protocol.h>
 #include <sr_external_dependencies/external/0230_palm_edc_TS/0230_palm_edc_ethercat_protocol.h>
+#include <sr_external_dependencies/external/0240_palm_edc_TS/0240_palm_edc_ethercat_protocol.h>
 #include <sr_external_dependencies/external/0320_palm_edc_muscle/0320_palm_edc_ethercat_protocol.h>
 #include <sr_external_dependencies/external/simplemotor-bootloader/bootloader.h>
 }
@@ -115,6 +121,13 @@ namespace shadow_robot
      */
     virtual void update(StatusType *status_data) = 0;
 
+    /**
+     * Called by the driver instead of update() when the frame was lost or repeated
+     * (see the frame_monitor): the joint states are extrapolated or held, the data of
+     * the frame are not fed to the filters.
+     */
+    void frame_missed();
+
     /**
      * Builds a command for the robot.
      *
@@ -133,8 +146,20 @@ namespace shadow_robot
      * Reads the tactile information.
      *
      * @param status The status information that comes from the robot
+     * @param frame_time The time of the frame (in seconds, see FrameMonitor::filter_time())
+     */
+    void update_tactile_info(StatusType *status, double frame_time);
+
+    /**
+     * Tells the library that the tactile (and aux) data of the next status are the same as
+     * the ones decoded in the previous update, so that update_tactile_info() skips them.
+     *
+     * @param unchanged true if the tactile data didn't change
      */
-    void update_tactile_info(StatusType *status);
+    void set_tactile_data_unchanged(bool unchanged)
+    {
+      tactile_data_unchanged_ = unchanged;
+    }
 
     /**
      * This function adds the diagnostics for the hand to the
@@ -163,6 +188,17 @@ namespace shadow_robot
     bool nullify_demand_callback(sr_robot_msgs::NullifyDemand::Request &request,
                                  sr_robot_msgs::NullifyDemand::Response &response);
 
+    /**
+     * Copies the last state committed by the realtime loop. This is the
+     * way for the non realtime threads (diagnostics, service callbacks...)
+     * to read a consistent state of the hand: it never blocks the realtime loop.
+     *
+     * @param snapshot where the state is copied
+     *
+     * @return the version of the snapshot (incremented at each cycle)
+     */
+    unsigned int get_state_snapshot(HandStateSnapshot &snapshot) const;
+
 
     /**
      * This is a pointer to the tactile object. This pointer
@@ -184,15 +220,61 @@ namespace shadow_robot
      */
     int main_pic_idle_time_min;
 
+    /**
+     * Called by the diagnostics once they've read the minimum idle time: the realtime
+     * loop resets it in its next update.
+     */
+    void reset_main_pic_idle_time_min()
+    {
+      main_pic_idle_time_min_reset_.store(true, boost::memory_order_release);
+    }
+
     // Current update state of the sensors (initialization, operation..)
     operation_mode::device_update_state::DeviceUpdateState tactile_current_state;
 
+    /// Sheds the telemetry load when the palm or the host run out of time (fed by the driver)
+    boost::shared_ptr<LoadGovernor> load_governor;
+
+    /// Detects the lost and repeated frames (fed by the driver)
+    boost::shared_ptr<FrameMonitor> frame_monitor;
+
+    /// The period of the EtherCAT cycle (in seconds), from the cycle_period parameter (1ms by default)
+    double cycle_period;
+
+    /**
+     * Converts a rate to a number of cycles, for the things done every N cycles.
+     *
+     * @param rate the rate (in Hz)
+     * @return the number of cycles between two events at this rate (at least 1)
+     */
+    unsigned int cycles_for_rate(double rate) const
+    {
+      if (rate <= 0.0 || rate * cycle_period >= 1.0)
+      {
+        return 1;
+      }
+      return static_cast<unsigned int>(1.0 / (rate * cycle_period) + 0.5);
+    }
+
     ros_ethercat_model::RobotState *hw_;
 
   protected:
     // True if we want to set the demand to 0 (stop the controllers)
     bool nullify_demand_;
 
+    /// Set with set_tactile_data_unchanged(), reset by update_tactile_info()
+    bool tactile_data_unchanged_;
+    /// The tactiles object which decoded the last tactile data (the init one, then the sensor specific one)
+    tactiles::GenericTactiles<StatusType, CommandType> *last_updated_tactiles_;
+
+    /// Set by reset_main_pic_idle_time_min(), consumed by update_main_pic_idle_time()
+    boost::atomic<bool> main_pic_idle_time_min_reset_;
+
+    /// The tactiles object of the last snapshot (its identification strings are copied again if it changed)
+    tactiles::GenericTactiles<StatusType, CommandType> *snapshot_tactiles_;
+    /// The type of the tactiles object, set when it's created
+    TactileStateSnapshot::TactileType tactile_type_;
+
     /// The vector containing all the robot joints.
     std::vector<shadow_joints::Joint> joints_vector;
 
@@ -226,6 +308,37 @@ namespace shadow_robot
      */
     virtual ros_ethercat_model::Actuator *get_joint_actuator(std::vector<shadow_joints::Joint>::iterator joint_tmp) = 0;
 
+    /**
+     * Extrapolates the state of the joints with their velocity, when no new data were received.
+     *
+     * @param dt the time since the last state (in seconds)
+     */
+    virtual void extrapolate_joint_states(double dt) = 0;
+
+    /**
+     * Updates the idle time of the PIC, and its minimum since the last diagnostics.
+     * Called from the update method.
+     *
+     * @param idle_time_us the idle time of the PIC in this frame (in microseconds)
+     */
+    void update_main_pic_idle_time(int idle_time_us);
+
+    /**
+     * Commits the state of the hand to the state_snapshot_. Called once per cycle
+     * from the update method, after the joints and tactiles have been updated.
+     *
+     * @param stamp Timestamp of the data acquisition time
+     */
+    void commit_state_snapshot(double stamp);
+
+    /**
+     * Fills the joints part of the snapshot from the joints_vector. The actuator
+     * state depends on the type of hand, so it's filled by the child classes.
+     *
+     * @param snapshot the snapshot being committed
+     */
+    virtual void fill_joints_snapshot(HandStateSnapshot &snapshot) = 0;
+
     /**
      * Reads the mapping between the sensors and the joints from the parameter server.
      *
@@ -262,6 +375,17 @@ namespace shadow_robot
      */
     void tactile_init_timer_callback(const ros::TimerEvent &event);
 
+    /**
+     * Applies the rates decided by the load governor to the updaters, out of the realtime loop.
+     * Called periodically when the governor is enabled.
+     */
+    virtual void apply_load_shedding();
+
+    void load_shedding_timer_callback(const ros::TimerEvent &event);
+
+    /// Applies the load shedding periodically (only running when the load governor is enabled)
+    ros::Timer load_shedding_timer_;
+
     /// A temporary calibration for a given joint.
     boost::shared_ptr<shadow_robot::JointCalibration> calibration_tmp;
 
@@ -317,6 +441,9 @@ namespace shadow_robot
     static const char *human_readable_sensor_data_types[];
     static const int32u sensor_data_types[];
 
+    /// The state of the hand, committed by the realtime loop at the end of each update.
+    SeqLock<HandStateSnapshot> state_snapshot_;
+
     /// It is run in a separate thread and calls the checkTests() method of the self_tests_.
     // This avoids the tests blocking the main thread
     void checkSelfTests();
@@ -123,8 +123,8 @@ namespace tactiles
         {
           if (sr_math_utils::is_bit_mask_index_true(tactile_mask, id_sensor))
           {
-            tactiles_vector->at(id_sensor).manufacturer = this->sanitise_string(status_data->tactile[id_sensor].string,
-                                                                                TACTILE_DATA_LENGTH_BYTES);
+            this->update_id_string(tactiles_vector->at(id_sensor).manufacturer, status_data->tactile[id_sensor].string,
+                                   TACTILE_DATA_LENGTH_BYTES);
           }
         }
           break;
@@ -133,8 +133,8 @@ namespace tactiles
         {
           if (sr_math_utils::is_bit_mask_index_true(tactile_mask, id_sensor))
           {
-            tactiles_vector->at(id_sensor).serial_number = this->sanitise_string(status_data->tactile[id_sensor].string,
-                                                                                 TACTILE_DATA_LENGTH_BYTES);
+            this->update_id_string(tactiles_vector->at(id_sensor).serial_number, status_data->tactile[id_sensor].string,
+                                   TACTILE_DATA_LENGTH_BYTES);
           }
         }
           break;
@@ -142,15 +142,16 @@ namespace tactiles
         case TACTILE_SENSOR_TYPE_SOFTWARE_VERSION:
           if (sr_math_utils::is_bit_mask_index_true(tactile_mask, id_sensor))
           {
-            tactiles_vector->at(id_sensor).set_software_version(status_data->tactile[id_sensor].string);
+            this->update_software_version(tactiles_vector->at(id_sensor), id_sensor,
+                                          status_data->tactile[id_sensor].string, TACTILE_DATA_LENGTH_BYTES);
           }
           break;
 
         case TACTILE_SENSOR_TYPE_PCB_VERSION:
           if (sr_math_utils::is_bit_mask_index_true(tactile_mask, id_sensor))
           {
-            tactiles_vector->at(id_sensor).pcb_version = this->sanitise_string(status_data->tactile[id_sensor].string,
-                                                                               TACTILE_DATA_LENGTH_BYTES);
+            this->update_id_string(tactiles_vector->at(id_sensor).pcb_version, status_data->tactile[id_sensor].string,
+                                   TACTILE_DATA_LENGTH_BYTES);
           }
           break;
 
@@ -193,27 +194,25 @@ namespace tactiles
 
   template<class StatusType, class CommandType>
   void UBI0<StatusType, CommandType>::add_diagnostics(std::vector<diagnostic_msgs::DiagnosticStatus> &vec,
-                                                      diagnostic_updater::DiagnosticStatusWrapper &d)
+                                                      diagnostic_updater::DiagnosticStatusWrapper &d,
+                                                      const shadow_robot::HandStateSnapshot &snapshot)
   {
-    for (unsigned int id_tact = 0; id_tact < this->nb_tactiles; ++id_tact)
+    for (unsigned int id_tact = 0; id_tact < snapshot.nb_tactiles; ++id_tact)
     {
-      std::stringstream ss;
-      std::string prefix = this->device_id_.empty() ? this->device_id_ : (this->device_id_ + " ");
+      const shadow_robot::TactileStateSnapshot &tactile = snapshot.tactiles[id_tact];
+      shadow_robot::CachedDiagnosticStatus &status = this->get_tactile_diagnostics(id_tact);
+      status.clear();
+      status.summary(d.OK, "OK");
 
-      ss << prefix << "Tactile " << id_tact + 1;
+      status.add("Sample Frequency", tactile.sample_frequency);
+      status.add("Manufacturer", tactile.manufacturer);
+      status.add("Serial Number", tactile.serial_number);
 
-      d.name = ss.str().c_str();
-      d.summary(d.OK, "OK");
-      d.clear();
+      status.add("Software Version", tactile.software_version);
+      status.add("PCB Version", tactile.pcb_version);
 
-      d.addf("Sample Frequency", "%d", tactiles_vector->at(id_tact).sample_frequency);
-      d.addf("Manufacturer", "%s", tactiles_vector->at(id_tact).manufacturer.c_str());
-      d.addf("Serial Number", "%s", tactiles_vector->at(id_tact).serial_number.c_str());
-
-      d.addf("Software Version", "%s", tactiles_vector->at(id_tact).get_software_version().c_str());
-      d.addf("PCB Version", "%s", tactiles_vector->at(id_tact).pcb_version.c_str());
-
-      vec.push_back(d);
+      status.finish();
+      vec.push_back(status.status);
     }
   }
 
@@ -235,6 +234,9 @@ namespace tactiles
   template
   class UBI0<ETHERCAT_DATA_STRUCTURE_0230_PALM_EDC_STATUS, ETHERCAT_DATA_STRUCTURE_0230_PALM_EDC_COMMAND>;
 
+  template
+  class UBI0<ETHERCAT_DATA_STRUCTURE_0240_PALM_EDC_STATUS, ETHERCAT_DATA_STRUCTURE_0240_PALM_EDC_COMMAND>;
+
   template
   class UBI0<ETHERCAT_DATA_STRUCTURE_0300_PALM_EDC_STATUS, ETHERCAT_DATA_STRUCTURE_0300_PALM_EDC_COMMAND>;
 }  // namespace tactiles
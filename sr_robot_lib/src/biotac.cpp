@@ -26,7 +26,10 @@
  */
 
 #include "sr_robot_lib/biotac.hpp"
+#include "sr_robot_lib/rt_logger.hpp"
 #include <sr_utilities/sr_math_utils.hpp>
+#include <algorithm>
+#include <cstdlib>
 #include <string>
 #include <vector>
 
@@ -81,12 +84,159 @@ namespace tactiles
     {
       this->all_tactile_data->at(i).type = "biotac";
     }
+
+    bool pac_capture = false;
+    this->nodehandle_.param("biotac_pac_capture/enabled", pac_capture, false);
+    if (pac_capture)
+    {
+      double window, buffer_length;
+      this->nodehandle_.param("biotac_pac_capture/window", window, 0.02);
+      this->nodehandle_.param("biotac_pac_capture/buffer_length", buffer_length, 1.0);
+      // same cycle period as the SrRobotLib
+      double cycle_period;
+      this->nodehandle_.param("cycle_period", cycle_period, 0.001);
+      pac_buffer_.reset(new BiotacPacBuffer(this->nodehandle_, this->nb_tactiles, window, buffer_length,
+                                            cycle_period > 0.0 ? cycle_period : 0.001));
+      ROS_INFO_STREAM("Capturing all the BioTac Pac samples, published every " << window << "s");
+    }
+
+    this->nodehandle_.param("biotac_adaptive_polling/enabled", adaptive_polling_, false);
+    this->nodehandle_.param("biotac_adaptive_polling/pdc_threshold", pdc_threshold_, 15);
+    this->nodehandle_.param("biotac_adaptive_polling/electrode_threshold", electrode_threshold_, 20);
+    int idle_electrode_period, contact_pressure_period;
+    this->nodehandle_.param("biotac_adaptive_polling/idle_electrode_period", idle_electrode_period, 4);
+    this->nodehandle_.param("biotac_adaptive_polling/contact_pressure_period", contact_pressure_period, 4);
+    idle_electrode_period_ = std::max(idle_electrode_period, 1);
+    contact_pressure_period_ = std::max(contact_pressure_period, 2);
+
+    electrode_slots_.assign(FROM_TACTILE_SENSOR_TYPE_BIOTAC_NUM_VALUES, -1);
+    pdc_baselines_.assign(this->nb_tactiles, -1.0);
+    fingers_in_contact_ = 0;
+    changing_electrodes_ = 0;
+    electrodes_changed_ = false;
+    polling_frame_ = 0;
+    next_pressure_ = 0;
+    next_electrode_ = 0;
+    next_changing_electrode_ = 0;
+    changing_electrodes_turn_ = false;
+  }
+
+  template<class StatusType, class CommandType>
+  operation_mode::device_update_state::DeviceUpdateState Biotac<StatusType, CommandType>::build_command(
+          CommandType *command)
+  {
+    if (!adaptive_polling_ || pressure_data_.empty() || electrode_data_.empty())
+    {
+      return this->sensor_updater->build_command(command);
+    }
+
+    int32u data;
+    if (!this->sensor_updater->pop_unimportant_data(&data))
+    {
+      data = next_adaptive_data();
+    }
+    command->tactile_data_type = data;
+
+    return this->sensor_updater->update_state;
+  }
+
+  template<class StatusType, class CommandType>
+  int32u Biotac<StatusType, CommandType>::next_adaptive_data()
+  {
+    ++polling_frame_;
+
+    if (fingers_in_contact_ == 0)
+    {
+      if (polling_frame_ % idle_electrode_period_ != 0)
+      {
+        next_pressure_ = (next_pressure_ + 1) % pressure_data_.size();
+        return pressure_data_[next_pressure_];
+      }
+      next_electrode_ = (next_electrode_ + 1) % electrode_data_.size();
+      return electrode_data_[next_electrode_];
+    }
+
+    if (polling_frame_ % contact_pressure_period_ == 0)
+    {
+      next_pressure_ = (next_pressure_ + 1) % pressure_data_.size();
+      return pressure_data_[next_pressure_];
+    }
+
+    changing_electrodes_turn_ = !changing_electrodes_turn_;
+    if (changing_electrodes_turn_ && changing_electrodes_ != 0)
+    {
+      do
+      {
+        next_changing_electrode_ = (next_changing_electrode_ + 1) % electrode_data_.size();
+      }
+      while (!(changing_electrodes_ & (1 << next_changing_electrode_)));
+      return electrode_data_[next_changing_electrode_];
+    }
+
+    next_electrode_ = (next_electrode_ + 1) % electrode_data_.size();
+    return electrode_data_[next_electrode_];
+  }
+
+  template<class StatusType, class CommandType>
+  void Biotac<StatusType, CommandType>::track_contact(unsigned int id_sensor, int32u data_type,
+                                                     TACTILE_SENSOR_BIOTAC_DATA_CONTENTS *tactile_data)
+  {
+    if (data_type == TACTILE_SENSOR_TYPE_BIOTAC_PDC)
+    {
+      if (!tactile_data->data_valid.other_sensor_0 || id_sensor >= pdc_baselines_.size())
+      {
+        return;
+      }
+
+      double pdc = static_cast<double>(tactile_data->other_sensor_0);
+      if (pdc_baselines_[id_sensor] < 0.0)
+      {
+        pdc_baselines_[id_sensor] = pdc;
+      }
+
+      if (pdc - pdc_baselines_[id_sensor] > pdc_threshold_)
+      {
+        fingers_in_contact_ |= 1 << id_sensor;
+      }
+      else
+      {
+        fingers_in_contact_ &= ~(1 << id_sensor);
+        // follows the slow drift of the Pdc without contact
+        pdc_baselines_[id_sensor] += 0.01 * (pdc - pdc_baselines_[id_sensor]);
+      }
+      return;
+    }
+
+    if (data_type >= electrode_slots_.size() || electrode_slots_[data_type] == -1 ||
+        !(fingers_in_contact_ & (1 << id_sensor)))
+    {
+      return;
+    }
+
+    // the pair starting with electrode N (from 0) is polled with TACTILE_SENSOR_TYPE_BIOTAC_ELECTRODE_1 + N
+    const std::vector<int> &electrodes = tactiles_vector->at(id_sensor).electrodes;
+    size_t first = data_type - TACTILE_SENSOR_TYPE_BIOTAC_ELECTRODE_1;
+    if (tactile_data->data_valid.other_sensor_0 && first < electrodes.size() &&
+        std::abs(static_cast<int>(tactile_data->other_sensor_0) - electrodes[first]) > electrode_threshold_)
+    {
+      electrodes_changed_ = true;
+    }
+    if (tactile_data->data_valid.other_sensor_1 && first + 1 < electrodes.size() &&
+        std::abs(static_cast<int>(tactile_data->other_sensor_1) - electrodes[first + 1]) > electrode_threshold_)
+    {
+      electrodes_changed_ = true;
+    }
   }
 
   template<class StatusType, class CommandType>
   void Biotac<StatusType, CommandType>::update(StatusType *status_data)
   {
     int tactile_mask = static_cast<int16u>(status_data->tactile_data_valid);
+    if (pac_buffer_)
+    {
+      pac_frame_.stamp = this->frame_stamp_;
+    }
+    electrodes_changed_ = false;
     // @todo use memcopy instead?
     for (unsigned int id_sensor = 0; id_sensor < this->nb_tactiles; ++id_sensor)
     {
@@ -94,13 +244,23 @@ namespace tactiles
       //We always receive pac0 and pac1
       tactiles_vector->at(id_sensor).pac0 = static_cast<int>(tactile_data->Pac[0]);
       tactiles_vector->at(id_sensor).pac1 = static_cast<int>(tactile_data->Pac[1]);
+      if (pac_buffer_ && id_sensor < BiotacPacFrame::max_tactiles)
+      {
+        pac_frame_.pac[id_sensor][0] = tactile_data->Pac[0];
+        pac_frame_.pac[id_sensor][1] = tactile_data->Pac[1];
+      }
+
+      if (adaptive_polling_)
+      {
+        track_contact(id_sensor, static_cast<int32u>(status_data->tactile_data_type), tactile_data);
+      }
 
       //the rest of the data is sampled at different rates
       switch( static_cast<int32u>(status_data->tactile_data_type) )
       {
         //TACTILE DATA
         case TACTILE_SENSOR_TYPE_BIOTAC_INVALID:
-          ROS_WARN("received invalid tactile type");
+          SR_RT_LOG_WARN("received invalid tactile type");
           break;
 
         case TACTILE_SENSOR_TYPE_BIOTAC_PDC:
@@ -317,31 +477,32 @@ namespace tactiles
         case TACTILE_SENSOR_TYPE_MANUFACTURER:
           if (sr_math_utils::is_bit_mask_index_true(tactile_mask, id_sensor))
           {
-            tactiles_vector->at(id_sensor).manufacturer = this->sanitise_string(status_data->tactile[id_sensor].string,
-                                                                                TACTILE_DATA_LENGTH_BYTES);
+            this->update_id_string(tactiles_vector->at(id_sensor).manufacturer, status_data->tactile[id_sensor].string,
+                                   TACTILE_DATA_LENGTH_BYTES);
           }
           break;
 
         case TACTILE_SENSOR_TYPE_SERIAL_NUMBER:
           if (sr_math_utils::is_bit_mask_index_true(tactile_mask, id_sensor))
           {
-            tactiles_vector->at(id_sensor).serial_number = this->sanitise_string(status_data->tactile[id_sensor].string,
-                                                                                 TACTILE_DATA_LENGTH_BYTES);
+            this->update_id_string(tactiles_vector->at(id_sensor).serial_number, status_data->tactile[id_sensor].string,
+                                   TACTILE_DATA_LENGTH_BYTES);
           }
           break;
 
         case TACTILE_SENSOR_TYPE_SOFTWARE_VERSION:
           if (sr_math_utils::is_bit_mask_index_true(tactile_mask, id_sensor))
           {
-            tactiles_vector->at(id_sensor).set_software_version(status_data->tactile[id_sensor].string);
+            this->update_software_version(tactiles_vector->at(id_sensor), id_sensor,
+                                          status_data->tactile[id_sensor].string, TACTILE_DATA_LENGTH_BYTES);
           }
           break;
 
         case TACTILE_SENSOR_TYPE_PCB_VERSION:
           if (sr_math_utils::is_bit_mask_index_true(tactile_mask, id_sensor))
           {
-            tactiles_vector->at(id_sensor).pcb_version = this->sanitise_string(status_data->tactile[id_sensor].string,
-                                                                               TACTILE_DATA_LENGTH_BYTES);
+            this->update_id_string(tactiles_vector->at(id_sensor).pcb_version, status_data->tactile[id_sensor].string,
+                                   TACTILE_DATA_LENGTH_BYTES);
           }
           break;
 
@@ -350,6 +511,25 @@ namespace tactiles
       }  // end switch
     }  // end for tactile
 
+    if (pac_buffer_)
+    {
+      pac_buffer_->push(pac_frame_);
+    }
+
+    if (adaptive_polling_)
+    {
+      int32u data_type = static_cast<int32u>(status_data->tactile_data_type);
+      if (fingers_in_contact_ == 0)
+      {
+        changing_electrodes_ = 0;
+      }
+      else if (data_type < electrode_slots_.size() && electrode_slots_[data_type] != -1)
+      {
+        int32u slot = 1 << electrode_slots_[data_type];
+        changing_electrodes_ = electrodes_changed_ ? (changing_electrodes_ | slot) : (changing_electrodes_ & ~slot);
+      }
+    }
+
     if (this->sensor_updater->update_state == operation_mode::device_update_state::INITIALIZATION)
     {
       this->process_received_data_type(static_cast<int32u>(status_data->tactile_data_type));
@@ -368,27 +548,29 @@ namespace tactiles
 
   template <class StatusType, class CommandType>
   void Biotac<StatusType, CommandType>::add_diagnostics(std::vector<diagnostic_msgs::DiagnosticStatus> &vec,
-                                                        diagnostic_updater::DiagnosticStatusWrapper &d)
+                                                        diagnostic_updater::DiagnosticStatusWrapper &d,
+                                                        const shadow_robot::HandStateSnapshot &snapshot)
   {
-    for (unsigned int id_tact = 0; id_tact < this->nb_tactiles; ++id_tact)
+    for (unsigned int id_tact = 0; id_tact < snapshot.nb_tactiles; ++id_tact)
     {
-      std::stringstream ss;
-      std::string prefix = this->device_id_.empty() ? this->device_id_ : (this->device_id_ + " ");
-
-      ss << prefix << "Tactile " << id_tact + 1;
-
-      d.name = ss.str().c_str();
-      d.summary(d.OK, "OK");
-      d.clear();
-
-      d.addf("Sample Frequency", "%d", tactiles_vector->at(id_tact).sample_frequency);
-      d.addf("Manufacturer", "%s", tactiles_vector->at(id_tact).manufacturer.c_str());
-      d.addf("Serial Number", "%s", tactiles_vector->at(id_tact).serial_number.c_str());
-
-      d.addf("Software Version", "%s", tactiles_vector->at(id_tact).get_software_version().c_str());
-      d.addf("PCB Version", "%s", tactiles_vector->at(id_tact).pcb_version.c_str());
+      const shadow_robot::TactileStateSnapshot &tactile = snapshot.tactiles[id_tact];
+      shadow_robot::CachedDiagnosticStatus &status = this->get_tactile_diagnostics(id_tact);
+      status.clear();
+      status.summary(d.OK, "OK");
+
+      status.add("Sample Frequency", tactile.sample_frequency);
+      status.add("Manufacturer", tactile.manufacturer);
+      status.add("Serial Number", tactile.serial_number);
+
+      status.add("Software Version", tactile.software_version);
+      status.add("PCB Version", tactile.pcb_version);
+      if (pac_buffer_)
+      {
+        status.add("Pac Frames Dropped", static_cast<int>(pac_buffer_->get_dropped_frames()));
+      }
 
-      vec.push_back(d);
+      status.finish();
+      vec.push_back(status.status);
     }
   }
 
@@ -443,6 +625,24 @@ namespace tactiles
     {
       tactiles_vector->at(id_tact).electrodes.resize(nb_electrodes_);
     }
+
+    // split the important data for the adaptive polling
+    pressure_data_.clear();
+    electrode_data_.clear();
+    electrode_slots_.assign(FROM_TACTILE_SENSOR_TYPE_BIOTAC_NUM_VALUES, -1);
+    for (size_t i = 0; i < this->sensor_updater->important_update_configs_vector.size(); ++i)
+    {
+      int32u data = this->sensor_updater->important_update_configs_vector[i].what_to_update;
+      if (data >= TACTILE_SENSOR_TYPE_BIOTAC_ELECTRODE_1 && data < FROM_TACTILE_SENSOR_TYPE_BIOTAC_NUM_VALUES)
+      {
+        electrode_slots_[data] = static_cast<int>(electrode_data_.size());
+        electrode_data_.push_back(data);
+      }
+      else
+      {
+        pressure_data_.push_back(data);
+      }
+    }
   }
 
   // Only to ensure that the template class is compiled for the types we are interested in
@@ -452,6 +652,9 @@ namespace tactiles
   template
   class Biotac<ETHERCAT_DATA_STRUCTURE_0230_PALM_EDC_STATUS, ETHERCAT_DATA_STRUCTURE_0230_PALM_EDC_COMMAND>;
 
+  template
+  class Biotac<ETHERCAT_DATA_STRUCTURE_0240_PALM_EDC_STATUS, ETHERCAT_DATA_STRUCTURE_0240_PALM_EDC_COMMAND>;
+
   template
   class Biotac<ETHERCAT_DATA_STRUCTURE_0300_PALM_EDC_STATUS, ETHERCAT_DATA_STRUCTURE_0300_PALM_EDC_COMMAND>;
 }  // namespace tactiles
@@ -0,0 +1,127 @@
+/**
+ * @file   biotac_pac_buffer.cpp
+ * @author Shadow Robot Software Team <software@shadowrobot.com>
+ * @date   Sun Oct 18 10:12:51 2026
+ *
+ * Copyright 2026 Shadow Robot Company Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @brief Lossless capture of the BioTac Pac channel.
+ *
+ *
+ */
+
+#include "sr_robot_lib/biotac_pac_buffer.hpp"
+#include <algorithm>
+
+namespace tactiles
+{
+  const unsigned int BiotacPacFrame::max_tactiles;
+  const unsigned int BiotacPacFrame::samples_per_frame;
+
+  BiotacPacBuffer::BiotacPacBuffer(ros::NodeHandle nh, unsigned int nb_tactiles, double window, double buffer_length,
+                                   double cycle_period)
+          : nb_tactiles_(std::min(nb_tactiles, BiotacPacFrame::max_tactiles)),
+            window_(boost::posix_time::microseconds(static_cast<int64_t>(window * 1000000.0))),
+            pac_sample_offset_(cycle_period / 2.0),
+            // one frame per cycle, at least twice the window so we don't drop frames while publishing
+            ring_(std::max(static_cast<size_t>(buffer_length / cycle_period),
+                           static_cast<size_t>(2.0 * window / cycle_period) + 1)),
+            dropped_frames_(0)
+  {
+    // the whole window is appended to the message, reserve it now so that
+    // the publishing thread doesn't reallocate every time
+    size_t nb_samples = ring_.write_available() * BiotacPacFrame::samples_per_frame;
+    msg_.tactiles.resize(nb_tactiles_);
+    for (unsigned int i = 0; i < nb_tactiles_; ++i)
+    {
+      msg_.tactiles[i].stamps.reserve(nb_samples);
+      msg_.tactiles[i].pac.reserve(nb_samples);
+    }
+
+    publisher_ = nh.advertise<sr_robot_lib::BiotacPacAll>("tactile_pac", 10);
+    publishing_thread_.reset(new boost::thread(boost::bind(&BiotacPacBuffer::publishing_loop, this)));
+  }
+
+  BiotacPacBuffer::~BiotacPacBuffer()
+  {
+    publishing_thread_->interrupt();
+    publishing_thread_->join();
+  }
+
+  void BiotacPacBuffer::push(const BiotacPacFrame &frame)
+  {
+    if (!ring_.push(frame))
+    {
+      dropped_frames_.fetch_add(1, boost::memory_order_relaxed);
+    }
+  }
+
+  void BiotacPacBuffer::publishing_loop()
+  {
+    try
+    {
+      while (ros::ok())
+      {
+        boost::this_thread::sleep(window_);
+        drain_and_publish();
+      }
+    }
+    catch (boost::thread_interrupted const &)
+    {
+      // the buffer is being destroyed
+    }
+  }
+
+  void BiotacPacBuffer::drain_and_publish()
+  {
+    for (unsigned int i = 0; i < nb_tactiles_; ++i)
+    {
+      msg_.tactiles[i].stamps.clear();
+      msg_.tactiles[i].pac.clear();
+    }
+
+    BiotacPacFrame frame;
+    bool first_frame = true;
+    while (ring_.pop(frame))
+    {
+      if (first_frame)
+      {
+        msg_.header.stamp = frame.stamp;
+        first_frame = false;
+      }
+
+      for (unsigned int i = 0; i < nb_tactiles_; ++i)
+      {
+        for (unsigned int sample = 0; sample < BiotacPacFrame::samples_per_frame; ++sample)
+        {
+          msg_.tactiles[i].stamps.push_back(frame.stamp + pac_sample_offset_ * static_cast<double>(sample));
+          msg_.tactiles[i].pac.push_back(frame.pac[i][sample]);
+        }
+      }
+    }
+
+    if (!first_frame)
+    {
+      publisher_.publish(msg_);
+    }
+  }
+}  // namespace tactiles
+
+/* For the emacs weenies in the crowd.
+Local Variables:
+   c-basic-offset: 2
+End:
+*/
@@ -0,0 +1,167 @@
+/**
+ * @file   cached_diagnostic_status.cpp
+ * @author Shadow Robot Software Team <software@shadowrobot.com>
+ * @date   Sun Oct 18 16:40:12 2026
+ *
+ * Copyright 2026 Shadow Robot Company Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @brief A diagnostic status which only reformats the values that changed.
+ *
+ *
+ */
+
+#include "sr_robot_lib/cached_diagnostic_status.hpp"
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+namespace shadow_robot
+{
+  CachedDiagnosticStatus::CachedDiagnosticStatus()
+          : cursor_(0)
+  {
+    status.level = diagnostic_msgs::DiagnosticStatus::OK;
+  }
+
+  void CachedDiagnosticStatus::clear()
+  {
+    cursor_ = 0;
+  }
+
+  void CachedDiagnosticStatus::summary(unsigned char level, const char *message)
+  {
+    status.level = level;
+    if (status.message != message)
+    {
+      status.message = message;
+    }
+  }
+
+  CachedDiagnosticStatus::Field &CachedDiagnosticStatus::next_field(const char *key)
+  {
+    if (cursor_ == fields_.size())
+    {
+      // first time we get there: create the key
+      diagnostic_msgs::KeyValue key_value;
+      key_value.key = key;
+      status.values.push_back(key_value);
+
+      Field field;
+      field.type = INVALID;
+      fields_.push_back(field);
+    }
+    else if (status.values[cursor_].key != key)
+    {
+      // the layout of the status changed (e.g. the motor went into error)
+      status.values[cursor_].key = key;
+      fields_[cursor_].type = INVALID;
+    }
+
+    return fields_[cursor_++];
+  }
+
+  void CachedDiagnosticStatus::format_value(const char *format, ...)
+  {
+    char buffer[128];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+
+    // reuses the capacity of the string
+    status.values[cursor_ - 1].value.assign(buffer);
+  }
+
+  void CachedDiagnosticStatus::add(const char *key, int value)
+  {
+    Field &field = next_field(key);
+    if (field.type != INT || field.integers[0] != value)
+    {
+      field.type = INT;
+      field.integers[0] = value;
+      format_value("%d", value);
+    }
+  }
+
+  void CachedDiagnosticStatus::add(const char *key, double value)
+  {
+    Field &field = next_field(key);
+    if (field.type != DOUBLE || field.real != value)
+    {
+      field.type = DOUBLE;
+      field.real = value;
+      format_value("%f", value);
+    }
+  }
+
+  void CachedDiagnosticStatus::add(const char *key, uint64_t value)
+  {
+    Field &field = next_field(key);
+    if (field.type != UINT64 || static_cast<uint64_t>(field.integers[0]) != value)
+    {
+      field.type = UINT64;
+      field.integers[0] = static_cast<int64_t>(value);
+      format_value("%llu", static_cast<unsigned long long>(value));
+    }
+  }
+
+  void CachedDiagnosticStatus::add(const char *key, const char *value)
+  {
+    Field &field = next_field(key);
+    std::string &cached_value = status.values[cursor_ - 1].value;
+    if (field.type != STRING || cached_value != value)
+    {
+      field.type = STRING;
+      cached_value = value;
+    }
+  }
+
+  void CachedDiagnosticStatus::add(const char *key, const std::string &value)
+  {
+    add(key, value.c_str());
+  }
+
+  void CachedDiagnosticStatus::addf(const char *key, const char *format, int a, int b, int c)
+  {
+    Field &field = next_field(key);
+    if (field.type != FORMATTED || field.format != format
+        || field.integers[0] != a || field.integers[1] != b || field.integers[2] != c)
+    {
+      field.type = FORMATTED;
+      field.format = format;
+      field.integers[0] = a;
+      field.integers[1] = b;
+      field.integers[2] = c;
+      format_value(format, a, b, c);
+    }
+  }
+
+  void CachedDiagnosticStatus::finish()
+  {
+    if (cursor_ < fields_.size())
+    {
+      fields_.resize(cursor_);
+      status.values.resize(cursor_);
+    }
+  }
+}  // namespace shadow_robot
+
+/* For the emacs weenies in the crowd.
+Local Variables:
+   c-basic-offset: 2
+End:
+*/
@@ -0,0 +1,108 @@
+/**
+ * @file   frame_monitor.cpp
+ * @author Shadow Robot Software Team <software@shadowrobot.com>
+ * @date   Sun Oct 18 15:12:47 2026
+ *
+ * Copyright 2026 Shadow Robot Company Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @brief Detects the lost and repeated frames, and the faults they lead to.
+ *
+ *
+ */
+
+#include "sr_robot_lib/frame_monitor.hpp"
+#include "sr_robot_lib/rt_logger.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace shadow_robot
+{
+  FrameMonitor::FrameMonitor(ros::NodeHandle nh_tilde, double cycle_period)
+          : lost_frames(0),
+            repeated_frames(0),
+            faults(0),
+            cycle_period_(cycle_period),
+            missed_frames_(0),
+            prev_frame_valid_(false),
+            last_timestamp_(0.0),
+            filter_time_(0.0)
+  {
+    int max_extrapolated_frames, max_lost_frames;
+    // hold the joint states by default
+    nh_tilde.param("frame_monitor/max_extrapolated_frames", max_extrapolated_frames, 0);
+    // 0 to never be in fault
+    nh_tilde.param("frame_monitor/max_lost_frames", max_lost_frames, 20);
+    max_extrapolated_frames_ = std::max(max_extrapolated_frames, 0);
+    max_lost_frames_ = std::max(max_lost_frames, 0);
+  }
+
+  FrameMonitor::FrameStatus FrameMonitor::check_frame(bool valid, const unsigned char *status,
+                                                      const unsigned char *prev_status, size_t size,
+                                                      bool check_repeated)
+  {
+    FrameStatus frame_status = FRAME_OK;
+    if (!valid)
+    {
+      frame_status = FRAME_LOST;
+      ++lost_frames;
+    }
+    else if (check_repeated && prev_frame_valid_ && memcmp(status, prev_status, size) == 0)
+    {
+      frame_status = FRAME_REPEATED;
+      ++repeated_frames;
+    }
+    prev_frame_valid_ = valid;
+
+    if (frame_status == FRAME_OK)
+    {
+      if (fault())
+      {
+        SR_RT_LOG_INFO("Frames received again after %u missed frames", missed_frames_);
+      }
+      missed_frames_ = 0;
+      return frame_status;
+    }
+
+    if (++missed_frames_ == max_lost_frames_)
+    {
+      ++faults;
+      SR_RT_LOG_ERROR("%u frames missed in a row: nullifying the demands", missed_frames_);
+    }
+    return frame_status;
+  }
+
+  double FrameMonitor::filter_time(double timestamp)
+  {
+    if (last_timestamp_ == 0.0)
+    {
+      filter_time_ = timestamp;
+    }
+    else
+    {
+      double cycles = std::floor((timestamp - last_timestamp_) / cycle_period_ + 0.5);
+      filter_time_ += std::max(cycles, 1.0) * cycle_period_;
+    }
+    last_timestamp_ = timestamp;
+    return filter_time_;
+  }
+}  // namespace shadow_robot
+
+/* For the emacs weenies in the crowd.
+Local Variables:
+   c-basic-offset: 2
+End:
+*/
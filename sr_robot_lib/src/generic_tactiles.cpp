@@ -26,9 +26,11 @@
  */
 
 #include "sr_robot_lib/generic_tactiles.hpp"
+#include "sr_robot_lib/rt_logger.hpp"
 #include <sr_utilities/sr_math_utils.hpp>
 #include <cctype>
 #include <string>
+#include <sstream>
 #include <vector>
 
 // NOTE: The length used in this generic tactile class (that is used to obtain common information to determine
@@ -48,7 +50,9 @@ namespace tactiles
                                         std::vector<generic_updater::UpdateConfig> update_configs_vector,
                                         operation_mode::device_update_state::DeviceUpdateState update_state)
           : nodehandle_(nh),
-            device_id_(device_id)
+            device_id_(device_id),
+            ids_changed_(false),
+            raw_software_versions_(nb_tactiles)
   {
     sensor_updater = boost::shared_ptr<generic_updater::SensorUpdater<CommandType> >(
             new generic_updater::SensorUpdater<CommandType>(update_configs_vector, update_state));
@@ -76,7 +80,7 @@ namespace tactiles
     // @todo use memcopy instead?
     for (unsigned int id_sensor = 0; id_sensor < nb_tactiles; ++id_sensor)
     {
-      ROS_DEBUG_STREAM(" received: " << static_cast<int32u>(status_data->tactile_data_type));
+      SR_RT_LOG_DEBUG(" received: %u", static_cast<int32u>(status_data->tactile_data_type));
 
       switch (static_cast<int32u>(status_data->tactile_data_type))
       {
@@ -89,7 +93,7 @@ namespace tactiles
               tactiles_vector->at(id_sensor).which_sensor =
                       static_cast<unsigned int>(static_cast<int16u>(status_data->tactile[id_sensor].word[0]));
             }
-            ROS_DEBUG_STREAM(" tact[" << id_sensor << "] = " << tactiles_vector->at(id_sensor).which_sensor);
+            SR_RT_LOG_DEBUG(" tact[%u] = %u", id_sensor, tactiles_vector->at(id_sensor).which_sensor);
           }
           break;
 
@@ -108,8 +112,8 @@ namespace tactiles
         {
           if (sr_math_utils::is_bit_mask_index_true(tactile_mask, id_sensor))
           {
-            tactiles_vector->at(id_sensor).manufacturer = sanitise_string(status_data->tactile[id_sensor].string,
-                                                                          TACTILE_DATA_LENGTH_BYTES);
+            update_id_string(tactiles_vector->at(id_sensor).manufacturer, status_data->tactile[id_sensor].string,
+                             TACTILE_DATA_LENGTH_BYTES);
           }
         }
           break;
@@ -118,8 +122,8 @@ namespace tactiles
         {
           if (sr_math_utils::is_bit_mask_index_true(tactile_mask, id_sensor))
           {
-            tactiles_vector->at(id_sensor).serial_number = sanitise_string(status_data->tactile[id_sensor].string,
-                                                                           TACTILE_DATA_LENGTH_BYTES);
+            update_id_string(tactiles_vector->at(id_sensor).serial_number, status_data->tactile[id_sensor].string,
+                             TACTILE_DATA_LENGTH_BYTES);
           }
         }
           break;
@@ -129,7 +133,8 @@ namespace tactiles
           {
             if (tactiles_vector != NULL)
             {
-              tactiles_vector->at(id_sensor).set_software_version(status_data->tactile[id_sensor].string);
+              update_software_version(tactiles_vector->at(id_sensor), id_sensor,
+                                      status_data->tactile[id_sensor].string, TACTILE_DATA_LENGTH_BYTES);
             }
           }
           break;
@@ -139,8 +144,8 @@ namespace tactiles
           {
             if (tactiles_vector != NULL)
             {
-              tactiles_vector->at(id_sensor).pcb_version = sanitise_string(status_data->tactile[id_sensor].string,
-                                                                           TACTILE_DATA_LENGTH_BYTES);
+              update_id_string(tactiles_vector->at(id_sensor).pcb_version, status_data->tactile[id_sensor].string,
+                               TACTILE_DATA_LENGTH_BYTES);
             }
           }
           break;
@@ -185,7 +190,8 @@ namespace tactiles
 
   template<class StatusType, class CommandType>
   void GenericTactiles<StatusType, CommandType>::add_diagnostics(std::vector<diagnostic_msgs::DiagnosticStatus> &vec,
-                                                                 diagnostic_updater::DiagnosticStatusWrapper &d)
+                                                                 diagnostic_updater::DiagnosticStatusWrapper &d,
+                                                                 const shadow_robot::HandStateSnapshot &snapshot)
   {
     // We don't publish diagnostics during the initialization phase
   }
@@ -234,12 +240,59 @@ namespace tactiles
     return sanitised_string;
   }
 
+  template<class StatusType, class CommandType>
+  void GenericTactiles<StatusType, CommandType>::update_id_string(std::string &id, const char *raw_string,
+                                                                  const unsigned int str_size)
+  {
+    std::string value = sanitise_string(raw_string, str_size);
+    if (value != id)
+    {
+      id.swap(value);
+      ids_changed_ = true;
+    }
+  }
+
+  template<class StatusType, class CommandType>
+  void GenericTactiles<StatusType, CommandType>::update_software_version(GenericTactileData &data,
+                                                                         unsigned int id_sensor,
+                                                                         const char *raw_string,
+                                                                         const unsigned int str_size)
+  {
+    std::string &raw_software_version = raw_software_versions_[id_sensor];
+    if (raw_software_version.compare(0, std::string::npos, raw_string, str_size) != 0)
+    {
+      raw_software_version.assign(raw_string, str_size);
+      data.set_software_version(raw_string);
+      ids_changed_ = true;
+    }
+  }
+
   template<class StatusType, class CommandType>
   std::vector<AllTactileData> *GenericTactiles<StatusType, CommandType>::get_tactile_data()
   {
     return all_tactile_data.get();
   }
 
+  template<class StatusType, class CommandType>
+  shadow_robot::CachedDiagnosticStatus &GenericTactiles<StatusType, CommandType>::get_tactile_diagnostics(
+          unsigned int id_tact)
+  {
+    if (tactile_diagnostics_.empty())
+    {
+      // the names don't change, build them only once
+      tactile_diagnostics_.resize(nb_tactiles);
+      std::string prefix = device_id_.empty() ? device_id_ : (device_id_ + " ");
+      for (unsigned int i = 0; i < nb_tactiles; ++i)
+      {
+        std::stringstream ss;
+        ss << prefix << "Tactile " << i + 1;
+        tactile_diagnostics_[i].status.name = ss.str();
+      }
+    }
+
+    return tactile_diagnostics_[id_tact];
+  }
+
   // Only to ensure that the template class is compiled for the types we are interested in
   template
   class GenericTactiles<ETHERCAT_DATA_STRUCTURE_0200_PALM_EDC_STATUS, ETHERCAT_DATA_STRUCTURE_0200_PALM_EDC_COMMAND>;
@@ -247,6 +300,9 @@ namespace tactiles
   template
   class GenericTactiles<ETHERCAT_DATA_STRUCTURE_0230_PALM_EDC_STATUS, ETHERCAT_DATA_STRUCTURE_0230_PALM_EDC_COMMAND>;
 
+  template
+  class GenericTactiles<ETHERCAT_DATA_STRUCTURE_0240_PALM_EDC_STATUS, ETHERCAT_DATA_STRUCTURE_0240_PALM_EDC_COMMAND>;
+
   template
   class GenericTactiles<ETHERCAT_DATA_STRUCTURE_0300_PALM_EDC_STATUS, ETHERCAT_DATA_STRUCTURE_0300_PALM_EDC_COMMAND>;
 }  // namespace tactiles
@@ -37,7 +37,7 @@ namespace generic_updater
   GenericUpdater<CommandType>::GenericUpdater(std::vector<UpdateConfig> update_configs_vector,
                                               operation_mode::device_update_state::DeviceUpdateState update_state)
           : nh_tilde("~"), which_data_to_request(0), update_state(update_state), update_configs_vector(
-          update_configs_vector)
+          update_configs_vector), unimportant_rate_divider(1)
   {
     mutex = boost::shared_ptr<boost::mutex>(new boost::mutex());
 
@@ -85,6 +85,26 @@ namespace generic_updater
     }
   }
 
+  template<class CommandType>
+  void GenericUpdater<CommandType>::set_unimportant_rate_divider(unsigned int divider)
+  {
+    if (divider == unimportant_rate_divider)
+    {
+      return;
+    }
+    unimportant_rate_divider = divider;
+
+    // the timers were created in the order of the unimportant configs
+    size_t timer_index = 0;
+    BOOST_FOREACH(UpdateConfig config, update_configs_vector)
+          {
+            if (config.when_to_update != -2.0 && config.when_to_update != -1.0 && timer_index < timers.size())
+            {
+              timers[timer_index++].setPeriod(ros::Duration(config.when_to_update * divider));
+            }
+          }
+  }
+
   // Only to ensure that the template class is compiled for the types we are interested in
   template
   class GenericUpdater<ETHERCAT_DATA_STRUCTURE_0200_PALM_EDC_COMMAND>;
@@ -92,6 +112,9 @@ namespace generic_updater
   template
   class GenericUpdater<ETHERCAT_DATA_STRUCTURE_0230_PALM_EDC_COMMAND>;
 
+  template
+  class GenericUpdater<ETHERCAT_DATA_STRUCTURE_0240_PALM_EDC_COMMAND>;
+
   template
   class GenericUpdater<ETHERCAT_DATA_STRUCTURE_0300_PALM_EDC_COMMAND>;
 }  // end namespace generic_updater
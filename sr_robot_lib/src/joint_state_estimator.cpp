@@ -0,0 +1,188 @@
+/**
+ * @file   joint_state_estimator.cpp
+ * @author Shadow Robot Software Team <software@shadowrobot.com>
+ * @date   Sun Oct 18 17:26:03 2026
+ *
+ * Copyright 2026 Shadow Robot Company Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @brief Estimates the joint states ahead of the transport delay.
+ *
+ *
+ */
+
+#include "sr_robot_lib/joint_state_estimator.hpp"
+#include <algorithm>
+
+namespace shadow_robot
+{
+  // the initial uncertainty of the states which aren't measured
+  static const double initial_velocity_variance = 1.0;
+  static const double initial_acceleration_variance = 1.0e4;
+  static const double initial_effort_variance = 1.0e8;
+
+  JointStateEstimator::JointStateEstimator(ros::NodeHandle nh_tilde, double cycle_period)
+          : initialized_(false),
+            last_time_(0.0),
+            p_pp_(0.0),
+            p_pv_(0.0),
+            p_pa_(0.0),
+            p_vv_(0.0),
+            p_va_(0.0),
+            p_aa_(0.0)
+  {
+    nh_tilde.param("joint_estimator/enabled", enabled_, false);
+    // the positions reach the controllers one cycle after they were sampled
+    nh_tilde.param("joint_estimator/delay", delay_, cycle_period);
+    double position_noise, jerk_noise, effort_noise, effort_acceleration_noise;
+    // standard deviations of the measurements (in rad and in raw effort units)
+    nh_tilde.param("joint_estimator/position_noise", position_noise, 0.002);
+    nh_tilde.param("joint_estimator/effort_noise", effort_noise, 10.0);
+    // how fast the acceleration and the effort rate can change
+    nh_tilde.param("joint_estimator/jerk_noise", jerk_noise, 300.0);
+    nh_tilde.param("joint_estimator/effort_acceleration_noise", effort_acceleration_noise, 3000.0);
+    position_variance_ = position_noise * position_noise;
+    effort_variance_ = effort_noise * effort_noise;
+    jerk_density_ = jerk_noise * jerk_noise;
+    effort_acceleration_density_ = effort_acceleration_noise * effort_acceleration_noise;
+
+    if (enabled_)
+    {
+      ROS_INFO("Joint state estimator enabled: states estimated %.2fms ahead", delay_ * 1000.0);
+    }
+  }
+
+  void JointStateEstimator::resize(unsigned int nb_joints)
+  {
+    measured_positions_.assign(nb_joints, 0.0);
+    measured_efforts_.assign(nb_joints, 0.0);
+    effort_measured_.assign(nb_joints, 0.0);
+    positions_.assign(nb_joints, 0.0);
+    velocities_.assign(nb_joints, 0.0);
+    accelerations_.assign(nb_joints, 0.0);
+    efforts_.assign(nb_joints, 0.0);
+    effort_rates_.assign(nb_joints, 0.0);
+    p_ff_.assign(nb_joints, initial_effort_variance);
+    p_fr_.assign(nb_joints, 0.0);
+    p_rr_.assign(nb_joints, initial_effort_variance);
+    initialized_ = false;
+  }
+
+  void JointStateEstimator::initialize()
+  {
+    std::copy(measured_positions_.begin(), measured_positions_.end(), positions_.begin());
+    std::fill(velocities_.begin(), velocities_.end(), 0.0);
+    std::fill(accelerations_.begin(), accelerations_.end(), 0.0);
+    p_pp_ = position_variance_;
+    p_vv_ = initial_velocity_variance;
+    p_aa_ = initial_acceleration_variance;
+    p_pv_ = p_pa_ = p_va_ = 0.0;
+    initialized_ = true;
+  }
+
+  void JointStateEstimator::update(double time)
+  {
+    if (positions_.empty())
+    {
+      return;
+    }
+
+    const double dt = initialized_ ? std::max(time - last_time_, 0.0) : 0.0;
+    last_time_ = time;
+    if (!initialized_)
+    {
+      initialize();
+    }
+
+    const double dt2 = dt * dt;
+    const double dt3 = dt2 * dt;
+    const double half_dt2 = 0.5 * dt2;
+    const size_t nb_joints = positions_.size();
+
+    // predict the position covariance: P = F P F' + Q, with F the constant acceleration model
+    const double a00 = p_pp_ + dt * p_pv_ + half_dt2 * p_pa_;
+    const double a01 = p_pv_ + dt * p_vv_ + half_dt2 * p_va_;
+    const double a02 = p_pa_ + dt * p_va_ + half_dt2 * p_aa_;
+    const double a11 = p_vv_ + dt * p_va_;
+    const double a12 = p_va_ + dt * p_aa_;
+    double p_pp = a00 + dt * a01 + half_dt2 * a02 + jerk_density_ * dt3 * dt2 / 20.0;
+    double p_pv = a01 + dt * a02 + jerk_density_ * dt2 * dt2 / 8.0;
+    double p_pa = a02 + jerk_density_ * dt3 / 6.0;
+    double p_vv = a11 + dt * a12 + jerk_density_ * dt3 / 3.0;
+    double p_va = a12 + jerk_density_ * half_dt2;
+    double p_aa = p_aa_ + jerk_density_ * dt;
+
+    // the same gains for all the joints
+    const double k_p = p_pp / (p_pp + position_variance_);
+    const double k_v = p_pv / (p_pp + position_variance_);
+    const double k_a = p_pa / (p_pp + position_variance_);
+    p_pp_ = p_pp - k_p * p_pp;
+    p_pv_ = p_pv - k_p * p_pv;
+    p_pa_ = p_pa - k_p * p_pa;
+    p_vv_ = p_vv - k_v * p_pv;
+    p_va_ = p_va - k_v * p_pa;
+    p_aa_ = p_aa - k_a * p_pa;
+
+    double *positions = &positions_[0];
+    double *velocities = &velocities_[0];
+    double *accelerations = &accelerations_[0];
+    const double *measured_positions = &measured_positions_[0];
+    for (size_t i = 0; i < nb_joints; ++i)
+    {
+      const double position = positions[i] + dt * velocities[i] + half_dt2 * accelerations[i];
+      const double velocity = velocities[i] + dt * accelerations[i];
+      const double innovation = measured_positions[i] - position;
+      positions[i] = position + k_p * innovation;
+      velocities[i] = velocity + k_v * innovation;
+      accelerations[i] += k_a * innovation;
+    }
+
+    // the efforts have their own covariances, as they're not measured in the same frames
+    double *efforts = &efforts_[0];
+    double *effort_rates = &effort_rates_[0];
+    double *p_ff = &p_ff_[0];
+    double *p_fr = &p_fr_[0];
+    double *p_rr = &p_rr_[0];
+    double *effort_measured = &effort_measured_[0];
+    const double *measured_efforts = &measured_efforts_[0];
+    const double q_ff = effort_acceleration_density_ * dt3 / 3.0;
+    const double q_fr = effort_acceleration_density_ * half_dt2;
+    const double q_rr = effort_acceleration_density_ * dt;
+    for (size_t i = 0; i < nb_joints; ++i)
+    {
+      const double effort = efforts[i] + dt * effort_rates[i];
+      const double pred_ff = p_ff[i] + dt * (2.0 * p_fr[i] + dt * p_rr[i]) + q_ff;
+      const double pred_fr = p_fr[i] + dt * p_rr[i] + q_fr;
+      const double pred_rr = p_rr[i] + q_rr;
+
+      // no correction if the effort wasn't measured
+      const double k_f = effort_measured[i] * pred_ff / (pred_ff + effort_variance_);
+      const double k_r = effort_measured[i] * pred_fr / (pred_ff + effort_variance_);
+      const double innovation = measured_efforts[i] - effort;
+      efforts[i] = effort + k_f * innovation;
+      effort_rates[i] += k_r * innovation;
+      p_ff[i] = pred_ff - k_f * pred_ff;
+      p_fr[i] = pred_fr - k_f * pred_fr;
+      p_rr[i] = pred_rr - k_r * pred_fr;
+      effort_measured[i] = 0.0;
+    }
+  }
+}  // namespace shadow_robot
+
+/* For the emacs weenies in the crowd.
+Local Variables:
+   c-basic-offset: 2
+End:
+*/
@@ -0,0 +1,169 @@
+/**
+ * @file   load_governor.cpp
+ * @author Shadow Robot Software Team <software@shadowrobot.com>
+ * @date   Sun Oct 18 23:41:12 2026
+ *
+ * Copyright 2026 Shadow Robot Company Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @brief Sheds the telemetry load when the palm or the host run out of time.
+ *
+ *
+ */
+
+#include "sr_robot_lib/load_governor.hpp"
+#include "sr_robot_lib/rt_logger.hpp"
+#include <algorithm>
+#include <string>
+#include <time.h>
+
+namespace shadow_robot
+{
+  static const char *stage_names[LoadGovernor::NB_STAGES] = {"publishing", "tactile_data", "motor_data"};
+
+  LoadGovernor::LoadGovernor(ros::NodeHandle nh_tilde)
+          : shed_stages_(0),
+            nb_shed_stages_(0),
+            processing_start_us_(0.0),
+            cycle_processing_time_us_(0.0),
+            window_cycle_(0),
+            window_idle_time_us_(0.0),
+            window_processing_time_us_(0.0),
+            headroom_windows_(0)
+  {
+    nh_tilde.param("load_governor/enabled", enabled_, false);
+    // the palm should idle more than 50us
+    nh_tilde.param("load_governor/idle_time_low_us", idle_time_low_us_, 50.0);
+    nh_tilde.param("load_governor/idle_time_high_us", idle_time_high_us_, 100.0);
+    nh_tilde.param("load_governor/processing_time_high_us", processing_time_high_us_, 300.0);
+    nh_tilde.param("load_governor/processing_time_low_us", processing_time_low_us_, 200.0);
+    int window_cycles, recovery_windows, rate_divider;
+    nh_tilde.param("load_governor/window_cycles", window_cycles, 100);
+    nh_tilde.param("load_governor/recovery_windows", recovery_windows, 10);
+    nh_tilde.param("load_governor/rate_divider", rate_divider, 4);
+    window_cycles_ = std::max(window_cycles, 1);
+    recovery_windows_ = std::max(recovery_windows, 1);
+    rate_divider_ = std::max(rate_divider, 1);
+
+    std::vector<std::string> default_order;
+    for (int stage = 0; stage < NB_STAGES; ++stage)
+    {
+      default_order.push_back(stage_names[stage]);
+    }
+    std::vector<std::string> order;
+    nh_tilde.param("load_governor/shedding_order", order, default_order);
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+      int stage = 0;
+      while (stage < NB_STAGES && order[i] != stage_names[stage])
+      {
+        ++stage;
+      }
+      if (stage == NB_STAGES)
+      {
+        ROS_WARN("Unknown load shedding stage: %s", order[i].c_str());
+        continue;
+      }
+      shedding_order_.push_back(static_cast<Stage>(stage));
+    }
+
+    if (enabled_)
+    {
+      ROS_INFO("Load governor enabled: %zu stages, rates divided by %u when shed", shedding_order_.size(),
+               rate_divider_);
+    }
+  }
+
+  double LoadGovernor::monotonic_us()
+  {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<double>(now.tv_sec) * 1.0e6 + static_cast<double>(now.tv_nsec) / 1.0e3;
+  }
+
+  void LoadGovernor::start_processing()
+  {
+    if (enabled_)
+    {
+      processing_start_us_ = monotonic_us();
+    }
+  }
+
+  void LoadGovernor::end_processing()
+  {
+    if (enabled_)
+    {
+      cycle_processing_time_us_ += monotonic_us() - processing_start_us_;
+    }
+  }
+
+  void LoadGovernor::sample(int palm_idle_time_us)
+  {
+    if (!enabled_)
+    {
+      return;
+    }
+
+    window_idle_time_us_ += palm_idle_time_us;
+    window_processing_time_us_ += cycle_processing_time_us_;
+    cycle_processing_time_us_ = 0.0;
+
+    if (++window_cycle_ < window_cycles_)
+    {
+      return;
+    }
+
+    end_window(window_idle_time_us_ / window_cycles_, window_processing_time_us_ / window_cycles_);
+    window_cycle_ = 0;
+    window_idle_time_us_ = 0.0;
+    window_processing_time_us_ = 0.0;
+  }
+
+  void LoadGovernor::end_window(double idle_time_us, double processing_time_us)
+  {
+    if (idle_time_us < idle_time_low_us_ || processing_time_us > processing_time_high_us_)
+    {
+      headroom_windows_ = 0;
+      if (nb_shed_stages_ < shedding_order_.size())
+      {
+        Stage stage = shedding_order_[nb_shed_stages_++];
+        shed_stages_.fetch_or(1 << stage, boost::memory_order_relaxed);
+        SR_RT_LOG_WARN("Load shedding %s (palm idle time %.0fus, host processing time %.0fus)",
+                       stage_names[stage], idle_time_us, processing_time_us);
+      }
+      return;
+    }
+
+    if (nb_shed_stages_ == 0 || idle_time_us < idle_time_high_us_ || processing_time_us > processing_time_low_us_)
+    {
+      headroom_windows_ = 0;
+      return;
+    }
+
+    if (++headroom_windows_ >= recovery_windows_)
+    {
+      headroom_windows_ = 0;
+      Stage stage = shedding_order_[--nb_shed_stages_];
+      shed_stages_.fetch_and(~(1 << stage), boost::memory_order_relaxed);
+      SR_RT_LOG_INFO("Load shedding: %s restored", stage_names[stage]);
+    }
+  }
+}  // namespace shadow_robot
+
+/* For the emacs weenies in the crowd.
+Local Variables:
+   c-basic-offset: 2
+End:
+*/
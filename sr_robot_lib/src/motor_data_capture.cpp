@@ -0,0 +1,140 @@
+/**
+ * @file   motor_data_capture.cpp
+ * @author Shadow Robot Software Team <software@shadowrobot.com>
+ * @date   Sun Oct 18 23:04:37 2026
+ *
+ * Copyright 2026 Shadow Robot Company Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @brief Records the motor data received during a capture window.
+ *
+ *
+ */
+
+#include "sr_robot_lib/motor_data_capture.hpp"
+#include <cmath>
+
+namespace shadow_robot
+{
+  const double MotorDataCapture::max_duration = 10.0;
+
+  MotorDataCapture::MotorDataCapture(ros::NodeHandle nh, double cycle_period)
+          : state_(IDLE),
+            cycle_period_(cycle_period),
+            motors_(0),
+            data_types_(0),
+            duration_(0.0),
+            nb_samples_(0),
+            dropped_samples_(0),
+            end_stamp_(0.0)
+  {
+    publisher_ = nh.advertise<sr_robot_lib::MotorDataSamples>("motor_data_capture", 1);
+  }
+
+  bool MotorDataCapture::start(int32u motors, const std::vector<int32u> &data_types, double duration)
+  {
+    if (state_.load(boost::memory_order_acquire) != IDLE)
+    {
+      return false;
+    }
+
+    motors_ = motors;
+    data_types_ = 0;
+    for (size_t i = 0; i < data_types.size(); ++i)
+    {
+      data_types_ |= 1 << data_types[i];
+    }
+    duration_ = duration;
+
+    unsigned int nb_motors = 0;
+    for (int32u remaining = motors; remaining != 0; remaining &= remaining - 1)
+    {
+      ++nb_motors;
+    }
+    samples_.resize(static_cast<size_t>(std::ceil(duration / cycle_period_)) * nb_motors);
+    nb_samples_ = 0;
+    dropped_samples_ = 0;
+    end_stamp_ = 0.0;
+
+    state_.store(CAPTURING, boost::memory_order_release);
+    return true;
+  }
+
+  void MotorDataCapture::new_cycle(double stamp)
+  {
+    if (state_.load(boost::memory_order_acquire) != CAPTURING)
+    {
+      return;
+    }
+
+    if (end_stamp_ == 0.0)
+    {
+      // first cycle of the capture
+      end_stamp_ = stamp + duration_;
+    }
+    else if (stamp >= end_stamp_)
+    {
+      state_.store(FINISHED, boost::memory_order_release);
+    }
+  }
+
+  void MotorDataCapture::push(double stamp, int motor_id, int32u data_type, int16s torque, int16u value)
+  {
+    if (nb_samples_ >= samples_.size())
+    {
+      ++dropped_samples_;
+      return;
+    }
+
+    Sample &sample = samples_[nb_samples_++];
+    sample.stamp = stamp;
+    sample.motor_id = static_cast<int8u>(motor_id);
+    sample.data_type = static_cast<int8u>(data_type);
+    sample.torque = torque;
+    sample.value = value;
+  }
+
+  void MotorDataCapture::publish()
+  {
+    msg_.stamps.resize(nb_samples_);
+    msg_.motor_ids.resize(nb_samples_);
+    msg_.data_types.resize(nb_samples_);
+    msg_.torques.resize(nb_samples_);
+    msg_.values.resize(nb_samples_);
+    for (size_t i = 0; i < nb_samples_; ++i)
+    {
+      msg_.stamps[i] = ros::Time(samples_[i].stamp);
+      msg_.motor_ids[i] = samples_[i].motor_id;
+      msg_.data_types[i] = samples_[i].data_type;
+      msg_.torques[i] = samples_[i].torque;
+      msg_.values[i] = samples_[i].value;
+    }
+    publisher_.publish(msg_);
+
+    if (dropped_samples_ > 0)
+    {
+      ROS_WARN("%u motor data samples weren't captured (buffer full)", dropped_samples_);
+    }
+    ROS_INFO("Motor data capture finished: %zu samples", nb_samples_);
+
+    state_.store(IDLE, boost::memory_order_release);
+  }
+}  // namespace shadow_robot
+
+/* For the emacs weenies in the crowd.
+Local Variables:
+   c-basic-offset: 2
+End:
+*/
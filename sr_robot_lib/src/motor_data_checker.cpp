@@ -25,6 +25,7 @@
  */
 
 #include "sr_robot_lib/motor_data_checker.hpp"
+#include "sr_robot_lib/rt_logger.hpp"
 #include <vector>
 
 namespace generic_updater
@@ -111,7 +112,7 @@ namespace generic_updater
           }
           else
           {
-            ROS_ERROR_STREAM("Checker conversion failed");
+            SR_RT_LOG_ERROR("Checker conversion failed");
           }
         }
         else
@@ -121,7 +122,7 @@ namespace generic_updater
       }
       else
       {
-        ROS_ERROR_STREAM("Motor id not found: " << motor_wrapper->motor_id);
+        SR_RT_LOG_ERROR("Motor id not found: %d", motor_wrapper->motor_id);
       }
     }
     return ((update_state == operation_mode::device_update_state::OPERATION) || is_everything_checked());
@@ -199,7 +200,7 @@ namespace generic_updater
       // Check the slow data type as received
       if (slow_data_type > MOTOR_SLOW_DATA_LAST)
       {
-        ROS_ERROR_STREAM("Received bad slow_data_type: " << slow_data_type << " > " << slow_data_received.size());
+        SR_RT_LOG_ERROR("Received bad slow_data_type: %d > %zu", slow_data_type, slow_data_received.size());
         return;
       }
       slow_data_received.at(slow_data_type) = true;
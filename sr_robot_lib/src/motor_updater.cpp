@@ -27,6 +27,7 @@
  */
 
 #include "sr_robot_lib/motor_updater.hpp"
+#include "sr_robot_lib/rt_logger.hpp"
 #include <boost/foreach.hpp>
 #include <iostream>
 #include <vector>
@@ -36,8 +37,66 @@ namespace generic_updater
   template<class CommandType>
   MotorUpdater<CommandType>::MotorUpdater(std::vector<UpdateConfig> update_configs_vector,
                                           operation_mode::device_update_state::DeviceUpdateState update_state)
-          : GenericUpdater<CommandType>(update_configs_vector, update_state), even_motors(1)
+          : GenericUpdater<CommandType>(update_configs_vector, update_state), even_motors(1),
+            all_motors_(0), next_capture_slot_(0), capture_frame_(false)
   {
+    motors_present_[0] = 0;
+    motors_present_[1] = 0;
+  }
+
+  template<class CommandType>
+  void MotorUpdater<CommandType>::set_motors_present(int32u motors_present)
+  {
+    boost::mutex::scoped_lock l(*(this->mutex));
+
+    for (int parity = 0; parity < 2; ++parity)
+    {
+      motors_present_[parity] = WHICH_MOTORS_PRESENCE_VALID;
+      for (int motor = parity; motor < NUM_MOTORS; motor += 2)
+      {
+        if (motors_present & (1 << motor))
+        {
+          motors_present_[parity] |= 1 << (WHICH_MOTORS_PRESENCE_SHIFT + motor / 2);
+        }
+      }
+    }
+  }
+
+  template<class CommandType>
+  void MotorUpdater<CommandType>::set_all_motors(bool all_motors)
+  {
+    boost::mutex::scoped_lock l(*(this->mutex));
+
+    all_motors_ = all_motors ? WHICH_MOTORS_ALL : 0;
+  }
+
+  template<class CommandType>
+  void MotorUpdater<CommandType>::start_capture(int32u motors, const std::vector<int32u> &data_types)
+  {
+    boost::mutex::scoped_lock l(*(this->mutex));
+
+    capture_slots_.clear();
+    for (size_t i = 0; i < data_types.size(); ++i)
+    {
+      for (int parity = 0; parity < (all_motors_ ? 1 : 2); ++parity)
+      {
+        // only poll the even (or odd) motors if some of them are captured (all of them answer in all motors mode)
+        if (all_motors_ || (motors & (parity ? 0xAAAAAAAA : 0x55555555)))
+        {
+          capture_slots_.push_back(std::pair<int, int32u>(parity, data_types[i]));
+        }
+      }
+    }
+    next_capture_slot_ = 0;
+    capture_frame_ = false;
+  }
+
+  template<class CommandType>
+  void MotorUpdater<CommandType>::stop_capture()
+  {
+    boost::mutex::scoped_lock l(*(this->mutex));
+
+    capture_slots_.clear();
   }
 
   template<class CommandType>
@@ -68,14 +127,14 @@ namespace generic_updater
         }
       }
 
-      command->which_motors = even_motors;
+      command->which_motors = even_motors | motors_present_[even_motors];
 
       // initialization data
       command->from_motor_data_type =
               static_cast<FROM_MOTOR_DATA_TYPE>(
                       this->initialization_configs_vector[this->which_data_to_request].what_to_update);
-      ROS_DEBUG_STREAM("Updating initialization data type: " << command->from_motor_data_type << " | [" <<
-                       this->which_data_to_request << "/" << this->initialization_configs_vector.size() << "] ");
+      SR_RT_LOG_DEBUG("Updating initialization data type: %d | [%d/%zu] ", command->from_motor_data_type,
+                      this->which_data_to_request, this->initialization_configs_vector.size());
     }
     else
     {
@@ -83,11 +142,11 @@ namespace generic_updater
       // (after that we use build_command instead of build_init_command)
       // we use the first important message and ask it to the even motors (0)
       // This is to avoid sending a random command
-      command->which_motors = 0;
+      command->which_motors = motors_present_[0];
       command->from_motor_data_type =
               static_cast<FROM_MOTOR_DATA_TYPE>(this->important_update_configs_vector[0].what_to_update);
-      ROS_DEBUG_STREAM("Updating important data type: " << command->from_motor_data_type << " | [" <<
-                       this->which_data_to_request << "/" << this->important_update_configs_vector.size() << "] ");
+      SR_RT_LOG_DEBUG("Updating important data type: %d | [%d/%zu] ", command->from_motor_data_type,
+                      this->which_data_to_request, this->important_update_configs_vector.size());
     }
 
     this->mutex->unlock();
@@ -103,6 +162,24 @@ namespace generic_updater
       return this->update_state;
     }
 
+    if (!capture_slots_.empty())
+    {
+      // one frame out of two polls the data being captured
+      capture_frame_ = !capture_frame_;
+      if (capture_frame_)
+      {
+        const std::pair<int, int32u> &slot = capture_slots_[next_capture_slot_];
+        next_capture_slot_ = (next_capture_slot_ + 1) % capture_slots_.size();
+
+        command->which_motors = slot.first | motors_present_[slot.first] | all_motors_;
+        command->from_motor_data_type = static_cast<FROM_MOTOR_DATA_TYPE>(slot.second);
+        SR_RT_LOG_DEBUG("Capturing data type: %d | motors: %d", command->from_motor_data_type, slot.first);
+
+        this->mutex->unlock();
+        return this->update_state;
+      }
+    }
+
     ///////
     // First we ask for the next data we want to receive
     if (even_motors)
@@ -112,6 +189,12 @@ namespace generic_updater
     else
     {
       even_motors = 1;
+    }
+
+    // the odd motors get the data the even motors got in the previous frame, unless all the
+    // motors send their data in every frame (the parity then only selects the presence bits sent)
+    if (even_motors || all_motors_)
+    {
       this->which_data_to_request++;
 
       if (this->which_data_to_request >= this->important_update_configs_vector.size())
@@ -120,7 +203,7 @@ namespace generic_updater
       }
     }
 
-    command->which_motors = even_motors;
+    command->which_motors = even_motors | motors_present_[even_motors] | all_motors_;
 
     if (!this->unimportant_data_queue.empty())
     {
@@ -128,8 +211,8 @@ namespace generic_updater
       command->from_motor_data_type = static_cast<FROM_MOTOR_DATA_TYPE>(this->unimportant_data_queue.front());
       this->unimportant_data_queue.pop();
 
-      ROS_DEBUG_STREAM("Updating unimportant data type: " << command->from_motor_data_type << " | queue size: " <<
-                       this->unimportant_data_queue.size());
+      SR_RT_LOG_DEBUG("Updating unimportant data type: %d | queue size: %zu", command->from_motor_data_type,
+                      this->unimportant_data_queue.size());
     }
     else
     {
@@ -137,8 +220,8 @@ namespace generic_updater
       command->from_motor_data_type =
               static_cast<FROM_MOTOR_DATA_TYPE>(
                       this->important_update_configs_vector[this->which_data_to_request].what_to_update);
-      ROS_DEBUG_STREAM("Updating important data type: " << command->from_motor_data_type << " | [" <<
-                       this->which_data_to_request << "/" << this->important_update_configs_vector.size() << "] ");
+      SR_RT_LOG_DEBUG("Updating important data type: %d | [%d/%zu] ", command->from_motor_data_type,
+                      this->which_data_to_request, this->important_update_configs_vector.size());
     }
 
     this->mutex->unlock();
@@ -152,6 +235,9 @@ namespace generic_updater
 
   template
   class MotorUpdater<ETHERCAT_DATA_STRUCTURE_0230_PALM_EDC_COMMAND>;
+
+  template
+  class MotorUpdater<ETHERCAT_DATA_STRUCTURE_0240_PALM_EDC_COMMAND>;
 }  // namespace generic_updater
 
 
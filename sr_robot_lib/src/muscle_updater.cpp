@@ -27,6 +27,7 @@
  */
 
 #include "sr_robot_lib/muscle_updater.hpp"
+#include "sr_robot_lib/rt_logger.hpp"
 #include <boost/foreach.hpp>
 #include <iostream>
 #include <vector>
@@ -66,8 +67,8 @@ namespace generic_updater
               static_cast<FROM_MUSCLE_DATA_TYPE>(
                       this->initialization_configs_vector[this->which_data_to_request].what_to_update);
 
-      ROS_DEBUG_STREAM("Updating initialization data type: " << command->from_muscle_data_type << " | [" <<
-                       this->which_data_to_request << "/" << this->initialization_configs_vector.size() << "] ");
+      SR_RT_LOG_DEBUG("Updating initialization data type: %d | [%d/%zu] ", command->from_muscle_data_type,
+                      this->which_data_to_request, this->initialization_configs_vector.size());
     }
     else
     {
@@ -78,8 +79,8 @@ namespace generic_updater
       // This is to avoid sending a random command
       command->from_muscle_data_type =
               static_cast<FROM_MUSCLE_DATA_TYPE>(this->important_update_configs_vector[0].what_to_update);
-      ROS_DEBUG_STREAM("Updating important data type: " << command->from_muscle_data_type << " | [" <<
-                       this->which_data_to_request << "/" << this->important_update_configs_vector.size() << "] ");
+      SR_RT_LOG_DEBUG("Updating important data type: %d | [%d/%zu] ", command->from_muscle_data_type,
+                      this->which_data_to_request, this->important_update_configs_vector.size());
     }
 
     this->mutex->unlock();
@@ -110,8 +111,8 @@ namespace generic_updater
       command->from_muscle_data_type = static_cast<FROM_MUSCLE_DATA_TYPE>(this->unimportant_data_queue.front());
       this->unimportant_data_queue.pop();
 
-      ROS_DEBUG_STREAM("Updating unimportant data type: " << command->from_muscle_data_type << " | queue size: " <<
-                       this->unimportant_data_queue.size());
+      SR_RT_LOG_DEBUG("Updating unimportant data type: %d | queue size: %zu", command->from_muscle_data_type,
+                      this->unimportant_data_queue.size());
     }
     else
     {
@@ -119,8 +120,8 @@ namespace generic_updater
       command->from_muscle_data_type =
               static_cast<FROM_MUSCLE_DATA_TYPE>(
                       this->important_update_configs_vector[this->which_data_to_request].what_to_update);
-      ROS_DEBUG_STREAM("Updating important data type: " << command->from_muscle_data_type << " | [" <<
-                       this->which_data_to_request << "/" << this->important_update_configs_vector.size() << "] ");
+      SR_RT_LOG_DEBUG("Updating important data type: %d | [%d/%zu] ", command->from_muscle_data_type,
+                      this->which_data_to_request, this->important_update_configs_vector.size());
     }
 
     this->mutex->unlock();
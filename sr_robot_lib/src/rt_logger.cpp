@@ -0,0 +1,313 @@
+/**
+ * @file   rt_logger.cpp
+ * @author Shadow Robot Software Team <software@shadowrobot.com>
+ * @date   Sun Oct 18 18:05:44 2026
+ *
+ * Copyright 2026 Shadow Robot Company Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @brief Logging from the realtime loop.
+ *
+ *
+ */
+
+#include "sr_robot_lib/rt_logger.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <time.h>
+
+namespace shadow_robot
+{
+  const unsigned int RtLogEntry::max_args;
+  const unsigned int RtLogger::ring_size;
+  const boost::posix_time::time_duration RtLogger::drain_period_ = boost::posix_time::milliseconds(10);
+
+  namespace
+  {
+    double monotonic_now()
+    {
+      struct timespec now;
+      clock_gettime(CLOCK_MONOTONIC, &now);
+      return static_cast<double>(now.tv_sec) + static_cast<double>(now.tv_nsec) / 1.0e+9;
+    }
+
+    /// Formats a single conversion, the length modifier is replaced to match the stored argument.
+    int format_arg(char *buffer, size_t size, const char *spec, size_t spec_length, char conversion,
+                   const RtLogValue &arg)
+    {
+      // "%" + flags, width and precision + "ll" + conversion
+      char spec_buffer[32];
+      if (spec_length > sizeof(spec_buffer) - 4)
+      {
+        spec_length = sizeof(spec_buffer) - 4;
+      }
+      memcpy(spec_buffer, spec, spec_length);
+      size_t end = spec_length;
+
+      switch (conversion)
+      {
+        case 'd':
+        case 'i':
+        case 'o':
+        case 'u':
+        case 'x':
+        case 'X':
+        {
+          spec_buffer[end++] = 'l';
+          spec_buffer[end++] = 'l';
+          spec_buffer[end++] = conversion;
+          spec_buffer[end] = '\0';
+          long long value = 0;
+          if (arg.type == RtLogValue::REAL)
+          {
+            value = static_cast<long long>(arg.d);
+          }
+          else if (arg.type == RtLogValue::SIGNED || arg.type == RtLogValue::UNSIGNED)
+          {
+            value = arg.i;
+          }
+          return snprintf(buffer, size, spec_buffer, value);
+        }
+
+        case 'c':
+          spec_buffer[end++] = conversion;
+          spec_buffer[end] = '\0';
+          return snprintf(buffer, size, spec_buffer, static_cast<int>(arg.i));
+
+        case 'e':
+        case 'E':
+        case 'f':
+        case 'F':
+        case 'g':
+        case 'G':
+        {
+          spec_buffer[end++] = conversion;
+          spec_buffer[end] = '\0';
+          double value = 0.0;
+          if (arg.type == RtLogValue::REAL)
+          {
+            value = arg.d;
+          }
+          else if (arg.type == RtLogValue::SIGNED)
+          {
+            value = static_cast<double>(arg.i);
+          }
+          else if (arg.type == RtLogValue::UNSIGNED)
+          {
+            value = static_cast<double>(arg.u);
+          }
+          return snprintf(buffer, size, spec_buffer, value);
+        }
+
+        case 's':
+          spec_buffer[end++] = conversion;
+          spec_buffer[end] = '\0';
+          return snprintf(buffer, size, spec_buffer,
+                          (arg.type == RtLogValue::STRING && arg.s != NULL) ? arg.s : "(null)");
+
+        default:
+          return snprintf(buffer, size, "%%%c", conversion);
+      }
+    }
+  }  // namespace
+
+  RtLogger &RtLogger::instance()
+  {
+    static RtLogger logger;
+    return logger;
+  }
+
+  RtLogger::RtLogger()
+          : dropped_messages_(0),
+            debug_enabled_(false),
+            reported_dropped_messages_(0)
+  {
+    update_debug_enabled();
+    draining_thread_.reset(new boost::thread(boost::bind(&RtLogger::draining_loop, this)));
+  }
+
+  RtLogger::~RtLogger()
+  {
+    draining_thread_->interrupt();
+    draining_thread_->join();
+  }
+
+  void RtLogger::log(RtLogSite &site, const char *format,
+                     RtLogArg a0, RtLogArg a1, RtLogArg a2, RtLogArg a3,
+                     RtLogArg a4, RtLogArg a5, RtLogArg a6, RtLogArg a7)
+  {
+    if (site.level == ros::console::levels::Debug && !debug_enabled_.load(boost::memory_order_relaxed))
+    {
+      return;
+    }
+
+    double now = monotonic_now();
+    if (site.last_logged >= 0.0 && now - site.last_logged < site.period)
+    {
+      ++site.suppressed;
+      return;
+    }
+
+    RtLogEntry entry;
+    entry.level = site.level;
+    entry.format = format;
+    entry.suppressed = site.suppressed;
+    entry.args[0] = a0.value;
+    entry.args[1] = a1.value;
+    entry.args[2] = a2.value;
+    entry.args[3] = a3.value;
+    entry.args[4] = a4.value;
+    entry.args[5] = a5.value;
+    entry.args[6] = a6.value;
+    entry.args[7] = a7.value;
+
+    if (ring_.bounded_push(entry))
+    {
+      site.last_logged = now;
+      site.suppressed = 0;
+    }
+    else
+    {
+      dropped_messages_.fetch_add(1, boost::memory_order_relaxed);
+    }
+  }
+
+  void RtLogger::format(const RtLogEntry &entry, char *buffer, size_t size)
+  {
+    size_t length = 0;
+    unsigned int next_arg = 0;
+    const char *c = entry.format;
+
+    while (*c != '\0' && length + 1 < size)
+    {
+      if (*c != '%')
+      {
+        buffer[length++] = *c++;
+        continue;
+      }
+
+      if (c[1] == '%')
+      {
+        buffer[length++] = '%';
+        c += 2;
+        continue;
+      }
+
+      // skip the flags, width, precision and length modifier up to the conversion
+      const char *spec = c++;
+      while (*c != '\0' && strchr("-+ #0123456789.hlLqjzt", *c) != NULL)
+      {
+        ++c;
+      }
+      if (*c == '\0')
+      {
+        break;
+      }
+
+      // the length modifier is dropped from the spec, format_arg adds the one matching the argument
+      size_t spec_length = c - spec;
+      while (spec_length > 1 && strchr("hlLqjzt", spec[spec_length - 1]) != NULL)
+      {
+        --spec_length;
+      }
+
+      const RtLogValue &arg = next_arg < RtLogEntry::max_args ? entry.args[next_arg] : RtLogArg().value;
+      ++next_arg;
+
+      int written = format_arg(buffer + length, size - length, spec, spec_length, *c, arg);
+      if (written > 0)
+      {
+        length += std::min(static_cast<size_t>(written), size - length - 1);
+      }
+      ++c;
+    }
+    buffer[length] = '\0';
+
+    if (entry.suppressed > 0 && length + 1 < size)
+    {
+      snprintf(buffer + length, size - length, " (%u similar messages suppressed)", entry.suppressed);
+    }
+  }
+
+  void RtLogger::draining_loop()
+  {
+    try
+    {
+      while (true)
+      {
+        boost::this_thread::sleep(drain_period_);
+        drain();
+      }
+    }
+    catch (boost::thread_interrupted const &)
+    {
+      // the process is exiting: print what's left
+      drain();
+    }
+  }
+
+  void RtLogger::update_debug_enabled()
+  {
+    // same logger as ROS_DEBUG_NAMED("rt", ...) below
+    ROSCONSOLE_DEFINE_LOCATION(true, ::ros::console::levels::Debug, std::string(ROSCONSOLE_NAME_PREFIX) + ".rt");
+    debug_enabled_.store(__rosconsole_define_location__enabled, boost::memory_order_relaxed);
+  }
+
+  void RtLogger::drain()
+  {
+    update_debug_enabled();
+
+    char buffer[512];
+    RtLogEntry entry;
+    while (ring_.pop(entry))
+    {
+      format(entry, buffer, sizeof(buffer));
+
+      // rosconsole caches the level of each call site, hence one call per level
+      switch (entry.level)
+      {
+        case ros::console::levels::Debug:
+          ROS_DEBUG_NAMED("rt", "%s", buffer);
+          break;
+        case ros::console::levels::Info:
+          ROS_INFO_NAMED("rt", "%s", buffer);
+          break;
+        case ros::console::levels::Warn:
+          ROS_WARN_NAMED("rt", "%s", buffer);
+          break;
+        case ros::console::levels::Error:
+          ROS_ERROR_NAMED("rt", "%s", buffer);
+          break;
+        default:
+          ROS_FATAL_NAMED("rt", "%s", buffer);
+          break;
+      }
+    }
+
+    unsigned int dropped = dropped_messages_.load(boost::memory_order_relaxed);
+    if (dropped != reported_dropped_messages_)
+    {
+      ROS_WARN_NAMED("rt", "%u realtime log messages were dropped (ring full)", dropped - reported_dropped_messages_);
+      reported_dropped_messages_ = dropped;
+    }
+  }
+}  // namespace shadow_robot
+
+/* For the emacs weenies in the crowd.
+Local Variables:
+   c-basic-offset: 2
+End:
+*/
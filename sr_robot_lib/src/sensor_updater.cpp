@@ -26,6 +26,7 @@
 
 
 #include "sr_robot_lib/sensor_updater.hpp"
+#include "sr_robot_lib/rt_logger.hpp"
 #include <boost/foreach.hpp>
 #include <iostream>
 #include <vector>
@@ -64,8 +65,8 @@ namespace generic_updater
 
         // initialization data
         command->tactile_data_type = this->initialization_configs_vector[this->which_data_to_request].what_to_update;
-        ROS_DEBUG_STREAM("Updating sensor initialization data type: " << command->tactile_data_type << " | [" <<
-                         this->which_data_to_request << "/" << this->initialization_configs_vector.size() << "] ");
+        SR_RT_LOG_DEBUG("Updating sensor initialization data type: %u | [%d/%zu] ", command->tactile_data_type,
+                        this->which_data_to_request, this->initialization_configs_vector.size());
       }
     }
     else
@@ -74,12 +75,12 @@ namespace generic_updater
       // (after that we use build_command instead of build_init_command)
       // we use the TACTILE_SENSOR_TYPE_WHICH_SENSORS message, which is supposed to be always implemented
       // This is to avoid sending a random command (initialization_configs_vector is empty at this time)
-      ROS_DEBUG_STREAM("Important data size: " << this->important_update_configs_vector.size());
+      SR_RT_LOG_DEBUG("Important data size: %zu", this->important_update_configs_vector.size());
 
 
       command->tactile_data_type = TACTILE_SENSOR_TYPE_WHICH_SENSORS;
-      ROS_DEBUG_STREAM("Updating sensor initialization data type: " << command->tactile_data_type << " | [" <<
-                       this->which_data_to_request << "/" << this->important_update_configs_vector.size() << "] ");
+      SR_RT_LOG_DEBUG("Updating sensor initialization data type: %u | [%d/%zu] ", command->tactile_data_type,
+                      this->which_data_to_request, this->important_update_configs_vector.size());
     }
     this->mutex->unlock();
 
@@ -110,15 +111,15 @@ namespace generic_updater
       command->tactile_data_type = this->unimportant_data_queue.front();
       this->unimportant_data_queue.pop();
 
-      ROS_DEBUG_STREAM("Updating sensor unimportant data type: " << command->tactile_data_type << " | queue size: " <<
-                       this->unimportant_data_queue.size());
+      SR_RT_LOG_DEBUG("Updating sensor unimportant data type: %u | queue size: %zu", command->tactile_data_type,
+                      this->unimportant_data_queue.size());
     }
     else
     {
       // important data to update as often as possible
       command->tactile_data_type = this->important_update_configs_vector[this->which_data_to_request].what_to_update;
-      ROS_DEBUG_STREAM("Updating sensor important data type: " << command->tactile_data_type << " | [" <<
-                       this->which_data_to_request << "/" << this->important_update_configs_vector.size() << "] ");
+      SR_RT_LOG_DEBUG("Updating sensor important data type: %u | [%d/%zu] ", command->tactile_data_type,
+                      this->which_data_to_request, this->important_update_configs_vector.size());
     }
 
     this->mutex->unlock();
@@ -126,6 +127,27 @@ namespace generic_updater
     return this->update_state;
   }
 
+  template<class CommandType>
+  bool SensorUpdater<CommandType>::pop_unimportant_data(int32u *data)
+  {
+    if (!this->mutex->try_lock())
+    {
+      return false;
+    }
+
+    bool available = !this->unimportant_data_queue.empty();
+    if (available)
+    {
+      *data = this->unimportant_data_queue.front();
+      this->unimportant_data_queue.pop();
+      SR_RT_LOG_DEBUG("Updating sensor unimportant data type: %u | queue size: %zu", *data,
+                      this->unimportant_data_queue.size());
+    }
+
+    this->mutex->unlock();
+    return available;
+  }
+
   template<class CommandType>
   bool SensorUpdater<CommandType>::reset()
   {
@@ -146,6 +168,9 @@ namespace generic_updater
   template
   class SensorUpdater<ETHERCAT_DATA_STRUCTURE_0230_PALM_EDC_COMMAND>;
 
+  template
+  class SensorUpdater<ETHERCAT_DATA_STRUCTURE_0240_PALM_EDC_COMMAND>;
+
   template
   class SensorUpdater<ETHERCAT_DATA_STRUCTURE_0300_PALM_EDC_COMMAND>;
 }  // namespace generic_updater
@@ -117,9 +117,34 @@ namespace shadow_robot
       joint_names_tmp.push_back(string(joint_names[i]));
     }
     initialize(joint_names_tmp, motor_ids, joint_to_sensor_vect);
+    this->joint_estimator_->resize(this->joints_vector.size());
+    this->send_motor_presence();
+    this->motor_updater_->set_all_motors(this->all_motors_every_frame_);
     // Initialize the motor data checker
     this->motor_data_checker = shared_ptr<MotorDataChecker>(
             new MotorDataChecker(this->joints_vector, this->motor_updater_->initialization_configs_vector));
+
+    change_force_pids_service_ = this->nh_tilde.advertiseService("change_force_PIDs",
+                                                                 &SrMotorHandLib::force_pids_callback, this);
+
+    // only running while motors are being reset
+    reboot_timer_ = this->nh_tilde.createTimer(ros::Duration(0.01), &SrMotorHandLib::check_rebooted_motors, this,
+                                               false, false);
+
+    capture_motor_data_service_ = this->nh_tilde.advertiseService("capture_motor_data",
+                                                                  &SrMotorHandLib::capture_motor_data_callback, this);
+    // only running during a capture
+    capture_timer_ = this->nh_tilde.createTimer(ros::Duration(0.01), &SrMotorHandLib::check_motor_data_capture,
+                                                this, false, false);
+  }
+
+  template<class StatusType, class CommandType>
+  SrMotorHandLib<StatusType, CommandType>::~SrMotorHandLib()
+  {
+    if (param_server_writer_)
+    {
+      param_server_writer_->join();
+    }
   }
 
   template<class StatusType, class CommandType>
@@ -184,19 +209,127 @@ namespace shadow_robot
   {
     ROS_INFO_STREAM(" resetting " << joint.second << " (" << joint.first << ")");
 
-    this->reset_motors_queue.push(joint.first);
+    // the realtime loop resends the config of the motor as soon as it has rebooted,
+    // the rest is done from check_rebooted_motors()
+    this->reset_motor(joint.first);
+    reboot_timer_.start();
+
+    return true;
+  }
 
-    // wait a few secs for the reset to be sent then resend the pids
-    string joint_name = joint.second;
+  template<class StatusType, class CommandType>
+  bool SrMotorHandLib<StatusType, CommandType>::capture_motor_data_callback(
+          sr_robot_lib::CaptureMotorData::Request &request,
+          sr_robot_lib::CaptureMotorData::Response &response)
+  {
+    response.success = false;
 
-    pid_timers[joint_name] = this->nh_tilde.createTimer(ros::Duration(3.0),
-                                                        boost::bind(&SrMotorHandLib::resend_pids, this, joint_name,
-                                                                    joint.first),
-                                                        true);
+    int32u motors = 0;
+    for (size_t i = 0; i < request.joint_names.size(); ++i)
+    {
+      int motor_index = find_motor_index(request.joint_names[i]);
+      if (motor_index == -1)
+      {
+        return true;
+      }
+      motors |= 1 << motor_index;
+    }
 
+    vector<int32u> data_types;
+    for (size_t i = 0; i < request.data_types.size(); ++i)
+    {
+      int data = 0;
+      while (data < nb_motor_data && request.data_types[i] != human_readable_motor_data_types[data])
+      {
+        ++data;
+      }
+      if (data == nb_motor_data)
+      {
+        ROS_ERROR("Unknown motor data type: %s", request.data_types[i].c_str());
+        return true;
+      }
+      data_types.push_back(motor_data_types[data]);
+    }
+
+    if (motors == 0 || data_types.empty() || request.duration <= 0.0 ||
+        request.duration > MotorDataCapture::max_duration)
+    {
+      ROS_ERROR("A motor data capture needs joints, data types and a duration up to %.1fs",
+                MotorDataCapture::max_duration);
+      return true;
+    }
+
+    if (!this->motor_data_capture_->start(motors, data_types, request.duration))
+    {
+      ROS_WARN("A motor data capture is already running");
+      return true;
+    }
+
+    this->motor_updater_->start_capture(motors, data_types);
+    capture_timer_.start();
+    ROS_INFO("Capturing the motor data for %.3fs", request.duration);
+
+    response.success = true;
     return true;
   }
 
+  template<class StatusType, class CommandType>
+  void SrMotorHandLib<StatusType, CommandType>::check_motor_data_capture(const ros::TimerEvent &event)
+  {
+    if (!this->motor_data_capture_->finished())
+    {
+      return;
+    }
+
+    this->motor_updater_->stop_capture();
+    capture_timer_.stop();
+    this->motor_data_capture_->publish();
+  }
+
+  template<class StatusType, class CommandType>
+  void SrMotorHandLib<StatusType, CommandType>::check_rebooted_motors(const ros::TimerEvent &event)
+  {
+    int32u rebooted = this->take_rebooted_motors();
+    if (rebooted == 0)
+    {
+      if (!this->motors_resetting())
+      {
+        reboot_timer_.stop();
+      }
+      return;
+    }
+
+    for (vector<Joint>::iterator joint = this->joints_vector.begin();
+         joint != this->joints_vector.end();
+         ++joint)
+    {
+      if (!joint->has_actuator)
+      {
+        continue;
+      }
+
+      int motor_index = static_pointer_cast<MotorWrapper>(joint->actuator_wrapper)->motor_id;
+      if (!sr_math_utils::is_bit_mask_index_true(rebooted, motor_index))
+      {
+        continue;
+      }
+
+      if (this->has_force_control_config(motor_index))
+      {
+        // the force PID was already resent by the realtime loop
+        resend_backlash_compensation(joint->joint_name, motor_index);
+      }
+      else
+      {
+        // never configured since the start: the PID is read from the parameter server
+        resend_pids(joint->joint_name, motor_index);
+      }
+    }
+
+    // Reinitialize motors information
+    this->reinitialize_motors();
+  }
+
   template<class StatusType, class CommandType>
   void SrMotorHandLib<StatusType, CommandType>::resend_pids(string joint_name, int motor_index)
   {
@@ -252,6 +385,18 @@ namespace shadow_robot
     sr_robot_msgs::ForceController::Response pid_response;
     bool pid_success = force_pid_callback(pid_request, pid_response, motor_index);
 
+    if (!pid_success)
+      ROS_WARN_STREAM("Didn't load the force pid settings for the motor in joint " << act_name);
+
+    resend_backlash_compensation(joint_name, motor_index);
+  }
+
+  template<class StatusType, class CommandType>
+  void SrMotorHandLib<StatusType, CommandType>::resend_backlash_compensation(string joint_name, int motor_index)
+  {
+    ostringstream full_param;
+    string act_name = boost::to_lower_copy(joint_name);
+
     // setting the backlash compensation (on or off)
     bool backlash_compensation;
     full_param << act_name << "/backlash_compensation";
@@ -269,8 +414,6 @@ namespace shadow_robot
     sr_robot_msgs::ChangeMotorSystemControls::Response backlash_response;
     bool backlash_success = this->motor_system_controls_callback_(backlash_request, backlash_response);
 
-    if (!pid_success)
-      ROS_WARN_STREAM("Didn't load the force pid settings for the motor in joint " << act_name);
     if (!backlash_success)
       ROS_WARN_STREAM("Didn't set the backlash compensation correctly for the motor in joint " << act_name);
   }
@@ -290,13 +433,38 @@ namespace shadow_robot
       return false;
     }
 
+    if (!force_pid_in_range(request))
+    {
+      response.configured = false;
+      return false;
+    }
+
+    // ok, the parameters sent are coherent, send the demand to the motor.
+    this->generate_force_control_config(motor_index, request.maxpwm, request.sgleftref,
+                                        request.sgrightref, request.f, request.p, request.i,
+                                        request.d, request.imax, request.deadband, request.sign);
+
+    update_force_control_in_param_server(find_joint_name(motor_index), request.maxpwm, request.sgleftref,
+                                         request.sgrightref, request.f, request.p, request.i,
+                                         request.d, request.imax, request.deadband, request.sign);
+    response.configured = true;
+
+    // Reinitialize motors information
+    this->reinitialize_motors();
+
+    return true;
+  }
+
+  template<class StatusType, class CommandType>
+  bool SrMotorHandLib<StatusType, CommandType>::force_pid_in_range(
+          const sr_robot_msgs::ForceController::Request &request)
+  {
     if (!((request.maxpwm >= MOTOR_DEMAND_PWM_RANGE_MIN) &&
           (request.maxpwm <= MOTOR_DEMAND_PWM_RANGE_MAX))
             )
     {
       ROS_WARN_STREAM(" pid parameter maxpwm is out of range : " << request.maxpwm << " -> not in [" <<
                       MOTOR_DEMAND_PWM_RANGE_MIN << " ; " << MOTOR_DEMAND_PWM_RANGE_MAX << "]");
-      response.configured = false;
       return false;
     }
 
@@ -306,7 +474,6 @@ namespace shadow_robot
     {
       ROS_WARN_STREAM(" pid parameter f is out of range : " << request.f << " -> not in [" <<
                       MOTOR_CONFIG_F_RANGE_MIN << " ; " << MOTOR_CONFIG_F_RANGE_MAX << "]");
-      response.configured = false;
       return false;
     }
 
@@ -316,7 +483,6 @@ namespace shadow_robot
     {
       ROS_WARN_STREAM(" pid parameter p is out of range : " << request.p << " -> not in [" <<
                       MOTOR_CONFIG_P_RANGE_MIN << " ; " << MOTOR_CONFIG_P_RANGE_MAX << "]");
-      response.configured = false;
       return false;
     }
 
@@ -326,7 +492,6 @@ namespace shadow_robot
     {
       ROS_WARN_STREAM(" pid parameter i is out of range : " << request.i << " -> not in [" <<
                       MOTOR_CONFIG_I_RANGE_MIN << " ; " << MOTOR_CONFIG_I_RANGE_MAX << "]");
-      response.configured = false;
       return false;
     }
 
@@ -336,7 +501,6 @@ namespace shadow_robot
     {
       ROS_WARN_STREAM(" pid parameter d is out of range : " << request.d << " -> not in [" <<
                       MOTOR_CONFIG_D_RANGE_MIN << " ; " << MOTOR_CONFIG_D_RANGE_MAX << "]");
-      response.configured = false;
       return false;
     }
 
@@ -346,7 +510,6 @@ namespace shadow_robot
     {
       ROS_WARN_STREAM(" pid parameter imax is out of range : " << request.imax << " -> not in [" <<
                       MOTOR_CONFIG_IMAX_RANGE_MIN << " ; " << MOTOR_CONFIG_IMAX_RANGE_MAX << "]");
-      response.configured = false;
       return false;
     }
 
@@ -356,7 +519,6 @@ namespace shadow_robot
     {
       ROS_WARN_STREAM(" pid parameter deadband is out of range : " << request.deadband << " -> not in [" <<
                       MOTOR_CONFIG_DEADBAND_RANGE_MIN << " ; " << MOTOR_CONFIG_DEADBAND_RANGE_MAX << "]");
-      response.configured = false;
       return false;
     }
 
@@ -366,26 +528,100 @@ namespace shadow_robot
     {
       ROS_WARN_STREAM(" pid parameter sign is out of range : " << request.sign << " -> not in [" <<
                       MOTOR_CONFIG_SIGN_RANGE_MIN << " ; " << MOTOR_CONFIG_SIGN_RANGE_MAX << "]");
-      response.configured = false;
       return false;
     }
 
-    // ok, the parameters sent are coherent, send the demand to the motor.
-    this->generate_force_control_config(motor_index, request.maxpwm, request.sgleftref,
-                                        request.sgrightref, request.f, request.p, request.i,
-                                        request.d, request.imax, request.deadband, request.sign);
+    return true;
+  }
 
-    update_force_control_in_param_server(find_joint_name(motor_index), request.maxpwm, request.sgleftref,
-                                         request.sgrightref, request.f, request.p, request.i,
-                                         request.d, request.imax, request.deadband, request.sign);
-    response.configured = true;
+  template<class StatusType, class CommandType>
+  bool SrMotorHandLib<StatusType, CommandType>::force_pids_callback(sr_robot_lib::ChangeForcePids::Request &request,
+                                                                    sr_robot_lib::ChangeForcePids::Response &response)
+  {
+    ROS_INFO_STREAM("Received new force PID parameters for " << request.pids.size() << " motors");
+
+    vector<typename SrMotorRobotLib<StatusType, CommandType>::ForceConfig> configs;
+    ForcePidParams params;
+    for (size_t index = 0; index < request.pids.size(); ++index)
+    {
+      const sr_robot_lib::ForcePid &pid = request.pids[index];
+      int motor_index = find_motor_index(pid.joint_name);
+
+      sr_robot_msgs::ForceController::Request pid_request;
+      pid_request.maxpwm = pid.maxpwm;
+      pid_request.sgleftref = pid.sgleftref;
+      pid_request.sgrightref = pid.sgrightref;
+      pid_request.f = pid.f;
+      pid_request.p = pid.p;
+      pid_request.i = pid.i;
+      pid_request.d = pid.d;
+      pid_request.imax = pid.imax;
+      pid_request.deadband = pid.deadband;
+      pid_request.sign = pid.sign;
+
+      if (motor_index == -1 || !force_pid_in_range(pid_request))
+      {
+        ROS_WARN_STREAM(" Not configuring the motor of joint " << pid.joint_name);
+        response.configured.push_back(false);
+        continue;
+      }
+
+      configs.push_back(this->build_force_control_config(motor_index, pid.maxpwm, pid.sgleftref, pid.sgrightref,
+                                                         pid.f, pid.p, pid.i, pid.d, pid.imax, pid.deadband,
+                                                         pid.sign));
+      params.push_back(std::make_pair(find_joint_name(motor_index), pid_request));
+      response.configured.push_back(true);
+    }
+
+    if (configs.empty())
+    {
+      return true;
+    }
+
+    // all the configs are queued at once, so that they're sent in the same frames
+    this->queue_force_control_configs(configs);
 
     // Reinitialize motors information
     this->reinitialize_motors();
 
+    // the parameter server is updated in the background, after the previous batch
+    if (param_server_writer_)
+    {
+      param_server_writer_->join();
+    }
+    param_server_writer_.reset(new boost::thread(boost::bind(&SrMotorHandLib::write_force_pids_to_param_server,
+                                                             this, params)));
+
     return true;
   }
 
+  template<class StatusType, class CommandType>
+  void SrMotorHandLib<StatusType, CommandType>::write_force_pids_to_param_server(ForcePidParams pids)
+  {
+    for (typename ForcePidParams::const_iterator pid = pids.begin(); pid != pids.end(); ++pid)
+    {
+      update_force_control_in_param_server(pid->first, pid->second.maxpwm, pid->second.sgleftref,
+                                           pid->second.sgrightref, pid->second.f, pid->second.p, pid->second.i,
+                                           pid->second.d, pid->second.imax, pid->second.deadband, pid->second.sign);
+    }
+  }
+
+  template<class StatusType, class CommandType>
+  int SrMotorHandLib<StatusType, CommandType>::find_motor_index(const string &joint_name)
+  {
+    for (vector<Joint>::iterator joint = this->joints_vector.begin();
+         joint != this->joints_vector.end();
+         ++joint)
+    {
+      if (joint->has_actuator && boost::iequals(joint->joint_name, joint_name))
+      {
+        return static_pointer_cast<MotorWrapper>(joint->actuator_wrapper)->motor_id;
+      }
+    }
+    ROS_ERROR("Could not find the motor of joint: %s", joint_name.c_str());
+    return -1;
+  }
+
   template<class StatusType, class CommandType>
   string SrMotorHandLib<StatusType, CommandType>::find_joint_name(int motor_index)
   {
@@ -518,6 +754,9 @@ namespace shadow_robot
 
   template
   class SrMotorHandLib<ETHERCAT_DATA_STRUCTURE_0230_PALM_EDC_STATUS, ETHERCAT_DATA_STRUCTURE_0230_PALM_EDC_COMMAND>;
+
+  template
+  class SrMotorHandLib<ETHERCAT_DATA_STRUCTURE_0240_PALM_EDC_STATUS, ETHERCAT_DATA_STRUCTURE_0240_PALM_EDC_COMMAND>;
 }  // namespace shadow_robot
 
 /* For the emacs weenies in the crowd.
@@ -26,9 +26,11 @@
  */
 
 #include "sr_robot_lib/sr_motor_robot_lib.hpp"
+#include "sr_robot_lib/rt_logger.hpp"
 #include <string>
 #include <vector>
 #include <utility>
+#include <algorithm>
 #include <boost/foreach.hpp>
 
 #include <sys/time.h>
@@ -57,15 +59,25 @@ using boost::static_pointer_cast;
 
 namespace shadow_robot
 {
-
   template<class StatusType, class CommandType>
   SrMotorRobotLib<StatusType, CommandType>::SrMotorRobotLib(hardware_interface::HardwareInterface *hw,
                                                             ros::NodeHandle nh, ros::NodeHandle nhtilde,
                                                             string device_id, string joint_prefix)
           : SrRobotLib<StatusType, CommandType>(hw, nh, nhtilde, device_id, joint_prefix),
             motor_current_state(operation_mode::device_update_state::INITIALIZATION),
+            lock_reconfig_queue_(new boost::mutex()),
+            configs_being_sent_(NUM_MOTORS),
+            nb_configs_being_sent_(0),
             config_index(MOTOR_CONFIG_FIRST_VALUE),
+            motor_configs_(NUM_MOTORS),
+            motor_resets_(NUM_MOTORS),
+            configs_to_resend_(0),
+            motors_resetting_(0),
+            motors_rebooted_(0),
+            motor_data_capture_(new MotorDataCapture(this->nodehandle_, this->cycle_period)),
+            joint_estimator_(new JointStateEstimator(this->nh_tilde, this->cycle_period)),
             control_type_changed_flag_(false),
+            send_motor_presence_(false),
             change_control_type_(this->nh_tilde.advertiseService("change_control_type",
                                                                  &SrMotorRobotLib::change_control_type_callback_,
                                                                  this)),
@@ -90,6 +102,25 @@ namespace shadow_robot
       ROS_INFO("Using TORQUE control.");
     }
 
+    this->nh_tilde.template param<bool>("send_motor_presence", send_motor_presence_, false);
+
+    // request all the motors in each frame if the status has room for them, and if
+    // the frame is long enough for the replies of all the motors on the CAN buses
+    bool alternate_motors;
+    this->nh_tilde.template param<bool>("alternate_motors", alternate_motors, this->cycle_period < 0.001);
+    all_motors_every_frame_ = !alternate_motors &&
+            sizeof(static_cast<StatusType *>(NULL)->motor_data_packet) /
+            sizeof(static_cast<StatusType *>(NULL)->motor_data_packet[0]) == NUM_MOTORS;
+    // 1s worth of samples: the motors are only sampled every other frame when they alternate
+    reboot_timeout_samples_ = std::max(this->cycles_for_rate(1.0) / (all_motors_every_frame_ ? 1 : 2), 1u);
+
+    for (int motor = 0; motor < NUM_MOTORS; ++motor)
+    {
+      motor_configs_[motor].first = motor;
+      // the configs are copied there from the realtime loop
+      configs_being_sent_[motor].second.reserve(MOTOR_CONFIG_CRC + 1);
+    }
+
 #ifdef DEBUG_PUBLISHER
     this->debug_motor_indexes_and_data.resize(this->nb_debug_publishers_const);
     for (int i = 0; i < this->nb_debug_publishers_const; ++i)
@@ -105,21 +136,25 @@ namespace shadow_robot
   void SrMotorRobotLib<StatusType, CommandType>::update(StatusType *status_data)
   {
     // read the PIC idle time
-    this->main_pic_idle_time = status_data->idle_time_us;
-    if (status_data->idle_time_us < this->main_pic_idle_time_min)
-    {
-      this->main_pic_idle_time_min = status_data->idle_time_us;
-    }
+    this->update_main_pic_idle_time(status_data->idle_time_us);
 
     // get the current timestamp
     struct timeval tv;
     double timestamp = 0.0;
     if (gettimeofday(&tv, NULL))
-      ROS_WARN("SrMotorRobotLib: Failed to get system time, timestamp in state will be zero");
+      SR_RT_LOG_WARN("SrMotorRobotLib: Failed to get system time, timestamp in state will be zero");
     else
     {
       timestamp = static_cast<double>(tv.tv_sec) + static_cast<double>(tv.tv_usec) / 1.0e+6;
     }
+    motor_data_capture_->new_cycle(timestamp);
+    // the filters need the time of the frame, not the one at which we decode it
+    const double filter_time = this->frame_monitor->filter_time(timestamp);
+
+    // the 0240 palms can send the data of all the motors in each frame
+    const bool all_motors_in_status =
+            sizeof(status_data->motor_data_packet) / sizeof(status_data->motor_data_packet[0]) == NUM_MOTORS &&
+            (status_data->which_motors & WHICH_MOTORS_ALL) != 0;
 
     // First we read the joints information
     for (vector<Joint>::iterator joint_tmp = this->joints_vector.begin();
@@ -144,17 +179,27 @@ namespace shadow_robot
         motor_actuator->motor_state_.tactiles_ = this->tactiles->get_tactile_data();
       }
 
-      this->process_position_sensor_data(joint_tmp, status_data, timestamp);
+      this->process_position_sensor_data(joint_tmp, status_data, filter_time);
+      if (joint_estimator_->enabled())
+      {
+        joint_estimator_->set_position(joint_tmp - this->joints_vector.begin(),
+                                       motor_actuator->motor_state_.position_unfiltered_);
+      }
 
       // filter the effort
       pair<double, double> effort_and_effort_d = joint_tmp->effort_filter.compute(
-              motor_actuator->motor_state_.force_unfiltered_, timestamp);
+              motor_actuator->motor_state_.force_unfiltered_, filter_time);
       motor_actuator->state_.last_measured_effort_ = effort_and_effort_d.first;
 
       // get the remaining information.
       bool read_motor_info = false;
 
-      if (status_data->which_motors == 0)
+      if (all_motors_in_status)
+      {
+        // the palm sampled all the motors
+        read_motor_info = true;
+      }
+      else if ((status_data->which_motors & WHICH_MOTORS_PARITY) == 0)
       {
         // We sampled the even motor numbers
         if (motor_index_full % 2 == 0)
@@ -175,8 +220,8 @@ namespace shadow_robot
       // is different from the motor index:
       // the motor indexes range from 0 to 19
       // while the message contains information
-      // for only 10 motors.
-      index_motor_in_msg = motor_index_full / 2;
+      // for only 10 motors (unless it contains all of them).
+      index_motor_in_msg = all_motors_in_status ? motor_index_full : motor_index_full / 2;
 
       // setting the position of the motor in the message,
       // we'll print that in the diagnostics.
@@ -186,11 +231,45 @@ namespace shadow_robot
       if (read_motor_info)
       {
         read_additional_data(joint_tmp, status_data);
+
+        if (motor_wrapper->actuator_ok && !motor_wrapper->bad_data)
+        {
+          motor_data_capture_->record(timestamp, motor_index_full, status_data->motor_data_type,
+                                      status_data->motor_data_packet[index_motor_in_msg].torque,
+                                      status_data->motor_data_packet[index_motor_in_msg].misc);
+
+          // the slow data don't carry the torque
+          if (joint_estimator_->enabled() && status_data->motor_data_type != MOTOR_DATA_SLOW_MISC)
+          {
+            joint_estimator_->set_effort(joint_tmp - this->joints_vector.begin(),
+                                         motor_actuator->motor_state_.force_unfiltered_);
+          }
+        }
       }
     }  // end for joint
 
+    if (joint_estimator_->enabled())
+    {
+      // replace the filtered states by the estimated ones
+      joint_estimator_->update(filter_time);
+      for (unsigned int joint = 0; joint < this->joints_vector.size(); ++joint)
+      {
+        if (!this->joints_vector[joint].has_actuator)
+        {
+          continue;
+        }
+
+        SrMotorActuator *motor_actuator = this->get_joint_actuator(this->joints_vector.begin() + joint);
+        motor_actuator->state_.position_ = joint_estimator_->position(joint);
+        motor_actuator->state_.velocity_ = joint_estimator_->velocity(joint);
+        motor_actuator->state_.last_measured_effort_ = joint_estimator_->effort(joint);
+      }
+    }
+
     // then we read the tactile sensors information
-    this->update_tactile_info(status_data);
+    this->update_tactile_info(status_data, filter_time);
+
+    this->commit_state_snapshot(timestamp);
   }  // end update()
 
   template<class StatusType, class CommandType>
@@ -231,7 +310,12 @@ namespace shadow_robot
     // configuration, a reset command, or a motor system control
     // request then we send the configuration
     // or the reset.
-    if (reconfig_queue.empty() && reset_motors_queue.empty()
+    if (nb_configs_being_sent_ == 0)
+    {
+      take_waiting_configs();
+    }
+
+    if (nb_configs_being_sent_ == 0 && reset_motors_queue.empty()
         && motor_system_control_flags_.empty())
     {
       // no config to send
@@ -261,7 +345,7 @@ namespace shadow_robot
 
         shared_ptr<MotorWrapper> motor_wrapper = static_pointer_cast<MotorWrapper>(joint_tmp->actuator_wrapper);
 
-        if (!this->nullify_demand_)
+        if (!this->nullify_demand_ && !this->frame_monitor->fault())
         {
           // We send the computed demand
           command->motor_data[motor_wrapper->motor_id] = motor_wrapper->actuator->command_.effort_;
@@ -306,7 +390,7 @@ namespace shadow_robot
          }  // end try_lock
 #endif
       }  // end for each joint
-    }  // end if reconfig_queue.empty()
+    }  // end if nb_configs_being_sent_ == 0
     else
     {
       if (!motor_system_control_flags_.empty())
@@ -413,202 +497,327 @@ namespace shadow_robot
             }
 
             command->motor_data[motor_id] = to_send.word;
+
+            // follow the reboot of the motor, to resend its config as soon as it's ready
+            motor_resets_[motor_id] = MotorReset();
+            motor_resets_[motor_id].resetting = true;
           }
         }  // end if reset queue not empty
         else
         {
-          if (!reconfig_queue.empty())
+          if (nb_configs_being_sent_ != 0)
           {
-            // we have a waiting config:
+            // we have waiting configs:
             // we need to send all the config, finishing by the
-            // CRC. We'll remove the config from the queue only
-            // when the whole config has been sent
+            // CRC. We'll remove the configs only when the whole
+            // configs have been sent. The configs of all the motors
+            // being reconfigured are sent in the same frames.
 
             // the motor data type correspond to the index
             // in the config array.
             command->to_motor_data_type = static_cast<TO_MOTOR_DATA_TYPE> (config_index);
 
-            // convert the motor index to the index of the motor in the message
-            int motor_index = reconfig_queue.front().first;
-
-            // set the data we want to send to the given motor
-            command->motor_data[motor_index] = reconfig_queue.front().second[config_index].word;
-
             // We're now sending the CRC. We need to send the correct CRC to
-            // the motor we updated, and CRC=0 to all the other motors in its
-            // group (odd/even) to tell them to ignore the new
-            // configuration.
-            // Once the config has been transmitted, pop the element
-            // and reset the config_index to the beginning of the
-            // config values
+            // the motors we updated, and CRC=0 to all the other motors
+            // to tell them to ignore the new configuration.
             if (config_index == static_cast<int> (MOTOR_CONFIG_CRC))
             {
-              // loop on all the motors and send a CRC of 0
-              // except for the motor we're reconfiguring
               for (int i = 0; i < NUM_MOTORS; ++i)
               {
-                if (i != motor_index)
-                {
-                  command->motor_data[i] = 0;
-                }
+                command->motor_data[i] = 0;
               }
+            }
 
-              // reset the config_index and remove the configuration
-              // we just sent from the configurations queue
-              reconfig_queue.pop();
+            // set the data we want to send to the given motors
+            for (unsigned int config = 0; config < nb_configs_being_sent_; ++config)
+            {
+              command->motor_data[configs_being_sent_[config].first] =
+                      configs_being_sent_[config].second[config_index].word;
+            }
+
+            // Once the configs have been transmitted, remove them
+            // and reset the config_index to the beginning of the
+            // config values
+            if (config_index == static_cast<int> (MOTOR_CONFIG_CRC))
+            {
+              nb_configs_being_sent_ = 0;
               config_index = MOTOR_CONFIG_FIRST_VALUE;
             }
             else
             {
               ++config_index;
             }
-          }  // end if reconfig queue not empty
+          }  // end if configs being sent
         }  // end else reset_queue.empty
       }  // end else motor_system_control_flags_.empty
-    }  // end else reconfig_queue.empty() && reset_queue.empty()
+    }  // end else nb_configs_being_sent_ == 0 && reset_queue.empty()
+  }
+
+  template<class StatusType, class CommandType>
+  void SrMotorRobotLib<StatusType, CommandType>::take_waiting_configs()
+  {
+    boost::mutex::scoped_try_lock l(*lock_reconfig_queue_);
+    if (!l.owns_lock())
+    {
+      return;
+    }
+
+    // the motors which rebooted get the last config they were sent
+    for (int motor = 0; motor < NUM_MOTORS && configs_to_resend_ != 0; ++motor)
+    {
+      if (sr_math_utils::is_bit_mask_index_true(configs_to_resend_, motor))
+      {
+        configs_to_resend_ &= ~(1u << motor);
+        if (!motor_configs_[motor].second.empty())
+        {
+          add_config_being_sent(motor_configs_[motor]);
+        }
+      }
+    }
+
+    while (!reconfig_queue.empty())
+    {
+      for (unsigned int config = 0; config < nb_configs_being_sent_; ++config)
+      {
+        if (configs_being_sent_[config].first == reconfig_queue.front().first)
+        {
+          // the next config for this motor will be sent once this one is
+          return;
+        }
+      }
+
+      add_config_being_sent(reconfig_queue.front());
+      reconfig_queue.pop();
+    }
+  }
+
+  template<class StatusType, class CommandType>
+  void SrMotorRobotLib<StatusType, CommandType>::add_config_being_sent(const ForceConfig &config)
+  {
+    // copied to the storage preallocated for the configs being sent: no allocation in the realtime loop
+    ForceConfig &config_being_sent = configs_being_sent_[nb_configs_being_sent_++];
+    config_being_sent.first = config.first;
+    config_being_sent.second.assign(config.second.begin(), config.second.end());
   }
 
   template<class StatusType, class CommandType>
   void SrMotorRobotLib<StatusType, CommandType>::add_diagnostics(vector<diagnostic_msgs::DiagnosticStatus> &vec,
                                                                  diagnostic_updater::DiagnosticStatusWrapper &d)
   {
-    for (vector<Joint>::iterator joint = this->joints_vector.begin();
-         joint != this->joints_vector.end();
-         ++joint)
+    // work on a consistent copy of the state, the realtime loop keeps on updating it
+    this->get_state_snapshot(diagnostics_snapshot_);
+
+    if (motor_diagnostics_.size() != diagnostics_snapshot_.nb_joints)
     {
-      ostringstream name("");
+      // the names don't change, build them only once
+      motor_diagnostics_.resize(diagnostics_snapshot_.nb_joints);
       string prefix = this->device_id_.empty() ? this->device_id_ : (this->device_id_ + " ");
-      name << prefix << "SRDMotor " << joint->joint_name;
-      d.name = name.str();
-
-      if (joint->has_actuator)
+      for (unsigned int index = 0; index < motor_diagnostics_.size(); ++index)
       {
-        shared_ptr<MotorWrapper> actuator_wrapper = static_pointer_cast<MotorWrapper>(joint->actuator_wrapper);
-        SrMotorActuator *actuator = this->get_joint_actuator(joint);
+        motor_diagnostics_[index].status.status.name = prefix + "SRDMotor " + this->joints_vector[index].joint_name;
+      }
+    }
+
+    for (unsigned int index = 0; index < diagnostics_snapshot_.nb_joints; ++index)
+    {
+      const JointStateSnapshot &joint_state = diagnostics_snapshot_.joints[index];
+      const MotorStateSnapshot &motor = joint_state.motor;
+      MotorDiagnostics &motor_diagnostics = motor_diagnostics_[index];
+      CachedDiagnosticStatus &status = motor_diagnostics.status;
 
-        if (actuator_wrapper->actuator_ok)
+      status.clear();
+      if (joint_state.has_actuator)
+      {
+        if (motor.actuator_ok)
         {
-          if (actuator_wrapper->bad_data)
+          if (motor.bad_data)
           {
-            d.summary(d.WARN, "WARNING, bad CAN data received");
-
-            d.clear();
-            d.addf("Motor ID", "%d", actuator_wrapper->motor_id);
+            status.summary(d.WARN, "WARNING, bad CAN data received");
+            status.add("Motor ID", motor.motor_id);
           }
           else  // the data is good
           {
-            d.summary(d.OK, "OK");
-
-            d.clear();
-            d.addf("Motor ID", "%d", actuator_wrapper->motor_id);
-            d.addf("Motor ID in message", "%d", actuator_wrapper->msg_motor_id);
-            d.addf("Serial Number", "%d", actuator->motor_state_.serial_number);
-            d.addf("Assembly date", "%d / %d / %d",
-                   actuator->motor_state_.assembly_data_day,
-                   actuator->motor_state_.assembly_data_month,
-                   actuator->motor_state_.assembly_data_year);
-
-            d.addf("Strain Gauge Left", "%d", actuator->motor_state_.strain_gauge_left_);
-            d.addf("Strain Gauge Right", "%d", actuator->motor_state_.strain_gauge_right_);
-
-            // if some flags are set
-            ostringstream ss;
-            if (actuator->motor_state_.flags_.size() > 0)
+            status.summary(d.OK, "OK");
+
+            status.add("Motor ID", motor.motor_id);
+            status.add("Motor ID in message", motor.msg_motor_id);
+            status.add("Serial Number", motor.serial_number);
+            status.addf("Assembly date", "%d / %d / %d",
+                        motor.assembly_data_day,
+                        motor.assembly_data_month,
+                        motor.assembly_data_year);
+
+            status.add("Strain Gauge Left", motor.strain_gauge_left);
+            status.add("Strain Gauge Right", motor.strain_gauge_right);
+
+            // the flags are only humanized when they change
+            if (motor_diagnostics.flags != motor.flags)
             {
-              int flags_seriousness = d.OK;
-              pair<string, bool> flag;
-
-              BOOST_FOREACH(flag, actuator->motor_state_.flags_)
-                    {
-                      // Serious error flag
-                      if (flag.second)
-                      {
-                        flags_seriousness = d.ERROR;
-                      }
-
-                      if (flags_seriousness != d.ERROR)
-                      {
-                        flags_seriousness = d.WARN;
-                      }
-                      ss << flag.first << " | ";
-                    }
-              d.summary(flags_seriousness, ss.str().c_str());
+              update_flags_diagnostics(motor_diagnostics, motor.flags);
             }
-            else
+            if (motor_diagnostics.flags_level != d.OK)
             {
-              ss << " None";
+              status.summary(motor_diagnostics.flags_level, motor_diagnostics.flags_description.c_str());
             }
-            d.addf("Motor Flags", "%s", ss.str().c_str());
+            status.add("Motor Flags", motor_diagnostics.flags_description);
 
-            d.addf("Measured PWM", "%d", actuator->motor_state_.pwm_);
-            d.addf("Measured Current", "%f", actuator->state_.last_measured_current_);
-            d.addf("Measured Voltage", "%f", actuator->state_.motor_voltage_);
-            d.addf("Measured Effort", "%f", actuator->state_.last_measured_effort_);
-            d.addf("Temperature", "%f", actuator->motor_state_.temperature_);
+            status.add("Measured PWM", motor.pwm);
+            status.add("Measured Current", motor.current);
+            status.add("Measured Voltage", motor.voltage);
+            status.add("Measured Effort", joint_state.effort);
+            status.add("Temperature", motor.temperature);
 
-            d.addf("Unfiltered position", "%f", actuator->motor_state_.position_unfiltered_);
-            d.addf("Unfiltered force", "%f", actuator->motor_state_.force_unfiltered_);
+            status.add("Unfiltered position", motor.position_unfiltered);
+            status.add("Unfiltered force", motor.force_unfiltered);
 
-            d.addf("Gear Ratio", "%d", actuator->motor_state_.motor_gear_ratio);
+            status.add("Gear Ratio", motor.gear_ratio);
 
-            d.addf("Number of CAN messages received", "%lld", actuator->motor_state_.can_msgs_received_);
-            d.addf("Number of CAN messages transmitted", "%lld", actuator->motor_state_.can_msgs_transmitted_);
+            status.add("Number of CAN messages received", motor.can_msgs_received);
+            status.add("Number of CAN messages transmitted", motor.can_msgs_transmitted);
 
-            d.addf("Force control Pterm", "%d", actuator->motor_state_.force_control_pterm);
-            d.addf("Force control Iterm", "%d", actuator->motor_state_.force_control_iterm);
-            d.addf("Force control Dterm", "%d", actuator->motor_state_.force_control_dterm);
+            status.add("Force control Pterm", motor.force_control_pterm);
+            status.add("Force control Iterm", motor.force_control_iterm);
+            status.add("Force control Dterm", motor.force_control_dterm);
 
-            d.addf("Force control F", "%d", actuator->motor_state_.force_control_f_);
-            d.addf("Force control P", "%d", actuator->motor_state_.force_control_p_);
-            d.addf("Force control I", "%d", actuator->motor_state_.force_control_i_);
-            d.addf("Force control D", "%d", actuator->motor_state_.force_control_d_);
-            d.addf("Force control Imax", "%d", actuator->motor_state_.force_control_imax_);
-            d.addf("Force control Deadband", "%d", actuator->motor_state_.force_control_deadband_);
-            d.addf("Force control Frequency", "%d", actuator->motor_state_.force_control_frequency_);
+            status.add("Force control F", motor.force_control_f);
+            status.add("Force control P", motor.force_control_p);
+            status.add("Force control I", motor.force_control_i);
+            status.add("Force control D", motor.force_control_d);
+            status.add("Force control Imax", motor.force_control_imax);
+            status.add("Force control Deadband", motor.force_control_deadband);
+            status.add("Force control Frequency", motor.force_control_frequency);
 
-            if (actuator->motor_state_.force_control_sign_ == 0)
-            {
-              d.addf("Force control Sign", "+");
-            }
-            else
-            {
-              d.addf("Force control Sign", "-");
-            }
+            status.add("Force control Sign", motor.force_control_sign == 0 ? "+" : "-");
 
-            d.addf("Last Commanded Effort", "%f", actuator->state_.last_commanded_effort_);
+            status.add("Last Commanded Effort", joint_state.commanded_effort);
 
-            d.addf("Encoder Position", "%f", actuator->state_.position_);
+            status.add("Encoder Position", joint_state.position);
 
-            if (actuator->motor_state_.firmware_modified_)
+            if (motor.firmware_modified)
             {
-              d.addf("Firmware svn revision (server / pic / modified)", "%d / %d / True",
-                     actuator->motor_state_.server_firmware_svn_revision_,
-                     actuator->motor_state_.pic_firmware_svn_revision_);
+              status.addf("Firmware svn revision (server / pic / modified)", "%d / %d / True",
+                          motor.server_firmware_svn_revision,
+                          motor.pic_firmware_svn_revision);
             }
             else
             {
-              d.addf("Firmware svn revision (server / pic / modified)", "%d / %d / False",
-                     actuator->motor_state_.server_firmware_svn_revision_,
-                     actuator->motor_state_.pic_firmware_svn_revision_);
+              status.addf("Firmware svn revision (server / pic / modified)", "%d / %d / False",
+                          motor.server_firmware_svn_revision,
+                          motor.pic_firmware_svn_revision);
             }
           }
         }
         else
         {
-          d.summary(d.ERROR, "Motor error");
-          d.clear();
-          d.addf("Motor ID", "%d", actuator_wrapper->motor_id);
+          status.summary(d.ERROR, "Motor error");
+          status.add("Motor ID", motor.motor_id);
         }
       }
       else
       {
-        d.summary(d.OK, "No motor associated to this joint");
-        d.clear();
+        status.summary(d.OK, "No motor associated to this joint");
       }
-      vec.push_back(d);
+      status.finish();
+      vec.push_back(status.status);
     }  // end for each joints
   }
 
+  template<class StatusType, class CommandType>
+  void SrMotorRobotLib<StatusType, CommandType>::update_flags_diagnostics(MotorDiagnostics &motor_diagnostics,
+                                                                          int flags)
+  {
+    motor_diagnostics.flags = flags;
+    motor_diagnostics.flags_level = diagnostic_msgs::DiagnosticStatus::OK;
+
+    ostringstream ss;
+    vector<pair<string, bool> > humanized_flags = humanize_flags(flags);
+    if (humanized_flags.size() > 0)
+    {
+      pair<string, bool> flag;
+      BOOST_FOREACH(flag, humanized_flags)
+            {
+              // Serious error flag
+              if (flag.second)
+              {
+                motor_diagnostics.flags_level = diagnostic_msgs::DiagnosticStatus::ERROR;
+              }
+
+              if (motor_diagnostics.flags_level != diagnostic_msgs::DiagnosticStatus::ERROR)
+              {
+                motor_diagnostics.flags_level = diagnostic_msgs::DiagnosticStatus::WARN;
+              }
+              ss << flag.first << " | ";
+            }
+    }
+    else
+    {
+      ss << " None";
+    }
+    motor_diagnostics.flags_description = ss.str();
+  }
+
+  template<class StatusType, class CommandType>
+  void SrMotorRobotLib<StatusType, CommandType>::fill_joints_snapshot(HandStateSnapshot &snapshot)
+  {
+    for (unsigned int i = 0; i < snapshot.nb_joints; ++i)
+    {
+      vector<Joint>::iterator joint = this->joints_vector.begin() + i;
+      JointStateSnapshot &joint_state = snapshot.joints[i];
+      joint_state.has_actuator = joint->has_actuator;
+      if (!joint->has_actuator)
+      {
+        continue;
+      }
+
+      shared_ptr<MotorWrapper> actuator_wrapper = static_pointer_cast<MotorWrapper>(joint->actuator_wrapper);
+      SrMotorActuator *actuator = this->get_joint_actuator(joint);
+      MotorStateSnapshot &motor = joint_state.motor;
+
+      joint_state.position = actuator->state_.position_;
+      joint_state.velocity = actuator->state_.velocity_;
+      joint_state.effort = actuator->state_.last_measured_effort_;
+      joint_state.commanded_effort = actuator->state_.last_commanded_effort_;
+
+      motor.actuator_ok = actuator_wrapper->actuator_ok;
+      motor.bad_data = actuator_wrapper->bad_data;
+      motor.motor_id = actuator_wrapper->motor_id;
+      motor.msg_motor_id = actuator_wrapper->msg_motor_id;
+      motor.flags = actuator_wrapper->flags;
+
+      motor.serial_number = actuator->motor_state_.serial_number;
+      motor.assembly_data_day = actuator->motor_state_.assembly_data_day;
+      motor.assembly_data_month = actuator->motor_state_.assembly_data_month;
+      motor.assembly_data_year = actuator->motor_state_.assembly_data_year;
+      motor.strain_gauge_left = actuator->motor_state_.strain_gauge_left_;
+      motor.strain_gauge_right = actuator->motor_state_.strain_gauge_right_;
+      motor.pwm = actuator->motor_state_.pwm_;
+      motor.current = actuator->state_.last_measured_current_;
+      motor.voltage = actuator->state_.motor_voltage_;
+      motor.temperature = actuator->motor_state_.temperature_;
+      motor.position_unfiltered = actuator->motor_state_.position_unfiltered_;
+      motor.force_unfiltered = actuator->motor_state_.force_unfiltered_;
+      motor.gear_ratio = actuator->motor_state_.motor_gear_ratio;
+      motor.can_msgs_received = actuator->motor_state_.can_msgs_received_;
+      motor.can_msgs_transmitted = actuator->motor_state_.can_msgs_transmitted_;
+
+      motor.force_control_pterm = actuator->motor_state_.force_control_pterm;
+      motor.force_control_iterm = actuator->motor_state_.force_control_iterm;
+      motor.force_control_dterm = actuator->motor_state_.force_control_dterm;
+      motor.force_control_f = actuator->motor_state_.force_control_f_;
+      motor.force_control_p = actuator->motor_state_.force_control_p_;
+      motor.force_control_i = actuator->motor_state_.force_control_i_;
+      motor.force_control_d = actuator->motor_state_.force_control_d_;
+      motor.force_control_imax = actuator->motor_state_.force_control_imax_;
+      motor.force_control_deadband = actuator->motor_state_.force_control_deadband_;
+      motor.force_control_frequency = actuator->motor_state_.force_control_frequency_;
+      motor.force_control_sign = actuator->motor_state_.force_control_sign_;
+
+      motor.server_firmware_svn_revision = actuator->motor_state_.server_firmware_svn_revision_;
+      motor.pic_firmware_svn_revision = actuator->motor_state_.pic_firmware_svn_revision_;
+      motor.firmware_modified = actuator->motor_state_.firmware_modified_;
+    }
+  }
+
   template<class StatusType, class CommandType>
   void SrMotorRobotLib<StatusType, CommandType>::read_additional_data(vector<Joint>::iterator joint_tmp,
                                                                       StatusType *status_data)
@@ -632,6 +841,9 @@ namespace shadow_robot
 
     crc_unions::union16 tmp_value;
 
+    check_motor_reboot(motor_index_full,
+                       joint_tmp->actuator_wrapper->actuator_ok && !(joint_tmp->actuator_wrapper->bad_data));
+
     if (joint_tmp->actuator_wrapper->actuator_ok && !(joint_tmp->actuator_wrapper->bad_data))
     {
       SrMotorActuator *actuator = static_cast<SrMotorActuator *> (joint_tmp->actuator_wrapper->actuator);
@@ -718,7 +930,8 @@ namespace shadow_robot
 #endif
           break;
         case MOTOR_DATA_FLAGS:
-          actuator->motor_state_.flags_ = humanize_flags(status_data->motor_data_packet[index_motor_in_msg].misc);
+          actuator_wrapper->flags = static_cast<int16u>(status_data->motor_data_packet[index_motor_in_msg].misc);
+          actuator->motor_state_.flags_ = humanize_flags(actuator_wrapper->flags);
           break;
         case MOTOR_DATA_CURRENT:
           // we're receiving the current in milli amps
@@ -952,7 +1165,7 @@ namespace shadow_robot
       PartialJointToSensor joint_to_sensor;
       string sensor_name;
 
-      ROS_DEBUG_STREAM("Combining actuator " << joint_tmp->joint_name);
+      SR_RT_LOG_DEBUG("Combining actuator %s", joint_tmp->joint_name.c_str());
 
       for (unsigned int index_joint_to_sensor = 0;
            index_joint_to_sensor < joint_tmp->joint_to_sensor.joint_to_sensor_vector.size();
@@ -975,10 +1188,12 @@ namespace shadow_robot
 
         calibrated_position += tmp_cal_value * joint_to_sensor.coeff;
 
-        ROS_DEBUG_STREAM("      -> " << sensor_name << " raw = " << raw_pos << " calibrated = " << calibrated_position);
+        SR_RT_LOG_DEBUG("      -> %s raw = %d calibrated = %f",
+                        joint_tmp->joint_to_sensor.sensor_names[index_joint_to_sensor].c_str(), raw_pos,
+                        calibrated_position);
       }
       actuator->motor_state_.position_unfiltered_ = calibrated_position;
-      ROS_DEBUG_STREAM("          => " << actuator->motor_state_.position_unfiltered_);
+      SR_RT_LOG_DEBUG("          => %f", actuator->motor_state_.position_unfiltered_);
     }
   }  // end calibrate_joint()
 
@@ -1000,6 +1215,23 @@ namespace shadow_robot
     actuator->state_.velocity_ = pos_and_velocity.second;
   }
 
+  template<class StatusType, class CommandType>
+  void SrMotorRobotLib<StatusType, CommandType>::extrapolate_joint_states(double dt)
+  {
+    for (vector<Joint>::iterator joint_tmp = this->joints_vector.begin();
+         joint_tmp != this->joints_vector.end();
+         ++joint_tmp)
+    {
+      if (!joint_tmp->has_actuator)
+      {
+        continue;
+      }
+
+      SrMotorActuator *actuator = get_joint_actuator(joint_tmp);
+      actuator->state_.position_ += actuator->state_.velocity_ * dt;
+    }
+  }
+
   template<class StatusType, class CommandType>
   vector<pair<string, bool> > SrMotorRobotLib<StatusType, CommandType>::humanize_flags(int flag)
   {
@@ -1033,6 +1265,18 @@ namespace shadow_robot
                                                                                int sg_left, int sg_right, int f, int p,
                                                                                int i, int d, int imax, int deadband,
                                                                                int sign)
+  {
+    queue_force_control_configs(vector<ForceConfig>(1, build_force_control_config(motor_index, max_pwm, sg_left,
+                                                                                  sg_right, f, p, i, d, imax,
+                                                                                  deadband, sign)));
+  }
+
+  template<class StatusType, class CommandType>
+  typename SrMotorRobotLib<StatusType, CommandType>::ForceConfig
+  SrMotorRobotLib<StatusType, CommandType>::build_force_control_config(int motor_index, int max_pwm,
+                                                                       int sg_left, int sg_right, int f, int p,
+                                                                       int i, int d, int imax, int deadband,
+                                                                       int sign)
   {
     ROS_INFO_STREAM("Setting new pid values for motor" << motor_index <<
                     ": max_pwm=" << max_pwm <<
@@ -1104,8 +1348,61 @@ namespace shadow_robot
     ForceConfig config;
     config.first = motor_index;
     config.second = full_config;
-    // push the new config to the configuration queue
-    reconfig_queue.push(config);
+    return config;
+  }
+
+  template<class StatusType, class CommandType>
+  void SrMotorRobotLib<StatusType, CommandType>::queue_force_control_configs(const vector<ForceConfig> &configs)
+  {
+    // push the new configs to the configuration queue
+    boost::mutex::scoped_lock l(*lock_reconfig_queue_);
+    for (typename vector<ForceConfig>::const_iterator config = configs.begin(); config != configs.end(); ++config)
+    {
+      reconfig_queue.push(*config);
+      motor_configs_.at(config->first) = *config;
+    }
+  }
+
+  template<class StatusType, class CommandType>
+  bool SrMotorRobotLib<StatusType, CommandType>::has_force_control_config(int motor_index)
+  {
+    boost::mutex::scoped_lock l(*lock_reconfig_queue_);
+    return !motor_configs_.at(motor_index).second.empty();
+  }
+
+  template<class StatusType, class CommandType>
+  void SrMotorRobotLib<StatusType, CommandType>::reset_motor(int motor_index)
+  {
+    motors_resetting_.fetch_or(1u << motor_index);
+    reset_motors_queue.push(motor_index);
+  }
+
+  template<class StatusType, class CommandType>
+  void SrMotorRobotLib<StatusType, CommandType>::check_motor_reboot(int motor_index, bool data_received)
+  {
+    MotorReset &reset = motor_resets_[motor_index];
+    if (!reset.resetting)
+    {
+      return;
+    }
+
+    ++reset.samples;
+    if (!data_received)
+    {
+      // the motor is rebooting
+      reset.data_missed = true;
+      return;
+    }
+
+    // the motor sends its data again once it has rebooted (or it was too quick to miss a sample)
+    if (reset.data_missed || reset.samples > reboot_timeout_samples_)
+    {
+      reset.resetting = false;
+      configs_to_resend_ |= 1u << motor_index;
+      motors_rebooted_.fetch_or(1u << motor_index);
+      motors_resetting_.fetch_and(~(1u << motor_index));
+      SR_RT_LOG_INFO("Motor %d rebooted after %u samples, resending its config", motor_index, reset.samples);
+    }
   }
 
   template<class StatusType, class CommandType>
@@ -1119,6 +1416,37 @@ namespace shadow_robot
     // Initialize the motor data checker
     motor_data_checker = shared_ptr<MotorDataChecker>(
             new MotorDataChecker(this->joints_vector, motor_updater_->initialization_configs_vector));
+    send_motor_presence();
+    motor_updater_->set_all_motors(all_motors_every_frame_);
+  }
+
+  template<class StatusType, class CommandType>
+  void SrMotorRobotLib<StatusType, CommandType>::apply_load_shedding()
+  {
+    SrRobotLib<StatusType, CommandType>::apply_load_shedding();
+
+    // the motor updater is replaced when the motors are reinitialized
+    shared_ptr<MotorUpdater<CommandType> > motor_updater = motor_updater_;
+    motor_updater->set_unimportant_rate_divider(this->load_governor->divider(LoadGovernor::MOTOR_DATA));
+  }
+
+  template<class StatusType, class CommandType>
+  void SrMotorRobotLib<StatusType, CommandType>::send_motor_presence()
+  {
+    if (!send_motor_presence_)
+    {
+      return;
+    }
+
+    int32u motors_present = 0;
+    for (vector<Joint>::iterator joint = this->joints_vector.begin(); joint != this->joints_vector.end(); ++joint)
+    {
+      if (joint->has_actuator)
+      {
+        motors_present |= 1 << static_pointer_cast<MotorWrapper>(joint->actuator_wrapper)->motor_id;
+      }
+    }
+    motor_updater_->set_motors_present(motors_present);
   }
 
   template<class StatusType, class CommandType>
@@ -1304,6 +1632,9 @@ namespace shadow_robot
 
   template
   class SrMotorRobotLib<ETHERCAT_DATA_STRUCTURE_0230_PALM_EDC_STATUS, ETHERCAT_DATA_STRUCTURE_0230_PALM_EDC_COMMAND>;
+
+  template
+  class SrMotorRobotLib<ETHERCAT_DATA_STRUCTURE_0240_PALM_EDC_STATUS, ETHERCAT_DATA_STRUCTURE_0240_PALM_EDC_COMMAND>;
 }  // namespace shadow_robot
 
 /* For the emacs weenies in the crowd.
@@ -26,6 +26,7 @@
  */
 
 #include "sr_robot_lib/sr_muscle_robot_lib.hpp"
+#include "sr_robot_lib/rt_logger.hpp"
 #include <string>
 #include <utility>
 #include <map>
@@ -140,26 +141,24 @@ namespace shadow_robot
   void SrMuscleRobotLib<StatusType, CommandType>::update(StatusType *status_data)
   {
     // read the PIC idle time
-    this->main_pic_idle_time = status_data->idle_time_us;
-    if (status_data->idle_time_us < this->main_pic_idle_time_min)
-    {
-      this->main_pic_idle_time_min = status_data->idle_time_us;
-    }
+    this->update_main_pic_idle_time(status_data->idle_time_us);
 
     // get the current timestamp
     struct timeval tv;
     double timestamp = 0.0;
     if (gettimeofday(&tv, NULL))
     {
-      ROS_WARN("SrMuscleRobotLib: Failed to get system time, timestamp in state will be zero");
+      SR_RT_LOG_WARN("SrMuscleRobotLib: Failed to get system time, timestamp in state will be zero");
     }
     else
     {
       timestamp = static_cast<double>(tv.tv_sec) + static_cast<double>(tv.tv_usec) / 1.0e+6;
     }
+    // the filters need the time of the frame, not the one at which we decode it
+    const double filter_time = this->frame_monitor->filter_time(timestamp);
 
     // First we read the tactile sensors information
-    this->update_tactile_info(status_data);
+    this->update_tactile_info(status_data, filter_time);
 
     // then we read the muscle drivers information
     for (vector<MuscleDriver>::iterator muscle_driver_tmp = this->muscle_drivers_vector_.begin();
@@ -188,7 +187,7 @@ namespace shadow_robot
         actuator->muscle_state_.tactiles_ = this->tactiles->get_tactile_data();
       }
 
-      this->process_position_sensor_data(joint_tmp, status_data, timestamp);
+      this->process_position_sensor_data(joint_tmp, status_data, filter_time);
 
       // if no muscle is associated to this joint, then continue
       if ((muscle_wrapper->muscle_driver_id[0] == -1))
@@ -198,8 +197,29 @@ namespace shadow_robot
 
       read_additional_muscle_data(joint_tmp, status_data);
     }  // end for joint
+
+    this->commit_state_snapshot(timestamp);
   }  // end update()
 
+  template<class StatusType, class CommandType>
+  void SrMuscleRobotLib<StatusType, CommandType>::fill_joints_snapshot(HandStateSnapshot &snapshot)
+  {
+    for (unsigned int i = 0; i < snapshot.nb_joints; ++i)
+    {
+      vector<Joint>::iterator joint = this->joints_vector.begin() + i;
+      JointStateSnapshot &joint_snapshot = snapshot.joints[i];
+      joint_snapshot.has_actuator = joint->has_actuator;
+      if (joint->has_actuator)
+      {
+        SrMuscleActuator *actuator = get_joint_actuator(joint);
+        joint_snapshot.position = actuator->state_.position_;
+        joint_snapshot.velocity = actuator->state_.velocity_;
+        joint_snapshot.effort = actuator->state_.last_measured_effort_;
+        joint_snapshot.commanded_effort = actuator->state_.last_commanded_effort_;
+      }
+    }
+  }
+
   template<class StatusType, class CommandType>
   void SrMuscleRobotLib<StatusType, CommandType>::build_command(CommandType *command)
   {
@@ -239,7 +259,7 @@ namespace shadow_robot
           unsigned int muscle_id_0 = muscle_wrapper->muscle_id[0];
           unsigned int muscle_id_1 = muscle_wrapper->muscle_id[1];
 
-          if (!this->nullify_demand_)
+          if (!this->nullify_demand_ && !this->frame_monitor->fault())
           {
             set_valve_demand(&(command->muscle_data[(muscle_driver_id_0 * 10 + muscle_id_0) / 2]),
                              muscle_actuator->muscle_command_.valve_[0], ((uint8_t) muscle_id_0) & 0x01);
@@ -684,7 +704,7 @@ namespace shadow_robot
         break;
 
       default:
-        ROS_ERROR("Incorrect muscle index: %d", muscle_index);
+        SR_RT_LOG_ERROR("Incorrect muscle index: %d", muscle_index);
         break;
     }
 
@@ -854,7 +874,7 @@ namespace shadow_robot
       PartialJointToSensor joint_to_sensor;
       string sensor_name;
 
-      ROS_DEBUG_STREAM("Combining actuator " << joint_tmp->joint_name);
+      SR_RT_LOG_DEBUG("Combining actuator %s", joint_tmp->joint_name.c_str());
 
       for (unsigned int index_joint_to_sensor = 0;
            index_joint_to_sensor < joint_tmp->joint_to_sensor.joint_to_sensor_vector.size();
@@ -877,10 +897,12 @@ namespace shadow_robot
 
         calibrated_position += tmp_cal_value * joint_to_sensor.coeff;
 
-        ROS_DEBUG_STREAM("      -> " << sensor_name << " raw = " << raw_pos << " calibrated = " << calibrated_position);
+        SR_RT_LOG_DEBUG("      -> %s raw = %d calibrated = %f",
+                        joint_tmp->joint_to_sensor.sensor_names[index_joint_to_sensor].c_str(), raw_pos,
+                        calibrated_position);
       }
       actuator->muscle_state_.position_unfiltered_ = calibrated_position;
-      ROS_DEBUG_STREAM("          => " << actuator->muscle_state_.position_unfiltered_);
+      SR_RT_LOG_DEBUG("          => %f", actuator->muscle_state_.position_unfiltered_);
     }
   }  // end calibrate_joint()
 
@@ -903,6 +925,23 @@ namespace shadow_robot
     actuator->state_.velocity_ = pos_and_velocity.second;
   }
 
+  template<class StatusType, class CommandType>
+  void SrMuscleRobotLib<StatusType, CommandType>::extrapolate_joint_states(double dt)
+  {
+    for (vector<Joint>::iterator joint_tmp = this->joints_vector.begin();
+         joint_tmp != this->joints_vector.end();
+         ++joint_tmp)
+    {
+      if (!joint_tmp->has_actuator)
+      {
+        continue;
+      }
+
+      SrMuscleActuator *actuator = get_joint_actuator(joint_tmp);
+      actuator->state_.position_ += actuator->state_.velocity_ * dt;
+    }
+  }
+
   template<class StatusType, class CommandType>
   vector<pair<string, bool> > SrMuscleRobotLib<StatusType, CommandType>::humanize_flags(int flag)
   {
@@ -29,6 +29,7 @@
 #include <utility>
 #include <map>
 #include <vector>
+#include <algorithm>
 #include <boost/foreach.hpp>
 
 #include <sys/time.h>
@@ -38,6 +39,7 @@
 #include "sr_robot_lib/shadow_PSTs.hpp"
 #include "sr_robot_lib/biotac.hpp"
 #include "sr_robot_lib/UBI0.hpp"
+#include "sr_robot_lib/rt_logger.hpp"
 #include <controller_manager_msgs/ListControllers.h>
 #include <sr_robot_lib/motor_updater.hpp>
 
@@ -66,6 +68,45 @@ using generic_updater::UpdateConfig;
 using boost::shared_ptr;
 using boost::ptr_vector;
 
+namespace
+{
+  /**
+   * Copies the sensor values to a fixed size array of the snapshot, whatever
+   * the type of container they're stored in.
+   *
+   * @return the number of values copied
+   */
+  template<class Values>
+  unsigned int copy_tactile_values(const Values &values, int *destination, unsigned int max_size)
+  {
+    unsigned int size = std::min(static_cast<unsigned int>(values.size()), max_size);
+    for (unsigned int i = 0; i < size; ++i)
+    {
+      destination[i] = static_cast<int>(values[i]);
+    }
+    return size;
+  }
+
+  /// Copies a string to a fixed size array of the snapshot, truncated if needed
+  void copy_tactile_string(const std::string &value, char *destination)
+  {
+    size_t size = value.copy(destination, shadow_robot::TactileStateSnapshot::max_string_length - 1);
+    destination[size] = '\0';
+  }
+
+  /**
+   * Copies the identification strings of a sensor to the snapshot. Formatting
+   * the software version allocates: only done when the strings changed.
+   */
+  void copy_tactile_ids(tactiles::GenericTactileData &data, shadow_robot::TactileStateSnapshot &tactile)
+  {
+    copy_tactile_string(data.manufacturer, tactile.manufacturer);
+    copy_tactile_string(data.serial_number, tactile.serial_number);
+    copy_tactile_string(data.get_software_version(), tactile.software_version);
+    copy_tactile_string(data.pcb_version, tactile.pcb_version);
+  }
+}  // namespace
+
 
 namespace shadow_robot
 {
@@ -169,10 +210,16 @@ namespace shadow_robot
           : main_pic_idle_time(0),
             main_pic_idle_time_min(1000),
             tactile_current_state(operation_mode::device_update_state::INITIALIZATION),
+            load_governor(new LoadGovernor(nhtilde)),
             hw_(static_cast<RobotState *> (hw)),
             device_id_(device_id),
             joint_prefix_(joint_prefix),
             nullify_demand_(false),
+            tactile_data_unchanged_(false),
+            last_updated_tactiles_(NULL),
+            main_pic_idle_time_min_reset_(false),
+            snapshot_tactiles_(NULL),
+            tactile_type_(TactileStateSnapshot::NONE),
             nodehandle_(nh),
             nh_tilde(nhtilde),
 
@@ -223,6 +270,22 @@ namespace shadow_robot
             // initialize the calibration map
             calibration_map(read_joint_calibration())
   {
+    // start the realtime logger now rather than from the first log in the realtime loop
+    RtLogger::instance();
+
+    nodehandle_.param("cycle_period", cycle_period, 0.001);
+    if (cycle_period <= 0.0)
+    {
+      ROS_WARN("Invalid cycle_period %f, using 1ms", cycle_period);
+      cycle_period = 0.001;
+    }
+    frame_monitor.reset(new FrameMonitor(nh_tilde, cycle_period));
+
+    if (load_governor->enabled())
+    {
+      load_shedding_timer_ = this->nh_tilde.createTimer(
+              ros::Duration(0.1), &SrRobotLib<StatusType, CommandType>::load_shedding_timer_callback, this);
+    }
   }
 
   template<class StatusType, class CommandType>
@@ -251,6 +314,17 @@ namespace shadow_robot
     return true;
   }
 
+  template<class StatusType, class CommandType>
+  void SrRobotLib<StatusType, CommandType>::frame_missed()
+  {
+    if (frame_monitor->extrapolate())
+    {
+      extrapolate_joint_states(cycle_period);
+    }
+    // the joint states changed, and the diagnostics must see the frames missed
+    commit_state_snapshot(ros::Time::now().toSec());
+  }
+
   template<class StatusType, class CommandType>
   void SrRobotLib<StatusType, CommandType>::build_tactile_command(CommandType *command)
   {
@@ -274,6 +348,7 @@ namespace shadow_robot
                                                             pst3_sensor_update_rate_configs_vector,
                                                             operation_mode::device_update_state::OPERATION,
                                                             tactiles_init->tactiles_vector));
+            tactile_type_ = TactileStateSnapshot::PST;
 
             ROS_INFO("PST3 tactiles initialized");
             break;
@@ -284,6 +359,7 @@ namespace shadow_robot
                                                         biotac_sensor_update_rate_configs_vector,
                                                         operation_mode::device_update_state::OPERATION,
                                                         tactiles_init->tactiles_vector));
+            tactile_type_ = TactileStateSnapshot::BIOTAC;
 
             ROS_INFO("Biotac tactiles initialized");
             break;
@@ -293,6 +369,7 @@ namespace shadow_robot
                     new UBI0<StatusType, CommandType>(nodehandle_, device_id_, ubi0_sensor_update_rate_configs_vector,
                                                       operation_mode::device_update_state::OPERATION,
                                                       tactiles_init->tactiles_vector));
+            tactile_type_ = TactileStateSnapshot::UBI;
 
             ROS_INFO("UBI0 tactiles initialized");
             break;
@@ -308,29 +385,146 @@ namespace shadow_robot
     }
     else
     {
-      tactile_current_state = tactiles->sensor_updater->build_command(command);
+      tactile_current_state = tactiles->build_command(command);
     }
   }
 
   template<class StatusType, class CommandType>
-  void SrRobotLib<StatusType, CommandType>::update_tactile_info(StatusType *status)
+  void SrRobotLib<StatusType, CommandType>::update_tactile_info(StatusType *status, double frame_time)
   {
     // Mutual exclusion with the the initialization timeout
     boost::mutex::scoped_lock l(*lock_tactile_init_timeout_);
+    GenericTactiles<StatusType, CommandType> *current_tactiles;
     if (tactile_current_state == operation_mode::device_update_state::INITIALIZATION)
     {
-      if (tactiles_init != NULL)
-      {
-        tactiles_init->update(status);
-      }
+      current_tactiles = tactiles_init.get();
     }
     else
     {
+      current_tactiles = tactiles.get();
+    }
+
+    bool unchanged = tactile_data_unchanged_;
+    tactile_data_unchanged_ = false;
+    if (current_tactiles == NULL)
+    {
+      return;
+    }
+
+    // The same data were already decoded by this object (a newly created one still needs them)
+    if (unchanged && current_tactiles == last_updated_tactiles_ && !current_tactiles->update_when_unchanged())
+    {
+      return;
+    }
+
+    current_tactiles->set_frame_stamp(frame_time);
+    current_tactiles->update(status);
+    last_updated_tactiles_ = current_tactiles;
+  }
+
+  template<class StatusType, class CommandType>
+  void SrRobotLib<StatusType, CommandType>::update_main_pic_idle_time(int idle_time_us)
+  {
+    main_pic_idle_time = idle_time_us;
+    // reset once the diagnostics have read it, from here as the realtime loop is the only writer
+    if (main_pic_idle_time_min_reset_.exchange(false, boost::memory_order_acquire))
+    {
+      main_pic_idle_time_min = 1000;
+    }
+    if (idle_time_us < main_pic_idle_time_min)
+    {
+      main_pic_idle_time_min = idle_time_us;
+    }
+  }
+
+  template<class StatusType, class CommandType>
+  unsigned int SrRobotLib<StatusType, CommandType>::get_state_snapshot(HandStateSnapshot &snapshot) const
+  {
+    return state_snapshot_.read(snapshot);
+  }
+
+  template<class StatusType, class CommandType>
+  void SrRobotLib<StatusType, CommandType>::commit_state_snapshot(double stamp)
+  {
+    HandStateSnapshot &snapshot = state_snapshot_.begin_write();
+
+    snapshot.stamp = stamp;
+    snapshot.main_pic_idle_time = main_pic_idle_time;
+    snapshot.main_pic_idle_time_min = main_pic_idle_time_min;
+    snapshot.lost_frames = frame_monitor->lost_frames;
+    snapshot.repeated_frames = frame_monitor->repeated_frames;
+    snapshot.frame_faults = frame_monitor->faults;
+    snapshot.frame_fault = frame_monitor->fault();
+    snapshot.nb_joints = std::min(static_cast<unsigned int>(joints_vector.size()),
+                                  static_cast<unsigned int>(HandStateSnapshot::max_joints));
+    fill_joints_snapshot(snapshot);
+
+    snapshot.nb_tactiles = 0;
+    {
+      // Mutual exclusion with the the initialization timeout (which can replace the tactiles)
+      boost::mutex::scoped_lock l(*lock_tactile_init_timeout_);
+      // the identification strings are kept in the snapshot until they change
+      bool copy_ids = tactiles.get() != snapshot_tactiles_ || (tactiles != NULL && tactiles->take_ids_changed());
+      snapshot_tactiles_ = tactiles.get();
       if (tactiles != NULL)
       {
-        tactiles->update(status);
+        vector<tactiles::AllTactileData> *tactile_data = tactiles->get_tactile_data();
+        snapshot.nb_tactiles = std::min(static_cast<unsigned int>(tactile_data->size()),
+                                        static_cast<unsigned int>(HandStateSnapshot::max_tactiles));
+        for (unsigned int i = 0; i < snapshot.nb_tactiles; ++i)
+        {
+          tactiles::AllTactileData &data = tactile_data->at(i);
+          TactileStateSnapshot &tactile = snapshot.tactiles[i];
+          tactile.type = tactile_type_;
+          switch (tactile_type_)
+          {
+            case TactileStateSnapshot::PST:
+              tactile.sample_frequency = data.pst.sample_frequency;
+              tactile.pst_pressure = data.pst.pressure;
+              tactile.pst_temperature = data.pst.temperature;
+              tactile.pst_pressure_raw = data.pst.pressure_raw;
+              tactile.pst_zero_tracking = data.pst.zero_tracking;
+              tactile.pst_dac_value = data.pst.dac_value;
+              if (copy_ids)
+              {
+                copy_tactile_ids(data.pst, tactile);
+              }
+              break;
+
+            case TactileStateSnapshot::BIOTAC:
+              tactile.sample_frequency = data.biotac.sample_frequency;
+              if (copy_ids)
+              {
+                copy_tactile_ids(data.biotac, tactile);
+              }
+              tactile.biotac_pac0 = data.biotac.pac0;
+              tactile.biotac_pac1 = data.biotac.pac1;
+              tactile.biotac_pdc = data.biotac.pdc;
+              tactile.biotac_tac = data.biotac.tac;
+              tactile.biotac_tdc = data.biotac.tdc;
+              tactile.biotac_nb_electrodes = copy_tactile_values(data.biotac.electrodes, tactile.biotac_electrodes,
+                                                                 TactileStateSnapshot::max_electrodes);
+              break;
+
+            case TactileStateSnapshot::UBI:
+              tactile.sample_frequency = data.ubi0.sample_frequency;
+              if (copy_ids)
+              {
+                copy_tactile_ids(data.ubi0, tactile);
+              }
+              copy_tactile_values(data.ubi0.distal, tactile.ubi_distal, TactileStateSnapshot::nb_distal);
+              copy_tactile_values(data.ubi0.middle, tactile.ubi_middle, TactileStateSnapshot::nb_mid_prox);
+              copy_tactile_values(data.ubi0.proximal, tactile.ubi_proximal, TactileStateSnapshot::nb_mid_prox);
+              break;
+
+            default:
+              break;
+          }
+        }
       }
     }
+
+    state_snapshot_.end_write();
   }
 
   template<class StatusType, class CommandType>
@@ -499,6 +693,24 @@ namespace shadow_robot
     }
   }
 
+  template<class StatusType, class CommandType>
+  void SrRobotLib<StatusType, CommandType>::load_shedding_timer_callback(const ros::TimerEvent &event)
+  {
+    apply_load_shedding();
+  }
+
+  template<class StatusType, class CommandType>
+  void SrRobotLib<StatusType, CommandType>::apply_load_shedding()
+  {
+    // the tactiles are replaced at the end of their initialization
+    boost::mutex::scoped_lock l(*lock_tactile_init_timeout_);
+
+    if (tactile_current_state == operation_mode::device_update_state::OPERATION && tactiles != NULL)
+    {
+      tactiles->sensor_updater->set_unimportant_rate_divider(load_governor->divider(LoadGovernor::TACTILE_DATA));
+    }
+  }
+
 //  template <class StatusType, class CommandType>
 // void SrRobotLib<StatusType, CommandType>::checkSelfTests()
 // {
@@ -519,6 +731,9 @@ namespace shadow_robot
   template
   class SrRobotLib<ETHERCAT_DATA_STRUCTURE_0230_PALM_EDC_STATUS, ETHERCAT_DATA_STRUCTURE_0230_PALM_EDC_COMMAND>;
 
+  template
+  class SrRobotLib<ETHERCAT_DATA_STRUCTURE_0240_PALM_EDC_STATUS, ETHERCAT_DATA_STRUCTURE_0240_PALM_EDC_COMMAND>;
+
   template
   class SrRobotLib<ETHERCAT_DATA_STRUCTURE_0300_PALM_EDC_STATUS, ETHERCAT_DATA_STRUCTURE_0300_PALM_EDC_COMMAND>;
 
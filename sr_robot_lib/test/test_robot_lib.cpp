@@ -25,9 +25,15 @@
  */
 
 #include "sr_robot_lib/sr_motor_hand_lib.hpp"
+#include "sr_robot_lib/rt_logger.hpp"
+#include "sr_robot_lib/frame_monitor.hpp"
+#include "sr_robot_lib/joint_state_estimator.hpp"
 #include <sr_mechanism_model/simple_transmission.hpp>
 #include <gtest/gtest.h>
 #include <ros/ros.h>
+#include <stdlib.h>
+#include <time.h>
+#include <cmath>
 #include <utility>
 #include <string>
 #include <vector>
@@ -48,6 +54,7 @@ public:
 public:
   using shadow_robot::SrMotorHandLib<STATUS_TYPE, COMMAND_TYPE>::joints_vector;
   using shadow_robot::SrMotorHandLib<STATUS_TYPE, COMMAND_TYPE>::humanize_flags;
+  using shadow_robot::SrMotorHandLib<STATUS_TYPE, COMMAND_TYPE>::generate_force_control_config;
 };
 
 class HandLibTest
@@ -457,6 +464,255 @@ TEST(SrRobotLib, HumanizeFlags)
   EXPECT_TRUE(flags[15].second);
 }
 
+/**
+ * The force PID configs of several motors (odd and even) are sent in the same frames,
+ * a second config for the same motor is sent once the first one is.
+ */
+TEST(SrRobotLib, BatchedForceConfigs)
+{
+  boost::shared_ptr<HandLibTest> lib_test = boost::shared_ptr<HandLibTest>(new HandLibTest());
+
+  lib_test->sr_hand_lib->generate_force_control_config(0, 100, 1, 2, 0, 10, 20, 30, 40, 5, 0);
+  lib_test->sr_hand_lib->generate_force_control_config(7, 200, 1, 2, 0, 11, 21, 31, 41, 5, 1);
+  lib_test->sr_hand_lib->generate_force_control_config(0, 300, 1, 2, 0, 12, 22, 32, 42, 5, 0);
+
+  COMMAND_TYPE command;
+  for (int config = MOTOR_CONFIG_FIRST_VALUE; config <= MOTOR_CONFIG_CRC; ++config)
+  {
+    lib_test->sr_hand_lib->build_command(&command);
+    EXPECT_EQ(command.to_motor_data_type, config);
+
+    if (config == MOTOR_CONFIG_P)
+    {
+      EXPECT_EQ(command.motor_data[0], 10);
+      EXPECT_EQ(command.motor_data[7], 11);
+    }
+  }
+  // only the reconfigured motors get a CRC
+  EXPECT_NE(command.motor_data[0], 0);
+  EXPECT_NE(command.motor_data[7], 0);
+  EXPECT_EQ(command.motor_data[1], 0);
+
+  // then the second config of motor 0, alone
+  for (int config = MOTOR_CONFIG_FIRST_VALUE; config <= MOTOR_CONFIG_CRC; ++config)
+  {
+    lib_test->sr_hand_lib->build_command(&command);
+    EXPECT_EQ(command.to_motor_data_type, config);
+
+    if (config == MOTOR_CONFIG_P)
+    {
+      EXPECT_EQ(command.motor_data[0], 12);
+    }
+  }
+  EXPECT_NE(command.motor_data[0], 0);
+  EXPECT_EQ(command.motor_data[7], 0);
+
+  // back to the demands
+  lib_test->sr_hand_lib->build_command(&command);
+  EXPECT_TRUE(command.to_motor_data_type == MOTOR_DEMAND_TORQUE || command.to_motor_data_type == MOTOR_DEMAND_PWM);
+}
+
+/**
+ * Testing the formatting of the messages logged from the realtime loop.
+ *
+ */
+TEST(RtLogger, Format)
+{
+  shadow_robot::RtLogEntry entry;
+  entry.level = ros::console::levels::Warn;
+  entry.format = "motor %d: %hu%% of %zu, %.2f %s 0x%02X";
+  entry.suppressed = 0;
+  entry.args[0] = shadow_robot::RtLogArg(-3).value;
+  entry.args[1] = shadow_robot::RtLogArg(static_cast<unsigned short>(42)).value;
+  entry.args[2] = shadow_robot::RtLogArg(static_cast<size_t>(100)).value;
+  entry.args[3] = shadow_robot::RtLogArg(1.5f).value;
+  entry.args[4] = shadow_robot::RtLogArg("FFJ0").value;
+  entry.args[5] = shadow_robot::RtLogArg(static_cast<unsigned char>(0xAB)).value;
+
+  char buffer[128];
+  shadow_robot::RtLogger::format(entry, buffer, sizeof(buffer));
+  EXPECT_STREQ("motor -3: 42% of 100, 1.50 FFJ0 0xAB", buffer);
+
+  // the suppressed messages are reported, and the output is truncated to the buffer
+  entry.format = "no argument";
+  entry.suppressed = 12;
+  shadow_robot::RtLogger::format(entry, buffer, sizeof(buffer));
+  EXPECT_STREQ("no argument (12 similar messages suppressed)", buffer);
+
+  char small_buffer[8];
+  shadow_robot::RtLogger::format(entry, small_buffer, sizeof(small_buffer));
+  EXPECT_STREQ("no argu", small_buffer);
+}
+
+/**
+ * Benchmarks the host side of a cycle (update and build_command), which must
+ * fit in 500us for the hand to run at 2kHz. The cost is only logged, and the
+ * benchmark is disabled by default: run it with --gtest_also_run_disabled_tests
+ */
+TEST(SrRobotLib, DISABLED_CycleCost)
+{
+  boost::shared_ptr<HandLibTest> lib_test = boost::shared_ptr<HandLibTest>(new HandLibTest());
+
+  STATUS_TYPE *status_data = new STATUS_TYPE();
+  COMMAND_TYPE *command = new COMMAND_TYPE();
+  for (unsigned int i = 0; i < SENSORS_NUM_0220 + 1; ++i)
+  {
+    status_data->sensors[i] = i + 1;
+  }
+  status_data->motor_data_type = MOTOR_DATA_SGR;
+  status_data->which_motor_data_arrived = 0x000FFFFF;
+  status_data->which_motor_data_had_errors = 0;
+  for (unsigned int i = 0; i < 10; ++i)
+  {
+    status_data->motor_data_packet[i].torque = 4;
+    status_data->motor_data_packet[i].misc = 2 * i;
+  }
+  status_data->idle_time_us = 100;
+
+  const unsigned int nb_cycles = 2000;
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (unsigned int cycle = 0; cycle < nb_cycles; ++cycle)
+  {
+    status_data->which_motors = cycle % 2;
+    lib_test->sr_hand_lib->update(status_data);
+    lib_test->sr_hand_lib->build_command(command);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  double cycle_cost_us = (static_cast<double>(end.tv_sec - start.tv_sec) * 1.0e6 +
+                          static_cast<double>(end.tv_nsec - start.tv_nsec) / 1.0e3) / nb_cycles;
+  ROS_INFO("Host cost of a cycle: %.1fus", cycle_cost_us);
+
+  delete command;
+  delete status_data;
+}
+
+TEST(FrameMonitor, LostAndRepeatedFrames)
+{
+  shadow_robot::FrameMonitor monitor(ros::NodeHandle("~"), 0.001);
+  unsigned char status[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+  unsigned char prev_status[8] = {0};
+
+  EXPECT_EQ(shadow_robot::FrameMonitor::FRAME_OK, monitor.check_frame(true, status, prev_status, sizeof(status)));
+  EXPECT_EQ(shadow_robot::FrameMonitor::FRAME_REPEATED, monitor.check_frame(true, status, status, sizeof(status)));
+  EXPECT_EQ(shadow_robot::FrameMonitor::FRAME_LOST, monitor.check_frame(false, status, status, sizeof(status)));
+  // a frame identical to a lost one isn't a repeated one
+  EXPECT_EQ(shadow_robot::FrameMonitor::FRAME_OK, monitor.check_frame(true, status, status, sizeof(status)));
+  // without a field changing at each frame, an identical status is a new one
+  EXPECT_EQ(shadow_robot::FrameMonitor::FRAME_OK, monitor.check_frame(true, status, status, sizeof(status), false));
+  EXPECT_EQ(1u, monitor.lost_frames);
+  EXPECT_EQ(1u, monitor.repeated_frames);
+  EXPECT_EQ(0u, monitor.missed_frames());
+
+  // the jitter of the host is removed, the missed frames are accounted for
+  EXPECT_NEAR(10.0, monitor.filter_time(10.0), 1.0e-9);
+  EXPECT_NEAR(10.001, monitor.filter_time(10.0013), 1.0e-9);
+  EXPECT_NEAR(10.002, monitor.filter_time(10.0018), 1.0e-9);
+  EXPECT_NEAR(10.005, monitor.filter_time(10.0049), 1.0e-9);
+
+  for (unsigned int i = 0; i < 20; ++i)
+  {
+    EXPECT_FALSE(monitor.fault());
+    monitor.check_frame(false, status, status, sizeof(status));
+  }
+  EXPECT_TRUE(monitor.fault());
+  EXPECT_EQ(1u, monitor.faults);
+  monitor.check_frame(true, status, prev_status, sizeof(status));
+  EXPECT_FALSE(monitor.fault());
+}
+
+/**
+ * Replays a log of a joint moving (two sines), with the position sampled at 1kHz (noisy and
+ * quantized) and the effort sampled every other frame, and compares the estimates to the true
+ * states one cycle later, when the controllers use them.
+ */
+TEST(JointStateEstimator, DelayCompensation)
+{
+  const double cycle_period = 0.001;
+  shadow_robot::JointStateEstimator estimator(ros::NodeHandle("~"), cycle_period);
+  estimator.resize(1);
+
+  unsigned int seed = 1;
+  double position_error = 0.0, raw_position_error = 0.0, velocity_error = 0.0, effort_error = 0.0;
+  double held_effort_error = 0.0, held_effort = 0.0;
+  unsigned int nb_samples = 0;
+  for (unsigned int cycle = 0; cycle < 10000; ++cycle)
+  {
+    // gaussian noise (sum of uniform variables)
+    double position_noise = -6.0, effort_noise = -6.0;
+    for (unsigned int i = 0; i < 12; ++i)
+    {
+      position_noise += static_cast<double>(rand_r(&seed)) / RAND_MAX;
+      effort_noise += static_cast<double>(rand_r(&seed)) / RAND_MAX;
+    }
+
+    double time = cycle * cycle_period;
+    double position = 0.4 * sin(2.0 * M_PI * 1.3 * time) + 0.2 * sin(2.0 * M_PI * 3.1 * time + 1.0);
+    estimator.set_position(0, floor((position + 0.002 * position_noise) / 0.001 + 0.5) * 0.001);
+    if (cycle % 2 == 0)
+    {
+      held_effort = floor(300.0 * sin(2.0 * M_PI * 2.0 * time) + 10.0 * effort_noise + 0.5);
+      estimator.set_effort(0, held_effort);
+    }
+    estimator.update(time);
+
+    // wait for the filters to converge
+    if (cycle < 1000)
+    {
+      continue;
+    }
+    double raw_position = position + 0.002 * position_noise;
+    time += cycle_period;
+    position = 0.4 * sin(2.0 * M_PI * 1.3 * time) + 0.2 * sin(2.0 * M_PI * 3.1 * time + 1.0);
+    double velocity = 0.4 * 2.0 * M_PI * 1.3 * cos(2.0 * M_PI * 1.3 * time) +
+                      0.2 * 2.0 * M_PI * 3.1 * cos(2.0 * M_PI * 3.1 * time + 1.0);
+    double effort = 300.0 * sin(2.0 * M_PI * 2.0 * time);
+    position_error += pow(estimator.position(0) - position, 2);
+    raw_position_error += pow(raw_position - position, 2);
+    velocity_error += pow(estimator.velocity(0) - velocity, 2);
+    effort_error += pow(estimator.effort(0) - effort, 2);
+    held_effort_error += pow(held_effort - effort, 2);
+    ++nb_samples;
+  }
+
+  // RMS errors, against the raw (one cycle late) position and the effort held between two samples
+  EXPECT_LT(sqrt(position_error / nb_samples), 0.5 * sqrt(raw_position_error / nb_samples));
+  EXPECT_LT(sqrt(velocity_error / nb_samples), 0.5);
+  EXPECT_LT(sqrt(effort_error / nb_samples), sqrt(held_effort_error / nb_samples));
+}
+
+/**
+ * Benchmarks the estimation for all the joints. The cost is only logged, and the
+ * benchmark is disabled by default: run it with --gtest_also_run_disabled_tests
+ */
+TEST(JointStateEstimator, DISABLED_Cost)
+{
+  shadow_robot::JointStateEstimator estimator(ros::NodeHandle("~"), 0.001);
+  estimator.resize(JOINTS_NUM_0220);
+
+  const unsigned int nb_cycles = 100000;
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (unsigned int cycle = 0; cycle < nb_cycles; ++cycle)
+  {
+    for (unsigned int joint = 0; joint < JOINTS_NUM_0220; ++joint)
+    {
+      estimator.set_position(joint, 0.01 * joint);
+      if ((cycle + joint) % 2 == 0)
+      {
+        estimator.set_effort(joint, joint);
+      }
+    }
+    estimator.update(cycle * 0.001);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  double cycle_cost_us = (static_cast<double>(end.tv_sec - start.tv_sec) * 1.0e6 +
+                          static_cast<double>(end.tv_nsec - start.tv_nsec) / 1.0e3) / nb_cycles;
+  ROS_INFO("Joint state estimation cost per cycle: %.2fus", cycle_cost_us);
+}
+
 /////////////////////
 //     MAIN       //
 ///////////////////
@@ -22,8 +22,9 @@ namespace controller
 class SrPSTTactileSensorPublisher: public SrTactileSensorPublisher
 {
 public:
-  SrPSTTactileSensorPublisher(std::vector<tactiles::AllTactileData>* sensors, double publish_rate, ros::NodeHandle nh_prefix, std::string prefix)
-    : SrTactileSensorPublisher(sensors, publish_rate, nh_prefix, prefix) {}
+  SrPSTTactileSensorPublisher(std::vector<tactiles::AllTactileData>* sensors, double publish_rate, ros::NodeHandle nh_prefix, std::string prefix,
+                              bool publish_changed_only = false)
+    : SrTactileSensorPublisher(sensors, publish_rate, nh_prefix, prefix, publish_changed_only) {}
   virtual void init();
   virtual void update(const ros::Time& time, const ros::Duration& period);
 
@@ -66,6 +66,7 @@ protected:
   ros::NodeHandle nh_prefix_;
   std::string prefix_;
   bool initialized_;
+  bool publish_changed_only_;
   boost::shared_ptr<SrTactileSensorPublisher> sensor_publisher_;
 };
 
@@ -14,6 +14,7 @@
 #include <sr_robot_msgs/ShadowPST.h>
 #include <realtime_tools/realtime_publisher.h>
 #include <ros/ros.h>
+#include <algorithm>
 
 namespace controller
 {
@@ -21,7 +22,8 @@ namespace controller
 class SrTactileSensorPublisher
 {
 public:
-  SrTactileSensorPublisher(std::vector<tactiles::AllTactileData>* sensors, double publish_rate, ros::NodeHandle nh_prefix, std::string prefix);
+  SrTactileSensorPublisher(std::vector<tactiles::AllTactileData>* sensors, double publish_rate, ros::NodeHandle nh_prefix, std::string prefix,
+                           bool publish_changed_only = false);
   virtual ~SrTactileSensorPublisher(){}
   virtual void init(){};
   virtual void update(const ros::Time& time, const ros::Duration& period){};
@@ -32,6 +34,38 @@ protected:
   double publish_rate_;
   ros::NodeHandle nh_prefix_;
   std::string prefix_;
+  // if true, the message is only published when one of the sensors has changed
+  bool publish_changed_only_;
+
+  /**
+   * Copies a value into a preallocated message field.
+   *
+   * @return true if the value of the field changed.
+   */
+  template <class Value, class Field>
+  static bool update_field(const Value& value, Field& field)
+  {
+    if (field == static_cast<Field>(value))
+      return false;
+    field = static_cast<Field>(value);
+    return true;
+  }
+
+  /**
+   * Copies the first field.size() values into a preallocated message field (fixed size array
+   * or vector resized at init), without allocating.
+   *
+   * @return true if any of the values changed.
+   */
+  template <class Values, class Field>
+  static bool update_fields(const Values& values, Field& field)
+  {
+    bool changed = false;
+    size_t size = std::min(static_cast<size_t>(values.size()), static_cast<size_t>(field.size()));
+    for (size_t i = 0; i < size; ++i)
+      changed |= update_field(values[i], field[i]);
+    return changed;
+  }
 };
 
 }// namespace
@@ -22,7 +22,8 @@ void SrBiotacTactileSensorPublisher::init()
   // realtime publisher
   biotac_realtime_pub_ = BiotacPublisherPtr(new realtime_tools::RealtimePublisher<sr_robot_msgs::BiotacAll>(nh_prefix_, "tactile", 4));
   biotac_realtime_pub_->lock();
-  for (unsigned i=0; i<sensors_->size(); i++)
+  biotac_realtime_pub_->msg_.header.frame_id = prefix_+"distal";
+  for (unsigned i=0; i<sensors_->size() && i<biotac_realtime_pub_->msg_.tactiles.size(); i++)
   {
     biotac_realtime_pub_->msg_.tactiles[i].electrodes.resize(sensors_->at(i).biotac.electrodes.size());
   }
@@ -31,7 +32,6 @@ void SrBiotacTactileSensorPublisher::init()
 
 void SrBiotacTactileSensorPublisher::update(const ros::Time& time, const ros::Duration& period)
 {
-  bool biotac_published=false;
   // limit rate of publishing
   if (publish_rate_ > 0.0 && last_publish_time_ + ros::Duration(1.0/publish_rate_) < time)
   {
@@ -40,20 +40,26 @@ void SrBiotacTactileSensorPublisher::update(const ros::Time& time, const ros::Du
     {
       // we're actually publishing, so increment time
       last_publish_time_ = last_publish_time_ + ros::Duration(1.0/publish_rate_);
-      biotac_published=true;
-      // populate message
-      biotac_realtime_pub_->msg_.header.stamp = time;
-      biotac_realtime_pub_->msg_.header.frame_id = prefix_+"distal";
-      // data
-      for (unsigned i=0; i<sensors_->size(); i++)
+      // populate message, the buffers have been sized in init
+      bool changed = false;
+      for (unsigned i=0; i<sensors_->size() && i<biotac_realtime_pub_->msg_.tactiles.size(); i++)
       {
-        biotac_realtime_pub_->msg_.tactiles[i].pac0 = sensors_->at(i).biotac.pac0;
-        biotac_realtime_pub_->msg_.tactiles[i].pac1 = sensors_->at(i).biotac.pac1;
-        biotac_realtime_pub_->msg_.tactiles[i].pdc = sensors_->at(i).biotac.pdc;
-        biotac_realtime_pub_->msg_.tactiles[i].tac = sensors_->at(i).biotac.tac;
-        biotac_realtime_pub_->msg_.tactiles[i].tdc = sensors_->at(i).biotac.tdc;
-        biotac_realtime_pub_->msg_.tactiles[i].electrodes = sensors_->at(i).biotac.electrodes;
+        sr_robot_msgs::Biotac& tactile = biotac_realtime_pub_->msg_.tactiles[i];
+        const tactiles::BiotacData& biotac = sensors_->at(i).biotac;
+        changed |= update_field(biotac.pac0, tactile.pac0);
+        changed |= update_field(biotac.pac1, tactile.pac1);
+        changed |= update_field(biotac.pdc, tactile.pdc);
+        changed |= update_field(biotac.tac, tactile.tac);
+        changed |= update_field(biotac.tdc, tactile.tdc);
+        changed |= update_fields(biotac.electrodes, tactile.electrodes);
       }
+
+      if (publish_changed_only_ && !changed)
+      {
+        biotac_realtime_pub_->unlock();
+        return;
+      }
+      biotac_realtime_pub_->msg_.header.stamp = time;
       biotac_realtime_pub_->unlockAndPublish();
     }
   }
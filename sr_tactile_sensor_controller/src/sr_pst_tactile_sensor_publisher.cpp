@@ -20,13 +20,15 @@ void SrPSTTactileSensorPublisher::init()
 {
   // realtime publisher
   pst_realtime_pub_ = PSTPublisherPtr(new realtime_tools::RealtimePublisher<sr_robot_msgs::ShadowPST>(nh_prefix_, "tactile", 4));
+  pst_realtime_pub_->lock();
+  pst_realtime_pub_->msg_.header.frame_id = prefix_+"distal";
   pst_realtime_pub_->msg_.pressure.resize(sensors_->size());
   pst_realtime_pub_->msg_.temperature.resize(sensors_->size());
+  pst_realtime_pub_->unlock();
 }
 
 void SrPSTTactileSensorPublisher::update(const ros::Time& time, const ros::Duration& period)
 {
-  bool pst_published=false;
   // limit rate of publishing
   if (publish_rate_ > 0.0 && last_publish_time_ + ros::Duration(1.0/publish_rate_) < time)
   {
@@ -35,16 +37,20 @@ void SrPSTTactileSensorPublisher::update(const ros::Time& time, const ros::Durat
     {
       // we're actually publishing, so increment time
       last_publish_time_ = last_publish_time_ + ros::Duration(1.0/publish_rate_);
-      pst_published=true;
-      // populate message
-      pst_realtime_pub_->msg_.header.stamp = time;
-      pst_realtime_pub_->msg_.header.frame_id = prefix_+"distal";
-      // data
+      // populate message, the buffers have been sized in init
+      bool changed = false;
       for (unsigned i=0; i<sensors_->size(); i++)
       {
-        pst_realtime_pub_->msg_.pressure[i] = sensors_->at(i).pst.pressure;
-        pst_realtime_pub_->msg_.temperature[i] = sensors_->at(i).pst.temperature;
+        changed |= update_field(sensors_->at(i).pst.pressure, pst_realtime_pub_->msg_.pressure[i]);
+        changed |= update_field(sensors_->at(i).pst.temperature, pst_realtime_pub_->msg_.temperature[i]);
       }
+
+      if (publish_changed_only_ && !changed)
+      {
+        pst_realtime_pub_->unlock();
+        return;
+      }
+      pst_realtime_pub_->msg_.header.stamp = time;
       pst_realtime_pub_->unlockAndPublish();
     }
   }
@@ -48,7 +48,7 @@ using namespace std;
 namespace controller
 {
 SrTactileSensorController::SrTactileSensorController()
-  : initialized_(false), sensors_(NULL)
+  : initialized_(false), sensors_(NULL), publish_changed_only_(false)
 {}
 
 bool SrTactileSensorController::init(ros_ethercat_model::RobotState* hw, ros::NodeHandle &root_nh, ros::NodeHandle& controller_nh)
@@ -84,6 +84,8 @@ bool SrTactileSensorController::init(ros_ethercat_model::RobotState* hw, ros::No
       ROS_ERROR("Parameter 'publish_rate' not set");
       return false;
     }
+    // only publish when the values changed (off by default)
+    controller_nh.param("publish_changed_only", publish_changed_only_, false);
 
     return true;
   }
@@ -106,15 +108,15 @@ void SrTactileSensorController::update(const ros::Time& time, const ros::Duratio
 	{
 	  if (sensors_->at(0).type == "pst")
 	  {
-	    sensor_publisher_.reset(new SrPSTTactileSensorPublisher(sensors_, publish_rate_, nh_prefix_, prefix_));
+	    sensor_publisher_.reset(new SrPSTTactileSensorPublisher(sensors_, publish_rate_, nh_prefix_, prefix_, publish_changed_only_));
 	  }
 	  else if (sensors_->at(0).type == "biotac")
 	  {
-	    sensor_publisher_.reset(new SrBiotacTactileSensorPublisher(sensors_, publish_rate_, nh_prefix_, prefix_));
+	    sensor_publisher_.reset(new SrBiotacTactileSensorPublisher(sensors_, publish_rate_, nh_prefix_, prefix_, publish_changed_only_));
 	  }
 	  else if (sensors_->at(0).type == "ubi")
 	  {
-	    sensor_publisher_.reset(new SrUbiTactileSensorPublisher(sensors_, publish_rate_, nh_prefix_, prefix_));
+	    sensor_publisher_.reset(new SrUbiTactileSensorPublisher(sensors_, publish_rate_, nh_prefix_, prefix_, publish_changed_only_));
 	  }
 	  else
 	  {
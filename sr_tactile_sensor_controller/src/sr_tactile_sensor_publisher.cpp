@@ -14,12 +14,14 @@ using namespace std;
 
 namespace controller
 {
-SrTactileSensorPublisher::SrTactileSensorPublisher(std::vector<tactiles::AllTactileData>* sensors, double publish_rate, ros::NodeHandle nh_prefix, std::string prefix)
+SrTactileSensorPublisher::SrTactileSensorPublisher(std::vector<tactiles::AllTactileData>* sensors, double publish_rate, ros::NodeHandle nh_prefix, std::string prefix,
+                                                   bool publish_changed_only)
 {
   sensors_ = sensors;
   publish_rate_ = publish_rate;
   nh_prefix_ = nh_prefix;
   prefix_ = prefix;
+  publish_changed_only_ = publish_changed_only;
 }
 } //end namespace
 
@@ -23,6 +23,13 @@ void SrUbiTactileSensorPublisher::init()
   // realtime publisher
   ubi_realtime_pub_ = UbiPublisherPtr(new realtime_tools::RealtimePublisher<sr_robot_msgs::UBI0All>(nh_prefix_, "tactile", 4));
   midprox_realtime_pub_ = MidProxPublisherPtr(new realtime_tools::RealtimePublisher<sr_robot_msgs::MidProxDataAll>(nh_prefix_, "tactile_mid_prox", 4));
+
+  ubi_realtime_pub_->lock();
+  ubi_realtime_pub_->msg_.header.frame_id = prefix_+"distal";
+  ubi_realtime_pub_->unlock();
+  midprox_realtime_pub_->lock();
+  midprox_realtime_pub_->msg_.header.frame_id = prefix_+"proximal";
+  midprox_realtime_pub_->unlock();
 }
 
 void SrUbiTactileSensorPublisher::update(const ros::Time& time, const ros::Duration& period)
@@ -37,18 +44,22 @@ void SrUbiTactileSensorPublisher::update(const ros::Time& time, const ros::Durat
       // we're actually publishing, so increment time
       last_publish_time_ = last_publish_time_ + ros::Duration(1.0/publish_rate_);
       ubi_published=true;
-      // populate message
-      ubi_realtime_pub_->msg_.header.stamp = time;
-      ubi_realtime_pub_->msg_.header.frame_id = prefix_+"distal";
-      // data
-      for (unsigned i=0; i<sensors_->size(); i++)
+      // populate message, the taxels are copied straight into the message arrays
+      bool changed = false;
+      for (unsigned i=0; i<sensors_->size() && i<ubi_realtime_pub_->msg_.tactiles.size(); i++)
       {
-        sr_robot_msgs::UBI0 tactile_tmp;
+        changed |= update_fields(sensors_->at(i).ubi0.distal, ubi_realtime_pub_->msg_.tactiles[i].distal);
+      }
 
-        tactile_tmp.distal = sensors_->at(i).ubi0.distal;
-        ubi_realtime_pub_->msg_.tactiles[i] = tactile_tmp;
+      if (publish_changed_only_ && !changed)
+      {
+        ubi_realtime_pub_->unlock();
+      }
+      else
+      {
+        ubi_realtime_pub_->msg_.header.stamp = time;
+        ubi_realtime_pub_->unlockAndPublish();
       }
-      ubi_realtime_pub_->unlockAndPublish();
     }
 
      // try to publish
@@ -60,22 +71,27 @@ void SrUbiTactileSensorPublisher::update(const ros::Time& time, const ros::Durat
         last_publish_time_ = last_publish_time_ + ros::Duration(1.0/publish_rate_);
       }
       // populate message
-      midprox_realtime_pub_->msg_.header.stamp = time;
-      midprox_realtime_pub_->msg_.header.frame_id = prefix_+"proximal";
-      // data
-      for (unsigned i=0; i<sensors_->size(); i++)
+      bool changed = false;
+      for (unsigned i=0; i<sensors_->size() && i<midprox_realtime_pub_->msg_.sensors.size(); i++)
       {
-        sr_robot_msgs::MidProxData midprox_tmp;
+        sr_robot_msgs::MidProxData& midprox = midprox_realtime_pub_->msg_.sensors[i];
+        changed |= update_fields(sensors_->at(i).ubi0.middle, midprox.middle);
+        changed |= update_fields(sensors_->at(i).ubi0.proximal, midprox.proximal);
+      }
 
-        midprox_tmp.middle = sensors_->at(i).ubi0.middle;
-        midprox_tmp.proximal = sensors_->at(i).ubi0.proximal;
-        midprox_realtime_pub_->msg_.sensors[i] = midprox_tmp;
+      if (publish_changed_only_ && !changed)
+      {
+        midprox_realtime_pub_->unlock();
+      }
+      else
+      {
+        midprox_realtime_pub_->msg_.header.stamp = time;
+        midprox_realtime_pub_->unlockAndPublish();
       }
-      midprox_realtime_pub_->unlockAndPublish();
     }
   }
 }
-}
+}  // namespace controller
 
 /* For the emacs weenies in the crowd.
 Local Variables: